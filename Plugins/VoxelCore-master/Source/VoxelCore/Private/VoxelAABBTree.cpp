@@ -1,6 +1,7 @@
 // Copyright Voxel Plugin SAS. All Rights Reserved.
 
 #include "VoxelAABBTree.h"
+#include "VoxelFastAABBTree.h"
 #include "VoxelWelfordVariance.h"
 
 void FVoxelAABBTree::Initialize(TVoxelArray<FElement>&& InElements)
@@ -192,6 +193,368 @@ void FVoxelAABBTree::Initialize(TVoxelArray<FElement>&& InElements)
 #endif
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Binned SAH, see Wald 2007, "On fast Construction of SAH-based Bounding Volume Hierarchies"
+// All builders share the same element array: each range is partitioned in place, and a builder only
+// ever touches the elements of the ranges it owns, so subtrees can be built concurrently
+class FVoxelAABBTreeSAHBuilder
+{
+public:
+	using FElement = FVoxelAABBTree::FElement;
+	using FNode = FVoxelAABBTree::FNode;
+	using FLeaf = FVoxelAABBTree::FLeaf;
+
+	struct FRange
+	{
+		int32 Begin = 0;
+		int32 End = 0;
+		int32 Depth = 0;
+		int32 NodeIndex = -1;
+	};
+
+	const int32 MaxChildrenInLeaf;
+	const int32 MaxTreeDepth;
+	const TVoxelArrayView<FElement> Elements;
+
+	TVoxelArray<FNode> Nodes;
+	TVoxelArray<FLeaf> Leaves;
+
+	FVoxelAABBTreeSAHBuilder(
+		const int32 MaxChildrenInLeaf,
+		const int32 MaxTreeDepth,
+		const TVoxelArrayView<FElement> Elements)
+		: MaxChildrenInLeaf(MaxChildrenInLeaf)
+		, MaxTreeDepth(MaxTreeDepth)
+		, Elements(Elements)
+	{
+	}
+
+	// Ranges with at most MaxSubtreeSize elements that still need splitting are not built,
+	// they are added to OutSubtrees instead. Their node is allocated but left uninitialized
+	void Build(
+		const FRange& Root,
+		const int32 MaxSubtreeSize,
+		TVoxelArray<FRange>& OutSubtrees)
+	{
+		VOXEL_FUNCTION_COUNTER_NUM(Root.End - Root.Begin, 128);
+
+		TVoxelInlineArray<FRange, 64> RangesToProcess;
+		RangesToProcess.Add(Root);
+
+		while (RangesToProcess.Num() > 0)
+		{
+			const FRange Range = RangesToProcess.Pop();
+			const int32 Num = Range.End - Range.Begin;
+
+			if (Num <= MaxChildrenInLeaf ||
+				Range.Depth >= MaxTreeDepth)
+			{
+				AddLeaf(Range);
+				continue;
+			}
+
+			if (Num <= MaxSubtreeSize)
+			{
+				OutSubtrees.Add(Range);
+				continue;
+			}
+
+			int32 SplitIndex = -1;
+			FVoxelBox ChildBounds0;
+			FVoxelBox ChildBounds1;
+			if (!Split(Range, SplitIndex, ChildBounds0, ChildBounds1))
+			{
+				// All centers are the same
+				AddLeaf(Range);
+				continue;
+			}
+			checkVoxelSlow(Range.Begin < SplitIndex && SplitIndex < Range.End);
+
+			const int32 ChildIndex0 = Nodes.Emplace();
+			const int32 ChildIndex1 = Nodes.Emplace();
+
+			FNode& Node = Nodes[Range.NodeIndex];
+			Node.bLeaf = false;
+			Node.ChildBounds0 = ChildBounds0;
+			Node.ChildBounds1 = ChildBounds1;
+			Node.ChildIndex0 = ChildIndex0;
+			Node.ChildIndex1 = ChildIndex1;
+
+			RangesToProcess.Add(FRange{ Range.Begin, SplitIndex, Range.Depth + 1, ChildIndex0 });
+			RangesToProcess.Add(FRange{ SplitIndex, Range.End, Range.Depth + 1, ChildIndex1 });
+		}
+	}
+
+private:
+	static constexpr int32 NumBins = 16;
+
+	struct FBin
+	{
+		FVoxelBox Bounds = FVoxelBox::InvertedInfinite;
+		int32 Num = 0;
+	};
+
+	FORCEINLINE static double GetHalfArea(const FVoxelBox& Bounds)
+	{
+		const FVector3d Size = Bounds.Size();
+		return Size.X * Size.Y + Size.Y * Size.Z + Size.Z * Size.X;
+	}
+	FORCEINLINE static int32 GetBin(const double Center, const double Min, const double Scale)
+	{
+		return FMath::Clamp(int32((Center - Min) * Scale), 0, NumBins - 1);
+	}
+
+	void AddLeaf(const FRange& Range)
+	{
+		FNode& Node = Nodes[Range.NodeIndex];
+		Node.bLeaf = true;
+		Node.LeafIndex = Leaves.Add(FLeaf{ TVoxelArray<FElement>(Elements.Slice(Range.Begin, Range.End - Range.Begin)) });
+	}
+
+	bool Split(
+		const FRange& Range,
+		int32& OutSplitIndex,
+		FVoxelBox& OutChildBounds0,
+		FVoxelBox& OutChildBounds1) const
+	{
+		FVoxelBox CenterBounds = FVoxelBox::InvertedInfinite;
+		for (int32 Index = Range.Begin; Index < Range.End; Index++)
+		{
+			CenterBounds += Elements[Index].Bounds.GetCenter();
+		}
+
+		double BestCost = MAX_dbl;
+		int32 BestAxis = -1;
+		int32 BestBin = -1;
+
+		for (int32 Axis = 0; Axis < 3; Axis++)
+		{
+			const double Extent = CenterBounds.Max[Axis] - CenterBounds.Min[Axis];
+			if (Extent <= 0)
+			{
+				continue;
+			}
+
+			const double Scale = NumBins / Extent;
+
+			TVoxelStaticArray<FBin, NumBins> Bins(FBin{});
+			for (int32 Index = Range.Begin; Index < Range.End; Index++)
+			{
+				const FVoxelBox& Bounds = Elements[Index].Bounds;
+				FBin& Bin = Bins[GetBin(Bounds.GetCenter()[Axis], CenterBounds.Min[Axis], Scale)];
+				Bin.Bounds += Bounds;
+				Bin.Num++;
+			}
+
+			// Cost of the right side when splitting before bin Index
+			TVoxelStaticArray<double, NumBins> RightCosts{ NoInit };
+			{
+				FVoxelBox RightBounds = FVoxelBox::InvertedInfinite;
+				int32 RightNum = 0;
+				for (int32 Index = NumBins - 1; Index > 0; Index--)
+				{
+					RightBounds += Bins[Index].Bounds;
+					RightNum += Bins[Index].Num;
+					RightCosts[Index] = RightNum > 0 ? RightNum * GetHalfArea(RightBounds) : -1;
+				}
+			}
+
+			FVoxelBox LeftBounds = FVoxelBox::InvertedInfinite;
+			int32 LeftNum = 0;
+			for (int32 Index = 0; Index < NumBins - 1; Index++)
+			{
+				LeftBounds += Bins[Index].Bounds;
+				LeftNum += Bins[Index].Num;
+
+				const double RightCost = RightCosts[Index + 1];
+				if (LeftNum == 0 ||
+					RightCost < 0)
+				{
+					continue;
+				}
+
+				const double Cost = LeftNum * GetHalfArea(LeftBounds) + RightCost;
+				if (Cost < BestCost)
+				{
+					BestCost = Cost;
+					BestAxis = Axis;
+					BestBin = Index;
+				}
+			}
+		}
+
+		if (BestAxis == -1)
+		{
+			return false;
+		}
+
+		const double Min = CenterBounds.Min[BestAxis];
+		const double Scale = NumBins / (CenterBounds.Max[BestAxis] - Min);
+
+		OutChildBounds0 = FVoxelBox::InvertedInfinite;
+		OutChildBounds1 = FVoxelBox::InvertedInfinite;
+
+		int32 Left = Range.Begin;
+		int32 Right = Range.End;
+		while (Left < Right)
+		{
+			FElement& Element = Elements[Left];
+			if (GetBin(Element.Bounds.GetCenter()[BestAxis], Min, Scale) <= BestBin)
+			{
+				OutChildBounds0 += Element.Bounds;
+				Left++;
+			}
+			else
+			{
+				Right--;
+				Swap(Element, Elements[Right]);
+				OutChildBounds1 += Elements[Right].Bounds;
+			}
+		}
+
+		OutSplitIndex = Left;
+		return true;
+	}
+};
+
+void FVoxelAABBTree::InitializeSAH(TVoxelArray<FElement>&& InElements)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(InElements.Num(), 128);
+	check(Nodes.Num() == 0);
+	check(Leaves.Num() == 0);
+
+	if (InElements.Num() == 0)
+	{
+		return;
+	}
+
+#if VOXEL_DEBUG
+	for (const FElement& Element : InElements)
+	{
+		ensure(Element.Bounds.IsValid());
+	}
+#endif
+
+	TVoxelArray<FElement> Elements = MoveTemp(InElements);
+	const int32 NumElements = Elements.Num();
+
+	RootBounds = FVoxelBox::InvertedInfinite;
+	for (const FElement& Element : Elements)
+	{
+		RootBounds += Element.Bounds;
+	}
+
+	using FRange = FVoxelAABBTreeSAHBuilder::FRange;
+
+	// Build the top of the tree on this thread until ranges are small enough to be spread across workers
+	TVoxelArray<FRange> Subtrees;
+	FVoxelAABBTreeSAHBuilder RootBuilder(MaxChildrenInLeaf, MaxTreeDepth, Elements);
+	{
+		const int32 NumThreads = FMath::Max(1, FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+		const int32 MaxSubtreeSize = FMath::Max(4096, NumElements / (4 * NumThreads));
+
+		RootBuilder.Nodes.Emplace();
+		RootBuilder.Build(FRange{ 0, NumElements, 0, 0 }, MaxSubtreeSize, Subtrees);
+	}
+
+	TVoxelArray<TUniquePtr<FVoxelAABBTreeSAHBuilder>> SubtreeBuilders;
+	SubtreeBuilders.SetNum(Subtrees.Num());
+
+	ParallelFor(Subtrees.Num(), [&](const int32 Index)
+	{
+		const FRange& Subtree = Subtrees[Index];
+
+		TUniquePtr<FVoxelAABBTreeSAHBuilder> Builder = MakeUnique<FVoxelAABBTreeSAHBuilder>(MaxChildrenInLeaf, MaxTreeDepth, Elements);
+		Builder->Nodes.Emplace();
+
+		TVoxelArray<FRange> Unused;
+		Builder->Build(FRange{ Subtree.Begin, Subtree.End, Subtree.Depth, 0 }, 0, Unused);
+		check(Unused.Num() == 0);
+
+		SubtreeBuilders[Index] = MoveTemp(Builder);
+	}, EParallelForFlags::Unbalanced);
+
+	// Merge the subtrees, in order so that the result is deterministic
+	{
+		VOXEL_SCOPE_COUNTER("Merge");
+
+		int32 NumNodes = RootBuilder.Nodes.Num();
+		int32 NumLeaves = RootBuilder.Leaves.Num();
+		for (const TUniquePtr<FVoxelAABBTreeSAHBuilder>& Builder : SubtreeBuilders)
+		{
+			NumNodes += Builder->Nodes.Num() - 1;
+			NumLeaves += Builder->Leaves.Num();
+		}
+
+		Nodes = MoveTemp(RootBuilder.Nodes);
+		Leaves = MoveTemp(RootBuilder.Leaves);
+		Nodes.Reserve(NumNodes);
+		Leaves.Reserve(NumLeaves);
+
+		for (int32 SubtreeIndex = 0; SubtreeIndex < Subtrees.Num(); SubtreeIndex++)
+		{
+			FVoxelAABBTreeSAHBuilder& Builder = *SubtreeBuilders[SubtreeIndex];
+
+			// The subtree root replaces the placeholder node, other nodes are appended
+			const int32 RootNodeIndex = Subtrees[SubtreeIndex].NodeIndex;
+			const int32 NodeOffset = Nodes.Num() - 1;
+			const int32 LeafOffset = Leaves.Num();
+
+			const auto RemapNode = [&](const int32 LocalNodeIndex)
+			{
+				return LocalNodeIndex == 0 ? RootNodeIndex : NodeOffset + LocalNodeIndex;
+			};
+
+			for (int32 LocalNodeIndex = 0; LocalNodeIndex < Builder.Nodes.Num(); LocalNodeIndex++)
+			{
+				FNode Node = Builder.Nodes[LocalNodeIndex];
+				if (Node.bLeaf)
+				{
+					Node.LeafIndex += LeafOffset;
+				}
+				else
+				{
+					Node.ChildIndex0 = RemapNode(Node.ChildIndex0);
+					Node.ChildIndex1 = RemapNode(Node.ChildIndex1);
+				}
+
+				if (LocalNodeIndex == 0)
+				{
+					Nodes[RootNodeIndex] = Node;
+				}
+				else
+				{
+					Nodes.Add_CheckNoGrow(Node);
+				}
+			}
+
+			for (FLeaf& Leaf : Builder.Leaves)
+			{
+				Leaves.Add_CheckNoGrow(MoveTemp(Leaf));
+			}
+		}
+
+		check(Nodes.Num() == NumNodes);
+		check(Leaves.Num() == NumLeaves);
+	}
+
+#if VOXEL_DEBUG
+	int32 NumElementsInLeaves = 0;
+	for (const FLeaf& Leaf : Leaves)
+	{
+		NumElementsInLeaves += Leaf.Elements.Num();
+	}
+	ensure(NumElementsInLeaves == NumElements);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 void FVoxelAABBTree::Shrink()
 {
 	VOXEL_FUNCTION_COUNTER();
@@ -200,7 +563,9 @@ void FVoxelAABBTree::Shrink()
 	Leaves.Shrink();
 }
 
-TSharedRef<FVoxelAABBTree> FVoxelAABBTree::Create(const TConstVoxelArrayView<FVoxelBox> Bounds)
+TSharedRef<FVoxelAABBTree> FVoxelAABBTree::Create(
+	const TConstVoxelArrayView<FVoxelBox> Bounds,
+	const bool bUseSAH)
 {
 	VOXEL_FUNCTION_COUNTER();
 
@@ -217,7 +582,14 @@ TSharedRef<FVoxelAABBTree> FVoxelAABBTree::Create(const TConstVoxelArrayView<FVo
 	}
 
 	const TSharedRef<FVoxelAABBTree> Tree = MakeShared<FVoxelAABBTree>();
-	Tree->Initialize(MoveTemp(Elements));
+	if (bUseSAH)
+	{
+		Tree->InitializeSAH(MoveTemp(Elements));
+	}
+	else
+	{
+		Tree->Initialize(MoveTemp(Elements));
+	}
 	return Tree;
 }
 
@@ -373,4 +745,22 @@ void FVoxelAABBTree::BulkRaycast(
 			}
 		}
 	}
+}
+
+void FVoxelAABBTree::RaycastPackets(
+	const TConstVoxelArrayView<FVector3f> RayPositions,
+	const TConstVoxelArrayView<FVector3f> RayDirections,
+	const FRaycastPacketsLambda Lambda) const
+{
+	VOXEL_FUNCTION_COUNTER_NUM(RayPositions.Num(), 128);
+	check(RayPositions.Num() == RayDirections.Num());
+
+	if (Nodes.Num() == 0)
+	{
+		return;
+	}
+
+	FVoxelFastAABBTree FastTree(MaxChildrenInLeaf, MaxTreeDepth);
+	FastTree.Initialize(*this);
+	FastTree.RaycastPackets(RayPositions, RayDirections, Lambda);
 }
\ No newline at end of file
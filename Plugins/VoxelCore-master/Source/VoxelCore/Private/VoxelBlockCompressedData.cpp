@@ -0,0 +1,406 @@
+﻿// Copyright Voxel Plugin SAS. All Rights Reserved.
+
+#include "VoxelBlockCompressedData.h"
+#include "VoxelZipReader.h"
+
+struct FVoxelBlockCompressedDataHeader
+{
+	uint64 Tag = MAKE_TAG_64("VOXBLOCK");
+	int64 UncompressedSize = 0;
+	int32 BlockSize = 0;
+	int32 NumBlocks = 0;
+};
+checkStatic(sizeof(FVoxelBlockCompressedDataHeader) == 24);
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+TVoxelArray64<uint8> FVoxelBlockCompressedData::Compress(
+	const TConstVoxelArrayView64<uint8> Data,
+	const int32 BlockSize,
+	const FOodleDataCompression::ECompressor Compressor,
+	const FOodleDataCompression::ECompressionLevel CompressionLevel)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Data.Num(), 1024);
+	check(BlockSize > 0);
+
+	const int64 NumBlocks64 = FVoxelUtilities::DivideCeil(Data.Num(), int64(BlockSize));
+	check(NumBlocks64 < MAX_int32);
+	const int32 NumBlocks = int32(NumBlocks64);
+
+	TVoxelArray<TVoxelArray64<uint8>> CompressedBlocks;
+	CompressedBlocks.SetNum(NumBlocks);
+
+	ParallelFor(NumBlocks, [&](const int32 BlockIndex)
+	{
+		const int64 BlockStart = int64(BlockIndex) * BlockSize;
+
+		// Blocks are already compressed in parallel
+		CompressedBlocks[BlockIndex] = FVoxelUtilities::Compress(
+			Data.Slice(BlockStart, FMath::Min<int64>(BlockSize, Data.Num() - BlockStart)),
+			false,
+			Compressor,
+			CompressionLevel);
+	});
+
+	const int64 IndexSize = (NumBlocks + 1) * sizeof(int64);
+
+	TVoxelArray<int64> BlockOffsets;
+	BlockOffsets.Reserve(NumBlocks + 1);
+	BlockOffsets.Add(sizeof(FVoxelBlockCompressedDataHeader) + IndexSize);
+
+	for (const TVoxelArray64<uint8>& CompressedBlock : CompressedBlocks)
+	{
+		BlockOffsets.Add(BlockOffsets.Last() + CompressedBlock.Num());
+	}
+
+	TVoxelArray64<uint8> Result;
+	FVoxelUtilities::SetNumFast(Result, BlockOffsets.Last());
+
+	FVoxelBlockCompressedDataHeader Header;
+	Header.UncompressedSize = Data.Num();
+	Header.BlockSize = BlockSize;
+	Header.NumBlocks = NumBlocks;
+
+	FVoxelUtilities::Memcpy(
+		MakeVoxelArrayView(Result).LeftOf(sizeof(Header)),
+		MakeByteVoxelArrayView(Header));
+
+	FVoxelUtilities::Memcpy(
+		MakeVoxelArrayView(Result).Slice(sizeof(Header), IndexSize),
+		MakeByteVoxelArrayView(BlockOffsets));
+
+	ParallelFor(NumBlocks, [&](const int32 BlockIndex)
+	{
+		FVoxelUtilities::Memcpy(
+			MakeVoxelArrayView(Result).Slice(BlockOffsets[BlockIndex], CompressedBlocks[BlockIndex].Num()),
+			CompressedBlocks[BlockIndex]);
+	});
+
+	return Result;
+}
+
+bool FVoxelBlockCompressedData::IsBlockCompressedData(const TConstVoxelArrayView64<uint8> CompressedData)
+{
+	if (CompressedData.Num() < sizeof(FVoxelBlockCompressedDataHeader))
+	{
+		return false;
+	}
+
+	FVoxelBlockCompressedDataHeader Header;
+	FVoxelUtilities::Memcpy(
+		MakeByteVoxelArrayView(Header),
+		CompressedData.LeftOf(sizeof(Header)));
+
+	return Header.Tag == FVoxelBlockCompressedDataHeader().Tag;
+}
+
+void FVoxelBlockCompressedData::Save(
+	FVoxelWriter& Writer,
+	const TConstVoxelArrayView64<uint8> CompressedData)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(CompressedData.Num(), 1024);
+	ensure(IsBlockCompressedData(CompressedData));
+
+	int64 Num = CompressedData.Num();
+	Writer << Num;
+	Writer << CompressedData;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+TSharedPtr<FVoxelBlockCompressedData> FVoxelBlockCompressedData::Load(
+	const TConstVoxelArrayView64<uint8> CompressedData,
+	const int32 MaxCachedBlocks)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	const TSharedRef<FVoxelBlockCompressedData> Result = MakeShareable(new FVoxelBlockCompressedData(MaxCachedBlocks));
+	if (!Result->Initialize(CompressedData))
+	{
+		return nullptr;
+	}
+	return Result;
+}
+
+TSharedPtr<FVoxelBlockCompressedData> FVoxelBlockCompressedData::Load(
+	FVoxelReader& Reader,
+	const int32 MaxCachedBlocks)
+{
+	int64 Num = 0;
+	Reader << Num;
+
+	const TConstVoxelArrayView64<uint8> CompressedData = Reader.ReadView(Num);
+	if (Reader.HasError())
+	{
+		return nullptr;
+	}
+
+	return Load(CompressedData, MaxCachedBlocks);
+}
+
+TSharedPtr<FVoxelBlockCompressedData> FVoxelBlockCompressedData::Load(
+	const FVoxelZipReader& ZipReader,
+	const FString& Path,
+	const int32 MaxCachedBlocks)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	const TSharedRef<FVoxelBlockCompressedData> Result = MakeShareable(new FVoxelBlockCompressedData(MaxCachedBlocks));
+
+	TConstVoxelArrayView64<uint8> CompressedData;
+	if (ZipReader.TryGetView(Path, CompressedData))
+	{
+		Result->ZipReader = ZipReader.AsShared();
+	}
+	else
+	{
+		if (!ZipReader.TryLoad(Path, Result->CompressedDataStorage))
+		{
+			return nullptr;
+		}
+
+		CompressedData = Result->CompressedDataStorage;
+	}
+
+	if (!Result->Initialize(CompressedData))
+	{
+		return nullptr;
+	}
+	return Result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool FVoxelBlockCompressedData::Read(
+	const int64 Offset,
+	const TVoxelArrayView64<uint8> OutData) const
+{
+	VOXEL_FUNCTION_COUNTER_NUM(OutData.Num(), 1024);
+
+	if (OutData.Num() == 0)
+	{
+		return true;
+	}
+
+	if (!ensure(0 <= Offset && Offset + OutData.Num() <= UncompressedSize))
+	{
+		return false;
+	}
+
+	const int32 FirstBlock = int32(Offset / BlockSize);
+	const int32 LastBlock = int32((Offset + OutData.Num() - 1) / BlockSize);
+
+	TVoxelArray<TSharedPtr<const TVoxelArray64<uint8>>> CachedBlocks;
+	CachedBlocks.SetNum(LastBlock - FirstBlock + 1);
+	{
+		VOXEL_SCOPE_LOCK(CriticalSection);
+
+		for (int32 BlockIndex = FirstBlock; BlockIndex <= LastBlock; BlockIndex++)
+		{
+			FCachedBlock* CachedBlock = CachedBlocks_RequiresLock.Find(BlockIndex);
+			if (!CachedBlock)
+			{
+				continue;
+			}
+
+			CachedBlock->LastUsed = ++CacheSerial_RequiresLock;
+			CachedBlocks[BlockIndex - FirstBlock] = CachedBlock->Data;
+		}
+	}
+
+	TVoxelAtomic<bool> bFailed;
+
+	// Reads within a single block are usually small, don't pay for a ParallelFor
+	const EParallelForFlags ParallelForFlags = CachedBlocks.Num() == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+
+	ParallelFor(CachedBlocks.Num(), [&](const int32 Index)
+	{
+		const int32 BlockIndex = FirstBlock + Index;
+		const int64 BlockStart = int64(BlockIndex) * BlockSize;
+		const int64 BlockEnd = FMath::Min(BlockStart + BlockSize, UncompressedSize);
+
+		const int64 CopyStart = FMath::Max(BlockStart, Offset);
+		const int64 CopyEnd = FMath::Min(BlockEnd, Offset + OutData.Num());
+		const TVoxelArrayView64<uint8> Dest = OutData.Slice(CopyStart - Offset, CopyEnd - CopyStart);
+
+		if (const TSharedPtr<const TVoxelArray64<uint8>>& CachedBlock = CachedBlocks[Index])
+		{
+			FVoxelUtilities::Memcpy(
+				Dest,
+				MakeVoxelArrayView(*CachedBlock).Slice(CopyStart - BlockStart, Dest.Num()));
+			return;
+		}
+
+		if (CopyStart == BlockStart &&
+			CopyEnd == BlockEnd)
+		{
+			if (!DecompressBlock(BlockIndex, Dest))
+			{
+				bFailed.Set(true);
+			}
+			return;
+		}
+
+		const TSharedRef<TVoxelArray64<uint8>> BlockData = MakeShared<TVoxelArray64<uint8>>();
+		FVoxelUtilities::SetNumFast(*BlockData, BlockEnd - BlockStart);
+
+		if (!DecompressBlock(BlockIndex, *BlockData))
+		{
+			bFailed.Set(true);
+			return;
+		}
+
+		FVoxelUtilities::Memcpy(
+			Dest,
+			MakeVoxelArrayView(*BlockData).Slice(CopyStart - BlockStart, Dest.Num()));
+
+		AddToCache(BlockIndex, BlockData);
+	}, ParallelForFlags);
+
+	return !bFailed.Get();
+}
+
+bool FVoxelBlockCompressedData::Decompress(TVoxelArray64<uint8>& OutData) const
+{
+	VOXEL_FUNCTION_COUNTER_NUM(UncompressedSize, 1024);
+
+	FVoxelUtilities::SetNumFast(OutData, UncompressedSize);
+
+	if (!Read(0, OutData))
+	{
+		OutData.Reset();
+		return false;
+	}
+	return true;
+}
+
+void FVoxelBlockCompressedData::EmptyCache() const
+{
+	VOXEL_FUNCTION_COUNTER();
+	VOXEL_SCOPE_LOCK(CriticalSection);
+
+	CachedBlocks_RequiresLock.Empty();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool FVoxelBlockCompressedData::Initialize(const TConstVoxelArrayView64<uint8> NewCompressedData)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (!ensure(IsBlockCompressedData(NewCompressedData)))
+	{
+		return false;
+	}
+
+	FVoxelBlockCompressedDataHeader Header;
+	FVoxelUtilities::Memcpy(
+		MakeByteVoxelArrayView(Header),
+		NewCompressedData.LeftOf(sizeof(Header)));
+
+	if (!ensure(Header.UncompressedSize >= 0) ||
+		!ensure(Header.BlockSize > 0) ||
+		!ensure(Header.NumBlocks == FVoxelUtilities::DivideCeil(Header.UncompressedSize, int64(Header.BlockSize))))
+	{
+		return false;
+	}
+
+	const int64 IndexSize = (Header.NumBlocks + 1) * sizeof(int64);
+	if (!ensure(sizeof(Header) + IndexSize <= NewCompressedData.Num()))
+	{
+		return false;
+	}
+
+	// Copy the index, it might not be aligned in the compressed data
+	FVoxelUtilities::SetNumFast(BlockOffsets, Header.NumBlocks + 1);
+	FVoxelUtilities::Memcpy(
+		MakeByteVoxelArrayView(BlockOffsets),
+		NewCompressedData.Slice(sizeof(Header), IndexSize));
+
+	if (!ensure(BlockOffsets[0] == int64(sizeof(Header)) + IndexSize) ||
+		!ensure(BlockOffsets.Last() == NewCompressedData.Num()))
+	{
+		return false;
+	}
+
+	for (int32 BlockIndex = 0; BlockIndex < Header.NumBlocks; BlockIndex++)
+	{
+		if (!ensure(BlockOffsets[BlockIndex] <= BlockOffsets[BlockIndex + 1]))
+		{
+			return false;
+		}
+	}
+
+	CompressedData = NewCompressedData;
+	UncompressedSize = Header.UncompressedSize;
+	BlockSize = Header.BlockSize;
+	return true;
+}
+
+bool FVoxelBlockCompressedData::DecompressBlock(
+	const int32 BlockIndex,
+	const TVoxelArrayView64<uint8> OutData) const
+{
+	VOXEL_FUNCTION_COUNTER_NUM(OutData.Num(), 1024);
+
+	const TConstVoxelArrayView64<uint8> CompressedBlock = CompressedData.Slice(
+		BlockOffsets[BlockIndex],
+		BlockOffsets[BlockIndex + 1] - BlockOffsets[BlockIndex]);
+
+	if (!ensure(FVoxelUtilities::GetDecompressedSize(CompressedBlock) == OutData.Num()))
+	{
+		return false;
+	}
+
+	// Blocks are already decompressed in parallel
+	return FVoxelUtilities::Decompress(CompressedBlock, OutData, false);
+}
+
+void FVoxelBlockCompressedData::AddToCache(
+	const int32 BlockIndex,
+	const TSharedRef<const TVoxelArray64<uint8>>& Data) const
+{
+	if (MaxCachedBlocks <= 0)
+	{
+		return;
+	}
+
+	VOXEL_SCOPE_LOCK(CriticalSection);
+
+	// Another thread might have decompressed the same block
+	if (FCachedBlock* CachedBlock = CachedBlocks_RequiresLock.Find(BlockIndex))
+	{
+		CachedBlock->LastUsed = ++CacheSerial_RequiresLock;
+		return;
+	}
+
+	if (CachedBlocks_RequiresLock.Num() >= MaxCachedBlocks)
+	{
+		// Few blocks are cached, a linear search for the least recently used one is fine
+		int32 BlockToEvict = -1;
+		uint64 MinLastUsed = MAX_uint64;
+		for (const auto& It : CachedBlocks_RequiresLock)
+		{
+			if (It.Value.LastUsed < MinLastUsed)
+			{
+				MinLastUsed = It.Value.LastUsed;
+				BlockToEvict = It.Key;
+			}
+		}
+
+		CachedBlocks_RequiresLock.RemoveChecked(BlockToEvict);
+	}
+
+	FCachedBlock CachedBlock;
+	CachedBlock.Data = Data;
+	CachedBlock.LastUsed = ++CacheSerial_RequiresLock;
+	CachedBlocks_RequiresLock.Add_CheckNew(BlockIndex, MoveTemp(CachedBlock));
+}
\ No newline at end of file
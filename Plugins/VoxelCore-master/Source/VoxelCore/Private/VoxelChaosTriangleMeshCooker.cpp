@@ -13,6 +13,91 @@ VOXEL_CONSOLE_VARIABLE(
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+struct FVoxelChaosTriangleMeshCooker::FUpdateData
+{
+	using FNode = Chaos::TAABBTreeNode<float>;
+	using FLeaf = Chaos::TAABBTreeLeafArray<int32, false, float>;
+	using FBVH = Chaos::TAABBTree<int32, FLeaf, false, float>;
+
+	int32 NumSourceTriangles = 0;
+	// Source triangle of each cooked triangle
+	// Updates reuse the slots of removed triangles, so this is only sorted after a full cook
+	TVoxelArray<int32> TriangleToSourceTriangle;
+	// Leaf containing each cooked triangle
+	TVoxelArray<int32> TriangleToLeaf;
+
+	// The BVH given to Chaos. Updates never change its topology
+	FBVH BVH;
+	// -1 for the root
+	TVoxelArray<int32> NodeToParent;
+	TVoxelArray<int32> LeafToNode;
+
+	FORCEINLINE TArray<FNode>& GetNodes()
+	{
+		return ConstCast(BVH.GetNodes());
+	}
+	FORCEINLINE TArray<FLeaf>& GetLeaves()
+	{
+		return ConstCast(BVH.GetLeaves());
+	}
+
+	void BuildTopology()
+	{
+		VOXEL_FUNCTION_COUNTER();
+
+		const TArray<FNode>& Nodes = BVH.GetNodes();
+		const TArray<FLeaf>& Leaves = BVH.GetLeaves();
+
+		FVoxelUtilities::SetNumFast(NodeToParent, Nodes.Num());
+		FVoxelUtilities::SetAll(NodeToParent, -1);
+		FVoxelUtilities::SetNumFast(LeafToNode, Leaves.Num());
+		FVoxelUtilities::SetNumFast(TriangleToLeaf, TriangleToSourceTriangle.Num());
+
+		for (int32 NodeIndex = 0; NodeIndex < Nodes.Num(); NodeIndex++)
+		{
+			const FNode& Node = Nodes[NodeIndex];
+			if (Node.bLeaf)
+			{
+				LeafToNode[Node.ChildrenNodes[0]] = NodeIndex;
+				continue;
+			}
+
+			NodeToParent[Node.ChildrenNodes[0]] = NodeIndex;
+			NodeToParent[Node.ChildrenNodes[1]] = NodeIndex;
+		}
+
+		for (int32 LeafIndex = 0; LeafIndex < Leaves.Num(); LeafIndex++)
+		{
+			for (const Chaos::TPayloadBoundsElement<int32, float>& Element : Leaves[LeafIndex].Elems)
+			{
+				TriangleToLeaf[Element.Payload] = LeafIndex;
+			}
+		}
+	}
+
+	int64 GetAllocatedSize() const
+	{
+		int64 AllocatedSize = sizeof(FUpdateData);
+		AllocatedSize += TriangleToSourceTriangle.GetAllocatedSize();
+		AllocatedSize += TriangleToLeaf.GetAllocatedSize();
+		AllocatedSize += BVH.GetNodes().GetAllocatedSize();
+		AllocatedSize += BVH.GetLeaves().GetAllocatedSize();
+		AllocatedSize += NodeToParent.GetAllocatedSize();
+		AllocatedSize += LeafToNode.GetAllocatedSize();
+
+		for (const FLeaf& Leaf : BVH.GetLeaves())
+		{
+			AllocatedSize += Leaf.Elems.GetAllocatedSize();
+		}
+
+		return AllocatedSize;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 namespace Chaos
 {
 	template<typename, typename>
@@ -58,14 +143,19 @@ namespace Chaos
 	template<>
 	struct FTriangleMeshOverlapVisitorNoMTD<FCookTriangleDummy>
 	{
-		template<typename IndexType>
-		static TRefCountPtr<FTriangleMeshImplicitObject> CookTriangleMesh(
-			const TConstVoxelArrayView<int32> Indices,
-			const TConstVoxelArrayView<FVector3f> Vertices,
-			const TConstVoxelArrayView<uint16> FaceMaterials)
+		using FUpdateData = FVoxelChaosTriangleMeshCooker::FUpdateData;
+		using FLeaf = TAABBTreeLeafArray<int32, false, float>;
+		using FBVHType = TAABBTree<int32, FLeaf, false, float>;
+		checkStatic(std::is_same_v<FBVHType, FTriangleMeshImplicitObject::BVHType>);
+		checkStatic(std::is_same_v<FBVHType, FUpdateData::FBVH>);
+
+		// From FTriangleMeshImplicitObject::RebuildBVImp
+		constexpr static int32 MaxChildrenInLeaf = 22;
+		constexpr static int32 MaxTreeDepth = FBVHType::DefaultMaxTreeDepth;
+
+		static TParticles<FRealSingle, 3> MakeParticles(const TConstVoxelArrayView<FVector3f> Vertices)
 		{
-			VOXEL_FUNCTION_COUNTER();
-			checkVoxelSlow(Indices.Num() > 0);
+			VOXEL_FUNCTION_COUNTER_NUM(Vertices.Num(), 1024);
 
 			TParticles<FRealSingle, 3> Particles;
 			Particles.AddParticles(Vertices.Num());
@@ -75,18 +165,86 @@ namespace Chaos
 				Particles.SetX(Index, Vertices[Index]);
 			}
 
+			return Particles;
+		}
+
+		FORCEINLINE static TVector<int32, 3> GetTriangle(
+			const TConstVoxelArrayView<int32> Indices,
+			const int32 SourceTriangle)
+		{
+			return TVector<int32, 3>{
+				Indices[3 * SourceTriangle + 2],
+				Indices[3 * SourceTriangle + 1],
+				Indices[3 * SourceTriangle + 0]
+			};
+		}
+		template<typename IndexType>
+		FORCEINLINE static FAABB3f GetBounds(
+			const TConstVoxelArrayView<FVector3f> Vertices,
+			const TVector<IndexType, 3>& Triangle)
+		{
+			const FVector3f VertexA = Vertices[Triangle.X];
+			const FVector3f VertexB = Vertices[Triangle.Y];
+			const FVector3f VertexC = Vertices[Triangle.Z];
+
+			return FAABB3f(
+				FVector3f(
+					FMath::Min3(VertexA.X, VertexB.X, VertexC.X),
+					FMath::Min3(VertexA.Y, VertexB.Y, VertexC.Y),
+					FMath::Min3(VertexA.Z, VertexB.Z, VertexC.Z)),
+				FVector3f(
+					FMath::Max3(VertexA.X, VertexB.X, VertexC.X),
+					FMath::Max3(VertexA.Y, VertexB.Y, VertexC.Y),
+					FMath::Max3(VertexA.Z, VertexB.Z, VertexC.Z)));
+		}
+
+		template<typename IndexType>
+		static TRefCountPtr<FTriangleMeshImplicitObject> MakeTriangleMesh(
+			TParticles<FRealSingle, 3>&& Particles,
+			TVoxelArray<TVector<IndexType, 3>>&& Triangles,
+			const TConstVoxelArrayView<uint16> FaceMaterials,
+			const FBVHType& BVH)
+		{
+			VOXEL_SCOPE_COUNTER("FTriangleMeshImplicitObject::FTriangleMeshImplicitObject");
+
+			// Chaos flattens BVH into its own format, it isn't kept
+
+			return new FTriangleMeshImplicitObject(
+				MoveTemp(Particles),
+				MoveTemp(Triangles),
+				TArray<uint16>(FaceMaterials),
+				BVH,
+				nullptr,
+				nullptr,
+				true);
+		}
+
+		template<typename IndexType>
+		static TRefCountPtr<FTriangleMeshImplicitObject> CookTriangleMesh(
+			const TConstVoxelArrayView<int32> Indices,
+			const TConstVoxelArrayView<FVector3f> Vertices,
+			const TConstVoxelArrayView<uint16> FaceMaterials,
+			TSharedPtr<const FUpdateData>* OutUpdateData)
+		{
+			VOXEL_FUNCTION_COUNTER();
+			checkVoxelSlow(Indices.Num() > 0);
+
+			TParticles<FRealSingle, 3> Particles = MakeParticles(Vertices);
+
 			const int32 NumTriangles = Indices.Num() / 3;
 
 			TVoxelArray<TVector<IndexType, 3>> Triangles;
 			Triangles.Reserve(NumTriangles);
 
+			TVoxelArray<int32> TriangleToSourceTriangle;
+			if (OutUpdateData)
+			{
+				TriangleToSourceTriangle.Reserve(NumTriangles);
+			}
+
 			for (int32 Index = 0; Index < NumTriangles; Index++)
 			{
-				const TVector<int32, 3> Triangle{
-					Indices[3 * Index + 2],
-					Indices[3 * Index + 1],
-					Indices[3 * Index + 0]
-				};
+				const TVector<int32, 3> Triangle = GetTriangle(Indices, Index);
 
 				if (!FConvexBuilder::IsValidTriangle(
 					Particles.GetX(Triangle.X),
@@ -97,6 +255,11 @@ namespace Chaos
 				}
 
 				Triangles.Add(Triangle);
+
+				if (OutUpdateData)
+				{
+					TriangleToSourceTriangle.Add(Index);
+				}
 			}
 
 			if (Triangles.Num() == 0)
@@ -143,92 +306,378 @@ namespace Chaos
 				}
 			}
 
-			using FLeaf = TAABBTreeLeafArray<int32, false, float>;
-			using FBVHType = TAABBTree<int32, FLeaf, false, float>;
-			checkStatic(std::is_same_v<FBVHType, FTriangleMeshImplicitObject::BVHType>);
+			// Emit the Chaos nodes & leaves directly as the tree is built,
+			// instead of building a FVoxelFastAABBTree and copying it afterwards
+			class FWriter : public FVoxelFastAABBTree::IBuildWriter
+			{
+			public:
+				TArray<TAABBTreeNode<float>>& Nodes;
+				TArray<FLeaf>& Leaves;
+
+				FWriter(
+					TArray<TAABBTreeNode<float>>& Nodes,
+					TArray<FLeaf>& Leaves)
+					: Nodes(Nodes)
+					, Leaves(Leaves)
+				{
+				}
+
+				virtual void Reserve(const int32 ExpectedNumNodes, const int32 ExpectedNumLeaves) override
+				{
+					Nodes.Reserve(ExpectedNumNodes);
+					Leaves.Reserve(ExpectedNumLeaves);
+				}
+				virtual void SetLeaf(const int32 NodeIndex, const FVoxelFastAABBTree::FElementArrayView& Elements) override
+				{
+					TAABBTreeNode<float>& Node = GetNode(NodeIndex);
+					Node.bLeaf = true;
+					Node.ChildrenNodes[0] = Leaves.Num();
+
+					FLeaf& Leaf = Leaves.Emplace_GetRef();
+					FVoxelUtilities::SetNumFast(Leaf.Elems, Elements.Num());
+
+					const TVoxelArrayView<TPayloadBoundsElement<int32, float>> Elems = MakeVoxelArrayView(Leaf.Elems);
+
+					for (int32 Index = 0; Index < Elements.Num(); Index++)
+					{
+						TPayloadBoundsElement<int32, float>& Element = Elems[Index];
+
+						Element.Payload = Elements.Payload[Index];
+						Element.Bounds = FAABB3f(
+							FVector3f(
+								Elements.MinX[Index],
+								Elements.MinY[Index],
+								Elements.MinZ[Index]),
+							FVector3f(
+								Elements.MaxX[Index],
+								Elements.MaxY[Index],
+								Elements.MaxZ[Index]));
+					}
+				}
+				virtual void SetInnerNode(
+					const int32 NodeIndex,
+					const int32 ChildIndex0,
+					const FVector3f& ChildBounds0_Min,
+					const FVector3f& ChildBounds0_Max,
+					const int32 ChildIndex1,
+					const FVector3f& ChildBounds1_Min,
+					const FVector3f& ChildBounds1_Max) override
+				{
+					TAABBTreeNode<float>& Node = GetNode(NodeIndex);
+					Node.bLeaf = false;
+					Node.ChildrenNodes[0] = ChildIndex0;
+					Node.ChildrenNodes[1] = ChildIndex1;
+					Node.ChildrenBounds[0] = FAABB3f(ChildBounds0_Min, ChildBounds0_Max);
+					Node.ChildrenBounds[1] = FAABB3f(ChildBounds1_Min, ChildBounds1_Max);
+				}
+
+			private:
+				FORCEINLINE TAABBTreeNode<float>& GetNode(const int32 NodeIndex)
+				{
+					if (Nodes.Num() <= NodeIndex)
+					{
+						Nodes.SetNum(NodeIndex + 1, EAllowShrinking::No);
+					}
+					return Nodes[NodeIndex];
+				}
+			};
+
+			// Build directly in the update data if we need one, so that it doesn't need to be copied
+			TSharedPtr<FUpdateData> UpdateData;
+			if (OutUpdateData)
+			{
+				UpdateData = MakeShared<FUpdateData>();
+			}
+
+			FBVHType LocalBVH;
+			FBVHType& BVH = UpdateData ? UpdateData->BVH : LocalBVH;
+			{
+				VOXEL_SCOPE_COUNTER("Build BVH");
+
+				FVoxelFastAABBTree::FElementArrayView ElementsView;
+				ElementsView.Payload = Elements.Payload;
+				ElementsView.MinX = Elements.MinX;
+				ElementsView.MinY = Elements.MinY;
+				ElementsView.MinZ = Elements.MinZ;
+				ElementsView.MaxX = Elements.MaxX;
+				ElementsView.MaxY = Elements.MaxY;
+				ElementsView.MaxZ = Elements.MaxZ;
+
+				FWriter Writer(
+					ConstCast(BVH.GetNodes()),
+					ConstCast(BVH.GetLeaves()));
+
+				FVoxelFastAABBTree::Build(ElementsView, MaxChildrenInLeaf, MaxTreeDepth, Writer);
+			}
+
+			if (UpdateData)
+			{
+				UpdateData->NumSourceTriangles = NumTriangles;
+				UpdateData->TriangleToSourceTriangle = MoveTemp(TriangleToSourceTriangle);
+				UpdateData->BuildTopology();
+
+				*OutUpdateData = UpdateData;
+			}
+
+			return MakeTriangleMesh(
+				MoveTemp(Particles),
+				MoveTemp(Triangles),
+				FaceMaterials,
+				BVH);
+		}
+
+		// Updates Data in place. Returns false if the mesh should be cooked from scratch instead, Data is then left in an invalid state
+		template<typename IndexType>
+		static bool UpdateTriangleMesh(
+			FUpdateData& Data,
+			const TConstVoxelArrayView<int32> Indices,
+			const TConstVoxelArrayView<FVector3f> Vertices,
+			const TConstVoxelArrayView<uint16> FaceMaterials,
+			const int32 ChangedTrianglesStart,
+			const int32 NumChangedTriangles,
+			TRefCountPtr<FTriangleMeshImplicitObject>& OutTriangleMesh)
+		{
+			VOXEL_FUNCTION_COUNTER();
 
-			// From FTriangleMeshImplicitObject::RebuildBVImp
-			constexpr static int32 MaxChildrenInLeaf = 22;
-			constexpr static int32 MaxTreeDepth = FBVHType::DefaultMaxTreeDepth;
+			const int32 NumSourceTriangles = Indices.Num() / 3;
+			const int32 SourceShift = NumSourceTriangles - Data.NumSourceTriangles;
+			const int32 NumPreviousChangedTriangles = NumChangedTriangles - SourceShift;
 
-			FVoxelFastAABBTree Tree(MaxChildrenInLeaf, MaxTreeDepth);
-			Tree.Initialize(MoveTemp(Elements));
+			if (!ensure(NumPreviousChangedTriangles >= 0) ||
+				!ensure(ChangedTrianglesStart + NumPreviousChangedTriangles <= Data.NumSourceTriangles))
+			{
+				return false;
+			}
 
-			const TConstVoxelArrayView<FVoxelFastAABBTree::FNode> SrcNodes = Tree.GetNodes();
-			const TConstVoxelArrayView<FVoxelFastAABBTree::FLeaf> SrcLeaves = Tree.GetLeaves();
+			TParticles<FRealSingle, 3> Particles = MakeParticles(Vertices);
 
-			FBVHType BVH;
-			FVoxelUtilities::SetNum(ConstCast(BVH.GetNodes()), SrcNodes.Num());
-			FVoxelUtilities::SetNum(ConstCast(BVH.GetLeaves()), SrcLeaves.Num());
+			TArray<TAABBTreeNode<float>>& Nodes = Data.GetNodes();
+			TArray<FLeaf>& Leaves = Data.GetLeaves();
 
+			TVoxelArray<int32> DirtyLeaves;
+			FVoxelBitArray IsLeafDirty;
+			IsLeafDirty.SetNum(Leaves.Num(), false);
+
+			const auto MarkDirty = [&](const int32 LeafIndex)
+			{
+				if (!IsLeafDirty[LeafIndex])
+				{
+					IsLeafDirty[LeafIndex] = true;
+					DirtyLeaves.Add(LeafIndex);
+				}
+			};
+			const auto FindElement = [&](const int32 LeafIndex, const int32 Triangle) -> int32
 			{
-				VOXEL_SCOPE_COUNTER("Copy Nodes");
+				const TArray<TPayloadBoundsElement<int32, float>>& Elems = Leaves[LeafIndex].Elems;
+				for (int32 Index = 0; Index < Elems.Num(); Index++)
+				{
+					if (Elems[Index].Payload == Triangle)
+					{
+						return Index;
+					}
+				}
+				checkVoxelSlow(false);
+				return -1;
+			};
 
-				const TVoxelArrayView<TAABBTreeNode<float>> DestNodes = MakeVoxelArrayView(ConstCast(BVH.GetNodes()));
+			// Slots of removed triangles, reused by the new ones
+			TVoxelArray<int32> FreeTriangles;
+			{
+				VOXEL_SCOPE_COUNTER("Remove changed triangles");
 
-				for (int32 Index = 0; Index < SrcNodes.Num(); Index++)
+				for (int32 Triangle = 0; Triangle < Data.TriangleToSourceTriangle.Num(); Triangle++)
 				{
-					const FVoxelFastAABBTree::FNode& SrcNode = SrcNodes[Index];
-					TAABBTreeNode<float>& DestNode = DestNodes[Index];
+					int32& SourceTriangle = Data.TriangleToSourceTriangle[Triangle];
 
-					if (SrcNode.bLeaf)
+					if (SourceTriangle < ChangedTrianglesStart)
 					{
-						DestNode.bLeaf = true;
-						DestNode.ChildrenNodes[0] = SrcNode.LeafIndex;
+						continue;
 					}
-					else
+
+					if (SourceTriangle >= ChangedTrianglesStart + NumPreviousChangedTriangles)
 					{
-						DestNode.bLeaf = false;
-						DestNode.ChildrenNodes[0] = SrcNode.ChildIndex0;
-						DestNode.ChildrenNodes[1] = SrcNode.ChildIndex1;
-						DestNode.ChildrenBounds[0] = FAABB3f(SrcNode.ChildBounds0_Min, SrcNode.ChildBounds0_Max);
-						DestNode.ChildrenBounds[1] = FAABB3f(SrcNode.ChildBounds1_Min, SrcNode.ChildBounds1_Max);
+						SourceTriangle += SourceShift;
+						continue;
 					}
+
+					const int32 LeafIndex = Data.TriangleToLeaf[Triangle];
+					Leaves[LeafIndex].Elems.RemoveAtSwap(FindElement(LeafIndex, Triangle), EAllowShrinking::No);
+					MarkDirty(LeafIndex);
+
+					FreeTriangles.Add(Triangle);
 				}
 			}
 
 			{
-				VOXEL_SCOPE_COUNTER("Copy Leaves");
+				VOXEL_SCOPE_COUNTER("Insert changed triangles");
 
-				const TVoxelArrayView<FLeaf> DestLeaves = MakeVoxelArrayView(ConstCast(BVH.GetLeaves()));
+				for (int32 SourceTriangle = ChangedTrianglesStart; SourceTriangle < ChangedTrianglesStart + NumChangedTriangles; SourceTriangle++)
+				{
+					const TVector<int32, 3> Triangle = GetTriangle(Indices, SourceTriangle);
+
+					if (!FConvexBuilder::IsValidTriangle(
+						Particles.GetX(Triangle.X),
+						Particles.GetX(Triangle.Y),
+						Particles.GetX(Triangle.Z)))
+					{
+						continue;
+					}
+
+					const FAABB3f Bounds = GetBounds(Vertices, Triangle);
+
+					// Descend in the child whose surface area grows the least
+					int32 NodeIndex = 0;
+					while (!Nodes[NodeIndex].bLeaf)
+					{
+						const TAABBTreeNode<float>& Node = Nodes[NodeIndex];
 
-				for (int32 Index = 0; Index < SrcLeaves.Num(); Index++)
+						const float Growth0 = GetSurfaceAreaGrowth(Node.ChildrenBounds[0], Bounds);
+						const float Growth1 = GetSurfaceAreaGrowth(Node.ChildrenBounds[1], Bounds);
+
+						NodeIndex = Node.ChildrenNodes[Growth0 <= Growth1 ? 0 : 1];
+					}
+
+					const int32 LeafIndex = Nodes[NodeIndex].ChildrenNodes[0];
+					TArray<TPayloadBoundsElement<int32, float>>& Elems = Leaves[LeafIndex].Elems;
+
+					if (Elems.Num() >= 2 * MaxChildrenInLeaf)
+					{
+						// Tree degraded too much, rebuild it
+						return false;
+					}
+
+					int32 TriangleIndex;
+					if (FreeTriangles.Num() > 0)
+					{
+						TriangleIndex = FreeTriangles.Pop();
+						Data.TriangleToSourceTriangle[TriangleIndex] = SourceTriangle;
+						Data.TriangleToLeaf[TriangleIndex] = LeafIndex;
+					}
+					else
+					{
+						TriangleIndex = Data.TriangleToSourceTriangle.Add(SourceTriangle);
+						Data.TriangleToLeaf.Add(LeafIndex);
+					}
+
+					TPayloadBoundsElement<int32, float>& Element = Elems.Emplace_GetRef();
+					Element.Payload = TriangleIndex;
+					Element.Bounds = Bounds;
+
+					MarkDirty(LeafIndex);
+				}
+			}
+
+			{
+				VOXEL_SCOPE_COUNTER("Fill holes");
+
+				// Move the last triangles in the remaining free slots. Slots are processed in decreasing order,
+				// so the last triangle is never a free slot unless it's the one being processed
+				for (int32 Index = FreeTriangles.Num() - 1; Index >= 0; Index--)
 				{
-					const FVoxelFastAABBTree::FLeaf& SrcLeaf = SrcLeaves[Index];
-					FLeaf& DestLeaf = DestLeaves[Index];
+					const int32 Triangle = FreeTriangles[Index];
+					const int32 LastTriangle = Data.TriangleToSourceTriangle.Num() - 1;
+
+					if (Triangle != LastTriangle)
+					{
+						const int32 LeafIndex = Data.TriangleToLeaf[LastTriangle];
+						Leaves[LeafIndex].Elems[FindElement(LeafIndex, LastTriangle)].Payload = Triangle;
+
+						Data.TriangleToSourceTriangle[Triangle] = Data.TriangleToSourceTriangle[LastTriangle];
+						Data.TriangleToLeaf[Triangle] = LeafIndex;
+					}
+
+					Data.TriangleToSourceTriangle.Pop();
+					Data.TriangleToLeaf.Pop();
+				}
+			}
+
+			Data.NumSourceTriangles = NumSourceTriangles;
 
-					FVoxelUtilities::SetNumFast(DestLeaf.Elems, SrcLeaf.Elements.Num());
+			if (Data.TriangleToSourceTriangle.Num() == 0)
+			{
+				OutTriangleMesh = nullptr;
+				return true;
+			}
 
-					const TVoxelArrayView<TPayloadBoundsElement<int32, float>> Elems = MakeVoxelArrayView(DestLeaf.Elems);
+			{
+				VOXEL_SCOPE_COUNTER("Refit");
 
-					for (int32 ElementIndex = 0; ElementIndex < SrcLeaf.Elements.Num(); ElementIndex++)
+				for (const int32 LeafIndex : DirtyLeaves)
+				{
+					FAABB3f Bounds = FAABB3f::EmptyAABB();
+					for (const TPayloadBoundsElement<int32, float>& Element : Leaves[LeafIndex].Elems)
 					{
-						TPayloadBoundsElement<int32, float>& DestElement = Elems[ElementIndex];
+						Bounds.GrowToInclude(Element.Bounds);
+					}
 
-						DestElement.Payload = SrcLeaf.Elements.Payload[ElementIndex];
-						DestElement.Bounds = FAABB3f(
-							FVector3f(
-								SrcLeaf.Elements.MinX[ElementIndex],
-								SrcLeaf.Elements.MinY[ElementIndex],
-								SrcLeaf.Elements.MinZ[ElementIndex]),
-							FVector3f(
-								SrcLeaf.Elements.MaxX[ElementIndex],
-								SrcLeaf.Elements.MaxY[ElementIndex],
-								SrcLeaf.Elements.MaxZ[ElementIndex]));
+					// Bounds of nodes are stored in their parent
+					int32 NodeIndex = Data.LeafToNode[LeafIndex];
+					while (Data.NodeToParent[NodeIndex] != -1)
+					{
+						TAABBTreeNode<float>& Parent = Nodes[Data.NodeToParent[NodeIndex]];
+						FAABB3f& ChildBounds = Parent.ChildrenBounds[Parent.ChildrenNodes[0] == NodeIndex ? 0 : 1];
+
+						if (ChildBounds.Min() == Bounds.Min() &&
+							ChildBounds.Max() == Bounds.Max())
+						{
+							// Ancestors are unchanged
+							break;
+						}
+						ChildBounds = Bounds;
+
+						Bounds = Parent.ChildrenBounds[0];
+						Bounds.GrowToInclude(Parent.ChildrenBounds[1]);
+						NodeIndex = Data.NodeToParent[NodeIndex];
 					}
 				}
 			}
 
-			VOXEL_SCOPE_COUNTER("FTriangleMeshImplicitObject::FTriangleMeshImplicitObject");
+			TVoxelArray<TVector<IndexType, 3>> Triangles;
+			TVoxelArray<uint16> TriangleMaterials;
+			{
+				VOXEL_SCOPE_COUNTER("Build Triangles");
 
-			return new FTriangleMeshImplicitObject(
+				FVoxelUtilities::SetNumFast(Triangles, Data.TriangleToSourceTriangle.Num());
+				for (int32 Index = 0; Index < Triangles.Num(); Index++)
+				{
+					Triangles[Index] = GetTriangle(Indices, Data.TriangleToSourceTriangle[Index]);
+				}
+
+				if (FaceMaterials.Num() > 0)
+				{
+					FVoxelUtilities::SetNumFast(TriangleMaterials, Triangles.Num());
+					for (int32 Index = 0; Index < Triangles.Num(); Index++)
+					{
+						TriangleMaterials[Index] = FaceMaterials[Data.TriangleToSourceTriangle[Index]];
+					}
+				}
+			}
+
+			OutTriangleMesh = MakeTriangleMesh(
 				MoveTemp(Particles),
 				MoveTemp(Triangles),
-				TArray<uint16>(FaceMaterials),
-				BVH,
-				nullptr,
-				nullptr,
-				true);
+				TriangleMaterials,
+				Data.BVH);
+
+			return true;
+		}
+
+		FORCEINLINE static float GetSurfaceArea(const FVector3f& Size)
+		{
+			return 2.f * (Size.X * Size.Y + Size.Y * Size.Z + Size.Z * Size.X);
+		}
+		FORCEINLINE static float GetSurfaceAreaGrowth(const FAABB3f& Bounds, const FAABB3f& NewBounds)
+		{
+			if (Bounds.Min().X > Bounds.Max().X)
+			{
+				// Empty leaf
+				return GetSurfaceArea(NewBounds.Max() - NewBounds.Min());
+			}
+
+			FAABB3f Union = Bounds;
+			Union.GrowToInclude(NewBounds);
+
+			return GetSurfaceArea(Union.Max() - Union.Min()) - GetSurfaceArea(Bounds.Max() - Bounds.Min());
 		}
 	};
 }
@@ -255,15 +704,182 @@ TRefCountPtr<Chaos::FTriangleMeshImplicitObject> FVoxelChaosTriangleMeshCooker::
 
 	if (Vertices.Num() < MAX_uint16)
 	{
-		return FCooker::CookTriangleMesh<uint16>(Indices, Vertices, FaceMaterials);
+		return FCooker::CookTriangleMesh<uint16>(Indices, Vertices, FaceMaterials, nullptr);
 	}
 	else
 	{
-		return FCooker::CookTriangleMesh<int32>(Indices, Vertices, FaceMaterials);
+		return FCooker::CookTriangleMesh<int32>(Indices, Vertices, FaceMaterials, nullptr);
 	}
 }
 
 int64 FVoxelChaosTriangleMeshCooker::GetAllocatedSize(const Chaos::FTriangleMeshImplicitObject& TriangleMesh)
 {
 	return Chaos::FTriangleMeshSweepVisitorCCD<void, void>::GetAllocatedSize(TriangleMesh);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+int64 FVoxelChaosTriangleMeshCooker::FUpdatableMesh::GetAllocatedSize() const
+{
+	int64 AllocatedSize = 0;
+	if (TriangleMesh)
+	{
+		AllocatedSize += FVoxelChaosTriangleMeshCooker::GetAllocatedSize(*TriangleMesh);
+	}
+	if (UpdateData)
+	{
+		AllocatedSize += UpdateData->GetAllocatedSize();
+	}
+	return AllocatedSize;
+}
+
+FVoxelChaosTriangleMeshCooker::FUpdatableMesh FVoxelChaosTriangleMeshCooker::CreateUpdatable(
+	const TConstVoxelArrayView<int32> Indices,
+	const TConstVoxelArrayView<FVector3f> Vertices,
+	const TConstVoxelArrayView<uint16> FaceMaterials)
+{
+	VOXEL_FUNCTION_COUNTER();
+	ensure(FaceMaterials.Num() == 0 || FaceMaterials.Num() == Indices.Num() / 3);
+
+	if (Indices.Num() == 0 ||
+		!ensure(Indices.Num() % 3 == 0))
+	{
+		return {};
+	}
+
+	using FCooker = Chaos::FTriangleMeshOverlapVisitorNoMTD<Chaos::FCookTriangleDummy>;
+
+	FUpdatableMesh Result;
+	if (Vertices.Num() < MAX_uint16)
+	{
+		Result.TriangleMesh = FCooker::CookTriangleMesh<uint16>(Indices, Vertices, FaceMaterials, &Result.UpdateData);
+	}
+	else
+	{
+		Result.TriangleMesh = FCooker::CookTriangleMesh<int32>(Indices, Vertices, FaceMaterials, &Result.UpdateData);
+	}
+	return Result;
+}
+
+FVoxelChaosTriangleMeshCooker::FUpdatableMesh FVoxelChaosTriangleMeshCooker::Update(
+	const FUpdatableMesh& Previous,
+	const TConstVoxelArrayView<int32> Indices,
+	const TConstVoxelArrayView<FVector3f> Vertices,
+	const TConstVoxelArrayView<uint16> FaceMaterials,
+	const int32 ChangedTrianglesStart,
+	const int32 NumChangedTriangles)
+{
+	return UpdateImpl(
+		Previous.UpdateData,
+		false,
+		Indices,
+		Vertices,
+		FaceMaterials,
+		ChangedTrianglesStart,
+		NumChangedTriangles);
+}
+
+FVoxelChaosTriangleMeshCooker::FUpdatableMesh FVoxelChaosTriangleMeshCooker::Update(
+	FUpdatableMesh&& Previous,
+	const TConstVoxelArrayView<int32> Indices,
+	const TConstVoxelArrayView<FVector3f> Vertices,
+	const TConstVoxelArrayView<uint16> FaceMaterials,
+	const int32 ChangedTrianglesStart,
+	const int32 NumChangedTriangles)
+{
+	const TSharedPtr<const FUpdateData> UpdateData = MoveTemp(Previous.UpdateData);
+	Previous.TriangleMesh.SafeRelease();
+
+	return UpdateImpl(
+		UpdateData,
+		true,
+		Indices,
+		Vertices,
+		FaceMaterials,
+		ChangedTrianglesStart,
+		NumChangedTriangles);
+}
+
+FVoxelChaosTriangleMeshCooker::FUpdatableMesh FVoxelChaosTriangleMeshCooker::UpdateImpl(
+	const TSharedPtr<const FUpdateData>& PreviousUpdateData,
+	const bool bCanReuseUpdateData,
+	const TConstVoxelArrayView<int32> Indices,
+	const TConstVoxelArrayView<FVector3f> Vertices,
+	const TConstVoxelArrayView<uint16> FaceMaterials,
+	const int32 ChangedTrianglesStart,
+	const int32 NumChangedTriangles)
+{
+	VOXEL_FUNCTION_COUNTER();
+	ensure(FaceMaterials.Num() == 0 || FaceMaterials.Num() == Indices.Num() / 3);
+
+	if (Indices.Num() == 0 ||
+		!ensure(Indices.Num() % 3 == 0))
+	{
+		return {};
+	}
+
+	if (!PreviousUpdateData ||
+		!GVoxelCollisionFastCooking ||
+		!ensure(ChangedTrianglesStart >= 0) ||
+		!ensure(NumChangedTriangles >= 0) ||
+		!ensure(ChangedTrianglesStart + NumChangedTriangles <= Indices.Num() / 3) ||
+		// Refitting is only worth it for small changes, and it keeps the tree from degrading too fast
+		NumChangedTriangles > Indices.Num() / 3 / 4)
+	{
+		return CreateUpdatable(Indices, Vertices, FaceMaterials);
+	}
+
+	// The update is done in place: only copy the previous data if someone else might use it
+	TSharedPtr<FUpdateData> UpdateData;
+	if (bCanReuseUpdateData &&
+		PreviousUpdateData.GetSharedReferenceCount() == 1)
+	{
+		UpdateData = ConstCastSharedPtr<FUpdateData>(PreviousUpdateData);
+	}
+	else
+	{
+		VOXEL_SCOPE_COUNTER("Copy update data");
+		UpdateData = MakeShared<FUpdateData>(*PreviousUpdateData);
+	}
+
+	using FCooker = Chaos::FTriangleMeshOverlapVisitorNoMTD<Chaos::FCookTriangleDummy>;
+
+	FUpdatableMesh Result;
+
+	bool bSuccess;
+	if (Vertices.Num() < MAX_uint16)
+	{
+		bSuccess = FCooker::UpdateTriangleMesh<uint16>(
+			*UpdateData,
+			Indices,
+			Vertices,
+			FaceMaterials,
+			ChangedTrianglesStart,
+			NumChangedTriangles,
+			Result.TriangleMesh);
+	}
+	else
+	{
+		bSuccess = FCooker::UpdateTriangleMesh<int32>(
+			*UpdateData,
+			Indices,
+			Vertices,
+			FaceMaterials,
+			ChangedTrianglesStart,
+			NumChangedTriangles,
+			Result.TriangleMesh);
+	}
+
+	if (!bSuccess)
+	{
+		return CreateUpdatable(Indices, Vertices, FaceMaterials);
+	}
+
+	if (Result.TriangleMesh)
+	{
+		Result.UpdateData = UpdateData;
+	}
+	return Result;
 }
\ No newline at end of file
@@ -1,7 +1,21 @@
 ﻿// Copyright Voxel Plugin SAS. All Rights Reserved.
 
 #include "VoxelMinimal.h"
+#include "VoxelTaskContext.h"
+#include "VoxelMinimal/VoxelPromiseState.h"
 #include "VoxelWelfordVariance.h"
+#include "VoxelAABBTree.h"
+#include "VoxelDynamicAABBTree.h"
+#include "VoxelFastAABBTree.h"
+#include "VoxelJumpFlood.h"
+#include "VoxelNaniteBuilder.h"
+#include "VoxelChaosTriangleMeshCooker.h"
+#include "VoxelZipReader.h"
+#include "VoxelZipWriter.h"
+#include "Rendering/NaniteResources.h"
+#include "HAL/Thread.h"
+#include "Misc/FileHelper.h"
+#include "HAL/PlatformFileManager.h"
 #include "Misc/OutputDeviceConsole.h"
 #include "Framework/Application/SlateApplication.h"
 
@@ -709,6 +723,223 @@ CUSTOM_BENCHMARK
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+// Keys are scrambled so that TVoxelMap doesn't benefit from the identity hash of sequential ints
+// Missing keys are guaranteed to not be in the map as MurmurHash32 is a bijection
+BENCHMARK
+{
+	TVoxelArray<int32> Keys;
+	TVoxelArray<int32> MissingKeys;
+	TVoxelArray<int32> MixedKeys;
+	{
+		Keys.Reserve(Num);
+		MissingKeys.Reserve(Num);
+		MixedKeys.Reserve(Num);
+
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			Keys.Add_CheckNoGrow(int32(FVoxelUtilities::MurmurHash32(Index)));
+			MissingKeys.Add_CheckNoGrow(int32(FVoxelUtilities::MurmurHash32(Num + Index)));
+			MixedKeys.Add_CheckNoGrow(Index % 2 ? Keys.Last() : MissingKeys.Last());
+		}
+	}
+
+	TMap<int32, int32> Map;
+	TVoxelMap<int32, int32> VoxelMap;
+	TVoxelFlatMap<int32, int32> FlatMap;
+	{
+		Map.Reserve(Num);
+		VoxelMap.Reserve(Num);
+		FlatMap.Reserve(Num);
+
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			Map.Add(Keys[Index], Index);
+			VoxelMap.Add_CheckNew_CheckNoRehash(Keys[Index], Index);
+			FlatMap.Add_CheckNew_CheckNoRehash(Keys[Index], Index);
+		}
+	}
+
+	int32 Value = 0;
+
+	RUN_BENCHMARK(
+		"TMap::FindChecked (hit)",
+		Value += Map.FindChecked(Keys[Run]),
+		"TVoxelFlatMap::FindChecked (hit)",
+		Value += FlatMap.FindChecked(Keys[Run]));
+
+	RUN_BENCHMARK(
+		"TVoxelMap::FindChecked (hit)",
+		Value += VoxelMap.FindChecked(Keys[Run]),
+		"TVoxelFlatMap::FindChecked (hit)",
+		Value += FlatMap.FindChecked(Keys[Run]));
+
+	RUN_BENCHMARK(
+		"TMap::FindRef (miss)",
+		Value += Map.FindRef(MissingKeys[Run]),
+		"TVoxelFlatMap::FindRef (miss)",
+		Value += FlatMap.FindRef(MissingKeys[Run]));
+
+	RUN_BENCHMARK(
+		"TVoxelMap::FindRef (miss)",
+		Value += VoxelMap.FindRef(MissingKeys[Run]),
+		"TVoxelFlatMap::FindRef (miss)",
+		Value += FlatMap.FindRef(MissingKeys[Run]));
+
+	RUN_BENCHMARK(
+		"TMap::FindRef (50% hit)",
+		Value += Map.FindRef(MixedKeys[Run]),
+		"TVoxelFlatMap::FindRef (50% hit)",
+		Value += FlatMap.FindRef(MixedKeys[Run]));
+
+	RUN_BENCHMARK(
+		"TVoxelMap::FindRef (50% hit)",
+		Value += VoxelMap.FindRef(MixedKeys[Run]),
+		"TVoxelFlatMap::FindRef (50% hit)",
+		Value += FlatMap.FindRef(MixedKeys[Run]));
+}
+
+BENCHMARK
+{
+	TVoxelMap<int32, int32> VoxelMap;
+	TVoxelFlatMap<int32, int32> FlatMap;
+
+	Run(
+		"TVoxelMap::FindOrAdd",
+		[&]
+		{
+			VoxelMap.Empty();
+			VoxelMap.Reserve(Num);
+		},
+		[&]
+		{
+			FRandomStream Stream;
+			Stream.Initialize(1337);
+
+			for (int32 Run = 0; Run < Num; Run++)
+			{
+				VoxelMap.FindOrAdd(Stream.RandRange(MIN_int32, MAX_int32)) = Run;
+			}
+		},
+		"TVoxelFlatMap::FindOrAdd",
+		[&]
+		{
+			FlatMap.Empty();
+			FlatMap.Reserve(Num);
+		},
+		[&]
+		{
+			FRandomStream Stream;
+			Stream.Initialize(1337);
+
+			for (int32 Run = 0; Run < Num; Run++)
+			{
+				FlatMap.FindOrAdd(Stream.RandRange(MIN_int32, MAX_int32)) = Run;
+			}
+		});
+}
+
+BENCHMARK
+{
+	TVoxelMap<int32, int32> VoxelMap;
+	TVoxelFlatMap<int32, int32> FlatMap;
+
+	Run(
+		"TVoxelMap::Remove + Add",
+		[&]
+		{
+			VoxelMap.Empty();
+			VoxelMap.Reserve(Num);
+
+			for (int32 Index = 0; Index < Num; Index++)
+			{
+				VoxelMap.Add_CheckNew(Index, Index);
+			}
+		},
+		[&]
+		{
+			FRandomStream Stream;
+			Stream.Initialize(1337);
+
+			for (int32 Run = 0; Run < Num; Run++)
+			{
+				const int32 Value = Stream.RandRange(0, Num - 1);
+				VoxelMap.Remove(Value);
+				VoxelMap.FindOrAdd(Value) = Value;
+			}
+		},
+		"TVoxelFlatMap::Remove + Add",
+		[&]
+		{
+			FlatMap.Empty();
+			FlatMap.Reserve(Num);
+
+			for (int32 Index = 0; Index < Num; Index++)
+			{
+				FlatMap.Add_CheckNew(Index, Index);
+			}
+		},
+		[&]
+		{
+			FRandomStream Stream;
+			Stream.Initialize(1337);
+
+			for (int32 Run = 0; Run < Num; Run++)
+			{
+				const int32 Value = Stream.RandRange(0, Num - 1);
+				FlatMap.Remove(Value);
+				FlatMap.FindOrAdd(Value) = Value;
+			}
+		},
+		"TVoxelFlatMap::Remove leaves tombstones in full groups, which are purged on the next rehash");
+}
+
+BENCHMARK
+{
+	TVoxelSet<int32> VoxelSet;
+	TVoxelFlatSet<int32> FlatSet;
+	{
+		VoxelSet.Reserve(Num);
+		FlatSet.Reserve(Num);
+
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			const int32 Key = int32(FVoxelUtilities::MurmurHash32(2 * Index));
+			VoxelSet.Add_CheckNew(Key);
+			FlatSet.Add_CheckNew_CheckNoRehash(Key);
+		}
+	}
+
+	int32 Value = 0;
+
+	RUN_BENCHMARK(
+		"TVoxelSet::Contains (50% hit)",
+		Value += VoxelSet.Contains(int32(FVoxelUtilities::MurmurHash32(Run))),
+		"TVoxelFlatSet::Contains (50% hit)",
+		Value += FlatSet.Contains(int32(FVoxelUtilities::MurmurHash32(Run))));
+}
+
+CUSTOM_BENCHMARK
+{
+	TVoxelMap<uint32, uint32> VoxelMap;
+	TVoxelFlatMap<uint32, uint32> FlatMap;
+	VoxelMap.Reserve(1000000);
+	FlatMap.Reserve(1000000);
+
+	for (int32 Index = 0; Index < 1000000; Index++)
+	{
+		VoxelMap.Add_CheckNew(Index, Index);
+		FlatMap.Add_CheckNew(Index, Index);
+	}
+
+	LOG("TVoxelMap<uint32, uint32> with 1M elements: %s TVoxelFlatMap<uint32, uint32> with 1M elements: %s",
+		*FVoxelUtilities::BytesToString(VoxelMap.GetAllocatedSize()),
+		*FVoxelUtilities::BytesToString(FlatMap.GetAllocatedSize()));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 BENCHMARK
 {
 	TArray<int32> Array;
@@ -1042,6 +1273,1346 @@ CUSTOM_BENCHMARK
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+CUSTOM_BENCHMARK
+{
+	for (const int32 NumTrackers : TArray<int32>{ 10000, 100000 })
+	{
+		// Emulates FVoxelDependencyTracker::Dependency3DToBounds_RequiresLock
+		TVoxelArray<TVoxelMap<uint64, FVoxelBox>> Trackers;
+		FVoxelDynamicAABBTree Tree;
+
+		const int32 GridSize = FMath::CeilToInt(FMath::Pow(double(NumTrackers), 1. / 3.));
+		const uint64 DependencyId = 1;
+
+		for (int32 Index = 0; Index < NumTrackers; Index++)
+		{
+			const FIntVector Position(
+				Index % GridSize,
+				(Index / GridSize) % GridSize,
+				Index / GridSize / GridSize);
+
+			const FVoxelBox Bounds = FVoxelBox(Position * 32, (Position + 1) * 32);
+
+			TVoxelMap<uint64, FVoxelBox>& Map = Trackers.Emplace_GetRef();
+			Map.Add_CheckNew(DependencyId + 1, FVoxelBox::Infinite);
+			Map.Add_CheckNew(DependencyId, Bounds);
+
+			Tree.Insert(Bounds, Index);
+		}
+
+		// Typical brush stroke
+		const FVoxelBox BrushBounds = FVoxelBox(FVector(GridSize * 16.), FVector(GridSize * 16. + 100.));
+
+		int32 NumFound = 0;
+
+		RunBenchmark<1>(
+			FString::Printf(TEXT("Invalidating %dk trackers by scanning all of them"), NumTrackers / 1000),
+			[&]
+			{
+				for (const TVoxelMap<uint64, FVoxelBox>& Map : Trackers)
+				{
+					const FVoxelBox* Bounds = Map.Find(DependencyId);
+					if (Bounds &&
+						Bounds->Intersects(BrushBounds))
+					{
+						NumFound++;
+					}
+				}
+			},
+			FString::Printf(TEXT("Invalidating %dk trackers with FVoxelDynamicAABBTree"), NumTrackers / 1000),
+			[&]
+			{
+				Tree.TraverseBounds(BrushBounds, [&](const int32 TrackerIndex)
+				{
+					if (Trackers[TrackerIndex].FindChecked(DependencyId).Intersects(BrushBounds))
+					{
+						NumFound++;
+					}
+				});
+			},
+			"FVoxelDependency2D/3D only check the trackers whose bounds overlap the invalidated bounds");
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+CUSTOM_BENCHMARK
+{
+	// Fan-out/fan-in future graph: each task spawns 64 small tasks from a worker thread and joins them
+	const auto RunGraph = [](const bool bWorkStealing)
+	{
+		GVoxelWorkStealing = bWorkStealing;
+
+		FVoxelTaskContext Context(false, false);
+		{
+			FVoxelTaskScope Scope(Context);
+
+			TVoxelArray<FVoxelFuture> Futures;
+			for (int32 Index = 0; Index < 64; Index++)
+			{
+				Futures.Add(FVoxelFuture::Execute(EVoxelFutureThread::AsyncThread, []
+				{
+					TVoxelArray<FVoxelFuture> InnerFutures;
+					for (int32 InnerIndex = 0; InnerIndex < 64; InnerIndex++)
+					{
+						InnerFutures.Add(FVoxelFuture::Execute(EVoxelFutureThread::AsyncThread, [InnerIndex]
+						{
+							uint32 Hash = InnerIndex;
+							for (int32 Iteration = 0; Iteration < 1000; Iteration++)
+							{
+								Hash = uint32(FVoxelUtilities::MurmurHash(Hash));
+							}
+							FPlatformMisc::MemoryBarrier();
+						}));
+					}
+					return FVoxelFuture(InnerFutures);
+				}));
+			}
+
+			FVoxelFuture(Futures).Then_AsyncThread([]
+			{
+			});
+		}
+		Context.FlushTasks();
+	};
+
+	RunBenchmark<1>(
+		"Fan-out/fan-in 64x64 tasks with the per-context queue",
+		[&]
+		{
+			RunGraph(false);
+		},
+		"Fan-out/fan-in 64x64 tasks with work stealing",
+		[&]
+		{
+			RunGraph(true);
+		},
+		"voxel.WorkStealing pushes tasks dispatched from worker threads to a lock-free per-thread deque");
+
+	GVoxelWorkStealing = false;
+}
+
+CUSTOM_BENCHMARK
+{
+	// 10k chains of 100 continuations, each continuation allocates a promise state and a continuation node
+	const auto ChainPromises = [](const bool bPoolPromises, int64& OutNumHeapAllocations)
+	{
+		GVoxelPoolPromises = bPoolPromises;
+
+		const int64 StartNumHeapAllocations = GVoxelNumPromiseHeapAllocations.Get();
+
+		for (int32 ChainIndex = 0; ChainIndex < 10000; ChainIndex++)
+		{
+			const FVoxelPromise Promise;
+
+			FVoxelFuture Future = Promise;
+			for (int32 Index = 0; Index < 100; Index++)
+			{
+				Future = Future.Then_AnyThread([]
+				{
+				});
+			}
+
+			Promise.Set();
+		}
+
+		OutNumHeapAllocations = GVoxelNumPromiseHeapAllocations.Get() - StartNumHeapAllocations;
+	};
+
+	int64 NumHeapAllocations = 0;
+	int64 NumPooledHeapAllocations = 0;
+
+	RunBenchmark<1000000>(
+		"Chaining 1M promises without pooling",
+		[&]
+		{
+			ChainPromises(false, NumHeapAllocations);
+		},
+		"Chaining 1M promises with pooling",
+		[&]
+		{
+			ChainPromises(true, NumPooledHeapAllocations);
+		},
+		"Timings are per continuation. Both modes use the intrusive refcount: this only measures the free lists, not the previous MakeShared/MakeUnique path");
+
+	LOG("Promise heap allocations per continuation: %.3f without pooling, %.3f with pooling",
+		NumHeapAllocations / 1000000.,
+		NumPooledHeapAllocations / 1000000.);
+
+	GVoxelPoolPromises = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Read-mostly cache workload: 1 in 16 operations is a FindOrAdd, the others are lookups
+// Half the keys are added in Initialize, the other half by the first FindOrAdds
+// Timings are per operation of a single thread, so perfect scaling keeps them constant
+CUSTOM_BENCHMARK
+{
+	constexpr int32 NumKeys = 1 << 16;
+	constexpr int32 NumOperationsPerThread = 100000;
+
+	const auto RunOnThreads = [](const int32 NumThreads, const TFunctionRef<uint32(int32 ThreadIndex)> Lambda)
+	{
+		TVoxelAtomic<uint32> Sum;
+		TVoxelArray<TUniquePtr<FThread>> Threads;
+
+		for (int32 ThreadIndex = 0; ThreadIndex < NumThreads; ThreadIndex++)
+		{
+			Threads.Add(MakeUnique<FThread>(TEXT("VoxelCoreBenchmark"), [&Sum, &Lambda, ThreadIndex]
+			{
+				Sum.Add(Lambda(ThreadIndex));
+			}));
+		}
+
+		for (const TUniquePtr<FThread>& Thread : Threads)
+		{
+			Thread->Join();
+		}
+
+		return Sum.Get();
+	};
+
+	const auto RunWorkload = [&](const int32 ThreadIndex, const auto& Find, const auto& FindOrAdd)
+	{
+		uint32 Sum = 0;
+		for (int32 Operation = 0; Operation < NumOperationsPerThread; Operation++)
+		{
+			const uint32 Hash = FVoxelUtilities::MurmurHash32(ThreadIndex * NumOperationsPerThread + Operation);
+			const int32 Key = Hash % NumKeys;
+
+			if (Hash % 16 == 0)
+			{
+				Sum += FindOrAdd(Key);
+			}
+			else
+			{
+				Sum += Find(Key);
+			}
+		}
+		return Sum;
+	};
+
+	TVoxelMap<int32, int32> LockedMap;
+	FVoxelCriticalSection CriticalSection;
+
+	TVoxelMap<int32, int32> SharedLockedMap;
+	FVoxelSharedCriticalSection SharedCriticalSection;
+
+	TVoxelConcurrentMap<int32, int32> ConcurrentMap;
+
+	const auto InitializeLockedMap = [&](TVoxelMap<int32, int32>& Map)
+	{
+		Map.Empty();
+		Map.Reserve(NumKeys);
+
+		for (int32 Key = 0; Key < NumKeys; Key += 2)
+		{
+			Map.Add_CheckNew(Key, Key);
+		}
+	};
+	const auto InitializeConcurrentMap = [&]
+	{
+		ConcurrentMap.Empty();
+
+		for (int32 Key = 0; Key < NumKeys; Key += 2)
+		{
+			ConcurrentMap.FindOrAdd(Key, [&] { return Key; });
+		}
+	};
+
+	const auto RunLocked = [&](const int32 NumThreads)
+	{
+		RunOnThreads(NumThreads, [&](const int32 ThreadIndex)
+		{
+			return RunWorkload(
+				ThreadIndex,
+				[&](const int32 Key)
+				{
+					VOXEL_SCOPE_LOCK(CriticalSection);
+					return LockedMap.FindRef(Key);
+				},
+				[&](const int32 Key)
+				{
+					VOXEL_SCOPE_LOCK(CriticalSection);
+					return LockedMap.FindOrAdd(Key) = Key;
+				});
+		});
+	};
+	const auto RunSharedLocked = [&](const int32 NumThreads)
+	{
+		RunOnThreads(NumThreads, [&](const int32 ThreadIndex)
+		{
+			return RunWorkload(
+				ThreadIndex,
+				[&](const int32 Key)
+				{
+					VOXEL_SCOPE_READ_LOCK(SharedCriticalSection);
+					return SharedLockedMap.FindRef(Key);
+				},
+				[&](const int32 Key)
+				{
+					{
+						VOXEL_SCOPE_READ_LOCK(SharedCriticalSection);
+
+						if (const int32* Value = SharedLockedMap.Find(Key))
+						{
+							return *Value;
+						}
+					}
+
+					VOXEL_SCOPE_WRITE_LOCK(SharedCriticalSection);
+					return SharedLockedMap.FindOrAdd(Key) = Key;
+				});
+		});
+	};
+	const auto RunConcurrent = [&](const int32 NumThreads)
+	{
+		RunOnThreads(NumThreads, [&](const int32 ThreadIndex)
+		{
+			return RunWorkload(
+				ThreadIndex,
+				[&](const int32 Key)
+				{
+					const int32* Value = ConcurrentMap.Find(Key);
+					return Value ? *Value : 0;
+				},
+				[&](const int32 Key)
+				{
+					return ConcurrentMap.FindOrAdd(Key, [&] { return Key; });
+				});
+		});
+	};
+
+	for (const int32 NumThreads : { 1, 2, 4, 8, 16, 32, 64 })
+	{
+		RunBenchmark<NumOperationsPerThread>(
+			FString::Printf(TEXT("TVoxelMap + FVoxelCriticalSection, %d threads"), NumThreads),
+			[&]
+			{
+				InitializeLockedMap(LockedMap);
+			},
+			[&]
+			{
+				RunLocked(NumThreads);
+			},
+			FString::Printf(TEXT("TVoxelConcurrentMap, %d threads"), NumThreads),
+			[&]
+			{
+				InitializeConcurrentMap();
+			},
+			[&]
+			{
+				RunConcurrent(NumThreads);
+			});
+
+		RunBenchmark<NumOperationsPerThread>(
+			FString::Printf(TEXT("TVoxelMap + FVoxelSharedCriticalSection, %d threads"), NumThreads),
+			[&]
+			{
+				InitializeLockedMap(SharedLockedMap);
+			},
+			[&]
+			{
+				RunSharedLocked(NumThreads);
+			},
+			FString::Printf(TEXT("TVoxelConcurrentMap, %d threads"), NumThreads),
+			[&]
+			{
+				InitializeConcurrentMap();
+			},
+			[&]
+			{
+				RunConcurrent(NumThreads);
+			});
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+CUSTOM_BENCHMARK
+{
+	// Foliage-like distribution: small instances, clustered around a few points
+	TVoxelArray<FVoxelAABBTree::FElement> Elements;
+	{
+		FRandomStream Stream;
+		Stream.Initialize(1337);
+
+		TVoxelArray<FVector> Clusters;
+		for (int32 Index = 0; Index < 256; Index++)
+		{
+			Clusters.Add(FVector(Stream.FRandRange(-100000, 100000), Stream.FRandRange(-100000, 100000), Stream.FRandRange(-1000, 1000)));
+		}
+
+		Elements.Reserve(500000);
+		for (int32 Index = 0; Index < 500000; Index++)
+		{
+			const FVector Center = Clusters[Stream.RandHelper(Clusters.Num())] + Stream.GetUnitVector() * Stream.FRandRange(0, 5000);
+			const FVector Extent = FVector(Stream.FRandRange(10, 200));
+
+			Elements.Add(FVoxelAABBTree::FElement
+			{
+				FVoxelBox(Center - Extent, Center + Extent),
+				Index
+			});
+		}
+	}
+
+	TVoxelArray<FVector> RayOrigins;
+	TVoxelArray<FVector> RayDirections;
+	TVoxelArray<FVoxelBox> Queries;
+	{
+		FRandomStream Stream;
+		Stream.Initialize(42);
+
+		for (int32 Index = 0; Index < 10000; Index++)
+		{
+			const FVector Position = Elements[Stream.RandHelper(Elements.Num())].Bounds.GetCenter();
+
+			RayOrigins.Add(Position + FVector(0, 0, 10000));
+			RayDirections.Add((FVector(Stream.FRandRange(-0.2f, 0.2f), Stream.FRandRange(-0.2f, 0.2f), -1)).GetSafeNormal());
+			Queries.Add(FVoxelBox(Position).Extend(Stream.FRandRange(100, 1000)));
+		}
+	}
+
+	TUniquePtr<FVoxelAABBTree> MeanSplitTree;
+	TUniquePtr<FVoxelAABBTree> SAHTree;
+
+	RunBenchmark<1>(
+		"FVoxelAABBTree::Initialize(500k)",
+		[&]
+		{
+			MeanSplitTree = MakeUnique<FVoxelAABBTree>();
+		},
+		[&]
+		{
+			MeanSplitTree->Initialize(TVoxelArray<FVoxelAABBTree::FElement>(Elements));
+		},
+		"FVoxelAABBTree::InitializeSAH(500k)",
+		[&]
+		{
+			SAHTree = MakeUnique<FVoxelAABBTree>();
+		},
+		[&]
+		{
+			SAHTree->InitializeSAH(TVoxelArray<FVoxelAABBTree::FElement>(Elements));
+		},
+		"InitializeSAH partitions in place and builds subtrees in parallel");
+
+	uint32 NumHits = 0;
+
+	RunBenchmark<10000>(
+		"FVoxelAABBTree::Raycast (mean split)",
+		[&]
+		{
+			for (int32 Index = 0; Index < RayOrigins.Num(); Index++)
+			{
+				MeanSplitTree->Raycast(RayOrigins[Index], RayDirections[Index], [&](int32)
+				{
+					NumHits++;
+					return true;
+				});
+			}
+		},
+		"FVoxelAABBTree::Raycast (SAH)",
+		[&]
+		{
+			for (int32 Index = 0; Index < RayOrigins.Num(); Index++)
+			{
+				SAHTree->Raycast(RayOrigins[Index], RayDirections[Index], [&](int32)
+				{
+					NumHits++;
+					return true;
+				});
+			}
+		});
+
+	RunBenchmark<10000>(
+		"FVoxelAABBTree::Intersects (mean split)",
+		[&]
+		{
+			for (const FVoxelBox& Query : Queries)
+			{
+				NumHits += MeanSplitTree->Intersects(Query);
+			}
+		},
+		"FVoxelAABBTree::Intersects (SAH)",
+		[&]
+		{
+			for (const FVoxelBox& Query : Queries)
+			{
+				NumHits += SAHTree->Intersects(Query);
+			}
+		});
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+CUSTOM_BENCHMARK
+{
+	TVoxelArray<FVoxelBox> Bounds;
+	{
+		FRandomStream Stream;
+		Stream.Initialize(1337);
+
+		for (int32 Index = 0; Index < 100000; Index++)
+		{
+			const FVector Center = FVector(Stream.FRandRange(-10000, 10000), Stream.FRandRange(-10000, 10000), Stream.FRandRange(-100, 100));
+			Bounds.Add(FVoxelBox(Center).Extend(Stream.FRandRange(10, 100)));
+		}
+	}
+
+	const TSharedRef<FVoxelAABBTree> Tree = FVoxelAABBTree::Create(Bounds);
+
+	FVoxelFastAABBTree FastTree;
+	FastTree.Initialize(*Tree);
+
+	// AO-like: 64 rays per texel, all starting from the same point
+	TVoxelArray<FVector3f> RayPositions;
+	TVoxelArray<FVector3f> RayDirections;
+	{
+		FRandomStream Stream;
+		Stream.Initialize(42);
+
+		for (int32 Texel = 0; Texel < 1024; Texel++)
+		{
+			const FVector3f Position = FVector3f(Stream.FRandRange(-10000, 10000), Stream.FRandRange(-10000, 10000), 0);
+
+			for (int32 Index = 0; Index < 64; Index++)
+			{
+				FVector3f Direction = FVector3f(Stream.GetUnitVector());
+				Direction.Z = FMath::Abs(Direction.Z);
+
+				RayPositions.Add(Position);
+				RayDirections.Add(Direction);
+			}
+		}
+	}
+
+	uint32 NumHits = 0;
+
+	RunBenchmark<64 * 1024>(
+		"FVoxelAABBTree::Raycast",
+		[&]
+		{
+			for (int32 Index = 0; Index < RayPositions.Num(); Index++)
+			{
+				Tree->Raycast(FVector(RayPositions[Index]), FVector(RayDirections[Index]), [&](int32)
+				{
+					NumHits++;
+					return true;
+				});
+			}
+		},
+		"FVoxelFastAABBTree::RaycastPackets",
+		[&]
+		{
+			FastTree.RaycastPackets(RayPositions, RayDirections, [&](const TConstVoxelArrayView<int32> RayIndices, TConstVoxelArrayView<int32>)
+			{
+				NumHits += RayIndices.Num();
+			});
+		},
+		"Rays are traced in packets of 4 or 8 with ISPC, sharing a single traversal stack");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+CUSTOM_BENCHMARK
+{
+	// Marching-cubes-like chunk: cells are scanned row by row and emit unshared triangles,
+	// here for a floor and a cave ceiling so that input order interleaves two surfaces
+	TVoxelArray<FVector3f> Positions;
+	TVoxelArray<FVoxelOctahedron> Normals;
+	{
+		FRandomStream Stream;
+		Stream.Initialize(1337);
+
+		constexpr int32 Size = 64;
+
+		TVoxelArray<float> Heights;
+		for (int32 Index = 0; Index < 2 * FMath::Square(Size + 1); Index++)
+		{
+			Heights.Add(Stream.FRandRange(0, 2));
+		}
+
+		const auto GetPosition = [&](const int32 Layer, const int32 X, const int32 Y)
+		{
+			const float Height = Heights[Layer * FMath::Square(Size + 1) + X + Y * (Size + 1)];
+			return FVector3f(X, Y, Layer * 20 + Height);
+		};
+
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			for (int32 X = 0; X < Size; X++)
+			{
+				for (int32 Layer = 0; Layer < 2; Layer++)
+				{
+					const FVector3f A = GetPosition(Layer, X, Y);
+					const FVector3f B = GetPosition(Layer, X + 1, Y);
+					const FVector3f C = GetPosition(Layer, X, Y + 1);
+					const FVector3f D = GetPosition(Layer, X + 1, Y + 1);
+
+					for (const FVector3f& Position : { A, B, C, B, D, C })
+					{
+						Positions.Add(Position);
+						Normals.Add(FVoxelOctahedron(FVector3f(0, 0, Layer == 0 ? 1 : -1)));
+					}
+				}
+			}
+		}
+	}
+
+	const int32 NumTriangles = Positions.Num() / 3;
+
+	TUniquePtr<FStaticMeshRenderData> RenderDatas[2];
+	TVoxelArray<int32> SourceVertexIndices[2];
+
+	const auto Build = [&](const bool bSpatialClustering)
+	{
+		FVoxelNaniteBuilder Builder;
+		Builder.Mesh.Positions = Positions;
+		Builder.Mesh.Normals = Normals;
+		Builder.bSpatialClustering = bSpatialClustering;
+
+		TVoxelArray<int32> VertexOffsets;
+		RenderDatas[bSpatialClustering] = Builder.CreateRenderData(VertexOffsets, SourceVertexIndices[bSpatialClustering]);
+	};
+
+	RunBenchmark<1>(
+		"FVoxelNaniteBuilder (input order)",
+		[&]
+		{
+			Build(false);
+		},
+		"FVoxelNaniteBuilder (spatial clustering)",
+		[&]
+		{
+			Build(true);
+		},
+		"Spatial clustering welds vertices to grow clusters over adjacent triangles");
+
+	for (const bool bSpatialClustering : { false, true })
+	{
+		const Nanite::FResources& Resources = *RenderDatas[bSpatialClustering]->NaniteResourcesPtr;
+
+		// Clusters are consecutive runs of at most 85 triangles, measure how compact they are
+		double SumClusterDiagonal = 0;
+		int32 NumClusters = 0;
+		for (int32 Index = 0; Index < SourceVertexIndices[bSpatialClustering].Num(); Index += 3 * 85)
+		{
+			const int32 Num = FMath::Min(3 * 85, SourceVertexIndices[bSpatialClustering].Num() - Index);
+
+			FVoxelBox ClusterBounds = FVoxelBox::InvertedInfinite;
+			for (const int32 VertexIndex : SourceVertexIndices[bSpatialClustering].Slice(Index, Num))
+			{
+				ClusterBounds += FVector(Positions[VertexIndex]);
+			}
+
+			SumClusterDiagonal += ClusterBounds.Size().Length();
+			NumClusters++;
+		}
+
+		LOG("%s: %d pages, %.1f bytes per triangle, average cluster diagonal %.1f",
+			bSpatialClustering ? TEXT("Spatial clustering") : TEXT("Input order"),
+			Resources.NumRootPages,
+			double(Resources.RootData.Num()) / NumTriangles,
+			SumClusterDiagonal / NumClusters);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+CUSTOM_BENCHMARK
+{
+	// Streaming-like workload: many small chunks built at once
+	constexpr int32 NumChunks = 256;
+	constexpr int32 Size = 32;
+
+	TVoxelArray<TVoxelArray<FVector3f>> AllPositions;
+	TVoxelArray<TVoxelArray<FVoxelOctahedron>> AllNormals;
+	TVoxelArray<FVoxelNaniteBuilder::FMesh> Meshes;
+	{
+		FRandomStream Stream;
+		Stream.Initialize(1337);
+
+		AllPositions.SetNum(NumChunks);
+		AllNormals.SetNum(NumChunks);
+
+		for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+		{
+			const FVector3f Offset = FVector3f(ChunkIndex % 16, ChunkIndex / 16, 0) * Size;
+
+			for (int32 Y = 0; Y < Size; Y++)
+			{
+				for (int32 X = 0; X < Size; X++)
+				{
+					const FVector3f A = Offset + FVector3f(X, Y, Stream.FRandRange(0, 2));
+					const FVector3f B = Offset + FVector3f(X + 1, Y, Stream.FRandRange(0, 2));
+					const FVector3f C = Offset + FVector3f(X, Y + 1, Stream.FRandRange(0, 2));
+					const FVector3f D = Offset + FVector3f(X + 1, Y + 1, Stream.FRandRange(0, 2));
+
+					for (const FVector3f& Position : { A, B, C, B, D, C })
+					{
+						AllPositions[ChunkIndex].Add(Position);
+						AllNormals[ChunkIndex].Add(FVoxelOctahedron(FVector3f(0, 0, 1)));
+					}
+				}
+			}
+
+			FVoxelNaniteBuilder::FMesh& Mesh = Meshes.Emplace_GetRef();
+			Mesh.Positions = AllPositions[ChunkIndex];
+			Mesh.Normals = AllNormals[ChunkIndex];
+		}
+	}
+
+	const FVoxelNaniteBuilder Builder;
+
+	TVoxelArray<TUniquePtr<FStaticMeshRenderData>> SerialRenderDatas;
+	TVoxelArray<TUniquePtr<FStaticMeshRenderData>> BatchRenderDatas;
+
+	RunBenchmark<1>(
+		"FVoxelNaniteBuilder::CreateRenderData (one by one)",
+		[&]
+		{
+			SerialRenderDatas.Reset();
+
+			for (const FVoxelNaniteBuilder::FMesh& Mesh : Meshes)
+			{
+				FVoxelNaniteBuilder MeshBuilder = Builder;
+				MeshBuilder.Mesh = Mesh;
+
+				TVoxelArray<int32> VertexOffsets;
+				SerialRenderDatas.Add(MeshBuilder.CreateRenderData(VertexOffsets));
+			}
+		},
+		"FVoxelNaniteBuilder::CreateRenderDataBatch",
+		[&]
+		{
+			TVoxelArray<TVoxelArray<int32>> VertexOffsets;
+			BatchRenderDatas = Builder.CreateRenderDataBatch(Meshes, VertexOffsets);
+		},
+		"Batch builds meshes in parallel and reuses cluster & page buffers");
+
+	int32 NumMismatches = 0;
+	for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+	{
+		if (SerialRenderDatas[ChunkIndex]->NaniteResourcesPtr->RootData != BatchRenderDatas[ChunkIndex]->NaniteResourcesPtr->RootData)
+		{
+			NumMismatches++;
+		}
+	}
+	LOG("%d chunks, %d with different root data", NumChunks, NumMismatches);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+CUSTOM_BENCHMARK
+{
+	// Continuous sculpting on a large collision chunk: a few rows of vertices move every frame
+	constexpr int32 Size = 316;
+	constexpr int32 NumSteps = 16;
+	constexpr int32 NumSculptedRows = 4;
+
+	TVoxelArray<FVector3f> Vertices;
+	TVoxelArray<int32> Indices;
+
+	for (int32 Y = 0; Y <= Size; Y++)
+	{
+		for (int32 X = 0; X <= Size; X++)
+		{
+			Vertices.Add(FVector3f(X, Y, 0));
+		}
+	}
+
+	for (int32 Y = 0; Y < Size; Y++)
+	{
+		for (int32 X = 0; X < Size; X++)
+		{
+			const int32 A = (X + 0) + (Y + 0) * (Size + 1);
+			const int32 B = (X + 1) + (Y + 0) * (Size + 1);
+			const int32 C = (X + 0) + (Y + 1) * (Size + 1);
+			const int32 D = (X + 1) + (Y + 1) * (Size + 1);
+
+			Indices.Append({ A, B, C, B, D, C });
+		}
+	}
+
+	LOG("%d triangles", Indices.Num() / 3);
+
+	const auto Sculpt = [&](const int32 Step, int32& OutChangedTrianglesStart, int32& OutNumChangedTriangles)
+	{
+		const int32 StartRow = 1 + (Step * 7) % (Size - NumSculptedRows - 1);
+
+		for (int32 Y = StartRow; Y < StartRow + NumSculptedRows; Y++)
+		{
+			for (int32 X = 0; X <= Size; X++)
+			{
+				Vertices[X + Y * (Size + 1)].Z += 0.1f;
+			}
+		}
+
+		// Quads on both sides of the moved vertices changed
+		OutChangedTrianglesStart = 2 * Size * (StartRow - 1);
+		OutNumChangedTriangles = 2 * Size * (NumSculptedRows + 1);
+	};
+
+	FVoxelChaosTriangleMeshCooker::FUpdatableMesh Mesh;
+
+	RunBenchmark<NumSteps>(
+		"FVoxelChaosTriangleMeshCooker::Create",
+		nullptr,
+		[&]
+		{
+			for (int32 Step = 0; Step < NumSteps; Step++)
+			{
+				int32 ChangedTrianglesStart;
+				int32 NumChangedTriangles;
+				Sculpt(Step, ChangedTrianglesStart, NumChangedTriangles);
+
+				FVoxelChaosTriangleMeshCooker::Create(Indices, Vertices, {});
+			}
+		},
+		"FVoxelChaosTriangleMeshCooker::Update",
+		[&]
+		{
+			Mesh = FVoxelChaosTriangleMeshCooker::CreateUpdatable(Indices, Vertices, {});
+		},
+		[&]
+		{
+			for (int32 Step = 0; Step < NumSteps; Step++)
+			{
+				int32 ChangedTrianglesStart;
+				int32 NumChangedTriangles;
+				Sculpt(Step, ChangedTrianglesStart, NumChangedTriangles);
+
+				Mesh = FVoxelChaosTriangleMeshCooker::Update(
+					MoveTemp(Mesh),
+					Indices,
+					Vertices,
+					{},
+					ChangedTrianglesStart,
+					NumChangedTriangles);
+			}
+		},
+		"Update refits the previous BVH instead of building a new one");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+CUSTOM_BENCHMARK
+{
+	// Building an AoS BVH like Chaos's from FVoxelFastAABBTree, with and without the intermediate tree
+	constexpr int32 NumElements = 200000;
+	constexpr int32 MaxChildrenInLeaf = 22;
+	constexpr int32 MaxTreeDepth = 32;
+
+	struct FDestElement
+	{
+		int32 Payload;
+		FVector3f Min;
+		FVector3f Max;
+	};
+	struct FDestNode
+	{
+		int32 ChildIndex0 = -1;
+		int32 ChildIndex1 = -1;
+		FVector3f ChildBounds0_Min;
+		FVector3f ChildBounds0_Max;
+		FVector3f ChildBounds1_Min;
+		FVector3f ChildBounds1_Max;
+		bool bLeaf = false;
+	};
+
+	FVoxelFastAABBTree::FElementArray SourceElements;
+	SourceElements.SetNum(NumElements);
+	{
+		FRandomStream Stream;
+		for (int32 Index = 0; Index < NumElements; Index++)
+		{
+			const FVector3f Min = FVector3f(
+				Stream.FRandRange(-10000.f, 10000.f),
+				Stream.FRandRange(-10000.f, 10000.f),
+				Stream.FRandRange(-10000.f, 10000.f));
+
+			const FVector3f Max = Min + FVector3f(
+				Stream.FRandRange(0.f, 100.f),
+				Stream.FRandRange(0.f, 100.f),
+				Stream.FRandRange(0.f, 100.f));
+
+			SourceElements.Payload[Index] = Index;
+			SourceElements.MinX[Index] = Min.X;
+			SourceElements.MinY[Index] = Min.Y;
+			SourceElements.MinZ[Index] = Min.Z;
+			SourceElements.MaxX[Index] = Max.X;
+			SourceElements.MaxY[Index] = Max.Y;
+			SourceElements.MaxZ[Index] = Max.Z;
+		}
+	}
+
+	const auto CopyLeaf = [](const FVoxelFastAABBTree::FElementArrayView& Elements, TVoxelArray<FDestElement>& OutLeaf)
+	{
+		FVoxelUtilities::SetNumFast(OutLeaf, Elements.Num());
+
+		for (int32 Index = 0; Index < Elements.Num(); Index++)
+		{
+			OutLeaf[Index].Payload = Elements.Payload[Index];
+			OutLeaf[Index].Min = FVector3f(Elements.MinX[Index], Elements.MinY[Index], Elements.MinZ[Index]);
+			OutLeaf[Index].Max = FVector3f(Elements.MaxX[Index], Elements.MaxY[Index], Elements.MaxZ[Index]);
+		}
+	};
+
+	class FWriter : public FVoxelFastAABBTree::IBuildWriter
+	{
+	public:
+		TVoxelArray<FDestNode> Nodes;
+		TVoxelArray<TVoxelArray<FDestElement>> Leaves;
+		TFunction<void(const FVoxelFastAABBTree::FElementArrayView&, TVoxelArray<FDestElement>&)> CopyLeaf;
+
+		virtual void Reserve(const int32 ExpectedNumNodes, const int32 ExpectedNumLeaves) override
+		{
+			Nodes.Reserve(ExpectedNumNodes);
+			Leaves.Reserve(ExpectedNumLeaves);
+		}
+		virtual void SetLeaf(const int32 NodeIndex, const FVoxelFastAABBTree::FElementArrayView& Elements) override
+		{
+			FDestNode& Node = GetNode(NodeIndex);
+			Node.bLeaf = true;
+			Node.ChildIndex0 = Leaves.Num();
+			CopyLeaf(Elements, Leaves.Emplace_GetRef());
+		}
+		virtual void SetInnerNode(
+			const int32 NodeIndex,
+			const int32 ChildIndex0,
+			const FVector3f& ChildBounds0_Min,
+			const FVector3f& ChildBounds0_Max,
+			const int32 ChildIndex1,
+			const FVector3f& ChildBounds1_Min,
+			const FVector3f& ChildBounds1_Max) override
+		{
+			FDestNode& Node = GetNode(NodeIndex);
+			Node.ChildIndex0 = ChildIndex0;
+			Node.ChildIndex1 = ChildIndex1;
+			Node.ChildBounds0_Min = ChildBounds0_Min;
+			Node.ChildBounds0_Max = ChildBounds0_Max;
+			Node.ChildBounds1_Min = ChildBounds1_Min;
+			Node.ChildBounds1_Max = ChildBounds1_Max;
+		}
+
+	private:
+		FDestNode& GetNode(const int32 NodeIndex)
+		{
+			if (Nodes.Num() <= NodeIndex)
+			{
+				Nodes.SetNum(NodeIndex + 1);
+			}
+			return Nodes[NodeIndex];
+		}
+	};
+
+	{
+		FVoxelFastAABBTree Tree(MaxChildrenInLeaf, MaxTreeDepth);
+		Tree.Initialize(CopyTemp(SourceElements));
+
+		const int64 IntermediateSize =
+			Tree.GetNodes().Num() * sizeof(FVoxelFastAABBTree::FNode) +
+			Tree.GetLeaves().Num() * sizeof(FVoxelFastAABBTree::FLeaf);
+
+		LOG("%d nodes, %d leaves. Intermediate FNode/FLeaf arrays: %lldB, none with Build + writer",
+			Tree.GetNodes().Num(),
+			Tree.GetLeaves().Num(),
+			IntermediateSize);
+	}
+
+	FVoxelFastAABBTree::FElementArray Elements;
+	TVoxelArray<FDestNode> Nodes;
+	TVoxelArray<TVoxelArray<FDestElement>> Leaves;
+
+	RunBenchmark<1>(
+		"Initialize + copy",
+		[&]
+		{
+			Elements = SourceElements;
+			Nodes.Reset();
+			Leaves.Reset();
+		},
+		[&]
+		{
+			FVoxelFastAABBTree Tree(MaxChildrenInLeaf, MaxTreeDepth);
+			Tree.Initialize(MoveTemp(Elements));
+
+			FVoxelUtilities::SetNum(Nodes, Tree.GetNodes().Num());
+			FVoxelUtilities::SetNum(Leaves, Tree.GetLeaves().Num());
+
+			for (int32 Index = 0; Index < Nodes.Num(); Index++)
+			{
+				const FVoxelFastAABBTree::FNode& SrcNode = Tree.GetNodes()[Index];
+				FDestNode& DestNode = Nodes[Index];
+
+				DestNode.bLeaf = SrcNode.bLeaf;
+				if (SrcNode.bLeaf)
+				{
+					DestNode.ChildIndex0 = SrcNode.LeafIndex;
+					continue;
+				}
+
+				DestNode.ChildIndex0 = SrcNode.ChildIndex0;
+				DestNode.ChildIndex1 = SrcNode.ChildIndex1;
+				DestNode.ChildBounds0_Min = SrcNode.ChildBounds0_Min;
+				DestNode.ChildBounds0_Max = SrcNode.ChildBounds0_Max;
+				DestNode.ChildBounds1_Min = SrcNode.ChildBounds1_Min;
+				DestNode.ChildBounds1_Max = SrcNode.ChildBounds1_Max;
+			}
+
+			for (int32 Index = 0; Index < Leaves.Num(); Index++)
+			{
+				CopyLeaf(Tree.GetLeaves()[Index].Elements, Leaves[Index]);
+			}
+		},
+		"Build + writer",
+		[&]
+		{
+			Elements = SourceElements;
+		},
+		[&]
+		{
+			FVoxelFastAABBTree::FElementArrayView View;
+			View.Payload = Elements.Payload;
+			View.MinX = Elements.MinX;
+			View.MinY = Elements.MinY;
+			View.MinZ = Elements.MinZ;
+			View.MaxX = Elements.MaxX;
+			View.MaxY = Elements.MaxY;
+			View.MaxZ = Elements.MaxZ;
+
+			FWriter Writer;
+			Writer.CopyLeaf = CopyLeaf;
+			FVoxelFastAABBTree::Build(View, MaxChildrenInLeaf, MaxTreeDepth, Writer);
+		},
+		"Build + writer skips the intermediate FNode/FLeaf arrays and the second pass over them");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+CUSTOM_BENCHMARK
+{
+	// Loading a save made of many Oodle-compressed chunks from a file on disk
+	constexpr int32 NumChunks = 4096;
+	constexpr int32 ChunkSize = 64 * 1024;
+
+	const FString Filename = FPaths::ProjectIntermediateDir() / "VoxelZipReaderBenchmark.zip";
+
+	TVoxelArray<FString> Paths;
+	{
+		TVoxelArray<TVoxelArray64<uint8>> Chunks;
+		TVoxelArray<FVoxelZipWriter::FBatchEntry> BatchEntries;
+
+		FRandomStream Stream;
+		for (int32 Index = 0; Index < NumChunks; Index++)
+		{
+			TVoxelArray64<uint8>& Chunk = Chunks.Emplace_GetRef();
+			FVoxelUtilities::SetNumFast(Chunk, ChunkSize);
+
+			// Compressible but not trivially so
+			for (int64 ByteIndex = 0; ByteIndex < ChunkSize; ByteIndex++)
+			{
+				Chunk[ByteIndex] = Stream.RandHelper(16);
+			}
+
+			Paths.Add(FString::Printf(TEXT("Chunks/%d.bin"), Index));
+
+			FVoxelZipWriter::FBatchEntry& BatchEntry = BatchEntries.Emplace_GetRef();
+			BatchEntry.Path = Paths.Last();
+			BatchEntry.Data = Chunk;
+		}
+
+		TVoxelArray64<uint8> ZipData;
+		const TSharedRef<FVoxelZipWriter> ZipWriter = FVoxelZipWriter::Create(ZipData);
+		ZipWriter->WriteBatch(BatchEntries);
+		check(ZipWriter->Finalize());
+
+		check(FFileHelper::SaveArrayToFile(ZipData, *Filename));
+
+		LOG("%d chunks, %lldB archive", NumChunks, ZipData.Num());
+	}
+
+	const TUniquePtr<IFileHandle> FileHandle(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+	check(FileHandle);
+
+	FVoxelCriticalSection CriticalSection;
+	int32 NumReads = 0;
+
+	const TSharedPtr<FVoxelZipReader> ZipReader = FVoxelZipReader::Create(
+		FileHandle->Size(),
+		[&](const int64 Offset, const TVoxelArrayView64<uint8> OutData)
+		{
+			VOXEL_SCOPE_LOCK(CriticalSection);
+
+			NumReads++;
+			return
+				FileHandle->Seek(Offset) &&
+				FileHandle->Read(OutData.GetData(), OutData.Num());
+		});
+	check(ZipReader);
+
+	RunBenchmark<1>(
+		"TryLoad",
+		[&]
+		{
+			NumReads = 0;
+		},
+		[&]
+		{
+			for (const FString& Path : Paths)
+			{
+				TVoxelArray64<uint8> Data;
+				check(ZipReader->TryLoad(Path, Data));
+				check(Data.Num() == ChunkSize);
+			}
+		},
+		"LoadAsync",
+		nullptr,
+		[&]
+		{
+			FVoxelTaskContext Context(false, false);
+			{
+				FVoxelTaskScope Scope(Context);
+
+				for (const TVoxelFuture<TSharedPtr<TVoxelArray64<uint8>>>& Future : ZipReader->LoadAsync(Paths))
+				{
+					Future.Then_AsyncThread([](const TSharedPtr<TVoxelArray64<uint8>>& Data)
+					{
+						check(Data && Data->Num() == ChunkSize);
+					});
+				}
+			}
+			Context.FlushTasks();
+		},
+		"LoadAsync coalesces adjacent entries into large sequential reads and decompresses them in parallel");
+
+	LOG("%d ReadLambda calls during the last LoadAsync + TryLoad run", NumReads);
+
+	IFileManager::Get().Delete(*Filename);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+CUSTOM_BENCHMARK
+{
+	// SDF rebuild after an edit: two spheres, distances only known in a narrow band around the surface
+	for (const int32 Size : { 128, 512 })
+	{
+		const FIntVector Size3D(Size);
+		const FVector3f CenterA = FVector3f(0.3f * Size);
+		const FVector3f CenterB = FVector3f(0.7f * Size);
+		const float Radius = 0.15f * Size;
+
+		const auto GetExactDistance = [&](const int32 X, const int32 Y, const int32 Z)
+		{
+			return FMath::Min(
+				FVector3f::Distance(FVector3f(X, Y, Z), CenterA) - Radius,
+				FVector3f::Distance(FVector3f(X, Y, Z), CenterB) - Radius);
+		};
+
+		TVoxelArray<float> SourceDistances;
+		FVoxelUtilities::SetNumFast(SourceDistances, Size * Size * Size);
+
+		ParallelFor(Size, [&](const int32 Z)
+		{
+			for (int32 Y = 0; Y < Size; Y++)
+			{
+				for (int32 X = 0; X < Size; X++)
+				{
+					const float Distance = GetExactDistance(X, Y, Z);
+					SourceDistances[FVoxelUtilities::Get3DIndex<int32>(Size3D, X, Y, Z)] = FMath::Abs(Distance) < 2.f ? Distance : FVoxelUtilities::NaNf();
+				}
+			}
+		});
+
+		TVoxelArray<float> DistancesA;
+		TVoxelArray<float> DistancesB;
+
+		RunBenchmark<1>(
+			FString::Printf(TEXT("JumpFlood %d^3"), Size),
+			[&]
+			{
+				DistancesA = SourceDistances;
+			},
+			[&]
+			{
+				FVoxelUtilities::JumpFlood(Size3D, DistancesA);
+			},
+			FString::Printf(TEXT("EuclideanDistanceTransform %d^3"), Size),
+			[&]
+			{
+				DistancesB = SourceDistances;
+			},
+			[&]
+			{
+				FVoxelUtilities::EuclideanDistanceTransform(Size3D, DistancesB);
+			});
+
+		float MaxErrorA = 0.f;
+		float MaxErrorB = 0.f;
+		for (int32 Z = 0; Z < Size; Z++)
+		{
+			for (int32 Y = 0; Y < Size; Y++)
+			{
+				for (int32 X = 0; X < Size; X++)
+				{
+					const int32 Index = FVoxelUtilities::Get3DIndex<int32>(Size3D, X, Y, Z);
+					const float ExactDistance = GetExactDistance(X, Y, Z);
+
+					MaxErrorA = FMath::Max(MaxErrorA, FMath::Abs(DistancesA[Index] - ExactDistance));
+					MaxErrorB = FMath::Max(MaxErrorB, FMath::Abs(DistancesB[Index] - ExactDistance));
+				}
+			}
+		}
+
+		// Closest point buffers only: per-task line & plane buffers of the transform are negligible
+		const int64 Num = int64(Size) * Size * Size;
+		LOG("%d^3: JumpFlood scratch %lldMB, max error %f. EuclideanDistanceTransform scratch %lldMB, max error %f",
+			Size,
+			6 * Num * sizeof(float) / (1024 * 1024),
+			MaxErrorA,
+			3 * Num * sizeof(float) / (1024 * 1024),
+			MaxErrorB);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+CUSTOM_BENCHMARK
+{
+	// Heightmap-derived distance field: sparse seeds, everything else invalid
+	// Smaller than a real 8k tile so that 100 runs of the scalar version stay reasonable
+	const FIntPoint Size(2048, 2048);
+
+	TVoxelArray<FIntPoint> SourcePositions;
+	FVoxelUtilities::SetNumFast(SourcePositions, Size.X * Size.Y);
+	{
+		FRandomStream Stream;
+		for (int32 Y = 0; Y < Size.Y; Y++)
+		{
+			for (int32 X = 0; X < Size.X; X++)
+			{
+				SourcePositions[FVoxelUtilities::Get2DIndex<int32>(Size, X, Y)] = Stream.FRand() < 0.001f ? FIntPoint(X, Y) : FIntPoint(MAX_int32);
+			}
+		}
+	}
+
+	TVoxelArray<FIntPoint> PositionsA;
+	TVoxelArray<FIntPoint> PositionsB;
+
+	RunBenchmark<1>(
+		"JumpFlood2D_Reference",
+		[&]
+		{
+			PositionsA = SourcePositions;
+		},
+		[&]
+		{
+			FVoxelJumpFlood::JumpFlood2D_Reference(Size, PositionsA);
+		},
+		"JumpFlood2D",
+		[&]
+		{
+			PositionsB = SourcePositions;
+		},
+		[&]
+		{
+			FVoxelJumpFlood::JumpFlood2D(Size, PositionsB);
+		},
+		"JumpFlood2D runs rows in parallel through an ISPC kernel on SoA buffers");
+
+	check(PositionsA == PositionsB);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+CUSTOM_BENCHMARK
+{
+	const FIntVector Size(256, 256, 256);
+
+	// Noise at different fill ratios, and a solid sphere as a typical collider
+	for (const float FillRatio : { 0.05f, 0.5f, 0.95f, -1.f })
+	{
+		FVoxelBitArray SourceArray;
+		SourceArray.SetNumZeroed(Size.X * Size.Y * Size.Z);
+		{
+			FRandomStream Stream;
+			for (int32 Z = 0; Z < Size.Z; Z++)
+			{
+				for (int32 Y = 0; Y < Size.Y; Y++)
+				{
+					for (int32 X = 0; X < Size.X; X++)
+					{
+						SourceArray[FVoxelUtilities::Get3DIndex<int32>(Size, X, Y, Z)] =
+							FillRatio < 0.f
+							? FVector3f::Dist(FVector3f(X, Y, Z), FVector3f(Size / 2)) < 100.f
+							: Stream.GetFraction() < FillRatio;
+					}
+				}
+			}
+		}
+
+		const FString Name = FillRatio < 0.f
+			? "GreedyMeshing3D (sphere)"
+			: FString::Printf(TEXT("GreedyMeshing3D (%.0f%% fill)"), FillRatio * 100.f);
+
+		FVoxelBitArray Array;
+		TVoxelArray<FVoxelIntBox> BoxesA;
+		TVoxelArray<FVoxelIntBox> BoxesB;
+
+		RunBenchmark<1>(
+			Name,
+			[&]
+			{
+				Array = SourceArray;
+			},
+			[&]
+			{
+				BoxesA = Array.GreedyMeshing3D(Size);
+			},
+			"GreedyMeshing3D_Parallel",
+			nullptr,
+			[&]
+			{
+				BoxesB = SourceArray.GreedyMeshing3D_Parallel(Size);
+			},
+			"GreedyMeshing3D_Parallel scans whole uint64 words and meshes Z slabs in parallel. The input is left untouched, but each slab copies its part of it in padded words");
+
+		LOG("\t%d boxes vs %d boxes", BoxesA.Num(), BoxesB.Num());
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 }
 
 #undef RUN_BENCHMARK
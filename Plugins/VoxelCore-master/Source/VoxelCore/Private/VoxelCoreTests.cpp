@@ -1,6 +1,26 @@
 ﻿// Copyright Voxel Plugin SAS. All Rights Reserved.
 
 #include "VoxelMinimal.h"
+#include "VoxelNaniteDAG.h"
+#include "VoxelBlockCompressedData.h"
+#include "VoxelSparseJumpFlood.h"
+#include "VoxelCoroutine.h"
+
+TVoxelFuture<int32> VoxelCoreTests_AddOne(const TVoxelFuture<int32> Future)
+{
+	const int32 Value = *co_await Future;
+
+	co_await EVoxelFutureThread::AnyThread;
+
+	co_return Value + 1;
+}
+
+FVoxelFuture VoxelCoreTests_Wait(const FVoxelFuture Future, const TSharedRef<int32> Counter)
+{
+	co_await Future;
+
+	(*Counter)++;
+}
 
 VOXEL_RUN_ON_STARTUP_GAME()
 {
@@ -24,4 +44,332 @@ VOXEL_RUN_ON_STARTUP_GAME()
 		TVoxelSet<int32> Set2 = Set;
 		TVoxelSet<float> Set3 = TVoxelSet<float>(Set);
 	}
+
+	{
+		// Wavy heightfield, so that simplification has some error
+		const int32 Size = 64;
+
+		TVoxelArray<FVector3f> Positions;
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			for (int32 X = 0; X < Size; X++)
+			{
+				const auto GetPosition = [](const int32 PositionX, const int32 PositionY)
+				{
+					return FVector3f(PositionX, PositionY, 4.f * FMath::Sin(PositionX / 5.f) * FMath::Cos(PositionY / 7.f));
+				};
+
+				Positions.Add(GetPosition(X, Y));
+				Positions.Add(GetPosition(X + 1, Y));
+				Positions.Add(GetPosition(X + 1, Y + 1));
+
+				Positions.Add(GetPosition(X, Y));
+				Positions.Add(GetPosition(X + 1, Y + 1));
+				Positions.Add(GetPosition(X, Y + 1));
+			}
+		}
+
+		Voxel::Nanite::FClusterDAG DAG(Positions, {}, 128, EParallelForFlags::None);
+		DAG.BuildLODs();
+		DAG.CheckInvariants();
+
+		int32 NumRoots = 0;
+		for (const Voxel::Nanite::FLODGroup& Group : DAG.Groups)
+		{
+			if (Group.MaxParentLODError == MAX_flt)
+			{
+				NumRoots++;
+			}
+		}
+
+		check(DAG.Clusters.Num() > FMath::DivideAndRoundUp(2 * Size * Size, 128));
+		check(NumRoots < FMath::DivideAndRoundUp(2 * Size * Size, 128));
+	}
+
+	{
+		TVoxelArray64<uint8> Data;
+		FVoxelUtilities::SetNumFast(Data, 100000);
+
+		FRandomStream Stream(1337);
+		for (int64 Index = 0; Index < Data.Num(); Index++)
+		{
+			Data[Index] = Stream.RandHelper(8);
+		}
+
+		FVoxelWriter Writer;
+		FVoxelBlockCompressedData::Save(Writer, FVoxelBlockCompressedData::Compress(Data, 4096));
+
+		FVoxelReader Reader(Writer);
+		const TSharedPtr<FVoxelBlockCompressedData> CompressedData = FVoxelBlockCompressedData::Load(Reader, 4);
+		check(CompressedData);
+		check(Reader.IsAtEndWithoutError());
+		check(CompressedData->NumBlocks() == FMath::DivideAndRoundUp(100000, 4096));
+
+		for (int32 Iteration = 0; Iteration < 64; Iteration++)
+		{
+			const int32 Offset = Stream.RandRange(0, 100000 - 1);
+			const int32 Num = Stream.RandRange(0, FMath::Min(3 * 4096, 100000 - Offset));
+
+			TVoxelArray64<uint8> ReadData;
+			FVoxelUtilities::SetNumFast(ReadData, Num);
+			check(CompressedData->Read(Offset, ReadData));
+			check(FVoxelUtilities::Equal(ReadData, MakeVoxelArrayView(Data).Slice(Offset, Num)));
+		}
+
+		TVoxelArray64<uint8> DecompressedData;
+		check(CompressedData->Decompress(DecompressedData));
+		check(DecompressedData == Data);
+	}
+
+	{
+		// Plane at X = 10.5: seeds are exact, so the transform must be too
+		const FIntVector Size(24, 16, 8);
+
+		TVoxelArray<float> Distances;
+		for (int32 Z = 0; Z < Size.Z; Z++)
+		{
+			for (int32 Y = 0; Y < Size.Y; Y++)
+			{
+				for (int32 X = 0; X < Size.X; X++)
+				{
+					Distances.Add(X - 10.5f);
+				}
+			}
+		}
+
+		TVoxelArray<float> ClosestX;
+		TVoxelArray<float> ClosestY;
+		TVoxelArray<float> ClosestZ;
+		FVoxelUtilities::EuclideanDistanceTransform(Size, Distances, ClosestX, ClosestY, ClosestZ);
+
+		for (int32 Index = 0; Index < Distances.Num(); Index++)
+		{
+			const FIntVector Position = FVoxelUtilities::Break3DIndex(Size, Index);
+
+			check(FMath::IsNearlyEqual(Distances[Index], Position.X - 10.5f, 1.e-4f));
+			check(FMath::IsNearlyEqual(ClosestX[Index], 10.5f, 1.e-4f));
+			check(ClosestY[Index] == Position.Y);
+			check(ClosestZ[Index] == Position.Z);
+		}
+	}
+
+	{
+		// Plane at X = 10.5, then moved to X = 12.5 for 4 <= Y < 8: the update must match a full transform
+		const FIntVector Size(48, 16, 8);
+
+		const auto GetInput = [&](const bool bEdited)
+		{
+			TVoxelArray<float> Result;
+			for (int32 Z = 0; Z < Size.Z; Z++)
+			{
+				for (int32 Y = 0; Y < Size.Y; Y++)
+				{
+					for (int32 X = 0; X < Size.X; X++)
+					{
+						Result.Add(X - (bEdited && 4 <= Y && Y < 8 ? 12.5f : 10.5f));
+					}
+				}
+			}
+			return Result;
+		};
+
+		TVoxelArray<float> Distances = GetInput(false);
+		TVoxelArray<float> ClosestX;
+		TVoxelArray<float> ClosestY;
+		TVoxelArray<float> ClosestZ;
+		FVoxelUtilities::EuclideanDistanceTransform(Size, Distances, ClosestX, ClosestY, ClosestZ);
+
+		const TVoxelArray<float> InputDistances = GetInput(true);
+		float MaxDistance = FVoxelUtilities::GetAbsMaxSafe(Distances);
+
+		FVoxelUtilities::UpdateEuclideanDistanceTransform(
+			Size,
+			InputDistances,
+			FVoxelIntBox(FIntVector(0, 4, 0), FIntVector(Size.X, 8, Size.Z)),
+			Distances,
+			ClosestX,
+			ClosestY,
+			ClosestZ,
+			MaxDistance);
+
+		TVoxelArray<float> ExpectedDistances = InputDistances;
+		FVoxelUtilities::EuclideanDistanceTransform(Size, ExpectedDistances);
+
+		for (int32 Index = 0; Index < Distances.Num(); Index++)
+		{
+			check(FMath::IsNearlyEqual(Distances[Index], ExpectedDistances[Index], 1.e-4f));
+			check(FMath::Abs(Distances[Index]) <= MaxDistance);
+		}
+	}
+
+	{
+		// Wavy surface with a sphere moved inside the dirty box: seeds are sub-voxel along all axes
+		const FIntVector Size(96, 96, 12);
+
+		const auto GetInput = [&](const FVector3f& SphereCenter)
+		{
+			TVoxelArray<float> Result;
+			for (int32 Z = 0; Z < Size.Z; Z++)
+			{
+				for (int32 Y = 0; Y < Size.Y; Y++)
+				{
+					for (int32 X = 0; X < Size.X; X++)
+					{
+						const float SurfaceDistance = Z - (5.f + 2.f * FMath::Sin(X / 3.f) * FMath::Cos(Y / 4.f));
+						const float SphereDistance = FVector3f::Dist(FVector3f(X, Y, Z), SphereCenter) - 4.2f;
+
+						Result.Add(FMath::Min(SurfaceDistance, SphereDistance));
+					}
+				}
+			}
+			return Result;
+		};
+
+		TVoxelArray<float> Distances = GetInput(FVector3f(46.3f, 47.7f, 6.4f));
+		TVoxelArray<float> ClosestX;
+		TVoxelArray<float> ClosestY;
+		TVoxelArray<float> ClosestZ;
+		FVoxelUtilities::EuclideanDistanceTransform(Size, Distances, ClosestX, ClosestY, ClosestZ);
+
+		const TVoxelArray<float> InputDistances = GetInput(FVector3f(50.6f, 45.2f, 7.1f));
+		float MaxDistance = FVoxelUtilities::GetAbsMaxSafe(Distances);
+
+		// Only a part of the volume is solved
+		FVoxelUtilities::UpdateEuclideanDistanceTransform(
+			Size,
+			InputDistances,
+			FVoxelIntBox(FIntVector(41, 40, 1), FIntVector(56, 53, 12)),
+			Distances,
+			ClosestX,
+			ClosestY,
+			ClosestZ,
+			MaxDistance);
+
+		TVoxelArray<float> ExpectedDistances = InputDistances;
+		FVoxelUtilities::EuclideanDistanceTransform(Size, ExpectedDistances);
+
+		for (int32 Index = 0; Index < Distances.Num(); Index++)
+		{
+			check(FMath::IsNearlyEqual(Distances[Index], ExpectedDistances[Index], 1.e-4f));
+			check(FMath::Abs(Distances[Index]) <= MaxDistance);
+		}
+	}
+
+	{
+		// Plane at X = 10.5, only given in the bricks it crosses: band bricks on both sides are added & signed
+		FVoxelSparseJumpFlood::FBrickMap Bricks;
+		for (int32 Z = 0; Z < 2; Z++)
+		{
+			for (int32 Y = 0; Y < 2; Y++)
+			{
+				const TSharedRef<FVoxelSparseJumpFlood::FBrick> Brick = MakeShared<FVoxelSparseJumpFlood::FBrick>();
+				for (int32 Index = 0; Index < FVoxelSparseJumpFlood::BrickCount; Index++)
+				{
+					Brick->Distances[Index] = FVoxelSparseJumpFlood::BrickSize + Index % FVoxelSparseJumpFlood::BrickSize - 10.5f;
+				}
+				Bricks.Add_CheckNew(FIntVector(1, Y, Z), Brick);
+			}
+		}
+
+		FVoxelSparseJumpFlood::JumpFlood(Bricks, 4.f);
+
+		for (int32 X = 0; X < 3 * FVoxelSparseJumpFlood::BrickSize; X++)
+		{
+			const FVoxelSparseJumpFlood::FBrick& Brick = *Bricks.FindChecked(FIntVector(X / FVoxelSparseJumpFlood::BrickSize, 1, 1));
+			const float Distance = Brick.Distances[FVoxelUtilities::Get3DIndex<int32>(FVoxelSparseJumpFlood::BrickSize, X % FVoxelSparseJumpFlood::BrickSize, 3, 5)];
+
+			if (FMath::Abs(X - 10.5f) < 4.f)
+			{
+				check(FMath::IsNearlyEqual(Distance, X - 10.5f, 1.e-4f));
+			}
+			else
+			{
+				check(FMath::IsNaN(Distance));
+			}
+		}
+	}
+
+	{
+		// Size.X isn't a multiple of 64 and Size.Z is large enough to be split in several slabs
+		// A solid column crosses all the slab seams, the rest is noise
+		const FIntVector Size(70, 13, 67);
+
+		FVoxelBitArray Array;
+		Array.SetNumZeroed(Size.X * Size.Y * Size.Z);
+
+		FRandomStream Stream;
+		for (int32 Z = 0; Z < Size.Z; Z++)
+		{
+			for (int32 Y = 0; Y < Size.Y; Y++)
+			{
+				for (int32 X = 0; X < Size.X; X++)
+				{
+					Array[FVoxelUtilities::Get3DIndex<int32>(Size, X, Y, Z)] =
+						(X < 40 && Y < 8) ||
+						Stream.GetFraction() < 0.5f;
+				}
+			}
+		}
+
+		const TVoxelArray<FVoxelIntBox> Boxes = Array.GreedyMeshing3D_Parallel(Size);
+
+		FVoxelBitArray Covered;
+		Covered.SetNumZeroed(Array.Num());
+
+		for (const FVoxelIntBox& Box : Boxes)
+		{
+			check(FVoxelIntBox(0, Size).Contains(Box));
+
+			for (int32 Z = Box.Min.Z; Z < Box.Max.Z; Z++)
+			{
+				for (int32 Y = Box.Min.Y; Y < Box.Max.Y; Y++)
+				{
+					for (int32 X = Box.Min.X; X < Box.Max.X; X++)
+					{
+						const int32 Index = FVoxelUtilities::Get3DIndex<int32>(Size, X, Y, Z);
+
+						// Boxes must be disjoint and only cover set bits
+						check(Array[Index]);
+						check(!Covered[Index]);
+						Covered[Index] = true;
+					}
+				}
+			}
+		}
+
+		// Boxes must cover all set bits
+		check(Covered.CountSetBits() == Array.CountSetBits());
+	}
+
+	{
+		// Complete futures are awaited inline
+		const TVoxelFuture<int32> Future = VoxelCoreTests_AddOne(TVoxelFuture<int32>(1));
+		check(Future.IsComplete());
+		check(Future.GetValueChecked() == 2);
+	}
+
+	{
+		// Pending futures resume the coroutine on the thread completing them
+		const TVoxelPromise<int32> Promise;
+		const TVoxelFuture<int32> Future = VoxelCoreTests_AddOne(Promise);
+		check(!Future.IsComplete());
+
+		Promise.Set(41);
+		check(Future.IsComplete());
+		check(Future.GetValueChecked() == 42);
+	}
+
+	{
+		const TSharedRef<int32> Counter = MakeShared<int32>(0);
+		const FVoxelPromise Promise;
+
+		const FVoxelFuture FutureA = VoxelCoreTests_Wait(Promise, Counter);
+		const FVoxelFuture FutureB = VoxelCoreTests_Wait(FutureA, Counter);
+		check(!FutureB.IsComplete());
+		check(*Counter == 0);
+
+		Promise.Set();
+		check(FutureB.IsComplete());
+		check(*Counter == 2);
+	}
 }
\ No newline at end of file
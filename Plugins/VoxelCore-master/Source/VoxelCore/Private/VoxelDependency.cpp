@@ -15,6 +15,7 @@ DEFINE_VOXEL_INSTANCE_COUNTER(FVoxelDependencyBase);
 FVoxelDependencyBase::FVoxelDependencyBase(const FString& Name)
 	: Name(Name)
 	, DependencyId(FVoxelDependencyId::New())
+	, Trackers(MakeShared<FVoxelDependencyTrackerIndex>())
 {
 }
 
@@ -30,7 +31,13 @@ void FVoxelDependency::Invalidate()
 {
 	VOXEL_FUNCTION_COUNTER();
 
-	GVoxelDependencyManager->InvalidateTrackers(this, [&](const FVoxelDependencyTracker& Tracker)
+	TVoxelArray<int32> TrackerIndices;
+	{
+		VOXEL_SCOPE_LOCK(Trackers->CriticalSection);
+		TrackerIndices = Trackers->TrackerIndices_RequiresLock.Array();
+	}
+
+	GVoxelDependencyManager->InvalidateTrackers(this, TrackerIndices, [&](const FVoxelDependencyTracker& Tracker)
 	{
 		return Tracker.Dependencies_RequiresLock.Contains(DependencyId);
 	});
@@ -54,15 +61,25 @@ void FVoxelDependency2D::Invalidate(const FVoxelBox2D& Bounds)
 		return;
 	}
 
-	GVoxelDependencyManager->InvalidateTrackers(this, [=, this](const FVoxelDependencyTracker& Tracker)
+	TVoxelArray<int32> TrackerIndices;
+	{
+		VOXEL_SCOPE_LOCK(Trackers->CriticalSection);
+
+		Trackers->Tree2D_RequiresLock.TraverseBounds(Bounds, [&](const int32 TrackerIndex)
+		{
+			TrackerIndices.Add(TrackerIndex);
+		});
+	}
+
+	GVoxelDependencyManager->InvalidateTrackers(this, TrackerIndices, [=, this](const FVoxelDependencyTracker& Tracker)
 	{
-		const FVoxelBox2D* TrackerBounds = Tracker.Dependency2DToBounds_RequiresLock.Find(DependencyId);
+		const FVoxelDependencyTracker::FBounds2D* TrackerBounds = Tracker.Dependency2DToBounds_RequiresLock.Find(DependencyId);
 		if (!TrackerBounds)
 		{
 			return false;
 		}
 
-		return Bounds.Intersects(*TrackerBounds);
+		return Bounds.Intersects(TrackerBounds->Bounds);
 	});
 }
 
@@ -77,15 +94,30 @@ void FVoxelDependency2D::Invalidate(const TConstVoxelArrayView<FVoxelBox2D> Boun
 
 	const TSharedRef<FVoxelAABBTree2D> Tree = FVoxelAABBTree2D::Create(BoundsArray);
 
-	GVoxelDependencyManager->InvalidateTrackers(this, [=, this](const FVoxelDependencyTracker& Tracker)
+	TVoxelArray<int32> TrackerIndices;
 	{
-		const FVoxelBox2D* TrackerBounds = Tracker.Dependency2DToBounds_RequiresLock.Find(DependencyId);
+		VOXEL_SCOPE_LOCK(Trackers->CriticalSection);
+
+		Trackers->Tree2D_RequiresLock.Traverse(
+			[&](const FVoxelBox2D& TrackerBounds)
+			{
+				return Tree->Intersects(TrackerBounds);
+			},
+			[&](const int32 TrackerIndex)
+			{
+				TrackerIndices.Add(TrackerIndex);
+			});
+	}
+
+	GVoxelDependencyManager->InvalidateTrackers(this, TrackerIndices, [=, this](const FVoxelDependencyTracker& Tracker)
+	{
+		const FVoxelDependencyTracker::FBounds2D* TrackerBounds = Tracker.Dependency2DToBounds_RequiresLock.Find(DependencyId);
 		if (!TrackerBounds)
 		{
 			return false;
 		}
 
-		return Tree->Intersects(*TrackerBounds);
+		return Tree->Intersects(TrackerBounds->Bounds);
 	});
 }
 
@@ -107,15 +139,25 @@ void FVoxelDependency3D::Invalidate(const FVoxelBox& Bounds)
 		return;
 	}
 
-	GVoxelDependencyManager->InvalidateTrackers(this, [=, this](const FVoxelDependencyTracker& Tracker)
+	TVoxelArray<int32> TrackerIndices;
 	{
-		const FVoxelBox* TrackerBounds = Tracker.Dependency3DToBounds_RequiresLock.Find(DependencyId);
+		VOXEL_SCOPE_LOCK(Trackers->CriticalSection);
+
+		Trackers->Tree3D_RequiresLock.TraverseBounds(Bounds, [&](const int32 TrackerIndex)
+		{
+			TrackerIndices.Add(TrackerIndex);
+		});
+	}
+
+	GVoxelDependencyManager->InvalidateTrackers(this, TrackerIndices, [=, this](const FVoxelDependencyTracker& Tracker)
+	{
+		const FVoxelDependencyTracker::FBounds3D* TrackerBounds = Tracker.Dependency3DToBounds_RequiresLock.Find(DependencyId);
 		if (!TrackerBounds)
 		{
 			return false;
 		}
 
-		return Bounds.Intersects(*TrackerBounds);
+		return Bounds.Intersects(TrackerBounds->Bounds);
 	});
 }
 
@@ -130,14 +172,29 @@ void FVoxelDependency3D::Invalidate(const TConstVoxelArrayView<FVoxelBox> Bounds
 
 	const TSharedRef<FVoxelAABBTree> Tree = FVoxelAABBTree::Create(BoundsArray);
 
-	GVoxelDependencyManager->InvalidateTrackers(this, [=, this](const FVoxelDependencyTracker& Tracker)
+	TVoxelArray<int32> TrackerIndices;
+	{
+		VOXEL_SCOPE_LOCK(Trackers->CriticalSection);
+
+		Trackers->Tree3D_RequiresLock.Traverse(
+			[&](const FVoxelBox& TrackerBounds)
+			{
+				return Tree->Intersects(TrackerBounds);
+			},
+			[&](const int32 TrackerIndex)
+			{
+				TrackerIndices.Add(TrackerIndex);
+			});
+	}
+
+	GVoxelDependencyManager->InvalidateTrackers(this, TrackerIndices, [=, this](const FVoxelDependencyTracker& Tracker)
 	{
-		const FVoxelBox* TrackerBounds = Tracker.Dependency3DToBounds_RequiresLock.Find(DependencyId);
+		const FVoxelDependencyTracker::FBounds3D* TrackerBounds = Tracker.Dependency3DToBounds_RequiresLock.Find(DependencyId);
 		if (!TrackerBounds)
 		{
 			return false;
 		}
 
-		return Tree->Intersects(*TrackerBounds);
+		return Tree->Intersects(TrackerBounds->Bounds);
 	});
 }
\ No newline at end of file
@@ -2,4 +2,6 @@
 
 #include "VoxelDependencyManager.h"
 
+DEFINE_VOXEL_COUNTER(STAT_VoxelDependencyTrackerLockContention);
+
 FVoxelDependencyManager* GVoxelDependencyManager = new FVoxelDependencyManager();
\ No newline at end of file
@@ -6,14 +6,103 @@
 #include "VoxelDependency.h"
 #include "VoxelDependencyTracker.h"
 #include "VoxelDependencySnapshot.h"
+#include "VoxelDynamicAABBTree.h"
+
+// Index of the trackers depending on a single dependency
+// Payloads are tracker indices, see FVoxelDependencyManager::GetShardIndex
+// Can be stale if a tracker is destroyed while invalidating, ShouldInvalidate is always checked on the actual tracker
+class FVoxelDependencyTrackerIndex
+{
+public:
+	FVoxelCriticalSection CriticalSection;
+
+	// FVoxelDependency
+	TVoxelSet<int32> TrackerIndices_RequiresLock;
+	// FVoxelDependency2D, element payload is the tracker index
+	FVoxelDynamicAABBTree2D Tree2D_RequiresLock;
+	// FVoxelDependency3D, element payload is the tracker index
+	FVoxelDynamicAABBTree Tree3D_RequiresLock;
+};
+
+DECLARE_VOXEL_COUNTER(VOXELCORE_API, STAT_VoxelDependencyTrackerLockContention, "Dependency Tracker Lock Contention");
 
 // Not a FVoxelSingleton, we don't want to free the memory on shutdown to avoid crashing when other singletons tear down
 class FVoxelDependencyManager
 {
 public:
-	mutable FVoxelCriticalSection CriticalSection;
-	// Inline allocations to reduce cache misses when invalidating
-	TVoxelChunkedSparseArray<FVoxelDependencyTracker> Trackers_RequiresLock;
+	// Trackers are split into shards to reduce contention between threads creating trackers & invalidation
+	// Tracker indices are LocalIndex * NumShards + ShardIndex
+	static constexpr int32 NumShards = 16;
+	checkStatic(FMath::IsPowerOfTwo(NumShards));
+
+	class FShard
+	{
+	public:
+		FShard() = default;
+		UE_NONCOPYABLE(FShard);
+
+		// Inline allocations to reduce cache misses when invalidating
+		TVoxelChunkedSparseArray<FVoxelDependencyTracker> Trackers_RequiresLock;
+		// Updated under the shard lock, read by FVoxelDependencyManager::GetAllocatedSize without locking
+		FVoxelCounter64 AllocatedSize;
+
+		// Used by VOXEL_SCOPE_LOCK
+		FORCEINLINE void Lock()
+		{
+			if (CriticalSection.TryLock())
+			{
+				return;
+			}
+
+			INC_VOXEL_COUNTER(STAT_VoxelDependencyTrackerLockContention);
+			CriticalSection.Lock();
+		}
+		FORCEINLINE void Unlock()
+		{
+			CriticalSection.Unlock();
+		}
+		FORCEINLINE bool ShouldRecordStats() const
+		{
+			return CriticalSection.ShouldRecordStats();
+		}
+
+	private:
+		FVoxelCriticalSection CriticalSection;
+	};
+	TVoxelStaticArray<FShard, NumShards> Shards;
+
+	FORCEINLINE static int32 GetShardIndex(const int32 TrackerIndex)
+	{
+		checkVoxelSlow(TrackerIndex >= 0);
+		return TrackerIndex & (NumShards - 1);
+	}
+	FORCEINLINE static int32 GetLocalIndex(const int32 TrackerIndex)
+	{
+		checkVoxelSlow(TrackerIndex >= 0);
+		return TrackerIndex / NumShards;
+	}
+	FORCEINLINE static int32 MakeTrackerIndex(const int32 ShardIndex, const int32 LocalIndex)
+	{
+		checkVoxelSlow(0 <= ShardIndex && ShardIndex < NumShards);
+		checkVoxelSlow(0 <= LocalIndex && LocalIndex < MAX_int32 / NumShards);
+		return LocalIndex * NumShards + ShardIndex;
+	}
+	// Threads will mostly create trackers in their own shard
+	FORCEINLINE static int32 GetCurrentThreadShardIndex()
+	{
+		return int32(FVoxelUtilities::MurmurHash(FPlatformTLS::GetCurrentThreadId()) & (NumShards - 1));
+	}
+
+	int32 NumTrackers() const
+	{
+		int32 Result = 0;
+		for (const FShard& Shard : Shards)
+		{
+			// Only used for logging, no need to lock
+			Result += Shard.Trackers_RequiresLock.Num();
+		}
+		return Result;
+	}
 
 public:
 	mutable FVoxelCriticalSection SnapshotCriticalSection;
@@ -24,16 +113,23 @@ public:
 
 	int64 GetAllocatedSize() const
 	{
-		return Trackers_RequiresLock.GetAllocatedSize();
+		int64 AllocatedSize = 0;
+		for (const FShard& Shard : Shards)
+		{
+			AllocatedSize += Shard.AllocatedSize.Get();
+		}
+		return AllocatedSize;
 	}
 
 public:
+	// TrackerIndices are the candidates found in the dependency FVoxelDependencyTrackerIndex
 	template<typename LambdaType>
 	void InvalidateTrackers(
 		FVoxelDependencyBase* Dependency,
+		const TConstVoxelArrayView<int32> TrackerIndices,
 		LambdaType ShouldInvalidate)
 	{
-		VOXEL_FUNCTION_COUNTER_NUM(Trackers_RequiresLock.Num(), 0);
+		VOXEL_FUNCTION_COUNTER_NUM(TrackerIndices.Num(), 0);
 
 		{
 			VOXEL_SCOPE_COUNTER("Snapshots");
@@ -58,10 +154,7 @@ public:
 					}
 
 					Tracker.bIsInvalidated.Set(true);
-
-					Tracker.Dependencies_RequiresLock.Empty();
-					Tracker.Dependency2DToBounds_RequiresLock.Empty();
-					Tracker.Dependency3DToBounds_RequiresLock.Empty();
+					Tracker.ClearDependencies_RequiresLock();
 
 					if (Tracker.OnInvalidated_RequiresLock)
 					{
@@ -71,55 +164,111 @@ public:
 			}
 		}
 
-		TVoxelMap<FName, int32> TrackerNameToCount;
+		if (TrackerIndices.Num() == 0)
+		{
+			return;
+		}
 
-		int32 NumTrackersInvalidated = 0;
-		TVoxelChunkedArray<TVoxelUniqueFunction<void()>> OnInvalidatedArray;
+		struct FShardInvalidation
+		{
+			TVoxelArray<int32> LocalIndices;
 
-		const double StartTime = FPlatformTime::Seconds();
+			int32 NumTrackersInvalidated = 0;
+			TVoxelChunkedArray<TVoxelUniqueFunction<void()>> OnInvalidatedArray;
+			TVoxelMap<FName, int32> TrackerNameToCount;
+		};
+		TVoxelStaticArray<FShardInvalidation, NumShards> ShardInvalidations;
+
+		for (const int32 TrackerIndex : TrackerIndices)
 		{
-			VOXEL_SCOPE_LOCK(CriticalSection);
+			ShardInvalidations[GetShardIndex(TrackerIndex)].LocalIndices.Add(GetLocalIndex(TrackerIndex));
+		}
 
-			Trackers_RequiresLock.Foreach([&](FVoxelDependencyTracker& Tracker)
+		const auto InvalidateShard = [&](const int32 ShardIndex)
+		{
+			FShardInvalidation& ShardInvalidation = ShardInvalidations[ShardIndex];
+			if (ShardInvalidation.LocalIndices.Num() == 0)
 			{
+				return;
+			}
+
+			FShard& Shard = Shards[ShardIndex];
+			VOXEL_SCOPE_LOCK(Shard);
+
+			for (const int32 LocalIndex : ShardInvalidation.LocalIndices)
+			{
+				if (!Shard.Trackers_RequiresLock.IsValidIndex(LocalIndex))
+				{
+					continue;
+				}
+
+				FVoxelDependencyTracker& Tracker = Shard.Trackers_RequiresLock[LocalIndex];
 				if (Tracker.bIsInvalidated.Get())
 				{
-					return;
+					continue;
 				}
 
 				VOXEL_SCOPE_LOCK(Tracker.CriticalSection);
 
 				if (!ShouldInvalidate(Tracker))
 				{
-					return;
+					continue;
 				}
 
-				NumTrackersInvalidated++;
+				ShardInvalidation.NumTrackersInvalidated++;
 
 				Tracker.bIsInvalidated.Set(true);
-
-				Tracker.Dependencies_RequiresLock.Empty();
-				Tracker.Dependency2DToBounds_RequiresLock.Empty();
-				Tracker.Dependency3DToBounds_RequiresLock.Empty();
+				Tracker.ClearDependencies_RequiresLock();
 
 				if (Tracker.OnInvalidated_RequiresLock)
 				{
-					OnInvalidatedArray.Add(MoveTemp(Tracker.OnInvalidated_RequiresLock));
+					ShardInvalidation.OnInvalidatedArray.Add(MoveTemp(Tracker.OnInvalidated_RequiresLock));
 				}
 
 #if !NO_LOGGING
 				if (LogVoxel.GetVerbosity() >= ELogVerbosity::Verbose)
 				{
-					TrackerNameToCount.FindOrAdd(Tracker.PrivateName)++;
+					ShardInvalidation.TrackerNameToCount.FindOrAdd(Tracker.PrivateName)++;
 				}
 #endif
-			});
+			}
+		};
+
+		const double StartTime = FPlatformTime::Seconds();
+		{
+			// Not worth going wide for small invalidations
+			if (TrackerIndices.Num() < 1024)
+			{
+				for (int32 ShardIndex = 0; ShardIndex < NumShards; ShardIndex++)
+				{
+					InvalidateShard(ShardIndex);
+				}
+			}
+			else
+			{
+				ParallelFor(NumShards, InvalidateShard);
+			}
 		}
 		const double EndTime = FPlatformTime::Seconds();
 
+		int32 NumTrackersInvalidated = 0;
+		for (const FShardInvalidation& ShardInvalidation : ShardInvalidations)
+		{
+			NumTrackersInvalidated += ShardInvalidation.NumTrackersInvalidated;
+		}
+
 #if !NO_LOGGING
 		if (LogVoxel.GetVerbosity() >= ELogVerbosity::Verbose)
 		{
+			TVoxelMap<FName, int32> TrackerNameToCount;
+			for (const FShardInvalidation& ShardInvalidation : ShardInvalidations)
+			{
+				for (const auto& It : ShardInvalidation.TrackerNameToCount)
+				{
+					TrackerNameToCount.FindOrAdd(It.Key) += It.Value;
+				}
+			}
+
 			TrackerNameToCount.ValueSort([](const int32 A, const int32 B)
 			{
 				return A > B;
@@ -131,18 +280,23 @@ public:
 				TrackerNames += FString::Printf(TEXT(" %s x%d"), *It.Key.ToString(), It.Value);
 			}
 
-			LOG_VOXEL(Verbose, "Invalidating took %-8s, %-4d trackers invalidated (out of %d trackers). Dependency: %s Trackers: %s",
+			LOG_VOXEL(Verbose, "Invalidating took %-8s, %-4d trackers invalidated (out of %d candidates, %d trackers). Dependency: %s Trackers: %s",
 				*FVoxelUtilities::SecondsToString(EndTime - StartTime),
 				NumTrackersInvalidated,
-				Trackers_RequiresLock.Num(),
+				TrackerIndices.Num(),
+				NumTrackers(),
 				*Dependency->Name,
 				*TrackerNames);
 		}
 #endif
 
-		for (const TVoxelUniqueFunction<void()>& OnInvalidated : OnInvalidatedArray)
+		// Call OnInvalidated on the calling thread, outside of any lock
+		for (const FShardInvalidation& ShardInvalidation : ShardInvalidations)
 		{
-			OnInvalidated();
+			for (const TVoxelUniqueFunction<void()>& OnInvalidated : ShardInvalidation.OnInvalidatedArray)
+			{
+				OnInvalidated();
+			}
 		}
 	}
 };
@@ -13,19 +13,37 @@ DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelDependencyTrackerMemory);
 
 TSharedRef<FVoxelDependencyTracker> FVoxelDependencyTracker::Create(const FName Name)
 {
-	VOXEL_SCOPE_LOCK(GVoxelDependencyManager->CriticalSection);
+	const int32 ShardIndex = FVoxelDependencyManager::GetCurrentThreadShardIndex();
+	FVoxelDependencyManager::FShard& Shard = GVoxelDependencyManager->Shards[ShardIndex];
 
-	const int32 NewTrackerIndex = GVoxelDependencyManager->Trackers_RequiresLock.Emplace(FPrivate());
-	GVoxelDependencyManager->UpdateStats();
+	FVoxelDependencyTracker* Tracker;
+	{
+		VOXEL_SCOPE_LOCK(Shard);
 
-	FVoxelDependencyTracker& Tracker = GVoxelDependencyManager->Trackers_RequiresLock[NewTrackerIndex];
-	Tracker.TrackerIndex = NewTrackerIndex;
-	Tracker.PrivateName = Name;
+		const int32 LocalIndex = Shard.Trackers_RequiresLock.Emplace(FPrivate());
+		Shard.AllocatedSize.Set(Shard.Trackers_RequiresLock.GetAllocatedSize());
+
+		Tracker = &Shard.Trackers_RequiresLock[LocalIndex];
+		Tracker->TrackerIndex = FVoxelDependencyManager::MakeTrackerIndex(ShardIndex, LocalIndex);
+		Tracker->PrivateName = Name;
+	}
+	GVoxelDependencyManager->UpdateStats();
 
-	return MakeShareable_CustomDestructor(&Tracker, [&Tracker]
+	return MakeShareable_CustomDestructor(Tracker, [Tracker]
 	{
-		VOXEL_SCOPE_LOCK(GVoxelDependencyManager->CriticalSection);
-		GVoxelDependencyManager->Trackers_RequiresLock.RemoveAt(Tracker.TrackerIndex);
+		FVoxelDependencyManager::FShard& TrackerShard = GVoxelDependencyManager->Shards[FVoxelDependencyManager::GetShardIndex(Tracker->TrackerIndex)];
+		{
+			VOXEL_SCOPE_LOCK(TrackerShard);
+
+			{
+				VOXEL_SCOPE_LOCK(Tracker->CriticalSection);
+				Tracker->ClearDependencies_RequiresLock();
+			}
+
+			TrackerShard.Trackers_RequiresLock.RemoveAt(FVoxelDependencyManager::GetLocalIndex(Tracker->TrackerIndex));
+			TrackerShard.AllocatedSize.Set(TrackerShard.Trackers_RequiresLock.GetAllocatedSize());
+		}
+		GVoxelDependencyManager->UpdateStats();
 	});
 }
 
@@ -55,7 +73,15 @@ void FVoxelDependencyTracker::AddDependency(const FVoxelDependency& Dependency)
 {
 	VOXEL_SCOPE_LOCK(CriticalSection);
 
-	Dependencies_RequiresLock.Add(Dependency.DependencyId);
+	if (Dependencies_RequiresLock.Contains(Dependency.DependencyId))
+	{
+		return;
+	}
+
+	Dependencies_RequiresLock.Add_CheckNew(Dependency.DependencyId, Dependency.Trackers);
+
+	VOXEL_SCOPE_LOCK(Dependency.Trackers->CriticalSection);
+	Dependency.Trackers->TrackerIndices_RequiresLock.Add(TrackerIndex);
 }
 
 void FVoxelDependencyTracker::AddDependency(
@@ -64,13 +90,21 @@ void FVoxelDependencyTracker::AddDependency(
 {
 	VOXEL_SCOPE_LOCK(CriticalSection);
 
-	if (FVoxelBox2D* ExistingBounds = Dependency2DToBounds_RequiresLock.Find(Dependency.DependencyId))
+	if (FBounds2D* ExistingBounds = Dependency2DToBounds_RequiresLock.Find(Dependency.DependencyId))
 	{
-		*ExistingBounds = ExistingBounds->UnionWith(Bounds);
+		ExistingBounds->Bounds = ExistingBounds->Bounds.UnionWith(Bounds);
+
+		VOXEL_SCOPE_LOCK(Dependency.Trackers->CriticalSection);
+		Dependency.Trackers->Tree2D_RequiresLock.Update(ExistingBounds->ElementId, ExistingBounds->Bounds);
 		return;
 	}
 
-	Dependency2DToBounds_RequiresLock.Add_CheckNew(Dependency.DependencyId, Bounds);
+	FBounds2D& NewBounds = Dependency2DToBounds_RequiresLock.Add_CheckNew(Dependency.DependencyId);
+	NewBounds.Bounds = Bounds;
+	NewBounds.WeakTrackers = Dependency.Trackers;
+
+	VOXEL_SCOPE_LOCK(Dependency.Trackers->CriticalSection);
+	NewBounds.ElementId = Dependency.Trackers->Tree2D_RequiresLock.Insert(Bounds, TrackerIndex);
 }
 
 void FVoxelDependencyTracker::AddDependency(
@@ -79,13 +113,21 @@ void FVoxelDependencyTracker::AddDependency(
 {
 	VOXEL_SCOPE_LOCK(CriticalSection);
 
-	if (FVoxelBox* ExistingBounds = Dependency3DToBounds_RequiresLock.Find(Dependency.DependencyId))
+	if (FBounds3D* ExistingBounds = Dependency3DToBounds_RequiresLock.Find(Dependency.DependencyId))
 	{
-		*ExistingBounds = ExistingBounds->UnionWith(Bounds);
+		ExistingBounds->Bounds = ExistingBounds->Bounds.UnionWith(Bounds);
+
+		VOXEL_SCOPE_LOCK(Dependency.Trackers->CriticalSection);
+		Dependency.Trackers->Tree3D_RequiresLock.Update(ExistingBounds->ElementId, ExistingBounds->Bounds);
 		return;
 	}
 
-	Dependency3DToBounds_RequiresLock.Add_CheckNew(Dependency.DependencyId, Bounds);
+	FBounds3D& NewBounds = Dependency3DToBounds_RequiresLock.Add_CheckNew(Dependency.DependencyId);
+	NewBounds.Bounds = Bounds;
+	NewBounds.WeakTrackers = Dependency.Trackers;
+
+	VOXEL_SCOPE_LOCK(Dependency.Trackers->CriticalSection);
+	NewBounds.ElementId = Dependency.Trackers->Tree3D_RequiresLock.Insert(Bounds, TrackerIndex);
 }
 
 void FVoxelDependencyTracker::SetOnInvalidated(TVoxelUniqueFunction<void()> OnInvalidated)
@@ -108,4 +150,53 @@ void FVoxelDependencyTracker::SetOnInvalidated(TVoxelUniqueFunction<void()> OnIn
 	Dependency3DToBounds_RequiresLock.Shrink();
 
 	UpdateStats();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelDependencyTracker::ClearDependencies_RequiresLock()
+{
+	VOXEL_FUNCTION_COUNTER();
+	checkVoxelSlow(CriticalSection.IsLocked());
+
+	// Dependencies might have been destroyed already, in which case their index is gone too
+	for (const auto& It : Dependencies_RequiresLock)
+	{
+		const TSharedPtr<FVoxelDependencyTrackerIndex> Trackers = It.Value.Pin();
+		if (!Trackers)
+		{
+			continue;
+		}
+
+		VOXEL_SCOPE_LOCK(Trackers->CriticalSection);
+		Trackers->TrackerIndices_RequiresLock.Remove(TrackerIndex);
+	}
+	for (const auto& It : Dependency2DToBounds_RequiresLock)
+	{
+		const TSharedPtr<FVoxelDependencyTrackerIndex> Trackers = It.Value.WeakTrackers.Pin();
+		if (!Trackers)
+		{
+			continue;
+		}
+
+		VOXEL_SCOPE_LOCK(Trackers->CriticalSection);
+		Trackers->Tree2D_RequiresLock.Remove(It.Value.ElementId);
+	}
+	for (const auto& It : Dependency3DToBounds_RequiresLock)
+	{
+		const TSharedPtr<FVoxelDependencyTrackerIndex> Trackers = It.Value.WeakTrackers.Pin();
+		if (!Trackers)
+		{
+			continue;
+		}
+
+		VOXEL_SCOPE_LOCK(Trackers->CriticalSection);
+		Trackers->Tree3D_RequiresLock.Remove(It.Value.ElementId);
+	}
+
+	Dependencies_RequiresLock.Empty();
+	Dependency2DToBounds_RequiresLock.Empty();
+	Dependency3DToBounds_RequiresLock.Empty();
 }
\ No newline at end of file
@@ -22,26 +22,44 @@ void FVoxelDistanceFieldWrapper::FMip::Initialize(const FVoxelDistanceFieldWrapp
 
 FVoxelDistanceFieldWrapper::FBrick* FVoxelDistanceFieldWrapper::FMip::FindBrick(const FIntVector& Position)
 {
-	return Bricks[FVoxelUtilities::Get3DIndex<int32>(IndirectionSize, Position)].Get();
+	const int32 BrickIndex = BrickIndices[FVoxelUtilities::Get3DIndex<int32>(IndirectionSize, Position)];
+	if (BrickIndex == -1)
+	{
+		return nullptr;
+	}
+
+	VOXEL_SCOPE_LOCK(BrickPoolCriticalSection);
+	return &BrickPool[BrickIndex];
 }
 
 FVoxelDistanceFieldWrapper::FBrick& FVoxelDistanceFieldWrapper::FMip::FindOrAddBrick(const FIntVector& Position)
 {
-	TSharedPtr<FBrick>& Ptr = Bricks[FVoxelUtilities::Get3DIndex<int32>(IndirectionSize, Position)];
-	if (!Ptr)
+	int32& BrickIndex = BrickIndices[FVoxelUtilities::Get3DIndex<int32>(IndirectionSize, Position)];
+
+	VOXEL_SCOPE_LOCK(BrickPoolCriticalSection);
+
+	if (BrickIndex == -1)
 	{
-		Ptr = MakeShared<FBrick>(NoInit);
+		BrickIndex = BrickPool.AddUninitialized();
 	}
-	return *Ptr;
+	return BrickPool[BrickIndex];
 }
 
 void FVoxelDistanceFieldWrapper::FMip::AddBrick(
 	const FIntVector& Position,
-	const TSharedRef<FBrick>& Brick)
+	const FBrick& Brick)
 {
-	TSharedPtr<FBrick>& Ptr = Bricks[FVoxelUtilities::Get3DIndex<int32>(IndirectionSize, Position)];
-	ensure(!Ptr);
-	Ptr = Brick;
+	int32& BrickIndex = BrickIndices[FVoxelUtilities::Get3DIndex<int32>(IndirectionSize, Position)];
+	ensure(BrickIndex == -1);
+
+	// Reserve a slot under the lock, but copy the brick outside of it: the slot never moves
+	FBrick* NewBrick;
+	{
+		VOXEL_SCOPE_LOCK(BrickPoolCriticalSection);
+		BrickIndex = BrickPool.AddUninitialized();
+		NewBrick = &BrickPool[BrickIndex];
+	}
+	*NewBrick = Brick;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -52,139 +70,143 @@ void FVoxelDistanceFieldWrapper::SetSize(const FIntVector& Mip0IndirectionSize)
 {
 	for (int32 MipIndex = 0; MipIndex < DistanceField::NumMips; MipIndex++)
 	{
-		Mips[MipIndex].IndirectionSize = FIntVector(
+		FMip& Mip = Mips[MipIndex];
+
+		Mip.IndirectionSize = FIntVector(
 			FVoxelUtilities::DivideCeil_Positive(Mip0IndirectionSize.X, 1 << MipIndex),
 			FVoxelUtilities::DivideCeil_Positive(Mip0IndirectionSize.Y, 1 << MipIndex),
 			FVoxelUtilities::DivideCeil_Positive(Mip0IndirectionSize.Z, 1 << MipIndex));
 
-		Mips[MipIndex].Bricks.Reset();
-		Mips[MipIndex].Bricks.SetNum(Mips[MipIndex].IndirectionSize.X * Mips[MipIndex].IndirectionSize.Y * Mips[MipIndex].IndirectionSize.Z);
+		Mip.BrickIndices.Reset();
+		Mip.BrickIndices.SetNumUninitialized(Mip.IndirectionSize.X * Mip.IndirectionSize.Y * Mip.IndirectionSize.Z);
+		FVoxelUtilities::SetAll(Mip.BrickIndices, -1);
+
+		Mip.BrickPool.Reset();
 
-		Mips[MipIndex].Initialize(*this);
+		Mip.Initialize(*this);
 	}
 }
 
 TSharedRef<FDistanceFieldVolumeData> FVoxelDistanceFieldWrapper::Build() const
 {
 	VOXEL_FUNCTION_COUNTER();
+	checkStatic(DistanceField::DistanceFieldFormat == PF_G8);
+
+	constexpr int32 BrickSizeBytes = sizeof(FBrick);
+	constexpr int32 AlwaysLoadedMipIndex = DistanceField::NumMips - 1;
 
 	const TSharedRef<FDistanceFieldVolumeData> OutData = MakeShared<FDistanceFieldVolumeData>();
 
-	TArray<uint8> StreamableMipData;
+	// Layout every mip first so that all of them can be written in place, in parallel
+	TVoxelStaticArray<int64, DistanceField::NumMips> MipOffsets{ NoInit };
+	int64 StreamableMipDataBytes = 0;
 
 	for (int32 MipIndex = 0; MipIndex < DistanceField::NumMips; MipIndex++)
 	{
-		VOXEL_SCOPE_COUNTER("Mip");
-
 		const FMip& Mip = Mips[MipIndex];
+		const int64 MipDataBytes =
+			int64(Mip.BrickIndices.Num()) * sizeof(uint32) +
+			int64(Mip.BrickPool.Num()) * BrickSizeBytes;
 
 		FSparseDistanceFieldMip& OutMip = OutData->Mips[MipIndex];
-		TVoxelArray<uint32> IndirectionTable;
-		IndirectionTable.Empty(Mip.IndirectionSize.X * Mip.IndirectionSize.Y * Mip.IndirectionSize.Z);
-		IndirectionTable.AddUninitialized(Mip.IndirectionSize.X * Mip.IndirectionSize.Y * Mip.IndirectionSize.Z);
+		OutMip.IndirectionDimensions = Mip.IndirectionSize;
+		OutMip.DistanceFieldToVolumeScaleBias = FVector2f(Mip.DistanceFieldToVolumeScaleBias);
+		OutMip.NumDistanceFieldBricks = Mip.BrickPool.Num();
 
-		for (int32 i = 0; i < IndirectionTable.Num(); i++)
+		// Account for the border voxels we added
+		const FVector VirtualUVMin = FVector(DistanceField::MeshDistanceFieldObjectBorder) / FVector(Mip.IndirectionSize * DistanceField::UniqueDataBrickSize);
+		const FVector VirtualUVSize = FVector(Mip.IndirectionSize * DistanceField::UniqueDataBrickSize - FIntVector(2 * DistanceField::MeshDistanceFieldObjectBorder)) / FVector(Mip.IndirectionSize * DistanceField::UniqueDataBrickSize);
+
+		// [-1, 1] -> [VirtualUVMin, VirtualUVMin + VirtualUVSize]
+		OutMip.VolumeToVirtualUVScale = FVector3f(VirtualUVSize / 2.f);
+		OutMip.VolumeToVirtualUVAdd = FVector3f(VirtualUVSize / 2.f + VirtualUVMin);
+
+		if (MipIndex == AlwaysLoadedMipIndex)
 		{
-			IndirectionTable[i] = DistanceField::InvalidBrickIndex;
-		}
+			MipOffsets[MipIndex] = 0;
 
-		uint32 NumBricks = 0;
-		for (const TSharedPtr<FBrick>& Brick : Mip.Bricks)
+			OutData->AlwaysLoadedMip.Empty(MipDataBytes);
+			OutData->AlwaysLoadedMip.AddUninitialized(MipDataBytes);
+		}
+		else
 		{
-			if (Brick)
-			{
-				NumBricks++;
-			}
+			MipOffsets[MipIndex] = StreamableMipDataBytes;
+			StreamableMipDataBytes += MipDataBytes;
+
+			check(MipDataBytes > 0);
+			OutMip.BulkOffset = MipOffsets[MipIndex];
+			// HACK: set BulkSize to 0 so no read request is ever emitted as they crash in packaged
+			OutMip.BulkSize = 0;
 		}
+	}
 
-		const uint32 BrickSizeBytes = DistanceField::BrickSize * DistanceField::BrickSize * DistanceField::BrickSize * GPixelFormats[DistanceField::DistanceFieldFormat].BlockBytes;
+	OutData->LocalSpaceMeshBounds = FBox3f(LocalSpaceMeshBounds);
+	OutData->bMostlyTwoSided = true;
 
-		TVoxelArray<uint8> DistanceFieldBrickData;
-		DistanceFieldBrickData.Empty(BrickSizeBytes * NumBricks);
-		DistanceFieldBrickData.AddUninitialized(BrickSizeBytes * NumBricks);
+	OutData->StreamableMips.Lock(LOCK_READ_WRITE);
+	uint8* StreamableMipData = static_cast<uint8*>(OutData->StreamableMips.Realloc(StreamableMipDataBytes));
 
-		int32 BrickIndex = 0;
-		for (int32 X = 0; X < Mip.IndirectionSize.X; X++)
+	const auto GetMipData = [&](const int32 MipIndex)
+	{
+		if (MipIndex == AlwaysLoadedMipIndex)
 		{
-			for (int32 Y = 0; Y < Mip.IndirectionSize.X; Y++)
-			{
-				for (int32 Z = 0; Z < Mip.IndirectionSize.X; Z++)
-				{
-					const int32 IndirectionIndex = FVoxelUtilities::Get3DIndex<int32>(Mip.IndirectionSize, X, Y, Z);
-					const TSharedPtr<FBrick>& Brick = Mip.Bricks[IndirectionIndex];
-
-					if (!Brick)
-					{
-						IndirectionTable[IndirectionIndex] = DistanceField::InvalidBrickIndex;
-						continue;
-					}
-
-					IndirectionTable[IndirectionIndex] = BrickIndex;
-					FMemory::Memcpy(&DistanceFieldBrickData[BrickIndex * BrickSizeBytes], Brick->GetData(), Brick->Num() * Brick->GetTypeSize());
-
-					BrickIndex++;
-				}
-			}
+			return OutData->AlwaysLoadedMip.GetData();
 		}
-		check(BrickIndex == NumBricks);
+		return StreamableMipData + MipOffsets[MipIndex];
+	};
 
-		const int32 IndirectionTableBytes = IndirectionTable.Num() * IndirectionTable.GetTypeSize();
-		const int32 MipDataBytes = IndirectionTableBytes + DistanceFieldBrickData.Num();
+	// Split each mip into one indirection job + batches of bricks, as mip 0 dominates the cost
+	struct FJob
+	{
+		int32 MipIndex = 0;
+		// -1 for the indirection table
+		int32 FirstBrick = -1;
+		int32 NumBricks = 0;
+	};
+	constexpr int32 BricksPerJob = 256;
+
+	TVoxelArray<FJob> Jobs;
+	for (int32 MipIndex = 0; MipIndex < DistanceField::NumMips; MipIndex++)
+	{
+		Jobs.Add(FJob{ MipIndex });
 
-		if (MipIndex == DistanceField::NumMips - 1)
+		const int32 NumBricks = Mips[MipIndex].BrickPool.Num();
+		for (int32 FirstBrick = 0; FirstBrick < NumBricks; FirstBrick += BricksPerJob)
 		{
-			VOXEL_SCOPE_COUNTER("Copy");
-
-			OutData->AlwaysLoadedMip.Empty(MipDataBytes);
-			OutData->AlwaysLoadedMip.AddUninitialized(MipDataBytes);
-
-			FPlatformMemory::Memcpy(&OutData->AlwaysLoadedMip[0], IndirectionTable.GetData(), IndirectionTableBytes);
-
-			if (DistanceFieldBrickData.Num() > 0)
-			{
-				FPlatformMemory::Memcpy(&OutData->AlwaysLoadedMip[IndirectionTableBytes], DistanceFieldBrickData.GetData(), DistanceFieldBrickData.Num());
-			}
+			Jobs.Add(FJob{ MipIndex, FirstBrick, FMath::Min(BricksPerJob, NumBricks - FirstBrick) });
 		}
-		else
-		{
-			VOXEL_SCOPE_COUNTER("Copy");
+	}
 
-			OutMip.BulkOffset = StreamableMipData.Num();
-			StreamableMipData.AddUninitialized(MipDataBytes);
-			OutMip.BulkSize = StreamableMipData.Num() - OutMip.BulkOffset;
-			check(OutMip.BulkSize > 0);
+	ParallelFor(Jobs.Num(), [&](const int32 JobIndex)
+	{
+		VOXEL_SCOPE_COUNTER("Copy");
 
-			FPlatformMemory::Memcpy(&StreamableMipData[OutMip.BulkOffset], IndirectionTable.GetData(), IndirectionTableBytes);
+		const FJob& Job = Jobs[JobIndex];
+		const FMip& Mip = Mips[Job.MipIndex];
+		uint8* MipData = GetMipData(Job.MipIndex);
 
-			if (DistanceFieldBrickData.Num() > 0)
+		if (Job.FirstBrick == -1)
+		{
+			// Pool indices are the final brick indices
+			uint32* IndirectionTable = reinterpret_cast<uint32*>(MipData);
+			for (int32 Index = 0; Index < Mip.BrickIndices.Num(); Index++)
 			{
-				FPlatformMemory::Memcpy(&StreamableMipData[OutMip.BulkOffset + IndirectionTableBytes], DistanceFieldBrickData.GetData(), DistanceFieldBrickData.Num());
+				const int32 BrickIndex = Mip.BrickIndices[Index];
+				IndirectionTable[Index] = BrickIndex == -1 ? DistanceField::InvalidBrickIndex : uint32(BrickIndex);
 			}
-
-			// HACK: set BulkSize to 0 so no read request is ever emitted as they crash in packaged
-			OutMip.BulkSize = 0;
+			return;
 		}
 
-		OutMip.IndirectionDimensions = Mip.IndirectionSize;
-		OutMip.DistanceFieldToVolumeScaleBias = FVector2f(Mip.DistanceFieldToVolumeScaleBias);
-		OutMip.NumDistanceFieldBricks = NumBricks;
-
-		// Account for the border voxels we added
-		const FVector VirtualUVMin = FVector(DistanceField::MeshDistanceFieldObjectBorder) / FVector(Mip.IndirectionSize * DistanceField::UniqueDataBrickSize);
-		const FVector VirtualUVSize = FVector(Mip.IndirectionSize * DistanceField::UniqueDataBrickSize - FIntVector(2 * DistanceField::MeshDistanceFieldObjectBorder)) / FVector(Mip.IndirectionSize * DistanceField::UniqueDataBrickSize);
-
-		// [-1, 1] -> [VirtualUVMin, VirtualUVMin + VirtualUVSize]
-		OutMip.VolumeToVirtualUVScale = FVector3f(VirtualUVSize / 2.f);
-		OutMip.VolumeToVirtualUVAdd = FVector3f(VirtualUVSize / 2.f + VirtualUVMin);
-	}
-
-	OutData->LocalSpaceMeshBounds = FBox3f(LocalSpaceMeshBounds);
-	OutData->bMostlyTwoSided = true;
+		uint8* BrickData = MipData + int64(Mip.BrickIndices.Num()) * sizeof(uint32);
+		for (int32 BrickIndex = Job.FirstBrick; BrickIndex < Job.FirstBrick + Job.NumBricks; BrickIndex++)
+		{
+			FMemory::Memcpy(
+				BrickData + int64(BrickIndex) * BrickSizeBytes,
+				Mip.BrickPool[BrickIndex].GetData(),
+				BrickSizeBytes);
+		}
+	});
 
-	VOXEL_SCOPE_COUNTER("Final copy");
-	OutData->StreamableMips.Lock(LOCK_READ_WRITE);
-	uint8* Ptr = static_cast<uint8*>(OutData->StreamableMips.Realloc(StreamableMipData.Num()));
-	FMemory::Memcpy(Ptr, StreamableMipData.GetData(), StreamableMipData.Num());
 	OutData->StreamableMips.Unlock();
 	OutData->StreamableMips.SetBulkDataFlags(BULKDATA_Force_NOT_InlinePayload);
 
@@ -1,6 +1,7 @@
 ﻿// Copyright Voxel Plugin SAS. All Rights Reserved.
 
 #include "VoxelFastAABBTree.h"
+#include "VoxelAABBTree.h"
 #include "VoxelWelfordVariance.h"
 #include "VoxelFastAABBTreeImpl.ispc.generated.h"
 
@@ -12,12 +13,93 @@ void FVoxelFastAABBTree::Initialize(FElementArray&& InElements)
 	check(Nodes.Num() == 0);
 	check(Leaves.Num() == 0);
 
-	const int32 NumElements = Elements.Num();
+	class FWriter : public IBuildWriter
+	{
+	public:
+		FVoxelFastAABBTree& Tree;
+
+		explicit FWriter(FVoxelFastAABBTree& Tree)
+			: Tree(Tree)
+		{
+		}
+
+		virtual void Reserve(const int32 ExpectedNumNodes, const int32 ExpectedNumLeaves) override
+		{
+			Tree.Nodes.Reserve(ExpectedNumNodes);
+			Tree.Leaves.Reserve(ExpectedNumLeaves);
+		}
+		virtual void SetLeaf(const int32 NodeIndex, const FElementArrayView& LeafElements) override
+		{
+			FNode& Node = GetNode(NodeIndex);
+			Node.bLeaf = true;
+			Node.LeafIndex = Tree.Leaves.Add(FLeaf{ LeafElements });
+		}
+		virtual void SetInnerNode(
+			const int32 NodeIndex,
+			const int32 ChildIndex0,
+			const FVector3f& ChildBounds0_Min,
+			const FVector3f& ChildBounds0_Max,
+			const int32 ChildIndex1,
+			const FVector3f& ChildBounds1_Min,
+			const FVector3f& ChildBounds1_Max) override
+		{
+			FNode& Node = GetNode(NodeIndex);
+			Node.bLeaf = false;
+			Node.ChildBounds0_Min = ChildBounds0_Min;
+			Node.ChildBounds0_Max = ChildBounds0_Max;
+			Node.ChildBounds1_Min = ChildBounds1_Min;
+			Node.ChildBounds1_Max = ChildBounds1_Max;
+			Node.ChildIndex0 = ChildIndex0;
+			Node.ChildIndex1 = ChildIndex1;
+		}
+
+	private:
+		FORCEINLINE FNode& GetNode(const int32 NodeIndex)
+		{
+			// Indices are allocated in order, but a node is only set once its children are allocated
+			if (Tree.Nodes.Num() <= NodeIndex)
+			{
+				Tree.Nodes.SetNum(NodeIndex + 1);
+			}
+			return Tree.Nodes[NodeIndex];
+		}
+	};
+
+	FElementArrayView AllElements;
+	AllElements.Payload = Elements.Payload;
+	AllElements.MinX = Elements.MinX;
+	AllElements.MinY = Elements.MinY;
+	AllElements.MinZ = Elements.MinZ;
+	AllElements.MaxX = Elements.MaxX;
+	AllElements.MaxY = Elements.MaxY;
+	AllElements.MaxZ = Elements.MaxZ;
+
+	FWriter Writer(*this);
+	Build(AllElements, MaxChildrenInLeaf, MaxTreeDepth, Writer);
+
+#if VOXEL_DEBUG
+	int32 NumElementsInLeaves = 0;
+	for (const FLeaf& Leaf : Leaves)
+	{
+		NumElementsInLeaves += Leaf.Elements.Num();
+	}
+	ensure(NumElementsInLeaves == Elements.Num());
+#endif
+}
+
+void FVoxelFastAABBTree::Build(
+	const FElementArrayView& AllElements,
+	const int32 MaxChildrenInLeaf,
+	const int32 MaxTreeDepth,
+	IBuildWriter& Writer)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(AllElements.Num(), 128);
+
+	const int32 NumElements = AllElements.Num();
 	const int32 ExpectedNumLeaves = 2 * FVoxelUtilities::DivideCeil(NumElements, MaxChildrenInLeaf);
 	const int32 ExpectedNumNodes = 2 * ExpectedNumLeaves;
 
-	Nodes.Reserve(ExpectedNumNodes);
-	Leaves.Reserve(ExpectedNumLeaves);
+	Writer.Reserve(ExpectedNumNodes, ExpectedNumLeaves);
 
 	struct FNodeToProcess
 	{
@@ -67,19 +149,14 @@ void FVoxelFastAABBTree::Initialize(FElementArray&& InElements)
 	};
 
 	TVoxelChunkedArray<FNodeToProcess> NodesToProcess;
+	int32 NumNodes = 0;
 
 	// Create root node
 	{
 		FNodeToProcess& RootNode = NodesToProcess.Emplace_GetRef();
-		RootNode.Elements.Payload = Elements.Payload;
-		RootNode.Elements.MinX = Elements.MinX;
-		RootNode.Elements.MinY = Elements.MinY;
-		RootNode.Elements.MinZ = Elements.MinZ;
-		RootNode.Elements.MaxX = Elements.MaxX;
-		RootNode.Elements.MaxY = Elements.MaxY;
-		RootNode.Elements.MaxZ = Elements.MaxZ;
+		RootNode.Elements = AllElements;
 		RootNode.NodeLevel = 0;
-		RootNode.NodeIndex = Nodes.Emplace();
+		RootNode.NodeIndex = NumNodes++;
 		RootNode.Compute();
 	}
 
@@ -87,30 +164,18 @@ void FVoxelFastAABBTree::Initialize(FElementArray&& InElements)
 	{
 		FNodeToProcess Parent = NodesToProcess.Pop();
 
-		Nodes.Reserve(Nodes.Num() + 2);
-
-		// Check Node will not be invalidated
-		const int32 CurrentNodesMax = Nodes.Max();
-		ON_SCOPE_EXIT
-		{
-			checkVoxelSlow(CurrentNodesMax == Nodes.Max());
-		};
-
-		FNode& ParentNode = Nodes[Parent.NodeIndex];
-
 		if (Parent.Elements.Num() <= MaxChildrenInLeaf ||
 			Parent.NodeLevel >= MaxTreeDepth)
 		{
-			ParentNode.bLeaf = true;
-			ParentNode.LeafIndex = Leaves.Add(FLeaf{ Parent.Elements });
+			Writer.SetLeaf(Parent.NodeIndex, Parent.Elements);
 			continue;
 		}
 
 		FNodeToProcess& Child0 = NodesToProcess.Emplace_GetRef();
 		FNodeToProcess& Child1 = NodesToProcess.Emplace_GetRef();
 
-		Child0.NodeIndex = Nodes.Emplace();
-		Child1.NodeIndex = Nodes.Emplace();
+		Child0.NodeIndex = NumNodes++;
+		Child1.NodeIndex = NumNodes++;
 
 		const EVoxelAxis SplitAxis = INLINE_LAMBDA
 		{
@@ -235,34 +300,111 @@ void FVoxelFastAABBTree::Initialize(FElementArray&& InElements)
 			Child1.Elements.Num() == 0)
 		{
 			ensure(false);
-			ParentNode.bLeaf = true;
-			ParentNode.LeafIndex = Leaves.Add(FLeaf{ Parent.Elements });
+			Writer.SetLeaf(Parent.NodeIndex, Parent.Elements);
 			continue;
 		}
 
 		Child0.Compute();
 		Child1.Compute();
 
-		ParentNode.bLeaf = false;
+		Writer.SetInnerNode(
+			Parent.NodeIndex,
+			Child0.NodeIndex,
+			FVector3f(Child0.MinX, Child0.MinY, Child0.MinZ),
+			FVector3f(Child0.MaxX, Child0.MaxY, Child0.MaxZ),
+			Child1.NodeIndex,
+			FVector3f(Child1.MinX, Child1.MinY, Child1.MinZ),
+			FVector3f(Child1.MaxX, Child1.MaxY, Child1.MaxZ));
+	}
+}
+
+void FVoxelFastAABBTree::Initialize(const FVoxelAABBTree& Tree)
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(Nodes.Num() == 0);
+	check(Leaves.Num() == 0);
+
+	const TConstVoxelArrayView<FVoxelAABBTree::FNode> SrcNodes = Tree.GetNodes();
+	const TConstVoxelArrayView<FVoxelAABBTree::FLeaf> SrcLeaves = Tree.GetLeaves();
+
+	const auto FloorToFloat = [](const double Value)
+	{
+		const float Result = float(Value);
+		return Result > Value ? std::nextafter(Result, -MAX_flt) : Result;
+	};
+	const auto CeilToFloat = [](const double Value)
+	{
+		const float Result = float(Value);
+		return Result < Value ? std::nextafter(Result, MAX_flt) : Result;
+	};
+	const auto FloorToFloatVector = [&](const FVector3d& Vector)
+	{
+		return FVector3f(FloorToFloat(Vector.X), FloorToFloat(Vector.Y), FloorToFloat(Vector.Z));
+	};
+	const auto CeilToFloatVector = [&](const FVector3d& Vector)
+	{
+		return FVector3f(CeilToFloat(Vector.X), CeilToFloat(Vector.Y), CeilToFloat(Vector.Z));
+	};
+
+	int32 NumElements = 0;
+	for (const FVoxelAABBTree::FLeaf& SrcLeaf : SrcLeaves)
+	{
+		NumElements += SrcLeaf.Elements.Num();
+	}
+	Elements.SetNum(NumElements);
+
+	FElementArrayView AllElements;
+	AllElements.Payload = Elements.Payload;
+	AllElements.MinX = Elements.MinX;
+	AllElements.MinY = Elements.MinY;
+	AllElements.MinZ = Elements.MinZ;
+	AllElements.MaxX = Elements.MaxX;
+	AllElements.MaxY = Elements.MaxY;
+	AllElements.MaxZ = Elements.MaxZ;
 
-		ParentNode.ChildBounds0_Min = FVector3f(Child0.MinX, Child0.MinY, Child0.MinZ);
-		ParentNode.ChildBounds0_Max = FVector3f(Child0.MaxX, Child0.MaxY, Child0.MaxZ);
+	Leaves.Reserve(SrcLeaves.Num());
 
-		ParentNode.ChildBounds1_Min = FVector3f(Child1.MinX, Child1.MinY, Child1.MinZ);
-		ParentNode.ChildBounds1_Max = FVector3f(Child1.MaxX, Child1.MaxY, Child1.MaxZ);
+	int32 ElementIndex = 0;
+	for (const FVoxelAABBTree::FLeaf& SrcLeaf : SrcLeaves)
+	{
+		const int32 FirstElementIndex = ElementIndex;
 
-		ParentNode.ChildIndex0 = Child0.NodeIndex;
-		ParentNode.ChildIndex1 = Child1.NodeIndex;
+		for (const FVoxelAABBTree::FElement& Element : SrcLeaf.Elements)
+		{
+			Elements.Payload[ElementIndex] = Element.Payload;
+			Elements.MinX[ElementIndex] = FloorToFloat(Element.Bounds.Min.X);
+			Elements.MinY[ElementIndex] = FloorToFloat(Element.Bounds.Min.Y);
+			Elements.MinZ[ElementIndex] = FloorToFloat(Element.Bounds.Min.Z);
+			Elements.MaxX[ElementIndex] = CeilToFloat(Element.Bounds.Max.X);
+			Elements.MaxY[ElementIndex] = CeilToFloat(Element.Bounds.Max.Y);
+			Elements.MaxZ[ElementIndex] = CeilToFloat(Element.Bounds.Max.Z);
+			ElementIndex++;
+		}
+
+		Leaves.Add(FLeaf{ AllElements.Slice(FirstElementIndex, SrcLeaf.Elements.Num()) });
 	}
+	check(ElementIndex == NumElements);
 
-#if VOXEL_DEBUG
-	int32 NumElementsInLeaves = 0;
-	for (const FLeaf& Leaf : Leaves)
+	Nodes.Reserve(SrcNodes.Num());
+
+	for (const FVoxelAABBTree::FNode& SrcNode : SrcNodes)
 	{
-		NumElementsInLeaves += Leaf.Elements.Num();
+		FNode& Node = Nodes.Emplace_GetRef();
+		Node.bLeaf = SrcNode.bLeaf;
+
+		if (SrcNode.bLeaf)
+		{
+			Node.LeafIndex = SrcNode.LeafIndex;
+			continue;
+		}
+
+		Node.ChildBounds0_Min = FloorToFloatVector(SrcNode.ChildBounds0.Min);
+		Node.ChildBounds0_Max = CeilToFloatVector(SrcNode.ChildBounds0.Max);
+		Node.ChildBounds1_Min = FloorToFloatVector(SrcNode.ChildBounds1.Min);
+		Node.ChildBounds1_Max = CeilToFloatVector(SrcNode.ChildBounds1.Max);
+		Node.ChildIndex0 = SrcNode.ChildIndex0;
+		Node.ChildIndex1 = SrcNode.ChildIndex1;
 	}
-	ensure(NumElementsInLeaves == NumElements);
-#endif
 }
 
 void FVoxelFastAABBTree::Shrink()
@@ -271,4 +413,92 @@ void FVoxelFastAABBTree::Shrink()
 
 	Nodes.Shrink();
 	Leaves.Shrink();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelFastAABBTree::RaycastPackets(
+	const TConstVoxelArrayView<FVector3f> RayPositions,
+	const TConstVoxelArrayView<FVector3f> RayDirections,
+	const FRaycastPacketsLambda Lambda) const
+{
+	VOXEL_FUNCTION_COUNTER_NUM(RayPositions.Num(), 128);
+	check(RayPositions.Num() == RayDirections.Num());
+	// Traversal stack size in the kernel is 64, and a stack never holds more than MaxTreeDepth + 1 nodes
+	check(MaxTreeDepth < 64);
+
+	checkStatic(sizeof(FNode) == sizeof(ispc::FVoxelFastAABBTreeNode));
+	checkStatic(offsetof(FNode, ChildBounds1_Max) == offsetof(ispc::FVoxelFastAABBTreeNode, ChildBounds1_Max));
+	checkStatic(offsetof(FNode, ChildIndex0) == offsetof(ispc::FVoxelFastAABBTreeNode, ChildIndex0));
+	checkStatic(offsetof(FNode, ChildIndex1) == offsetof(ispc::FVoxelFastAABBTreeNode, ChildIndex1));
+	checkStatic(offsetof(FNode, bLeaf) == offsetof(ispc::FVoxelFastAABBTreeNode, bLeaf));
+	checkStatic(sizeof(bool) == sizeof(uint8));
+
+	if (Nodes.Num() == 0 ||
+		Elements.Num() == 0 ||
+		RayPositions.Num() == 0)
+	{
+		return;
+	}
+
+	TVoxelArray<int32> LeafOffsets;
+	TVoxelArray<int32> LeafNums;
+	FVoxelUtilities::SetNumFast(LeafOffsets, Leaves.Num());
+	FVoxelUtilities::SetNumFast(LeafNums, Leaves.Num());
+
+	for (int32 Index = 0; Index < Leaves.Num(); Index++)
+	{
+		const FElementArrayView& LeafElements = Leaves[Index].Elements;
+		LeafOffsets[Index] = int32(LeafElements.Payload.GetData() - Elements.Payload.GetData());
+		LeafNums[Index] = LeafElements.Num();
+	}
+
+	TVoxelArray<int32> HitRayIndices;
+	TVoxelArray<int32> HitPayloads;
+	FVoxelUtilities::SetNumFast(HitRayIndices, 16384);
+	FVoxelUtilities::SetNumFast(HitPayloads, 16384);
+
+	int32 FirstRay = 0;
+	while (FirstRay < RayPositions.Num())
+	{
+		int32 NumHits = 0;
+		const int32 NextRay = ispc::VoxelFastAABBTree_RaycastPackets(
+			ReinterpretCastPtr<ispc::FVoxelFastAABBTreeNode>(Nodes.GetData()),
+			LeafOffsets.GetData(),
+			LeafNums.GetData(),
+			Elements.Payload.GetData(),
+			Elements.MinX.GetData(),
+			Elements.MinY.GetData(),
+			Elements.MinZ.GetData(),
+			Elements.MaxX.GetData(),
+			Elements.MaxY.GetData(),
+			Elements.MaxZ.GetData(),
+			ReinterpretCastPtr<ispc::float3>(RayPositions.GetData()),
+			ReinterpretCastPtr<ispc::float3>(RayDirections.GetData()),
+			FirstRay,
+			RayPositions.Num(),
+			HitRayIndices.GetData(),
+			HitPayloads.GetData(),
+			HitRayIndices.Num(),
+			NumHits);
+
+		if (NumHits > 0)
+		{
+			Lambda(
+				TConstVoxelArrayView<int32>(HitRayIndices).LeftOf(NumHits),
+				TConstVoxelArrayView<int32>(HitPayloads).LeftOf(NumHits));
+		}
+
+		if (NextRay == FirstRay)
+		{
+			// A single packet doesn't fit in the hit buffer
+			check(NumHits == 0);
+			FVoxelUtilities::SetNumFast(HitRayIndices, 2 * HitRayIndices.Num());
+			FVoxelUtilities::SetNumFast(HitPayloads, 2 * HitPayloads.Num());
+		}
+
+		FirstRay = NextRay;
+	}
 }
\ No newline at end of file
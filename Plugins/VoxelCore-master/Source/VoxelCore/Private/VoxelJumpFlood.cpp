@@ -1,6 +1,7 @@
 // Copyright Voxel Plugin SAS. All Rights Reserved.
 
 #include "VoxelJumpFlood.h"
+#include "VoxelJumpFloodImpl.ispc.generated.h"
 #if WITH_EDITOR
 #include "Misc/ScopedSlowTask.h"
 #endif
@@ -12,6 +13,84 @@ void FVoxelJumpFlood::JumpFlood2D(
 	VOXEL_SCOPE_COUNTER_FORMAT("JumpFlood2D %dx%d", Size.X, Size.Y);
 	check(InOutClosestPosition.Num() == Size.X * Size.Y);
 
+	// SoA so that the kernel loads are contiguous
+	TVoxelArray<int32> ClosestX;
+	TVoxelArray<int32> ClosestY;
+	TVoxelArray<int32> TempX;
+	TVoxelArray<int32> TempY;
+	FVoxelUtilities::SetNumFast(ClosestX, Size.X * Size.Y);
+	FVoxelUtilities::SetNumFast(ClosestY, Size.X * Size.Y);
+	FVoxelUtilities::SetNumFast(TempX, Size.X * Size.Y);
+	FVoxelUtilities::SetNumFast(TempY, Size.X * Size.Y);
+
+	{
+		VOXEL_SCOPE_COUNTER("Split");
+
+		ParallelFor(Size.Y, [&](const int32 Y)
+		{
+			for (int32 Index = Size.X * Y; Index < Size.X * (Y + 1); Index++)
+			{
+				ClosestX[Index] = InOutClosestPosition[Index].X;
+				ClosestY[Index] = InOutClosestPosition[Index].Y;
+			}
+		});
+	}
+
+	const int32 NumPasses = FMath::CeilLogTwo(Size.GetMax());
+
+#if WITH_EDITOR
+	FScopedSlowTask SlowTask(NumPasses + 1, INVTEXT("Performing Jump Flood"));
+	SlowTask.EnterProgressFrame();
+#endif
+
+	for (int32 Pass = 0; Pass < NumPasses; Pass++)
+	{
+		// -1: we want to start with half the size
+		const int32 Step = 1 << (NumPasses - 1 - Pass);
+
+		VOXEL_SCOPE_COUNTER_FORMAT("JumpFlood2D Step=%d", Step);
+
+		ParallelFor(Size.Y, [&](const int32 Y)
+		{
+			ispc::VoxelJumpFlood_JumpFlood2D(
+				Y,
+				Size.X,
+				Size.Y,
+				Step,
+				ClosestX.GetData(),
+				ClosestY.GetData(),
+				TempX.GetData(),
+				TempY.GetData());
+		});
+
+		Swap(ClosestX, TempX);
+		Swap(ClosestY, TempY);
+
+#if WITH_EDITOR
+		SlowTask.EnterProgressFrame(1.f, FText::FromString("Performing Jump Flood " + LexToString(Pass + 1) + " of " + LexToString(NumPasses)));
+#endif
+	}
+
+	{
+		VOXEL_SCOPE_COUNTER("Merge");
+
+		ParallelFor(Size.Y, [&](const int32 Y)
+		{
+			for (int32 Index = Size.X * Y; Index < Size.X * (Y + 1); Index++)
+			{
+				InOutClosestPosition[Index] = FIntPoint(ClosestX[Index], ClosestY[Index]);
+			}
+		});
+	}
+}
+
+void FVoxelJumpFlood::JumpFlood2D_Reference(
+	const FIntPoint& Size,
+	const TVoxelArrayView<FIntPoint> InOutClosestPosition)
+{
+	VOXEL_SCOPE_COUNTER_FORMAT("JumpFlood2D_Reference %dx%d", Size.X, Size.Y);
+	check(InOutClosestPosition.Num() == Size.X * Size.Y);
+
 	TVoxelArray<FIntPoint> Temp;
 	FVoxelUtilities::SetNumFast(Temp, Size.X * Size.Y);
 
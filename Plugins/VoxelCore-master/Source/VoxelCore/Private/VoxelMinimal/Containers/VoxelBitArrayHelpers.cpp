@@ -734,5 +734,285 @@ TVoxelArray<FVoxelIntBox> FVoxelBitArrayHelpers::GreedyMeshing3D(
 		}
 	}
 
+	return Result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Copy of a Z slab with every row padded to whole uint64 words, so that runs can be found with bit scans
+class FVoxelGreedyMeshingSlab
+{
+public:
+	static constexpr int32 NumBitsPerWord = 64;
+
+	const int32 SizeX;
+	const int32 SizeY;
+	const int32 SizeZ;
+	const int32 NumRowWords;
+	TVoxelArray<uint64> Words;
+
+	FVoxelGreedyMeshingSlab(
+		const TConstVoxelArrayView<uint32> Data,
+		const FIntVector& Size,
+		const int32 MinZ,
+		const int32 MaxZ)
+		: SizeX(Size.X)
+		, SizeY(Size.Y)
+		, SizeZ(MaxZ - MinZ)
+		, NumRowWords(FVoxelUtilities::DivideCeil_Positive(Size.X, NumBitsPerWord))
+	{
+		VOXEL_FUNCTION_COUNTER();
+
+		// Padding must be zero so that runs stop at the end of rows
+		FVoxelUtilities::SetNumZeroed(Words, NumRowWords * SizeY * SizeZ);
+
+		for (int32 Z = 0; Z < SizeZ; Z++)
+		{
+			for (int32 Y = 0; Y < SizeY; Y++)
+			{
+				FVoxelBitArrayHelpers::Copy(
+					reinterpret_cast<uint32*>(GetRow(Y, Z)),
+					Data.GetData(),
+					0,
+					FVoxelUtilities::Get3DIndex<int64>(Size, 0, Y, MinZ + Z),
+					SizeX);
+			}
+		}
+	}
+
+	FORCEINLINE uint64* GetRow(const int32 Y, const int32 Z)
+	{
+		checkVoxelSlow(0 <= Y && Y < SizeY);
+		checkVoxelSlow(0 <= Z && Z < SizeZ);
+		return &Words[NumRowWords * (Y + SizeY * Z)];
+	}
+
+	// Number of consecutive set bits starting at X
+	FORCEINLINE int32 CountRun(const uint64* RESTRICT Row, const int32 X) const
+	{
+		int32 WordIndex = X / NumBitsPerWord;
+		int32 Offset = X % NumBitsPerWord;
+
+		int32 Num = 0;
+		while (WordIndex < NumRowWords)
+		{
+			// Bits shifted in are zeros, ie ones once flipped: Count is at most NumBitsPerWord - Offset
+			const int32 Count = FPlatformMath::CountTrailingZeros64(~(Row[WordIndex] >> Offset));
+			Num += Count;
+
+			if (Count < NumBitsPerWord - Offset)
+			{
+				break;
+			}
+
+			WordIndex++;
+			Offset = 0;
+		}
+		return Num;
+	}
+
+	template<typename LambdaType>
+	FORCEINLINE static void ForAllWords(
+		const int32 X,
+		const int32 Num,
+		LambdaType&& Lambda)
+	{
+		checkVoxelSlow(Num > 0);
+
+		const int32 FirstWord = X / NumBitsPerWord;
+		const int32 LastWord = (X + Num - 1) / NumBitsPerWord;
+
+		for (int32 WordIndex = FirstWord; WordIndex <= LastWord; WordIndex++)
+		{
+			uint64 Mask = ~uint64(0);
+			if (WordIndex == FirstWord)
+			{
+				Mask &= ~uint64(0) << (X % NumBitsPerWord);
+			}
+			if (WordIndex == LastWord)
+			{
+				Mask &= ~uint64(0) >> (NumBitsPerWord - 1 - (X + Num - 1) % NumBitsPerWord);
+			}
+
+			if (!Lambda(WordIndex, Mask))
+			{
+				return;
+			}
+		}
+	}
+	FORCEINLINE static bool TestRange(const uint64* RESTRICT Row, const int32 X, const int32 Num)
+	{
+		bool bResult = true;
+		ForAllWords(X, Num, [&](const int32 WordIndex, const uint64 Mask)
+		{
+			bResult = (Row[WordIndex] & Mask) == Mask;
+			return bResult;
+		});
+		return bResult;
+	}
+	FORCEINLINE static void ClearRange(uint64* RESTRICT Row, const int32 X, const int32 Num)
+	{
+		ForAllWords(X, Num, [&](const int32 WordIndex, const uint64 Mask)
+		{
+			Row[WordIndex] &= ~Mask;
+			return true;
+		});
+	}
+
+	void Mesh(
+		const int32 OffsetZ,
+		TVoxelArray<FVoxelIntBox>& OutBoxes)
+	{
+		VOXEL_FUNCTION_COUNTER();
+
+		for (int32 Z = 0; Z < SizeZ; Z++)
+		{
+			for (int32 Y = 0; Y < SizeY; Y++)
+			{
+				uint64* RESTRICT Row = GetRow(Y, Z);
+
+				for (int32 WordIndex = 0; WordIndex < NumRowWords; WordIndex++)
+				{
+					while (Row[WordIndex] != 0)
+					{
+						const int32 X = WordIndex * NumBitsPerWord + FPlatformMath::CountTrailingZeros64(Row[WordIndex]);
+
+						const int32 BoxSizeX = CountRun(Row, X);
+						ClearRange(Row, X, BoxSizeX);
+
+						int32 BoxSizeY = 1;
+						while (
+							Y + BoxSizeY < SizeY &&
+							TestRange(GetRow(Y + BoxSizeY, Z), X, BoxSizeX))
+						{
+							ClearRange(GetRow(Y + BoxSizeY, Z), X, BoxSizeX);
+							BoxSizeY++;
+						}
+
+						const auto TestAndClearBlock = [&](const int32 BlockZ)
+						{
+							for (int32 Index = 0; Index < BoxSizeY; Index++)
+							{
+								if (!TestRange(GetRow(Y + Index, BlockZ), X, BoxSizeX))
+								{
+									return false;
+								}
+							}
+
+							for (int32 Index = 0; Index < BoxSizeY; Index++)
+							{
+								ClearRange(GetRow(Y + Index, BlockZ), X, BoxSizeX);
+							}
+							return true;
+						};
+
+						int32 BoxSizeZ = 1;
+						while (
+							Z + BoxSizeZ < SizeZ &&
+							TestAndClearBlock(Z + BoxSizeZ))
+						{
+							BoxSizeZ++;
+						}
+
+						OutBoxes.Add(FVoxelIntBox(
+							FIntVector(X, Y, OffsetZ + Z),
+							FIntVector(X + BoxSizeX, Y + BoxSizeY, OffsetZ + Z + BoxSizeZ)));
+					}
+				}
+			}
+		}
+	}
+};
+
+TVoxelArray<FVoxelIntBox> FVoxelBitArrayHelpers::GreedyMeshing3D_Parallel(
+	const TConstVoxelArrayView<uint32> Data,
+	const FIntVector& Size)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Size.X * Size.Y * Size.Z, 1024);
+	checkVoxelSlow(Size.X * Size.Y * Size.Z <= Data.Num() * NumBitsPerWord);
+
+	if (Size.X * Size.Y * Size.Z == 0)
+	{
+		return {};
+	}
+
+	// Thin slabs would split too many boxes
+	constexpr int32 MinSlabSize = 16;
+	const int32 NumSlabs = FMath::Clamp(
+		FVoxelUtilities::GetNumBackgroundWorkerThreads(),
+		1,
+		FVoxelUtilities::DivideCeil_Positive(Size.Z, MinSlabSize));
+
+	const auto GetSlabMinZ = [&](const int32 SlabIndex)
+	{
+		return int32(int64(Size.Z) * SlabIndex / NumSlabs);
+	};
+
+	TVoxelArray<TVoxelArray<FVoxelIntBox>> SlabToBoxes;
+	SlabToBoxes.SetNum(NumSlabs);
+
+	ParallelFor(NumSlabs, [&](const int32 SlabIndex)
+	{
+		const int32 MinZ = GetSlabMinZ(SlabIndex);
+		const int32 MaxZ = GetSlabMinZ(SlabIndex + 1);
+
+		FVoxelGreedyMeshingSlab Slab(Data, Size, MinZ, MaxZ);
+		Slab.Mesh(MinZ, SlabToBoxes[SlabIndex]);
+	});
+
+	VOXEL_SCOPE_COUNTER("Merge seams");
+
+	int32 NumBoxes = 0;
+	for (const TVoxelArray<FVoxelIntBox>& Boxes : SlabToBoxes)
+	{
+		NumBoxes += Boxes.Num();
+	}
+
+	TVoxelArray<FVoxelIntBox> Result;
+	Result.Reserve(NumBoxes);
+
+	// Boxes touching the top of the previous slab don't overlap: their min corner is enough to find them
+	TVoxelMap<FIntPoint, int32> SeamToBoxIndex;
+	TVoxelMap<FIntPoint, int32> NewSeamToBoxIndex;
+
+	for (int32 SlabIndex = 0; SlabIndex < NumSlabs; SlabIndex++)
+	{
+		const int32 MaxZ = GetSlabMinZ(SlabIndex + 1);
+
+		NewSeamToBoxIndex.Reset();
+
+		for (const FVoxelIntBox& Box : SlabToBoxes[SlabIndex])
+		{
+			int32 BoxIndex = -1;
+
+			if (const int32* OtherBoxIndex = SeamToBoxIndex.Find(FIntPoint(Box.Min.X, Box.Min.Y)))
+			{
+				FVoxelIntBox& OtherBox = Result[*OtherBoxIndex];
+
+				if (OtherBox.Max.Z == Box.Min.Z &&
+					OtherBox.Max.X == Box.Max.X &&
+					OtherBox.Max.Y == Box.Max.Y)
+				{
+					OtherBox.Max.Z = Box.Max.Z;
+					BoxIndex = *OtherBoxIndex;
+				}
+			}
+
+			if (BoxIndex == -1)
+			{
+				BoxIndex = Result.Add(Box);
+			}
+
+			if (Box.Max.Z == MaxZ)
+			{
+				NewSeamToBoxIndex.Add_CheckNew(FIntPoint(Box.Min.X, Box.Min.Y), BoxIndex);
+			}
+		}
+
+		Swap(SeamToBoxIndex, NewSeamToBoxIndex);
+	}
+
 	return Result;
 }
\ No newline at end of file
@@ -487,31 +487,64 @@ bool FVoxelUtilities::Decompress(
 		return true;
 	}
 
-	if (!ensureVoxelSlow(CompressedData.Num() >= sizeof(FVoxelOodleHeader)))
+	const int64 UncompressedSize = GetDecompressedSize(CompressedData);
+	if (!ensureVoxelSlow(UncompressedSize != -1))
 	{
 		return false;
 	}
 
+	TVoxelArray64<uint8> UncompressedData;
+	FVoxelUtilities::SetNumFast(UncompressedData, UncompressedSize);
+
+	if (!Decompress(CompressedData, MakeVoxelArrayView(UncompressedData), bAllowParallel))
+	{
+		return false;
+	}
+
+	OutData = MoveTemp(UncompressedData);
+	return true;
+}
+
+int64 FVoxelUtilities::GetDecompressedSize(const TConstVoxelArrayView64<uint8> CompressedData)
+{
+	if (!IsCompressedData(CompressedData))
+	{
+		return -1;
+	}
+
 	const TConstVoxelArrayView<uint8> HeaderBytes = MakeVoxelArrayView(CompressedData).LeftOf(sizeof(FVoxelOodleHeader));
 	const FVoxelOodleHeader Header = CastBytes<FVoxelOodleHeader>(HeaderBytes);
 
-	if (!ensureVoxelSlow(Header.Tag == FVoxelOodleHeader().Tag) ||
-		!ensureVoxelSlow(sizeof(FVoxelOodleHeader) + Header.CompressedSize == CompressedData.Num()))
+	if (sizeof(FVoxelOodleHeader) + Header.CompressedSize != CompressedData.Num() ||
+		Header.UncompressedSize < 0)
 	{
-		return false;
+		return -1;
 	}
 
-	using namespace FOodleDataCompression;
+	return Header.UncompressedSize;
+}
 
-	TVoxelArray64<uint8> UncompressedData;
-	FVoxelUtilities::SetNumFast(UncompressedData, Header.UncompressedSize);
+bool FVoxelUtilities::Decompress(
+	const TConstVoxelArrayView64<uint8> CompressedData,
+	const TVoxelArrayView64<uint8> OutData,
+	const bool bAllowParallel)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (!ensureVoxelSlow(GetDecompressedSize(CompressedData) == OutData.Num()))
+	{
+		return false;
+	}
+
+	const TConstVoxelArrayView<uint8> HeaderBytes = MakeVoxelArrayView(CompressedData).LeftOf(sizeof(FVoxelOodleHeader));
+	const FVoxelOodleHeader Header = CastBytes<FVoxelOodleHeader>(HeaderBytes);
 
 	if (bAllowParallel)
 	{
 		VOXEL_SCOPE_COUNTER_FORMAT("DecompressParallel %lldB", Header.UncompressedSize);
 
 		if (!ensure(FOodleDataCompression::DecompressParallel(
-			UncompressedData.GetData(),
+			OutData.GetData(),
 			Header.UncompressedSize,
 			CompressedData.GetData() + sizeof(FVoxelOodleHeader),
 			Header.CompressedSize)))
@@ -524,7 +557,7 @@ bool FVoxelUtilities::Decompress(
 		VOXEL_SCOPE_COUNTER_FORMAT("Decompress %lldB", Header.UncompressedSize);
 
 		if (!ensure(FOodleDataCompression::Decompress(
-			UncompressedData.GetData(),
+			OutData.GetData(),
 			Header.UncompressedSize,
 			CompressedData.GetData() + sizeof(FVoxelOodleHeader),
 			Header.CompressedSize)))
@@ -533,6 +566,5 @@ bool FVoxelUtilities::Decompress(
 		}
 	}
 
-	OutData = MoveTemp(UncompressedData);
 	return true;
 }
\ No newline at end of file
@@ -55,6 +55,9 @@ void JumpFloodImpl(
 					Size.X,
 					Size.Y,
 					Size.Z,
+					0,
+					0,
+					0,
 					Distances.GetData(),
 					ClosestX.GetData(),
 					ClosestY.GetData(),
@@ -138,6 +141,9 @@ void JumpFloodImpl(
 					Size.X,
 					Size.Y,
 					Size.Z,
+					0,
+					0,
+					0,
 					ClosestX.GetData(),
 					ClosestY.GetData(),
 					ClosestZ.GetData(),
@@ -183,6 +189,419 @@ void JumpFloodImpl(
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+class FVoxelEuclideanDistanceTransformLine
+{
+public:
+	explicit FVoxelEuclideanDistanceTransformLine(const int32 MaxNum)
+	{
+		FVoxelUtilities::SetNumFast(Candidates, MaxNum);
+		FVoxelUtilities::SetNumFast(Envelope, MaxNum);
+		FVoxelUtilities::SetNumFast(Starts, MaxNum);
+	}
+
+	// Replaces the closest points of a line of Num voxels along Axis by the closest of all the line's closest points
+	// LinePosition is the position of the first voxel of the line
+	void Process(
+		const int32 Axis,
+		const FVector3f& LinePosition,
+		const int32 Num,
+		float* RESTRICT ClosestX,
+		float* RESTRICT ClosestY,
+		float* RESTRICT ClosestZ)
+	{
+		checkVoxelSlow(Num <= Candidates.Num());
+
+		const float* Closest[] = { ClosestX, ClosestY, ClosestZ };
+		const int32 AxisU = (Axis + 1) % 3;
+		const int32 AxisV = (Axis + 2) % 3;
+
+		int32 NumCandidates = 0;
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			if (FMath::IsNaN(ClosestX[Index]))
+			{
+				continue;
+			}
+
+			FCandidate Candidate;
+			Candidate.Point = FVector3f(ClosestX[Index], ClosestY[Index], ClosestZ[Index]);
+			Candidate.Vertex = Closest[Axis][Index];
+			Candidate.Height =
+				FMath::Square<double>(Closest[AxisU][Index] - LinePosition[AxisU]) +
+				FMath::Square<double>(Closest[AxisV][Index] - LinePosition[AxisV]);
+
+			// Seeds are sub-voxel so vertices are only almost sorted: insertion sort is close to linear
+			int32 InsertIndex = NumCandidates;
+			while (
+				InsertIndex > 0 &&
+				Candidates[InsertIndex - 1].Vertex > Candidate.Vertex)
+			{
+				Candidates[InsertIndex] = Candidates[InsertIndex - 1];
+				InsertIndex--;
+			}
+			Candidates[InsertIndex] = Candidate;
+			NumCandidates++;
+		}
+
+		if (NumCandidates == 0)
+		{
+			// Closest are all NaN already
+			return;
+		}
+
+		// Lower envelope of the parabolas (X - Vertex)^2 + Height
+		int32 NumEnvelope = 0;
+		for (int32 CandidateIndex = 0; CandidateIndex < NumCandidates; CandidateIndex++)
+		{
+			const FCandidate& Candidate = Candidates[CandidateIndex];
+
+			double Start = -MAX_dbl;
+			bool bIsHidden = false;
+			while (NumEnvelope > 0)
+			{
+				const FCandidate& Top = Candidates[Envelope[NumEnvelope - 1]];
+
+				if (Top.Vertex == Candidate.Vertex)
+				{
+					if (Top.Height <= Candidate.Height)
+					{
+						bIsHidden = true;
+						break;
+					}
+
+					NumEnvelope--;
+					continue;
+				}
+
+				// Position after which Candidate is below Top
+				const double Intersection =
+					((Candidate.Height + FMath::Square(Candidate.Vertex)) - (Top.Height + FMath::Square(Top.Vertex))) /
+					(2. * (Candidate.Vertex - Top.Vertex));
+
+				if (Intersection <= Starts[NumEnvelope - 1])
+				{
+					// Top is never the lowest
+					NumEnvelope--;
+					continue;
+				}
+
+				Start = Intersection;
+				break;
+			}
+
+			if (bIsHidden)
+			{
+				continue;
+			}
+
+			Envelope[NumEnvelope] = CandidateIndex;
+			Starts[NumEnvelope] = Start;
+			NumEnvelope++;
+		}
+		checkVoxelSlow(NumEnvelope > 0);
+
+		int32 EnvelopeIndex = 0;
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			while (
+				EnvelopeIndex + 1 < NumEnvelope &&
+				Starts[EnvelopeIndex + 1] < LinePosition[Axis] + Index)
+			{
+				EnvelopeIndex++;
+			}
+
+			const FVector3f Point = Candidates[Envelope[EnvelopeIndex]].Point;
+			ClosestX[Index] = Point.X;
+			ClosestY[Index] = Point.Y;
+			ClosestZ[Index] = Point.Z;
+		}
+	}
+
+private:
+	struct FCandidate
+	{
+		double Vertex;
+		double Height;
+		FVector3f Point;
+	};
+	TVoxelArray<FCandidate> Candidates;
+	TVoxelArray<int32> Envelope;
+	TVoxelArray<double> Starts;
+};
+
+// Origin is the position of the first voxel, to work on a part of a larger volume
+void EuclideanDistanceTransform_Initialize(
+	const FIntVector& Size,
+	const FIntVector& Origin,
+	const TConstVoxelArrayView<float> Distances,
+	TVoxelArray<float>& ClosestX,
+	TVoxelArray<float>& ClosestY,
+	TVoxelArray<float>& ClosestZ)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	FVoxelParallelTaskScope Scope;
+
+	for (int32 Z = 0; Z < Size.Z; Z++)
+	{
+		Scope.AddTask([&, Z]
+		{
+			VOXEL_SCOPE_COUNTER_FORMAT("FVoxelUtilities::EuclideanDistanceTransform Initialize Num=%d", Size.X * Size.Y);
+
+			ispc::VoxelDistanceFieldUtilities_JumpFlood_Initialize(
+				Z,
+				Size.X,
+				Size.Y,
+				Size.Z,
+				Origin.X,
+				Origin.Y,
+				Origin.Z,
+				Distances.GetData(),
+				ClosestX.GetData(),
+				ClosestY.GetData(),
+				ClosestZ.GetData());
+		});
+	}
+}
+
+void EuclideanDistanceTransform_Passes(
+	const FIntVector& Size,
+	const FIntVector& Origin,
+	TVoxelArray<float>& ClosestX,
+	TVoxelArray<float>& ClosestY,
+	TVoxelArray<float>& ClosestZ)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	{
+		VOXEL_SCOPE_COUNTER("Rows");
+
+		FVoxelParallelTaskScope Scope;
+
+		for (int32 Z = 0; Z < Size.Z; Z++)
+		{
+			Scope.AddTask([&, Z]
+			{
+				VOXEL_SCOPE_COUNTER_FORMAT("FVoxelUtilities::EuclideanDistanceTransform Rows Num=%d", Size.X * Size.Y);
+
+				FVoxelEuclideanDistanceTransformLine Line(Size.X);
+
+				for (int32 Y = 0; Y < Size.Y; Y++)
+				{
+					const int32 Index = FVoxelUtilities::Get3DIndex<int32>(Size, 0, Y, Z);
+
+					Line.Process(
+						0,
+						FVector3f(Origin.X, Origin.Y + Y, Origin.Z + Z),
+						Size.X,
+						&ClosestX[Index],
+						&ClosestY[Index],
+						&ClosestZ[Index]);
+				}
+			});
+		}
+	}
+
+	// Columns and slices are strided: transpose them into a per-task plane so that each line is contiguous
+	const auto ProcessTransposed = [&](
+		const int32 Axis,
+		const int32 PlaneAxis,
+		const int32 PlanePosition)
+	{
+		const int32 OtherAxis = 3 - Axis - PlaneAxis;
+		const int32 NumLines = Size[OtherAxis];
+		const int32 LineSize = Size[Axis];
+
+		int32 Strides[3];
+		Strides[0] = 1;
+		Strides[1] = Size.X;
+		Strides[2] = Size.X * Size.Y;
+
+		TVoxelArray<float> PlaneX;
+		TVoxelArray<float> PlaneY;
+		TVoxelArray<float> PlaneZ;
+		FVoxelUtilities::SetNumFast(PlaneX, NumLines * LineSize);
+		FVoxelUtilities::SetNumFast(PlaneY, NumLines * LineSize);
+		FVoxelUtilities::SetNumFast(PlaneZ, NumLines * LineSize);
+
+		const int32 BaseIndex = PlanePosition * Strides[PlaneAxis];
+
+		// Iterate lines innermost: OtherAxis is always X, the contiguous axis of the volume
+		for (int32 IndexInLine = 0; IndexInLine < LineSize; IndexInLine++)
+		{
+			for (int32 LineIndex = 0; LineIndex < NumLines; LineIndex++)
+			{
+				const int32 Index = BaseIndex + LineIndex * Strides[OtherAxis] + IndexInLine * Strides[Axis];
+				const int32 PlaneIndex = IndexInLine + LineIndex * LineSize;
+
+				PlaneX[PlaneIndex] = ClosestX[Index];
+				PlaneY[PlaneIndex] = ClosestY[Index];
+				PlaneZ[PlaneIndex] = ClosestZ[Index];
+			}
+		}
+
+		FVoxelEuclideanDistanceTransformLine Line(LineSize);
+
+		for (int32 LineIndex = 0; LineIndex < NumLines; LineIndex++)
+		{
+			FVector3f LinePosition = FVector3f(Origin);
+			LinePosition[PlaneAxis] += PlanePosition;
+			LinePosition[OtherAxis] += LineIndex;
+
+			Line.Process(
+				Axis,
+				LinePosition,
+				LineSize,
+				&PlaneX[LineIndex * LineSize],
+				&PlaneY[LineIndex * LineSize],
+				&PlaneZ[LineIndex * LineSize]);
+		}
+
+		for (int32 IndexInLine = 0; IndexInLine < LineSize; IndexInLine++)
+		{
+			for (int32 LineIndex = 0; LineIndex < NumLines; LineIndex++)
+			{
+				const int32 Index = BaseIndex + LineIndex * Strides[OtherAxis] + IndexInLine * Strides[Axis];
+				const int32 PlaneIndex = IndexInLine + LineIndex * LineSize;
+
+				ClosestX[Index] = PlaneX[PlaneIndex];
+				ClosestY[Index] = PlaneY[PlaneIndex];
+				ClosestZ[Index] = PlaneZ[PlaneIndex];
+			}
+		}
+	};
+
+	{
+		VOXEL_SCOPE_COUNTER("Columns");
+
+		FVoxelParallelTaskScope Scope;
+
+		for (int32 Z = 0; Z < Size.Z; Z++)
+		{
+			Scope.AddTask([&, Z]
+			{
+				VOXEL_SCOPE_COUNTER_FORMAT("FVoxelUtilities::EuclideanDistanceTransform Columns Num=%d", Size.X * Size.Y);
+				ProcessTransposed(1, 2, Z);
+			});
+		}
+	}
+
+	{
+		VOXEL_SCOPE_COUNTER("Slices");
+
+		FVoxelParallelTaskScope Scope;
+
+		for (int32 Y = 0; Y < Size.Y; Y++)
+		{
+			Scope.AddTask([&, Y]
+			{
+				VOXEL_SCOPE_COUNTER_FORMAT("FVoxelUtilities::EuclideanDistanceTransform Slices Num=%d", Size.X * Size.Z);
+				ProcessTransposed(2, 1, Y);
+			});
+		}
+	}
+}
+
+void EuclideanDistanceTransformImpl(
+	const FIntVector& Size,
+	const TVoxelArrayView<float> Distances,
+	TVoxelArray<float>* OutClosestX,
+	TVoxelArray<float>* OutClosestY,
+	TVoxelArray<float>* OutClosestZ)
+{
+	VOXEL_FUNCTION_COUNTER();
+	VOXEL_SCOPE_COUNTER_FORMAT("EuclideanDistanceTransform %dx%dx%d Num=%d", Size.X, Size.Y, Size.Z, Size.X * Size.Y * Size.Z);
+
+	const int64 SizeXYZ = Size.X * Size.Y * Size.Z;
+	if (!ensureVoxelSlow(SizeXYZ < 1024 * 1024 * 1024))
+	{
+		return;
+	}
+
+	TVoxelArray<float> ClosestX;
+	TVoxelArray<float> ClosestY;
+	TVoxelArray<float> ClosestZ;
+
+	{
+		VOXEL_SCOPE_COUNTER("SetNumFast");
+
+		FVoxelUtilities::SetNumFast(ClosestX, SizeXYZ);
+		FVoxelUtilities::SetNumFast(ClosestY, SizeXYZ);
+		FVoxelUtilities::SetNumFast(ClosestZ, SizeXYZ);
+	}
+
+	EuclideanDistanceTransform_Initialize(
+		Size,
+		FIntVector(0),
+		Distances,
+		ClosestX,
+		ClosestY,
+		ClosestZ);
+
+	EuclideanDistanceTransform_Passes(
+		Size,
+		FIntVector(0),
+		ClosestX,
+		ClosestY,
+		ClosestZ);
+
+	{
+		VOXEL_SCOPE_COUNTER("ComputeDistances");
+
+		FVoxelParallelTaskScope Scope;
+
+		for (int32 Z = 0; Z < Size.Z; Z++)
+		{
+			Scope.AddTask([&, Z]
+			{
+				VOXEL_SCOPE_COUNTER_FORMAT("FVoxelUtilities::EuclideanDistanceTransform ComputeDistances Num=%d", Size.X * Size.Y);
+
+				ispc::VoxelDistanceFieldUtilities_JumpFlood_ComputeDistances(
+					Z,
+					Size.X,
+					Size.Y,
+					Size.Z,
+					0,
+					0,
+					0,
+					ClosestX.GetData(),
+					ClosestY.GetData(),
+					ClosestZ.GetData(),
+					Distances.GetData());
+			});
+		}
+	}
+
+	if (OutClosestX)
+	{
+		*OutClosestX = MoveTemp(ClosestX);
+	}
+	if (OutClosestY)
+	{
+		*OutClosestY = MoveTemp(ClosestY);
+	}
+	if (OutClosestZ)
+	{
+		*OutClosestZ = MoveTemp(ClosestZ);
+	}
+
+	Voxel::AsyncTask([
+		ClosestX = MakeSharedCopy(MoveTemp(ClosestX)),
+		ClosestY = MakeSharedCopy(MoveTemp(ClosestY)),
+		ClosestZ = MakeSharedCopy(MoveTemp(ClosestZ))]
+	{
+		VOXEL_SCOPE_COUNTER("Free Closest");
+
+		ClosestX->Reset();
+		ClosestY->Reset();
+		ClosestZ->Reset();
+	});
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 void FVoxelUtilities::JumpFlood(
 	const FIntVector& Size,
 	const TVoxelArrayView<float> Distances,
@@ -208,4 +627,273 @@ void FVoxelUtilities::JumpFlood(
 		nullptr,
 		nullptr,
 		nullptr);
+}
+
+void FVoxelUtilities::EuclideanDistanceTransform(
+	const FIntVector& Size,
+	const TVoxelArrayView<float> Distances,
+	TVoxelArray<float>& OutClosestX,
+	TVoxelArray<float>& OutClosestY,
+	TVoxelArray<float>& OutClosestZ)
+{
+	EuclideanDistanceTransformImpl(
+		Size,
+		Distances,
+		&OutClosestX,
+		&OutClosestY,
+		&OutClosestZ);
+}
+
+void FVoxelUtilities::EuclideanDistanceTransform(
+	const FIntVector& Size,
+	const TVoxelArrayView<float> Distances)
+{
+	EuclideanDistanceTransformImpl(
+		Size,
+		Distances,
+		nullptr,
+		nullptr,
+		nullptr);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelUtilities::UpdateEuclideanDistanceTransform(
+	const FIntVector& Size,
+	const TConstVoxelArrayView<float> InputDistances,
+	const FVoxelIntBox& DirtyBox,
+	const TVoxelArrayView<float> Distances,
+	const TVoxelArrayView<float> ClosestX,
+	const TVoxelArrayView<float> ClosestY,
+	const TVoxelArrayView<float> ClosestZ,
+	float& MaxDistance)
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(InputDistances.Num() == Size.X * Size.Y * Size.Z);
+	check(Distances.Num() == Size.X * Size.Y * Size.Z);
+	check(ClosestX.Num() == Size.X * Size.Y * Size.Z);
+	check(ClosestY.Num() == Size.X * Size.Y * Size.Z);
+	check(ClosestZ.Num() == Size.X * Size.Y * Size.Z);
+
+	const FVoxelIntBox Bounds(FIntVector(0), Size);
+	if (!DirtyBox.Intersects(Bounds))
+	{
+		return;
+	}
+
+	// Seeds depend on their 6 neighbors
+	const FVoxelIntBox SeedBox = Bounds.IntersectWith(DirtyBox.Extend(1));
+
+	// Seeds are less than a voxel away from their voxel: any voxel further than MaxDistance + 1 from SeedBox
+	// can neither have lost its closest seed nor have gained a closer one
+	const int32 MaxRadius = Size.GetMax();
+	const int32 UpdateRadius = MaxDistance < MaxRadius ? FMath::CeilToInt(MaxDistance) + 2 : MaxRadius;
+	const FVoxelIntBox UpdateBox = Bounds.IntersectWith(SeedBox.Extend(UpdateRadius));
+
+	VOXEL_SCOPE_COUNTER_FORMAT("UpdateEuclideanDistanceTransform Num=%d", UpdateBox.Count_int32());
+
+	// Updated voxels can be closest to seeds outside of UpdateBox: solve in a larger box,
+	// and grow it until every updated voxel is well within its closest seed's distance from the box faces
+	int32 Margin = FMath::Clamp(UpdateRadius, 1, MaxRadius);
+
+	TVoxelArray<float> LocalDistances;
+	TVoxelArray<float> LocalClosestX;
+	TVoxelArray<float> LocalClosestY;
+	TVoxelArray<float> LocalClosestZ;
+
+	FVoxelIntBox SolveBox;
+	FVoxelIntBox LocalBox;
+	while (true)
+	{
+		SolveBox = Bounds.IntersectWith(UpdateBox.Extend(Margin));
+		// One more layer so that seeds on the border of SolveBox see all their neighbors
+		LocalBox = Bounds.IntersectWith(SolveBox.Extend(1));
+
+		const FIntVector LocalSize = LocalBox.Size();
+		const int32 LocalNum = LocalSize.X * LocalSize.Y * LocalSize.Z;
+
+		FVoxelUtilities::SetNumFast(LocalDistances, LocalNum);
+		FVoxelUtilities::SetNumFast(LocalClosestX, LocalNum);
+		FVoxelUtilities::SetNumFast(LocalClosestY, LocalNum);
+		FVoxelUtilities::SetNumFast(LocalClosestZ, LocalNum);
+
+		{
+			VOXEL_SCOPE_COUNTER("Copy input");
+
+			ParallelFor(LocalSize.Z, [&](const int32 Z)
+			{
+				for (int32 Y = 0; Y < LocalSize.Y; Y++)
+				{
+					FVoxelUtilities::Memcpy(
+						MakeVoxelArrayView(LocalDistances).Slice(FVoxelUtilities::Get3DIndex<int32>(LocalSize, 0, Y, Z), LocalSize.X),
+						InputDistances.Slice(FVoxelUtilities::Get3DIndex<int32>(Size, LocalBox.Min + FIntVector(0, Y, Z)), LocalSize.X));
+				}
+			});
+		}
+
+		EuclideanDistanceTransform_Initialize(
+			LocalSize,
+			LocalBox.Min,
+			LocalDistances,
+			LocalClosestX,
+			LocalClosestY,
+			LocalClosestZ);
+
+		{
+			VOXEL_SCOPE_COUNTER("Remove border seeds");
+
+			// Seeds of the extra layer are missing neighbors and might not be actual seeds
+			ParallelFor(LocalSize.Z, [&](const int32 Z)
+			{
+				for (int32 Y = 0; Y < LocalSize.Y; Y++)
+				{
+					for (int32 X = 0; X < LocalSize.X; X++)
+					{
+						if (SolveBox.Contains(LocalBox.Min + FIntVector(X, Y, Z)))
+						{
+							continue;
+						}
+
+						LocalClosestX[FVoxelUtilities::Get3DIndex<int32>(LocalSize, X, Y, Z)] = FVoxelUtilities::NaNf();
+					}
+				}
+			});
+		}
+
+		// Work in the volume space so that the passes round exactly like a full transform
+		EuclideanDistanceTransform_Passes(
+			LocalSize,
+			LocalBox.Min,
+			LocalClosestX,
+			LocalClosestY,
+			LocalClosestZ);
+
+		if (SolveBox.Min == Bounds.Min &&
+			SolveBox.Max == Bounds.Max)
+		{
+			break;
+		}
+
+		VOXEL_SCOPE_COUNTER("Check margin");
+
+		// Seeds of voxels outside SolveBox are at least as far as SolveBox's faces, unless the face is the volume border
+		std::atomic<bool> bIsValid = true;
+
+		ParallelFor(UpdateBox.Size().Z, [&](const int32 Z)
+		{
+			for (int32 Y = 0; Y < UpdateBox.Size().Y; Y++)
+			{
+				for (int32 X = 0; X < UpdateBox.Size().X; X++)
+				{
+					const FIntVector Position = UpdateBox.Min + FIntVector(X, Y, Z);
+					const int32 LocalIndex = FVoxelUtilities::Get3DIndex<int32>(LocalSize, Position - LocalBox.Min);
+
+					float FreeDistance = MAX_flt;
+					for (int32 Axis = 0; Axis < 3; Axis++)
+					{
+						if (SolveBox.Min[Axis] > 0)
+						{
+							FreeDistance = FMath::Min<float>(FreeDistance, Position[Axis] - SolveBox.Min[Axis]);
+						}
+						if (SolveBox.Max[Axis] < Size[Axis])
+						{
+							FreeDistance = FMath::Min<float>(FreeDistance, SolveBox.Max[Axis] - 1 - Position[Axis]);
+						}
+					}
+
+					const FVector3f Closest = FVector3f(
+						LocalClosestX[LocalIndex],
+						LocalClosestY[LocalIndex],
+						LocalClosestZ[LocalIndex]);
+
+					// The separable passes only approximate the closest seed: the winner of a row or column
+					// used by this voxel can be displaced by a seed outside SolveBox in a full transform
+					// Seeds are up to a voxel off their row & slice, so keep two voxels of slack
+					constexpr float Slack = 2.f;
+
+					if (Closest.ContainsNaN() ||
+						FreeDistance <= Slack ||
+						FVector3f::DistSquared(FVector3f(Position), Closest) >= FMath::Square(FreeDistance - Slack))
+					{
+						bIsValid.store(false, std::memory_order_relaxed);
+						return;
+					}
+				}
+			}
+		});
+
+		if (bIsValid.load())
+		{
+			break;
+		}
+
+		Margin = FMath::Min(2 * Margin, MaxRadius);
+	}
+
+	const FIntVector LocalSize = LocalBox.Size();
+
+	{
+		VOXEL_SCOPE_COUNTER("ComputeDistances");
+
+		FVoxelParallelTaskScope Scope;
+
+		for (int32 Z = 0; Z < LocalSize.Z; Z++)
+		{
+			Scope.AddTask([&, Z]
+			{
+				ispc::VoxelDistanceFieldUtilities_JumpFlood_ComputeDistances(
+					Z,
+					LocalSize.X,
+					LocalSize.Y,
+					LocalSize.Z,
+					LocalBox.Min.X,
+					LocalBox.Min.Y,
+					LocalBox.Min.Z,
+					LocalClosestX.GetData(),
+					LocalClosestY.GetData(),
+					LocalClosestZ.GetData(),
+					LocalDistances.GetData());
+			});
+		}
+	}
+
+	VOXEL_SCOPE_COUNTER("Write back");
+
+	TVoxelArray<float> NewMaxDistances;
+	FVoxelUtilities::SetNumFast(NewMaxDistances, UpdateBox.Size().Z);
+
+	ParallelFor(UpdateBox.Size().Z, [&](const int32 Z)
+	{
+		float NewMaxDistance = 0.f;
+
+		for (int32 Y = 0; Y < UpdateBox.Size().Y; Y++)
+		{
+			const FIntVector Position = UpdateBox.Min + FIntVector(0, Y, Z);
+			const int32 Index = FVoxelUtilities::Get3DIndex<int32>(Size, Position);
+			const int32 LocalIndex = FVoxelUtilities::Get3DIndex<int32>(LocalSize, Position - LocalBox.Min);
+			const int32 Num = UpdateBox.Size().X;
+
+			FVoxelUtilities::Memcpy(ClosestX.Slice(Index, Num), MakeVoxelArrayView(LocalClosestX).Slice(LocalIndex, Num));
+			FVoxelUtilities::Memcpy(ClosestY.Slice(Index, Num), MakeVoxelArrayView(LocalClosestY).Slice(LocalIndex, Num));
+			FVoxelUtilities::Memcpy(ClosestZ.Slice(Index, Num), MakeVoxelArrayView(LocalClosestZ).Slice(LocalIndex, Num));
+			FVoxelUtilities::Memcpy(Distances.Slice(Index, Num), MakeVoxelArrayView(LocalDistances).Slice(LocalIndex, Num));
+
+			for (int32 X = 0; X < Num; X++)
+			{
+				const float Distance = Distances[Index + X];
+
+				// NaN if there are no seeds at all
+				NewMaxDistance = FMath::IsNaN(Distance) ? MAX_flt : FMath::Max(NewMaxDistance, FMath::Abs(Distance));
+			}
+		}
+
+		NewMaxDistances[Z] = NewMaxDistance;
+	});
+
+	for (const float NewMaxDistance : NewMaxDistances)
+	{
+		MaxDistance = FMath::Max(MaxDistance, NewMaxDistance);
+	}
 }
\ No newline at end of file
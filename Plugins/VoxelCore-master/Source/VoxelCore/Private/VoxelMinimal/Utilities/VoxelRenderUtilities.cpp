@@ -1,6 +1,7 @@
 // Copyright Voxel Plugin SAS. All Rights Reserved.
 
 #include "VoxelMinimal.h"
+#include "VoxelTaskContext.h"
 #include "VoxelGPUBufferReadback.h"
 #include "TextureResource.h"
 #include "DataDrivenShaderPlatformInfo.h"
@@ -235,6 +236,7 @@ FVoxelFuture FVoxelUtilities::AsyncCopyTexture(
 		if (CompletionEvent.IsValid())
 		{
 			VOXEL_SCOPE_COUNTER("Wait");
+			FVoxelTaskBlockingScope BlockingScope;
 			CompletionEvent->Wait();
 		}
 
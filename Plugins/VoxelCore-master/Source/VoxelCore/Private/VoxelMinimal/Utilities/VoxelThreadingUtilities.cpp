@@ -1,6 +1,7 @@
 // Copyright Voxel Plugin SAS. All Rights Reserved.
 
 #include "VoxelMinimal.h"
+#include "VoxelTaskContext.h"
 #include "Async/Async.h"
 
 TMulticastDelegate<void(bool& bAnyTaskProcessed)> Voxel::OnFlushGameTasks;
@@ -55,6 +56,14 @@ void FVoxelParallelTaskScope::FlushTasks()
 {
 	VOXEL_FUNCTION_COUNTER();
 
+	if (Tasks.IsEmpty())
+	{
+		return;
+	}
+
+	// We might be on a work stealing loop
+	FVoxelTaskBlockingScope BlockingScope;
+
 	UE::Tasks::TTask<void> Task;
 	while (Tasks.Dequeue(Task))
 	{
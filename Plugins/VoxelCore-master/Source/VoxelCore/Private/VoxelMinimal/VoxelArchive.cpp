@@ -48,6 +48,26 @@ FVoxelReader::FVoxelReader(const TConstVoxelArrayView64<uint8> Bytes)
 	Impl.SetIsPersistent(true);
 }
 
+TConstVoxelArrayView64<uint8> FVoxelReader::ReadView(const int64 Num)
+{
+	if (Impl.IsError())
+	{
+		return {};
+	}
+
+	if (Num < 0 ||
+		Impl.Offset + Num > Impl.Bytes.Num())
+	{
+		ensureVoxelSlow(false);
+		Impl.SetError();
+		return {};
+	}
+
+	const TConstVoxelArrayView64<uint8> Result = Impl.Bytes.Slice(Impl.Offset, Num);
+	Impl.Offset += Num;
+	return Result;
+}
+
 void FVoxelReader::FArchiveImpl::Serialize(void* Data, const int64 NumToSerialize)
 {
 	if (IsError() ||
@@ -13,16 +13,16 @@ VOXEL_CONSOLE_VARIABLE(
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-TSharedRef<IVoxelPromiseState> IVoxelPromiseState::New(
+FVoxelPromiseStatePtr IVoxelPromiseState::New(
 	FVoxelTaskContext* ContextOverride,
 	const bool bWithValue)
 {
-	return MakeShared<FVoxelPromiseState>(ContextOverride, bWithValue);
+	return FVoxelPromiseStatePtr::Adopt(*FVoxelPromiseState::New(ContextOverride, bWithValue));
 }
 
-TSharedRef<IVoxelPromiseState> IVoxelPromiseState::New(const FSharedVoidRef& Value)
+FVoxelPromiseStatePtr IVoxelPromiseState::New(const FSharedVoidRef& Value)
 {
-	return MakeShared<FVoxelPromiseState>(Value);
+	return FVoxelPromiseStatePtr::Adopt(*FVoxelPromiseState::New(Value));
 }
 
 void IVoxelPromiseState::Set()
@@ -37,21 +37,21 @@ void IVoxelPromiseState::Set(const FSharedVoidRef& NewValue)
 
 void IVoxelPromiseState::AddContinuation(const FVoxelFuture& Future)
 {
-	static_cast<FVoxelPromiseState&>(*this).AddContinuation(MakeUnique<FVoxelPromiseState::FContinuation>(Future));
+	static_cast<FVoxelPromiseState&>(*this).AddContinuation(FVoxelPromiseState::FContinuation::New(Future));
 }
 
 void IVoxelPromiseState::AddContinuation(
 	const EVoxelFutureThread Thread,
 	TVoxelUniqueFunction<void()> Continuation)
 {
-	static_cast<FVoxelPromiseState*>(this)->AddContinuation(MakeUnique<FVoxelPromiseState::FContinuation>(Thread, MoveTemp(Continuation)));
+	static_cast<FVoxelPromiseState*>(this)->AddContinuation(FVoxelPromiseState::FContinuation::New(Thread, MoveTemp(Continuation)));
 }
 
 void IVoxelPromiseState::AddContinuation(
 	const EVoxelFutureThread Thread,
 	TVoxelUniqueFunction<void(const FSharedVoidRef&)> Continuation)
 {
-	static_cast<FVoxelPromiseState*>(this)->AddContinuation(MakeUnique<FVoxelPromiseState::FContinuation>(Thread, MoveTemp(Continuation)));
+	static_cast<FVoxelPromiseState*>(this)->AddContinuation(FVoxelPromiseState::FContinuation::New(Thread, MoveTemp(Continuation)));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -101,4 +101,12 @@ void FVoxelFuture::ExecuteImpl(
 	TVoxelUniqueFunction<void()> Lambda)
 {
 	FVoxelTaskScope::GetContext().Dispatch(Thread, MoveTemp(Lambda));
+}
+
+void FVoxelFuture::ExecuteImpl(
+	const EVoxelFutureThread Thread,
+	FVoxelTaskPriority Priority,
+	TVoxelUniqueFunction<void()> Lambda)
+{
+	FVoxelTaskScope::GetContext().Dispatch(Thread, MoveTemp(Priority), MoveTemp(Lambda));
 }
\ No newline at end of file
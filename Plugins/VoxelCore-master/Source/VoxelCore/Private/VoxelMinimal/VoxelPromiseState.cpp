@@ -4,6 +4,139 @@
 
 DEFINE_VOXEL_INSTANCE_COUNTER(FVoxelPromiseState);
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELCORE_API, bool, GVoxelPoolPromises, true,
+	"voxel.PoolPromises",
+	"If true, freed promise states and continuations are kept in per-thread free lists to be reused");
+
+FVoxelCounter64 GVoxelNumPromiseHeapAllocations;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Blocks can be freed on a different thread than the one that allocated them, that's fine
+// Free lists are stored in a TLS slot and never destroyed, so that promises can safely be freed while a thread exits
+// The blocks of exited threads are leaked, at most MaxNum per thread
+template<typename T>
+class TVoxelPromiseFreeList
+{
+public:
+	FORCEINLINE static void* Allocate()
+	{
+		TVoxelPromiseFreeList& FreeList = Get();
+
+		if (FBlock* Block = FreeList.Head)
+		{
+			FreeList.Head = Block->Next;
+			FreeList.Num--;
+			return Block;
+		}
+
+		GVoxelNumPromiseHeapAllocations.Increment(std::memory_order_relaxed);
+		return FMemory::Malloc(sizeof(T), alignof(T));
+	}
+	FORCEINLINE static void Free(void* Pointer)
+	{
+		if (!GVoxelPoolPromises)
+		{
+			FMemory::Free(Pointer);
+			return;
+		}
+
+		TVoxelPromiseFreeList& FreeList = Get();
+		if (FreeList.Num >= MaxNum)
+		{
+			FMemory::Free(Pointer);
+			return;
+		}
+
+		FBlock* Block = static_cast<FBlock*>(Pointer);
+		Block->Next = FreeList.Head;
+		FreeList.Head = Block;
+		FreeList.Num++;
+	}
+
+private:
+	struct FBlock
+	{
+		FBlock* Next;
+	};
+	checkStatic(sizeof(T) >= sizeof(FBlock));
+
+	static constexpr int32 MaxNum = 4096;
+
+	FBlock* Head = nullptr;
+	int32 Num = 0;
+
+	FORCEINLINE static TVoxelPromiseFreeList& Get()
+	{
+		static const uint32 TLS = FPlatformTLS::AllocTlsSlot();
+
+		if (TVoxelPromiseFreeList* FreeList = static_cast<TVoxelPromiseFreeList*>(FPlatformTLS::GetTlsValue(TLS)))
+		{
+			return *FreeList;
+		}
+
+		TVoxelPromiseFreeList* FreeList = new TVoxelPromiseFreeList();
+		FPlatformTLS::SetTlsValue(TLS, FreeList);
+		return *FreeList;
+	}
+};
+
+using FVoxelPromiseStateFreeList = TVoxelPromiseFreeList<FVoxelPromiseState>;
+using FVoxelContinuationFreeList = TVoxelPromiseFreeList<FVoxelPromiseState::FContinuation>;
+
+FVoxelPromiseState* FVoxelPromiseState::New(
+	FVoxelTaskContext* ContextOverride,
+	const bool bHasValue)
+{
+	return new (FVoxelPromiseStateFreeList::Allocate()) FVoxelPromiseState(ContextOverride, bHasValue);
+}
+
+FVoxelPromiseState* FVoxelPromiseState::New(const FSharedVoidRef& NewValue)
+{
+	return new (FVoxelPromiseStateFreeList::Allocate()) FVoxelPromiseState(NewValue);
+}
+
+void IVoxelPromiseState::Destroy()
+{
+	checkVoxelSlow(NumRefs.Get() == 0);
+
+	FVoxelPromiseState* State = static_cast<FVoxelPromiseState*>(this);
+	State->~FVoxelPromiseState();
+	FVoxelPromiseStateFreeList::Free(State);
+}
+
+FVoxelPromiseState::FContinuationPtr FVoxelPromiseState::FContinuation::New(const FVoxelFuture& Future)
+{
+	return FContinuationPtr(new (FVoxelContinuationFreeList::Allocate()) FContinuation(Future));
+}
+
+FVoxelPromiseState::FContinuationPtr FVoxelPromiseState::FContinuation::New(
+	const EVoxelFutureThread Thread,
+	TVoxelUniqueFunction<void()> Lambda)
+{
+	return FContinuationPtr(new (FVoxelContinuationFreeList::Allocate()) FContinuation(Thread, MoveTemp(Lambda)));
+}
+
+FVoxelPromiseState::FContinuationPtr FVoxelPromiseState::FContinuation::New(
+	const EVoxelFutureThread Thread,
+	TVoxelUniqueFunction<void(const FSharedVoidRef&)> Lambda)
+{
+	return FContinuationPtr(new (FVoxelContinuationFreeList::Allocate()) FContinuation(Thread, MoveTemp(Lambda)));
+}
+
+void FVoxelPromiseState::FContinuationDeleter::operator()(FContinuation* Continuation) const
+{
+	Continuation->~FContinuation();
+	FVoxelContinuationFreeList::Free(Continuation);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 FORCEINLINE void FVoxelPromiseState::FContinuation::Execute(
 	FVoxelTaskContext& Context,
 	const FVoxelPromiseState& NewValue)
@@ -13,7 +146,7 @@ FORCEINLINE void FVoxelPromiseState::FContinuation::Execute(
 	default: VOXEL_ASSUME(false);
 	case EType::Future:
 	{
-		FVoxelPromiseState& Future = *GetFuture();
+		FVoxelPromiseState& Future = static_cast<FVoxelPromiseState&>(*GetFuture());
 		if (Future.bHasValue)
 		{
 			Future.Set(NewValue.GetSharedValueChecked());
@@ -120,7 +253,7 @@ void FVoxelPromiseState::Set(const FSharedVoidRef& NewValue)
 	SetImpl(ContextStrongRef->Context);
 }
 
-void FVoxelPromiseState::AddContinuation(TUniquePtr<FContinuation> Continuation)
+void FVoxelPromiseState::AddContinuation(FContinuationPtr Continuation)
 {
 	const TUniquePtr<FVoxelTaskContextStrongRef> ContextStrongRef = ContextWeakRef.Pin();
 	if (!ContextStrongRef)
@@ -154,7 +287,7 @@ void FVoxelPromiseState::AddContinuation(TUniquePtr<FContinuation> Continuation)
 	if (KeepAliveIndex == -1)
 	{
 		VOXEL_SCOPE_LOCK(Context.CriticalSection);
-		KeepAliveIndex = Context.PromisesToKeepAlive_RequiresLock.Add(AsShared());
+		KeepAliveIndex = Context.PromisesToKeepAlive_RequiresLock.Add(FVoxelPromiseStatePtr::AddRef(*this));
 	}
 
 	checkVoxelSlow(!Continuation->NextContinuation);
@@ -177,9 +310,12 @@ void FVoxelPromiseState::SetImpl(FVoxelTaskContext& Context)
 	{
 		Context.NumPromises.Decrement();
 
+		// Released last, might be our last reference
+		FVoxelPromiseStatePtr KeepAlive;
 		if (KeepAliveIndex != -1)
 		{
 			VOXEL_SCOPE_LOCK(Context.CriticalSection);
+			KeepAlive = MoveTemp(Context.PromisesToKeepAlive_RequiresLock[KeepAliveIndex]);
 			Context.PromisesToKeepAlive_RequiresLock.RemoveAt(KeepAliveIndex);
 
 			KeepAliveIndex = -1;
@@ -196,7 +332,7 @@ void FVoxelPromiseState::SetImpl(FVoxelTaskContext& Context)
 
 	VOXEL_SCOPE_LOCK_ATOMIC(bIsLocked);
 
-	TUniquePtr<FContinuation> Continuation = MoveTemp(Continuation_RequiresLock);
+	FContinuationPtr Continuation = MoveTemp(Continuation_RequiresLock);
 	while (Continuation)
 	{
 		Continuation->Execute(Context, *this);
@@ -5,11 +5,17 @@
 #include "VoxelMinimal.h"
 #include "VoxelTaskContext.h"
 
-class FVoxelPromiseState
-	: public IVoxelPromiseState
-	, public TSharedFromThis<FVoxelPromiseState>
+class FVoxelPromiseState : public IVoxelPromiseState
 {
 public:
+	struct FContinuation;
+
+	struct FContinuationDeleter
+	{
+		void operator()(FContinuation* Continuation) const;
+	};
+	using FContinuationPtr = TUniquePtr<FContinuation, FContinuationDeleter>;
+
 	struct FContinuation
 	{
 	public:
@@ -24,14 +30,24 @@ public:
 		const EType Type;
 		TVoxelStaticArray<uint64, 2> Storage{ NoInit };
 
-		TUniquePtr<FContinuation> NextContinuation;
+		FContinuationPtr NextContinuation;
 
 	public:
+		// Allocated from a per-thread free list
+		static FContinuationPtr New(const FVoxelFuture& Future);
+		static FContinuationPtr New(
+			EVoxelFutureThread Thread,
+			TVoxelUniqueFunction<void()> Lambda);
+		static FContinuationPtr New(
+			EVoxelFutureThread Thread,
+			TVoxelUniqueFunction<void(const FSharedVoidRef&)> Lambda);
+
 		FORCEINLINE explicit FContinuation(const FVoxelFuture& Future)
 			: Thread(EVoxelFutureThread::AnyThread)
 			, Type(EType::Future)
 		{
-			new(&Storage) TSharedRef<FVoxelPromiseState>(StaticCastSharedRef<FVoxelPromiseState>(Future.PromiseState.ToSharedRef()));
+			checkVoxelSlow(Future.PromiseState);
+			new(&Storage) FVoxelPromiseStatePtr(Future.PromiseState);
 		}
 		FORCEINLINE FContinuation(
 			const EVoxelFutureThread Thread,
@@ -54,7 +70,7 @@ public:
 			switch (Type)
 			{
 			default: VOXEL_ASSUME(false);
-			case EType::Future: GetFuture().~TSharedRef();
+			case EType::Future: GetFuture().~FVoxelPromiseStatePtr();
 				break;
 			case EType::VoidLambda: GetVoidLambda().~TVoxelUniqueFunction();
 				break;
@@ -64,10 +80,10 @@ public:
 		}
 
 	public:
-		FORCEINLINE TSharedRef<FVoxelPromiseState>& GetFuture()
+		FORCEINLINE FVoxelPromiseStatePtr& GetFuture()
 		{
 			checkVoxelSlow(Type == EType::Future);
-			return ReinterpretCastRef<TSharedRef<FVoxelPromiseState>>(Storage);
+			return ReinterpretCastRef<FVoxelPromiseStatePtr>(Storage);
 		}
 		FORCEINLINE TVoxelUniqueFunction<void()>& GetVoidLambda()
 		{
@@ -89,6 +105,12 @@ public:
 public:
 	const FVoxelTaskContextWeakRef ContextWeakRef;
 
+	// Allocated from a per-thread free list, freed by IVoxelPromiseState::Destroy once the last FVoxelPromiseStatePtr is released
+	static FVoxelPromiseState* New(
+		FVoxelTaskContext* ContextOverride,
+		bool bHasValue);
+	static FVoxelPromiseState* New(const FSharedVoidRef& NewValue);
+
 	explicit FVoxelPromiseState(
 		FVoxelTaskContext* ContextOverride,
 		bool bHasValue);
@@ -109,13 +131,15 @@ public:
 public:
 	void Set();
 	void Set(const FSharedVoidRef& NewValue);
-	void AddContinuation(TUniquePtr<FContinuation> Continuation);
+	void AddContinuation(FContinuationPtr Continuation);
 
 private:
 	int32 StackIndex = -1;
-	TUniquePtr<FContinuation> Continuation_RequiresLock;
+	FContinuationPtr Continuation_RequiresLock;
 
 	void SetImpl(FVoxelTaskContext& Context);
+
+	friend IVoxelPromiseState;
 };
-checkStatic(sizeof(FVoxelPromiseState) == 64);
+checkStatic(sizeof(FVoxelPromiseState) == 56);
 checkStatic(sizeof(FVoxelPromiseState::FContinuation) == 32);
\ No newline at end of file
@@ -82,6 +82,26 @@ FCluster::FCluster()
 	Colors.Reserve(128);
 }
 
+void FCluster::Reset(const int32 NumTextureCoordinates)
+{
+	Positions.Reset();
+	Normals.Reset();
+	Colors.Reset();
+
+	for (TVoxelArray<FVector2f>& TextureCoordinate : TextureCoordinates)
+	{
+		TextureCoordinate.Reset();
+	}
+	TextureCoordinates.SetNum(NumTextureCoordinates);
+
+	LODBounds = FSphere3f(ForceInit);
+	LODError = 0.f;
+	bIsLeaf = true;
+
+	CachedBounds.Reset();
+	CachedEncodingInfo.Reset();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -270,19 +290,20 @@ FPackedCluster FCluster::Pack(const FEncodingInfo& Info) const
 	Result.SetPosBitsZ(Info.PositionBits.Z);
 
 	Result.LODBounds = FVector4f(
-		Bounds.GetCenter().X,
-		Bounds.GetCenter().Y,
-		Bounds.GetCenter().Z,
-		Bounds.Size().Length());
+		LODBounds.Center.X,
+		LODBounds.Center.Y,
+		LODBounds.Center.Z,
+		LODBounds.W);
 
 	Result.BoxBoundsCenter = FVector3f(Bounds.GetCenter());
 
 	Result.LODErrorAndEdgeLength =
-		(uint32(FFloat16(0.1f /* TODO? InCluster.LODError*/).Encoded) << 0) |
+		(uint32(FFloat16(LODError).Encoded) << 0) |
 		(uint32(FFloat16(MaxEdgeLength).Encoded) << 16);
 
 	Result.BoxBoundsExtent = FVector3f(Bounds.GetExtent());
-	Result.Flags = NANITE_CLUSTER_FLAG_STREAMING_LEAF | NANITE_CLUSTER_FLAG_ROOT_LEAF;
+	// All pages are root pages, so leaves are both streaming & root leaves
+	Result.Flags = bIsLeaf ? NANITE_CLUSTER_FLAG_STREAMING_LEAF | NANITE_CLUSTER_FLAG_ROOT_LEAF : 0;
 
 	Result.SetBitsPerAttribute(Info.BitsPerAttribute);
 	Result.SetNormalPrecision(Info.Settings.NormalBits);
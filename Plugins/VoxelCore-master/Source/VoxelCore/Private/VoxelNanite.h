@@ -173,8 +173,17 @@ public:
 	TVoxelArray<FColor> Colors;
 	TVoxelFixedArray<TVoxelArray<FVector2f>, NANITE_MAX_UVS> TextureCoordinates;
 
+	// Sphere & error the runtime uses to pick this cluster's LOD, see FClusterDAG
+	FSphere3f LODBounds = FSphere3f(ForceInit);
+	float LODError = 0.f;
+	// False for clusters simplified from finer ones
+	bool bIsLeaf = true;
+
 	FCluster();
 
+	// Clear the cluster while keeping its allocations, so that it can be reused for another mesh
+	void Reset(int32 NumTextureCoordinates);
+
 	FVoxelBox GetBounds() const;
 	const FEncodingInfo& GetEncodingInfo(const FEncodingSettings& Settings) const;
 
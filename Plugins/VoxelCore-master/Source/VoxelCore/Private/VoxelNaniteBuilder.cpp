@@ -2,211 +2,651 @@
 
 #include "VoxelNaniteBuilder.h"
 #include "VoxelNanite.h"
+#include "VoxelNaniteDAG.h"
 #include "Engine/StaticMesh.h"
 #include "Rendering/NaniteResources.h"
 
+struct FVoxelNaniteBuilder::FScratch
+{
+	// Only the first NumClusters/NumPages are used, the rest is kept to avoid reallocating
+	TVoxelArray<Voxel::Nanite::FCluster> Clusters;
+	TVoxelArray<TVoxelChunkedArray<uint8>> PageDatas;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 TUniquePtr<FStaticMeshRenderData> FVoxelNaniteBuilder::CreateRenderData(TVoxelArray<int32>& OutVertexOffsets)
+{
+	TVoxelArray<int32> SourceVertexIndices;
+	return CreateRenderData(OutVertexOffsets, SourceVertexIndices);
+}
+
+TUniquePtr<FStaticMeshRenderData> FVoxelNaniteBuilder::CreateRenderData(
+	TVoxelArray<int32>& OutVertexOffsets,
+	TVoxelArray<int32>& OutSourceVertexIndices)
+{
+	FScratch Scratch;
+	return CreateRenderData(Mesh, Scratch, true, OutVertexOffsets, OutSourceVertexIndices);
+}
+
+UStaticMesh* FVoxelNaniteBuilder::CreateStaticMesh()
 {
 	VOXEL_FUNCTION_COUNTER();
-	check(Mesh.Positions.Num() == Mesh.Normals.Num());
-	check(Mesh.Positions.Num() % 3 == 0);
 
-	if (!ensure(Mesh.Positions.Num() > 0))
+	TVoxelArray<int32> VertexOffsets;
+	return CreateStaticMesh(CreateRenderData(VertexOffsets));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+TVoxelArray<TUniquePtr<FStaticMeshRenderData>> FVoxelNaniteBuilder::CreateRenderDataBatch(
+	const TConstVoxelArrayView<FMesh> Meshes,
+	TVoxelArray<TVoxelArray<int32>>& OutVertexOffsets) const
+{
+	TVoxelArray<TVoxelArray<int32>> SourceVertexIndices;
+	return CreateRenderDataBatch(Meshes, OutVertexOffsets, SourceVertexIndices);
+}
+
+TVoxelArray<TUniquePtr<FStaticMeshRenderData>> FVoxelNaniteBuilder::CreateRenderDataBatch(
+	const TConstVoxelArrayView<FMesh> Meshes,
+	TVoxelArray<TVoxelArray<int32>>& OutVertexOffsets,
+	TVoxelArray<TVoxelArray<int32>>& OutSourceVertexIndices) const
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Meshes.Num(), 1);
+
+	TVoxelArray<TUniquePtr<FStaticMeshRenderData>> Result;
+	Result.SetNum(Meshes.Num());
+
+	OutVertexOffsets.Reset();
+	OutVertexOffsets.SetNum(Meshes.Num());
+
+	OutSourceVertexIndices.Reset();
+	OutSourceVertexIndices.SetNum(Meshes.Num());
+
+	// Parallelize across meshes and build each mesh single-threaded: there are usually many small meshes,
+	// and this lets every worker reuse its scratch for all the meshes it picks up
+	TArray<FScratch> Scratches;
+	ParallelForWithTaskContext(
+		Scratches,
+		Meshes.Num(),
+		[&](FScratch& Scratch, const int32 Index)
+		{
+			if (Meshes[Index].Positions.Num() == 0)
+			{
+				return;
+			}
+
+			Result[Index] = CreateRenderData(
+				Meshes[Index],
+				Scratch,
+				false,
+				OutVertexOffsets[Index],
+				OutSourceVertexIndices[Index]);
+		},
+		EParallelForFlags::Unbalanced);
+
+	return Result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+TUniquePtr<FStaticMeshRenderData> FVoxelNaniteBuilder::CreateRenderData(
+	const FMesh& InMesh,
+	FScratch& Scratch,
+	const bool bParallel,
+	TVoxelArray<int32>& OutVertexOffsets,
+	TVoxelArray<int32>& OutSourceVertexIndices) const
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(InMesh.Positions.Num() == InMesh.Normals.Num());
+	check(InMesh.Positions.Num() % 3 == 0);
+
+	if (!ensure(InMesh.Positions.Num() > 0))
 	{
 		return nullptr;
 	}
 
 	using namespace Voxel::Nanite;
 
-	const FVoxelBox Bounds = FVoxelBox::FromPositions(Mesh.Positions);
+	const EParallelForFlags ParallelForFlags = bParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread;
+
+	const FVoxelBox Bounds = FVoxelBox::FromPositions(InMesh.Positions);
 
 	Nanite::FResources Resources;
 
-	TVoxelArray<FCluster> AllClusters;
-	for (int32 TriangleIndex = 0; TriangleIndex < Mesh.Positions.Num() / 3; TriangleIndex++)
+	// Clusters don't share vertices, so they're limited by their vertex count
+	const int32 MaxTrianglesPerCluster = FMath::Min(NANITE_MAX_CLUSTER_TRIANGLES, NANITE_MAX_CLUSTER_VERTICES / 3);
+
+	const int32 NumTriangles = InMesh.Positions.Num() / 3;
+
+	TVoxelArray<int32> TriangleOrder;
+	if (bSpatialClustering)
 	{
-		if (AllClusters.Num() == 0 ||
-			AllClusters.Last().NumTriangles() == NANITE_MAX_CLUSTER_TRIANGLES ||
-			AllClusters.Last().Positions.Num() + 3 > NANITE_MAX_CLUSTER_VERTICES)
-		{
-			FCluster& Cluster = AllClusters.Emplace_GetRef();
-			Cluster.TextureCoordinates.SetNum(Mesh.TextureCoordinates.Num());
+		TriangleOrder = ComputeSpatialTriangleOrder(InMesh);
+		check(TriangleOrder.Num() == NumTriangles);
+	}
 
-			for (TVoxelArray<FVector2f>& TextureCoordinate : Cluster.TextureCoordinates)
-			{
-				TextureCoordinate.Reserve(128);
-			}
+	FClusterDAG DAG(InMesh.Positions, TriangleOrder, MaxTrianglesPerCluster, ParallelForFlags);
+
+	if (bBuildLODs)
+	{
+		DAG.BuildLODs();
+	}
+	else
+	{
+		DAG.BuildFlat();
+	}
+
+#if VOXEL_DEBUG
+	DAG.CheckInvariants();
+#endif
+
+	// Clusters of a group are contiguous so that a group spans as few pages as possible
+	const TVoxelArray<int32> SortedClusters = DAG.GetClustersSortedByGroup();
+	const int32 NumClusters = SortedClusters.Num();
+
+	FEncodingSettings EncodingSettings;
+	EncodingSettings.PositionPrecision = PositionPrecision;
+	checkStatic(FEncodingSettings::NormalBits == NormalBits);
+
+	TVoxelArray<int32> ClusterVertexOffsets;
+	FVoxelUtilities::SetNumFast(ClusterVertexOffsets, NumClusters);
+	{
+		int32 VertexOffset = 0;
+		for (int32 ClusterIndex = 0; ClusterIndex < NumClusters; ClusterIndex++)
+		{
+			ClusterVertexOffsets[ClusterIndex] = VertexOffset;
+			VertexOffset += DAG.Clusters[SortedClusters[ClusterIndex]].NumVertices;
 		}
+		FVoxelUtilities::SetNumFast(OutSourceVertexIndices, VertexOffset);
+	}
 
-		FCluster& Cluster = AllClusters.Last();
+	if (Scratch.Clusters.Num() < NumClusters)
+	{
+		Scratch.Clusters.SetNum(NumClusters);
+	}
+	const TVoxelArrayView<FCluster> AllClusters = MakeVoxelArrayView(Scratch.Clusters).LeftOf(NumClusters);
 
-		const int32 IndexA = 3 * TriangleIndex + 0;
-		const int32 IndexB = 3 * TriangleIndex + 1;
-		const int32 IndexC = 3 * TriangleIndex + 2;
+	// Each cluster is a fixed range of DAG vertices, so clusters can be filled & encoded independently
+	ParallelFor(NumClusters, [&](const int32 ClusterIndex)
+	{
+		const FLODCluster& LODCluster = DAG.Clusters[SortedClusters[ClusterIndex]];
+		const TConstVoxelArrayView<int32> SourceVertices = DAG.GetVertices(LODCluster);
+		const int32 VertexOffset = ClusterVertexOffsets[ClusterIndex];
 
-		Cluster.Positions.Add(Mesh.Positions[IndexA]);
-		Cluster.Positions.Add(Mesh.Positions[IndexB]);
-		Cluster.Positions.Add(Mesh.Positions[IndexC]);
+		FCluster& Cluster = AllClusters[ClusterIndex];
+		Cluster.Reset(InMesh.TextureCoordinates.Num());
+		Cluster.LODBounds = LODCluster.LODBounds;
+		Cluster.LODError = LODCluster.LODError;
+		Cluster.bIsLeaf = LODCluster.IsLeaf();
 
-		Cluster.Normals.Add(Mesh.Normals[IndexA]);
-		Cluster.Normals.Add(Mesh.Normals[IndexB]);
-		Cluster.Normals.Add(Mesh.Normals[IndexC]);
+		Cluster.Positions.Reserve(SourceVertices.Num());
+		Cluster.Normals.Reserve(SourceVertices.Num());
 
-		if (Mesh.Colors.Num() > 0)
+		if (InMesh.Colors.Num() > 0)
 		{
-			Cluster.Colors.Add(Mesh.Colors[IndexA]);
-			Cluster.Colors.Add(Mesh.Colors[IndexB]);
-			Cluster.Colors.Add(Mesh.Colors[IndexC]);
+			Cluster.Colors.Reserve(SourceVertices.Num());
 		}
 
-		for (int32 UVIndex = 0; UVIndex < Cluster.TextureCoordinates.Num(); UVIndex++)
+		for (TVoxelArray<FVector2f>& TextureCoordinate : Cluster.TextureCoordinates)
 		{
-			Cluster.TextureCoordinates[UVIndex].Add(Mesh.TextureCoordinates[UVIndex][IndexA]);
-			Cluster.TextureCoordinates[UVIndex].Add(Mesh.TextureCoordinates[UVIndex][IndexB]);
-			Cluster.TextureCoordinates[UVIndex].Add(Mesh.TextureCoordinates[UVIndex][IndexC]);
+			TextureCoordinate.Reserve(SourceVertices.Num());
 		}
-	}
 
-	const int32 TreeDepth = FMath::CeilToInt(FMath::LogX(4.f, AllClusters.Num()));
-	ensure(TreeDepth < NANITE_MAX_CLUSTER_HIERARCHY_DEPTH);
+		for (int32 Index = 0; Index < SourceVertices.Num(); Index++)
+		{
+			const int32 SourceIndex = SourceVertices[Index];
+
+			OutSourceVertexIndices[VertexOffset + Index] = SourceIndex;
+
+			Cluster.Positions.Add(InMesh.Positions[SourceIndex]);
+			Cluster.Normals.Add(InMesh.Normals[SourceIndex]);
+
+			if (InMesh.Colors.Num() > 0)
+			{
+				Cluster.Colors.Add(InMesh.Colors[SourceIndex]);
+			}
+
+			for (int32 UVIndex = 0; UVIndex < Cluster.TextureCoordinates.Num(); UVIndex++)
+			{
+				Cluster.TextureCoordinates[UVIndex].Add(InMesh.TextureCoordinates[UVIndex][SourceIndex]);
+			}
+		}
+		checkVoxelSlow(Cluster.NumTriangles() <= NANITE_MAX_CLUSTER_TRIANGLES);
+		checkVoxelSlow(Cluster.NumVertices() <= NANITE_MAX_CLUSTER_VERTICES);
+
+		// Cache the encoding info, page assignment and CreatePageData only read it
+		Cluster.GetEncodingInfo(EncodingSettings);
+	}, ParallelForFlags);
 
-	const auto MakeHierarchyNode = [&]
+	struct FPage
+	{
+		int32 ClusterOffset = 0;
+		int32 NumClusters = 0;
+		int32 VertexOffset = 0;
+	};
+	// Clusters of a group that are in the same page, each part is a leaf slot of the hierarchy
+	struct FGroupPart
+	{
+		int32 GroupIndex = 0;
+		int32 PageIndex = 0;
+		// Relative to the page
+		int32 ClusterOffset = 0;
+		int32 NumClusters = 0;
+	};
+	TVoxelArray<FPage> Pages;
+	TVoxelArray<FGroupPart> Parts;
 	{
-		Nanite::FPackedHierarchyNode HierarchyNode;
+		int32 ClusterIndex = 0;
+		int32 VertexOffset = 0;
+		int32 PageGpuSize = 0;
+
+		const auto CanAddToPage = [&](const int32 NumClustersToAdd, const int32 GpuSize)
+		{
+			if (Pages.Num() == 0)
+			{
+				return false;
+			}
+
+			const FPage& Page = Pages.Last();
+			if (Page.NumClusters == 0)
+			{
+				return true;
+			}
+
+			return
+				Page.NumClusters + NumClustersToAdd <= NANITE_ROOT_PAGE_MAX_CLUSTERS &&
+				PageGpuSize + GpuSize <= NANITE_ROOT_PAGE_GPU_SIZE;
+		};
+		const auto StartPage = [&]
+		{
+			ensure(PageGpuSize <= NANITE_ROOT_PAGE_GPU_SIZE);
+
+			FPage& Page = Pages.Emplace_GetRef();
+			Page.ClusterOffset = ClusterIndex;
+			Page.VertexOffset = VertexOffset;
+
+			PageGpuSize = 0;
+		};
 
-		for (int32 Index = 0; Index < 4; Index++)
+		for (int32 GroupIndex = 0; GroupIndex < DAG.Groups.Num(); GroupIndex++)
 		{
-			HierarchyNode.LODBounds[Index] = FVector4f(
-				Bounds.GetCenter().X,
-				Bounds.GetCenter().Y,
-				Bounds.GetCenter().Z,
-				Bounds.Size().Length());
-
-			HierarchyNode.Misc0[Index].MinLODError_MaxParentLODError = FFloat16(-1).Encoded | (FFloat16(1e10f).Encoded << 16);
-			HierarchyNode.Misc0[Index].BoxBoundsCenter = FVector3f(Bounds.GetCenter());
-			HierarchyNode.Misc1[Index].BoxBoundsExtent = FVector3f(Bounds.GetExtent());
-			HierarchyNode.Misc1[Index].ChildStartReference = 0xFFFFFFFF;
-			HierarchyNode.Misc2[Index].ResourcePageIndex_NumPages_GroupPartSize = 0;
+			const int32 NumGroupClusters = DAG.Groups[GroupIndex].Children.Num();
+
+			int32 GroupGpuSize = 0;
+			for (int32 Index = 0; Index < NumGroupClusters; Index++)
+			{
+				GroupGpuSize += AllClusters[ClusterIndex + Index].GetEncodingInfo(EncodingSettings).GpuSizes.GetTotal();
+			}
+
+			// Only split groups that don't fit in a page by themselves, every part costs a hierarchy slot
+			if (!CanAddToPage(NumGroupClusters, GroupGpuSize))
+			{
+				StartPage();
+			}
+
+			for (int32 Index = 0; Index < NumGroupClusters; Index++)
+			{
+				const FCluster& Cluster = AllClusters[ClusterIndex];
+				const int32 ClusterGpuSize = Cluster.GetEncodingInfo(EncodingSettings).GpuSizes.GetTotal();
+
+				if (!CanAddToPage(1, ClusterGpuSize))
+				{
+					StartPage();
+				}
+
+				FPage& Page = Pages.Last();
+
+				if (Index == 0 ||
+					Parts.Last().PageIndex != Pages.Num() - 1)
+				{
+					FGroupPart& Part = Parts.Emplace_GetRef();
+					Part.GroupIndex = GroupIndex;
+					Part.PageIndex = Pages.Num() - 1;
+					Part.ClusterOffset = Page.NumClusters;
+				}
+
+				Parts.Last().NumClusters++;
+
+				Page.NumClusters++;
+				PageGpuSize += ClusterGpuSize;
+				VertexOffset += Cluster.NumVertices();
+				ClusterIndex++;
+			}
 		}
+		check(ClusterIndex == NumClusters);
+		ensure(PageGpuSize <= NANITE_ROOT_PAGE_GPU_SIZE);
+	}
 
-		return HierarchyNode;
-	};
+	// Hierarchy slot of each part, filled when packing the hierarchy
+	TVoxelArray<int32> PartToNodeIndex;
+	TVoxelArray<int32> PartToSlotIndex;
+	FVoxelUtilities::SetNumFast(PartToNodeIndex, Parts.Num());
+	FVoxelUtilities::SetNumFast(PartToSlotIndex, Parts.Num());
 
-	TVoxelArray<int32> LeafNodes;
-	for (int32 Depth = 0; Depth <= TreeDepth; Depth++)
 	{
-		if (Depth == 0)
+		VOXEL_SCOPE_COUNTER("Build hierarchy");
+
+		struct FNode
 		{
-			Resources.HierarchyNodes.Add(MakeHierarchyNode());
-			LeafNodes.Add(0);
-			continue;
+			FVoxelBox Bounds;
+			FSphere3f LODBounds = FSphere3f(ForceInit);
+			float MinLODError = 0.f;
+			float MaxParentLODError = 0.f;
+
+			// Leaf nodes are group parts, they're stored in the slots of their parent
+			int32 PartIndex = -1;
+			TVoxelFixedArray<int32, 4> Children;
+		};
+		// The first nodes are the parts, in the same order
+		TVoxelArray<FNode> Nodes;
+		Nodes.Reserve(2 * Parts.Num() + 1);
+
+		for (int32 PartIndex = 0; PartIndex < Parts.Num(); PartIndex++)
+		{
+			const FGroupPart& Part = Parts[PartIndex];
+			const FLODGroup& Group = DAG.Groups[Part.GroupIndex];
+
+			FNode& Node = Nodes.Emplace_GetRef();
+			Node.Bounds = FVoxelBox::InvertedInfinite;
+			Node.LODBounds = Group.LODBounds;
+			Node.MinLODError = Group.MinLODError;
+			Node.MaxParentLODError = Group.MaxParentLODError;
+			Node.PartIndex = PartIndex;
+
+			const int32 ClusterOffset = Pages[Part.PageIndex].ClusterOffset + Part.ClusterOffset;
+			for (int32 Index = 0; Index < Part.NumClusters; Index++)
+			{
+				Node.Bounds += DAG.Clusters[SortedClusters[ClusterOffset + Index]].Bounds;
+			}
 		}
 
-		Resources.HierarchyNodes.Reserve(Resources.HierarchyNodes.Num() + 4 * LeafNodes.Num());
+		const auto AddParentNode = [&](const TConstVoxelArrayView<int32> Children)
+		{
+			checkVoxelSlow(Children.Num() <= 4);
+
+			FNode Node;
+			Node.Bounds = FVoxelBox::InvertedInfinite;
+			Node.MinLODError = MAX_flt;
+
+			FVoxelBox SpheresBounds = FVoxelBox::InvertedInfinite;
+			for (const int32 ChildIndex : Children)
+			{
+				const FNode& Child = Nodes[ChildIndex];
+
+				Node.Bounds += Child.Bounds;
+				Node.MinLODError = FMath::Min(Node.MinLODError, Child.MinLODError);
+				Node.MaxParentLODError = FMath::Max(Node.MaxParentLODError, Child.MaxParentLODError);
+				Node.Children.Add(ChildIndex);
 
-		TVoxelArray<int32> NewLeafNodes;
-		for (const int32 ParentIndex : LeafNodes)
+				SpheresBounds += FVoxelBox(
+					FVector3d(Child.LODBounds.Center) - Child.LODBounds.W,
+					FVector3d(Child.LODBounds.Center) + Child.LODBounds.W);
+			}
+
+			const FVector3f Center = FVector3f(SpheresBounds.GetCenter());
+
+			float Radius = 0.f;
+			for (const int32 ChildIndex : Children)
+			{
+				const FSphere3f& LODBounds = Nodes[ChildIndex].LODBounds;
+				Radius = FMath::Max(Radius, FVector3f::Distance(Center, LODBounds.Center) + LODBounds.W);
+			}
+			Node.LODBounds = FSphere3f(Center, Radius);
+
+			return Nodes.Add(Node);
+		};
+
+		// Bottom-up 4-ary tree, merging nodes that are close along a Morton curve
+		const auto BuildTree = [&](TVoxelArray<int32> LevelNodes, const bool bSort)
 		{
-			Nanite::FPackedHierarchyNode& ParentNode = Resources.HierarchyNodes[ParentIndex];
-			for (int32 Index = 0; Index < 4; Index++)
+			while (LevelNodes.Num() > 1)
 			{
-				const int32 ChildIndex = Resources.HierarchyNodes.Add(MakeHierarchyNode());
+				if (bSort)
+				{
+					FVoxelBox LevelBounds = FVoxelBox::InvertedInfinite;
+					for (const int32 NodeIndex : LevelNodes)
+					{
+						LevelBounds += Nodes[NodeIndex].Bounds;
+					}
+
+					TVoxelArray<uint64> Keys;
+					FVoxelUtilities::SetNumFast(Keys, LevelNodes.Num());
+
+					for (int32 Index = 0; Index < LevelNodes.Num(); Index++)
+					{
+						const uint32 Code = FClusterDAG::GetMortonCode(LevelBounds, Nodes[LevelNodes[Index]].Bounds.GetCenter());
+						Keys[Index] = (uint64(Code) << 32) | uint64(LevelNodes[Index]);
+					}
+
+					Keys.Sort();
+
+					for (int32 Index = 0; Index < LevelNodes.Num(); Index++)
+					{
+						LevelNodes[Index] = int32(Keys[Index] & MAX_uint32);
+					}
+				}
 
-				ensure(ParentNode.Misc1[Index].ChildStartReference == 0xFFFFFFFF);
-				ensure(ParentNode.Misc2[Index].ResourcePageIndex_NumPages_GroupPartSize == 0);
+				TVoxelArray<int32> ParentNodes;
+				for (int32 Index = 0; Index < LevelNodes.Num(); Index += 4)
+				{
+					ParentNodes.Add(AddParentNode(MakeVoxelArrayView(LevelNodes).Slice(Index, FMath::Min(4, LevelNodes.Num() - Index))));
+				}
 
-				ParentNode.Misc1[Index].ChildStartReference = ChildIndex;
-				ParentNode.Misc2[Index].ResourcePageIndex_NumPages_GroupPartSize = 0xFFFFFFFF;
+				LevelNodes = MoveTemp(ParentNodes);
+			}
 
-				NewLeafNodes.Add(ChildIndex);
+			check(LevelNodes.Num() == 1);
+			return LevelNodes[0];
+		};
+
+		// One tree per DAG level so that coarse levels are culled as a whole, then merge the trees
+		TVoxelArray<TVoxelArray<int32>> LevelToNodes;
+		for (int32 PartIndex = 0; PartIndex < Parts.Num(); PartIndex++)
+		{
+			const int32 Level = DAG.Groups[Parts[PartIndex].GroupIndex].Level;
+			if (LevelToNodes.Num() <= Level)
+			{
+				LevelToNodes.SetNum(Level + 1);
 			}
+			LevelToNodes[Level].Add(PartIndex);
 		}
 
-		LeafNodes = MoveTemp(NewLeafNodes);
-	}
-	check(AllClusters.Num() <= LeafNodes.Num());
+		TVoxelArray<int32> LevelRoots;
+		for (TVoxelArray<int32>& LevelNodes : LevelToNodes)
+		{
+			if (LevelNodes.Num() > 0)
+			{
+				LevelRoots.Add(BuildTree(MoveTemp(LevelNodes), true));
+			}
+		}
 
-	for (int32 ClusterIndex = 0; ClusterIndex < AllClusters.Num(); ClusterIndex++)
-	{
-		Nanite::FPackedHierarchyNode& HierarchyNode = Resources.HierarchyNodes[LeafNodes[ClusterIndex]];
+		int32 RootIndex = BuildTree(LevelRoots, false);
+		if (Nodes[RootIndex].PartIndex != -1)
+		{
+			// The root must be a node, not a slot
+			RootIndex = AddParentNode({ RootIndex });
+		}
 
-		ensure(HierarchyNode.Misc1[0].ChildStartReference == 0xFFFFFFFF);
-		ensure(HierarchyNode.Misc2[0].ResourcePageIndex_NumPages_GroupPartSize == 0);
+		// Pack inner nodes breadth-first so that the root is the first node
+		TVoxelArray<int32> PackedNodes;
+		TVoxelArray<int32> NodeToPackedIndex;
+		TVoxelArray<int32> NodeToDepth;
+		NodeToPackedIndex.SetNumUninitialized(Nodes.Num());
+		NodeToDepth.SetNumUninitialized(Nodes.Num());
 
-		HierarchyNode.Misc1[0].ChildStartReference = Resources.HierarchyNodes.Num() + ClusterIndex;
-		HierarchyNode.Misc2[0].ResourcePageIndex_NumPages_GroupPartSize = 0xFFFFFFFF;
-	}
+		PackedNodes.Add(RootIndex);
+		NodeToPackedIndex[RootIndex] = 0;
+		NodeToDepth[RootIndex] = 0;
 
-	FEncodingSettings EncodingSettings;
-	EncodingSettings.PositionPrecision = PositionPrecision;
-	checkStatic(FEncodingSettings::NormalBits == NormalBits);
+		for (int32 Index = 0; Index < PackedNodes.Num(); Index++)
+		{
+			const FNode& Node = Nodes[PackedNodes[Index]];
 
-	TVoxelArray<TVoxelArray<FCluster>> Pages;
-	{
-		int32 ClusterIndex = 0;
-		while (ClusterIndex < AllClusters.Num())
+			for (const int32 ChildIndex : Node.Children)
+			{
+				NodeToDepth[ChildIndex] = NodeToDepth[PackedNodes[Index]] + 1;
+
+				if (Nodes[ChildIndex].PartIndex == -1)
+				{
+					NodeToPackedIndex[ChildIndex] = PackedNodes.Add(ChildIndex);
+				}
+			}
+		}
+
+		Resources.HierarchyNodes.Reserve(PackedNodes.Num());
+
+		for (int32 PackedIndex = 0; PackedIndex < PackedNodes.Num(); PackedIndex++)
 		{
-			TVoxelArray<FCluster>& Clusters = Pages.Emplace_GetRef();
-			int32 GpuSize = 0;
+			const FNode& Node = Nodes[PackedNodes[PackedIndex]];
 
-			while (
-				ClusterIndex < AllClusters.Num() &&
-				Clusters.Num() < NANITE_ROOT_PAGE_MAX_CLUSTERS)
+			Nanite::FPackedHierarchyNode PackedHierarchyNode;
+			FMemory::Memzero(PackedHierarchyNode);
+
+			for (int32 SlotIndex = 0; SlotIndex < 4; SlotIndex++)
 			{
-				FCluster& Cluster = AllClusters[ClusterIndex];
+				if (SlotIndex >= Node.Children.Num())
+				{
+					PackedHierarchyNode.Misc1[SlotIndex].ChildStartReference = 0xFFFFFFFF;
+					PackedHierarchyNode.Misc2[SlotIndex].ResourcePageIndex_NumPages_GroupPartSize = 0;
+					continue;
+				}
 
-				const int32 ClusterGpuSize = Cluster.GetEncodingInfo(EncodingSettings).GpuSizes.GetTotal();
-				if (GpuSize + ClusterGpuSize > NANITE_ROOT_PAGE_GPU_SIZE)
+				const int32 ChildIndex = Node.Children[SlotIndex];
+				const FNode& Child = Nodes[ChildIndex];
+
+				PackedHierarchyNode.LODBounds[SlotIndex] = FVector4f(
+					Child.LODBounds.Center.X,
+					Child.LODBounds.Center.Y,
+					Child.LODBounds.Center.Z,
+					Child.LODBounds.W);
+
+				PackedHierarchyNode.Misc0[SlotIndex].BoxBoundsCenter = FVector3f(Child.Bounds.GetCenter());
+				PackedHierarchyNode.Misc0[SlotIndex].MinLODError_MaxParentLODError =
+					FFloat16(Child.MinLODError).Encoded |
+					(FFloat16(FMath::Min(Child.MaxParentLODError, 1e10f)).Encoded << 16);
+
+				PackedHierarchyNode.Misc1[SlotIndex].BoxBoundsExtent = FVector3f(Child.Bounds.GetExtent());
+
+				if (Child.PartIndex == -1)
 				{
-					break;
+					PackedHierarchyNode.Misc1[SlotIndex].ChildStartReference = NodeToPackedIndex[ChildIndex];
+					PackedHierarchyNode.Misc2[SlotIndex].ResourcePageIndex_NumPages_GroupPartSize = 0xFFFFFFFF;
+					continue;
 				}
 
-				Clusters.Add(MoveTemp(Cluster));
-				GpuSize += ClusterGpuSize;
-				ClusterIndex++;
+				ensure(NodeToDepth[ChildIndex] <= NANITE_MAX_CLUSTER_HIERARCHY_DEPTH);
+
+				PartToNodeIndex[Child.PartIndex] = PackedIndex;
+				PartToSlotIndex[Child.PartIndex] = SlotIndex;
+
+				// Set by the hierarchy fixup when the page is installed
+				PackedHierarchyNode.Misc1[SlotIndex].ChildStartReference = 0xFFFFFFFF;
+
+				const int32 PageIndexStart = 0;
+				const int32 PageIndexNum = 0;
+				const int32 GroupPartSize = Parts[Child.PartIndex].NumClusters;
+				PackedHierarchyNode.Misc2[SlotIndex].ResourcePageIndex_NumPages_GroupPartSize =
+					(PageIndexStart << (NANITE_MAX_CLUSTERS_PER_GROUP_BITS + NANITE_MAX_GROUP_PARTS_BITS)) |
+					(PageIndexNum << NANITE_MAX_CLUSTERS_PER_GROUP_BITS) |
+					GroupPartSize;
 			}
 
-			ensure(GpuSize <= NANITE_ROOT_PAGE_GPU_SIZE);
+			Resources.HierarchyNodes.Add(PackedHierarchyNode);
 		}
-		check(ClusterIndex == AllClusters.Num());
 	}
 
-	TVoxelChunkedArray<uint8> RootData;
-
-	int32 VertexOffset = 0;
-	int32 ClusterIndexOffset = 0;
+	// Parts are added page by page
+	TVoxelArray<int32> PageToFirstPart;
+	PageToFirstPart.SetNumZeroed(Pages.Num() + 1);
+	for (const FGroupPart& Part : Parts)
+	{
+		PageToFirstPart[Part.PageIndex + 1]++;
+	}
 	for (int32 PageIndex = 0; PageIndex < Pages.Num(); PageIndex++)
 	{
-		TVoxelArray<FCluster>& Clusters = Pages[PageIndex];
-		ON_SCOPE_EXIT
+		PageToFirstPart[PageIndex + 1] += PageToFirstPart[PageIndex];
+	}
+
+	if (Scratch.PageDatas.Num() < Pages.Num())
+	{
+		Scratch.PageDatas.SetNum(Pages.Num());
+	}
+
+	// Page data only stores offsets relative to the page start, so pages can be encoded separately
+	// and concatenated afterwards: the result is the same as encoding them one after the other
+	ParallelFor(Pages.Num(), [&](const int32 PageIndex)
+	{
+		const FPage& Page = Pages[PageIndex];
+
+		TVoxelChunkedArray<uint8>& PageData = Scratch.PageDatas[PageIndex];
+		PageData.Reset();
+
+		int32 VertexOffset = Page.VertexOffset;
+
+		CreatePageData(
+			AllClusters.Slice(Page.ClusterOffset, Page.NumClusters),
+			EncodingSettings,
+			PageData,
+			VertexOffset);
+
+		checkVoxelSlow(PageIndex + 1 == Pages.Num() || VertexOffset == Pages[PageIndex + 1].VertexOffset);
+	}, ParallelForFlags);
+
+	TArray<uint8>& RootData = Resources.RootData;
+	{
+		int32 RootDataSize = 0;
+		for (int32 PageIndex = 0; PageIndex < Pages.Num(); PageIndex++)
 		{
-			ClusterIndexOffset += Clusters.Num();
-		};
+			RootDataSize += sizeof(Nanite::FFixupChunk) + Scratch.PageDatas[PageIndex].Num();
+		}
+		RootData.Reserve(RootDataSize);
+	}
+
+	for (int32 PageIndex = 0; PageIndex < Pages.Num(); PageIndex++)
+	{
+		const FPage& Page = Pages[PageIndex];
+		const TVoxelChunkedArray<uint8>& PageData = Scratch.PageDatas[PageIndex];
 
 		Nanite::FPageStreamingState PageStreamingState{};
 		PageStreamingState.BulkOffset = RootData.Num();
 
 		Nanite::FFixupChunk FixupChunk;
 		FixupChunk.Header.Magic = NANITE_FIXUP_MAGIC;
-		FixupChunk.Header.NumClusters = Clusters.Num();
-		FixupChunk.Header.NumHierachyFixups = Clusters.Num();
-		FixupChunk.Header.NumClusterFixups = Clusters.Num();
+		FixupChunk.Header.NumClusters = Page.NumClusters;
+		const int32 FirstPart = PageToFirstPart[PageIndex];
+		const int32 NumParts = PageToFirstPart[PageIndex + 1] - FirstPart;
+
+		FixupChunk.Header.NumHierachyFixups = NumParts;
+		FixupChunk.Header.NumClusterFixups = Page.NumClusters;
 
-		const TVoxelArrayView<uint8> HierarchyFixupsData = MakeVoxelArrayView(FixupChunk.Data).LeftOf(sizeof(Nanite::FHierarchyFixup) * Clusters.Num());
-		const TVoxelArrayView<uint8> ClusterFixupsData = MakeVoxelArrayView(FixupChunk.Data).RightOf(sizeof(Nanite::FHierarchyFixup) * Clusters.Num());
+		const TVoxelArrayView<uint8> HierarchyFixupsData = MakeVoxelArrayView(FixupChunk.Data).LeftOf(sizeof(Nanite::FHierarchyFixup) * NumParts);
+		const TVoxelArrayView<uint8> ClusterFixupsData = MakeVoxelArrayView(FixupChunk.Data).RightOf(sizeof(Nanite::FHierarchyFixup) * NumParts);
 		const TVoxelArrayView<Nanite::FHierarchyFixup> HierarchyFixups = HierarchyFixupsData.ReinterpretAs<Nanite::FHierarchyFixup>();
-		const TVoxelArrayView<Nanite::FClusterFixup> ClusterFixups = ClusterFixupsData.ReinterpretAs<Nanite::FClusterFixup>().LeftOf(Clusters.Num());
+		const TVoxelArrayView<Nanite::FClusterFixup> ClusterFixups = ClusterFixupsData.ReinterpretAs<Nanite::FClusterFixup>().LeftOf(Page.NumClusters);
 
-		for (int32 Index = 0; Index < Clusters.Num(); Index++)
+		for (int32 Index = 0; Index < NumParts; Index++)
 		{
+			const int32 PartIndex = FirstPart + Index;
+			checkVoxelSlow(Parts[PartIndex].PageIndex == PageIndex);
+
 			HierarchyFixups[Index] = Nanite::FHierarchyFixup(
 				PageIndex,
-				Resources.HierarchyNodes.Num() + ClusterIndexOffset + Index,
-				0,
-				Index,
+				PartToNodeIndex[PartIndex],
+				PartToSlotIndex[PartIndex],
+				Parts[PartIndex].ClusterOffset,
 				0,
 				0);
+		}
 
+		for (int32 Index = 0; Index < Page.NumClusters; Index++)
+		{
 			ClusterFixups[Index] = Nanite::FClusterFixup(
 				PageIndex,
 				Index,
@@ -214,17 +654,20 @@ TUniquePtr<FStaticMeshRenderData> FVoxelNaniteBuilder::CreateRenderData(TVoxelAr
 				0);
 		}
 
-		RootData.Append(MakeByteVoxelArrayView(FixupChunk).LeftOf(FixupChunk.GetSize()));
+		const TConstVoxelArrayView<uint8> FixupChunkData = MakeByteVoxelArrayView(FixupChunk).LeftOf(FixupChunk.GetSize());
+		RootData.Append(FixupChunkData.GetData(), FixupChunkData.Num());
+
+		// CreatePageData requires the page to be aligned
+		ensure(RootData.Num() % sizeof(uint32) == 0);
 
 		const int32 PageStartIndex = RootData.Num();
 
-		OutVertexOffsets.Add(VertexOffset);
+		OutVertexOffsets.Add(Page.VertexOffset);
 
-		CreatePageData(
-			Clusters,
-			EncodingSettings,
-			RootData,
-			VertexOffset);
+		PageData.ForeachView(0, PageData.Num(), [&](const int32 ViewIndex, const TConstVoxelArrayView<uint8> View)
+		{
+			RootData.Append(View.GetData(), View.Num());
+		});
 
 		PageStreamingState.BulkSize = RootData.Num() - PageStreamingState.BulkOffset;
 		PageStreamingState.PageSize = RootData.Num() - PageStartIndex;
@@ -232,35 +675,12 @@ TUniquePtr<FStaticMeshRenderData> FVoxelNaniteBuilder::CreateRenderData(TVoxelAr
 		Resources.PageStreamingStates.Add(PageStreamingState);
 	}
 
-	for (int32 ClusterIndex = 0; ClusterIndex < AllClusters.Num(); ClusterIndex++)
-	{
-		Nanite::FPackedHierarchyNode PackedHierarchyNode;
-		FMemory::Memzero(PackedHierarchyNode);
-
-		PackedHierarchyNode.Misc0[0].BoxBoundsCenter = FVector3f(Bounds.GetCenter());
-		PackedHierarchyNode.Misc0[0].MinLODError_MaxParentLODError = FFloat16(-1).Encoded | (FFloat16(1e10f).Encoded << 16);
-
-		PackedHierarchyNode.Misc1[0].BoxBoundsExtent = FVector3f(Bounds.GetExtent());
-		PackedHierarchyNode.Misc1[0].ChildStartReference = 0xFFFFFFFFu;
-
-		const int32 PageIndexStart = 0;
-		const int32 PageIndexNum = 0;
-		const int32 GroupPartSize = 1;
-		PackedHierarchyNode.Misc2[0].ResourcePageIndex_NumPages_GroupPartSize =
-			(PageIndexStart << (NANITE_MAX_CLUSTERS_PER_GROUP_BITS + NANITE_MAX_GROUP_PARTS_BITS)) |
-			(PageIndexNum << NANITE_MAX_CLUSTERS_PER_GROUP_BITS) |
-			GroupPartSize;
-
-		Resources.HierarchyNodes.Add(PackedHierarchyNode);
-	}
-
-	Resources.RootData = RootData.Array();
 	Resources.PositionPrecision = -1;
 	Resources.NormalPrecision = -1;
 	Resources.NumInputTriangles = 0;
-	Resources.NumInputVertices = Mesh.Positions.Num();
+	Resources.NumInputVertices = InMesh.Positions.Num();
 	Resources.NumInputMeshes = 1;
-	Resources.NumInputTexCoords = Mesh.TextureCoordinates.Num();
+	Resources.NumInputTexCoords = InMesh.TextureCoordinates.Num();
 	Resources.NumClusters = AllClusters.Num();
 	Resources.NumRootPages = Pages.Num();
 	Resources.HierarchyRootOffsets.Add(0);
@@ -286,12 +706,172 @@ TUniquePtr<FStaticMeshRenderData> FVoxelNaniteBuilder::CreateRenderData(TVoxelAr
 	return RenderData;
 }
 
-UStaticMesh* FVoxelNaniteBuilder::CreateStaticMesh()
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+TVoxelArray<int32> FVoxelNaniteBuilder::ComputeSpatialTriangleOrder(const FMesh& InMesh)
 {
-	VOXEL_FUNCTION_COUNTER();
+	const int32 NumTriangles = InMesh.Positions.Num() / 3;
+	VOXEL_FUNCTION_COUNTER_NUM(NumTriangles, 1024);
 
-	TVoxelArray<int32> VertexOffsets;
-	return CreateStaticMesh(CreateRenderData(VertexOffsets));
+	// Same limit as CreateRenderData: clusters don't share vertices, so they're limited by their vertex count
+	const int32 MaxTrianglesPerCluster = FMath::Min(NANITE_MAX_CLUSTER_TRIANGLES, NANITE_MAX_CLUSTER_VERTICES / 3);
+
+	// Triangle lists store every vertex once per triangle: weld identical positions to find adjacency
+	int32 NumVertices = 0;
+	TVoxelArray<int32> CornerToVertex;
+	{
+		VOXEL_SCOPE_COUNTER("Weld");
+
+		TVoxelMap<FVector3f, int32> PositionToVertex;
+		PositionToVertex.Reserve(InMesh.Positions.Num() / 4);
+		FVoxelUtilities::SetNumFast(CornerToVertex, InMesh.Positions.Num());
+
+		for (int32 Index = 0; Index < InMesh.Positions.Num(); Index++)
+		{
+			const FVector3f& Position = InMesh.Positions[Index];
+			const uint32 Hash = PositionToVertex.HashValue(Position);
+
+			if (const int32* Vertex = PositionToVertex.FindHashed(Hash, Position))
+			{
+				CornerToVertex[Index] = *Vertex;
+				continue;
+			}
+
+			CornerToVertex[Index] = NumVertices;
+			PositionToVertex.AddHashed_CheckNew(Hash, Position, NumVertices);
+			NumVertices++;
+		}
+	}
+
+	// Compressed vertex -> triangles adjacency
+	TVoxelArray<int32> VertexToTrianglesStart;
+	TVoxelArray<int32> VertexToTriangles;
+	{
+		VOXEL_SCOPE_COUNTER("Adjacency");
+
+		VertexToTrianglesStart.SetNumZeroed(NumVertices + 1);
+		for (const int32 Vertex : CornerToVertex)
+		{
+			VertexToTrianglesStart[Vertex + 1]++;
+		}
+		for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+		{
+			VertexToTrianglesStart[Vertex + 1] += VertexToTrianglesStart[Vertex];
+		}
+
+		TVoxelArray<int32> Offsets = VertexToTrianglesStart;
+		FVoxelUtilities::SetNumFast(VertexToTriangles, CornerToVertex.Num());
+
+		for (int32 Index = 0; Index < CornerToVertex.Num(); Index++)
+		{
+			VertexToTriangles[Offsets[CornerToVertex[Index]]++] = Index / 3;
+		}
+	}
+
+	// Seeds are picked along a Morton curve so that consecutive clusters, and thus pages, stay close
+	TVoxelArray<int32> MortonOrder;
+	{
+		VOXEL_SCOPE_COUNTER("Morton");
+
+		const FVoxelBox Bounds = FVoxelBox::FromPositions(InMesh.Positions);
+
+		// Code in the high bits, triangle index in the low bits to keep the sort deterministic
+		TVoxelArray<uint64> Keys;
+		FVoxelUtilities::SetNumFast(Keys, NumTriangles);
+
+		for (int32 TriangleIndex = 0; TriangleIndex < NumTriangles; TriangleIndex++)
+		{
+			const FVector3f Centroid =
+				(InMesh.Positions[3 * TriangleIndex + 0] +
+				InMesh.Positions[3 * TriangleIndex + 1] +
+				InMesh.Positions[3 * TriangleIndex + 2]) / 3.f;
+
+			const uint32 Code = Voxel::Nanite::FClusterDAG::GetMortonCode(Bounds, FVector(Centroid));
+
+			Keys[TriangleIndex] = (uint64(Code) << 32) | uint64(TriangleIndex);
+		}
+
+		Keys.Sort();
+
+		FVoxelUtilities::SetNumFast(MortonOrder, NumTriangles);
+		for (int32 Index = 0; Index < NumTriangles; Index++)
+		{
+			MortonOrder[Index] = int32(Keys[Index] & MAX_uint32);
+		}
+	}
+
+	// Grow each cluster breadth-first over adjacent triangles, like a greedy graph partition
+	// If the surface runs out before the cluster is full, continue from the next seed
+	TVoxelArray<int32> Result;
+	Result.Reserve(NumTriangles);
+	{
+		VOXEL_SCOPE_COUNTER("Grow clusters");
+
+		// Set for triangles that are either in a cluster or in the current frontier
+		FVoxelBitArray IsVisited;
+		IsVisited.SetNum(NumTriangles, false);
+
+		TVoxelArray<int32> Frontier;
+		int32 FrontierIndex = 0;
+		int32 SeedIndex = 0;
+		int32 NumTrianglesInCluster = 0;
+
+		while (Result.Num() < NumTriangles)
+		{
+			if (FrontierIndex == Frontier.Num())
+			{
+				while (IsVisited[MortonOrder[SeedIndex]])
+				{
+					SeedIndex++;
+				}
+
+				Frontier.Reset();
+				FrontierIndex = 0;
+
+				Frontier.Add(MortonOrder[SeedIndex]);
+				IsVisited[MortonOrder[SeedIndex]] = true;
+			}
+
+			const int32 TriangleIndex = Frontier[FrontierIndex++];
+			Result.Add(TriangleIndex);
+			NumTrianglesInCluster++;
+
+			if (NumTrianglesInCluster == MaxTrianglesPerCluster)
+			{
+				// Cluster is full: release the frontier so that its triangles can seed or join later clusters
+				for (int32 Index = FrontierIndex; Index < Frontier.Num(); Index++)
+				{
+					IsVisited[Frontier[Index]] = false;
+				}
+
+				Frontier.Reset();
+				FrontierIndex = 0;
+				NumTrianglesInCluster = 0;
+				continue;
+			}
+
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				const int32 Vertex = CornerToVertex[3 * TriangleIndex + Corner];
+
+				for (int32 Index = VertexToTrianglesStart[Vertex]; Index < VertexToTrianglesStart[Vertex + 1]; Index++)
+				{
+					const int32 NeighborIndex = VertexToTriangles[Index];
+					if (IsVisited[NeighborIndex])
+					{
+						continue;
+					}
+
+					IsVisited[NeighborIndex] = true;
+					Frontier.Add(NeighborIndex);
+				}
+			}
+		}
+	}
+
+	return Result;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
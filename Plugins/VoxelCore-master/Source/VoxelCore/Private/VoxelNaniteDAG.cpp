@@ -0,0 +1,892 @@
+﻿// Copyright Voxel Plugin SAS. All Rights Reserved.
+
+#include "VoxelNaniteDAG.h"
+
+namespace Voxel::Nanite
+{
+struct FClusterDAG::FQuadric
+{
+	// Upper half of the symmetric 4x4 matrix of the plane equations, weighted by triangle area
+	double XX = 0;
+	double XY = 0;
+	double XZ = 0;
+	double XW = 0;
+	double YY = 0;
+	double YZ = 0;
+	double YW = 0;
+	double ZZ = 0;
+	double ZW = 0;
+	double WW = 0;
+	double Area = 0;
+
+	FQuadric() = default;
+	FQuadric(
+		const FVector3d& Normal,
+		const double Distance,
+		const double InArea)
+		: XX(InArea * Normal.X * Normal.X)
+		, XY(InArea * Normal.X * Normal.Y)
+		, XZ(InArea * Normal.X * Normal.Z)
+		, XW(InArea * Normal.X * Distance)
+		, YY(InArea * Normal.Y * Normal.Y)
+		, YZ(InArea * Normal.Y * Normal.Z)
+		, YW(InArea * Normal.Y * Distance)
+		, ZZ(InArea * Normal.Z * Normal.Z)
+		, ZW(InArea * Normal.Z * Distance)
+		, WW(InArea * Distance * Distance)
+		, Area(InArea)
+	{
+	}
+
+	FORCEINLINE void operator+=(const FQuadric& Other)
+	{
+		XX += Other.XX;
+		XY += Other.XY;
+		XZ += Other.XZ;
+		XW += Other.XW;
+		YY += Other.YY;
+		YZ += Other.YZ;
+		YW += Other.YW;
+		ZZ += Other.ZZ;
+		ZW += Other.ZW;
+		WW += Other.WW;
+		Area += Other.Area;
+	}
+
+	// Area-weighted sum of the squared distances to the planes
+	FORCEINLINE double Evaluate(const FVector3d& P) const
+	{
+		return
+			XX * P.X * P.X + 2 * XY * P.X * P.Y + 2 * XZ * P.X * P.Z + 2 * XW * P.X +
+			YY * P.Y * P.Y + 2 * YZ * P.Y * P.Z + 2 * YW * P.Y +
+			ZZ * P.Z * P.Z + 2 * ZW * P.Z +
+			WW;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+FClusterDAG::FClusterDAG(
+	const TConstVoxelArrayView<FVector3f> Positions,
+	const TConstVoxelArrayView<int32> TriangleOrder,
+	const int32 MaxTrianglesPerCluster,
+	const EParallelForFlags ParallelForFlags)
+	: Positions(Positions)
+	, MaxTrianglesPerCluster(MaxTrianglesPerCluster)
+	, ParallelForFlags(ParallelForFlags)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Positions.Num(), 1024);
+	check(Positions.Num() % 3 == 0);
+	check(MaxTrianglesPerCluster > 0);
+
+	const int32 NumTriangles = Positions.Num() / 3;
+	check(TriangleOrder.Num() == 0 || TriangleOrder.Num() == NumTriangles);
+
+	FVoxelUtilities::SetNumFast(Vertices, Positions.Num());
+
+	for (int32 Index = 0; Index < NumTriangles; Index++)
+	{
+		const int32 TriangleIndex = TriangleOrder.Num() > 0 ? TriangleOrder[Index] : Index;
+
+		Vertices[3 * Index + 0] = 3 * TriangleIndex + 0;
+		Vertices[3 * Index + 1] = 3 * TriangleIndex + 1;
+		Vertices[3 * Index + 2] = 3 * TriangleIndex + 2;
+	}
+
+	Clusters.SetNum(FVoxelUtilities::DivideCeil_Positive(NumTriangles, MaxTrianglesPerCluster));
+
+	ParallelFor(Clusters.Num(), [&](const int32 ClusterIndex)
+	{
+		FLODCluster& Cluster = Clusters[ClusterIndex];
+		Cluster.VertexOffset = 3 * MaxTrianglesPerCluster * ClusterIndex;
+		Cluster.NumVertices = FMath::Min(3 * MaxTrianglesPerCluster, Vertices.Num() - Cluster.VertexOffset);
+
+		ComputeBounds(Cluster);
+	}, ParallelForFlags);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FClusterDAG::BuildFlat()
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Clusters.Num(), 16);
+	check(Groups.Num() == 0);
+
+	Groups.Reserve(Clusters.Num());
+
+	for (int32 ClusterIndex = 0; ClusterIndex < Clusters.Num(); ClusterIndex++)
+	{
+		AddGroup(0, { ClusterIndex }, MAX_flt);
+	}
+}
+
+void FClusterDAG::BuildLODs()
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Clusters.Num(), 16);
+	check(Groups.Num() == 0);
+
+	TVoxelArray<int32> LevelClusters;
+	FVoxelUtilities::SetNumFast(LevelClusters, Clusters.Num());
+
+	for (int32 ClusterIndex = 0; ClusterIndex < Clusters.Num(); ClusterIndex++)
+	{
+		LevelClusters[ClusterIndex] = ClusterIndex;
+	}
+
+	// Every simplified group has fewer parents than children, so this always terminates
+	for (int32 Level = 0; LevelClusters.Num() > 0; Level++)
+	{
+		VOXEL_SCOPE_COUNTER_FORMAT("Level %d", Level);
+
+		if (LevelClusters.Num() == 1)
+		{
+			AddGroup(Level, LevelClusters, MAX_flt);
+			break;
+		}
+
+		TVoxelArray<TVoxelArray<int32>> LevelGroups = MakeGroups(LevelClusters);
+
+		TVoxelArray<bool> IsSimplified;
+		TVoxelArray<float> Errors;
+		TVoxelArray<TVoxelArray<int32>> NewVertices;
+		IsSimplified.SetNum(LevelGroups.Num());
+		Errors.SetNum(LevelGroups.Num());
+		NewVertices.SetNum(LevelGroups.Num());
+
+		ParallelFor(LevelGroups.Num(), [&](const int32 Index)
+		{
+			IsSimplified[Index] = SimplifyGroup(
+				LevelGroups[Index],
+				NewVertices[Index],
+				Errors[Index]);
+		}, ParallelForFlags);
+
+		TVoxelArray<int32> NextLevelClusters;
+		for (int32 Index = 0; Index < LevelGroups.Num(); Index++)
+		{
+			if (!IsSimplified[Index])
+			{
+				// Stays a root of the DAG
+				AddGroup(Level, MoveTemp(LevelGroups[Index]), MAX_flt);
+				continue;
+			}
+
+			const int32 GroupIndex = AddGroup(Level, MoveTemp(LevelGroups[Index]), Errors[Index]);
+			const FSphere3f LODBounds = Groups[GroupIndex].LODBounds;
+			const float LODError = Groups[GroupIndex].MaxParentLODError;
+
+			const TConstVoxelArrayView<int32> GroupVertices = NewVertices[Index];
+			for (int32 Offset = 0; Offset < GroupVertices.Num(); Offset += 3 * MaxTrianglesPerCluster)
+			{
+				const int32 ClusterIndex = AddCluster(GroupVertices.Slice(Offset, FMath::Min(3 * MaxTrianglesPerCluster, GroupVertices.Num() - Offset)));
+
+				FLODCluster& Cluster = Clusters[ClusterIndex];
+				Cluster.LODBounds = LODBounds;
+				Cluster.LODError = LODError;
+				Cluster.GeneratingGroupIndex = GroupIndex;
+
+				NextLevelClusters.Add(ClusterIndex);
+			}
+		}
+
+		LevelClusters = MoveTemp(NextLevelClusters);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+TVoxelArray<int32> FClusterDAG::GetClustersSortedByGroup() const
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Clusters.Num(), 1024);
+
+	TVoxelArray<int32> Result;
+	Result.Reserve(Clusters.Num());
+
+	for (const FLODGroup& Group : Groups)
+	{
+		Result.Append(Group.Children);
+	}
+
+	check(Result.Num() == Clusters.Num());
+	return Result;
+}
+
+void FClusterDAG::CheckInvariants() const
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Clusters.Num(), 16);
+
+	const auto ContainsSphere = [](const FSphere3f& Parent, const FSphere3f& Child)
+	{
+		const float Tolerance = 1.e-4f * FMath::Max(1.f, Parent.W);
+		return FVector3f::Distance(Parent.Center, Child.Center) + Child.W <= Parent.W + Tolerance;
+	};
+
+	for (int32 ClusterIndex = 0; ClusterIndex < Clusters.Num(); ClusterIndex++)
+	{
+		const FLODCluster& Cluster = Clusters[ClusterIndex];
+
+		check(Cluster.NumVertices > 0);
+		check(Cluster.NumVertices % 3 == 0);
+		check(Cluster.NumVertices <= 3 * MaxTrianglesPerCluster);
+		check(Groups.IsValidIndex(Cluster.GroupIndex));
+		check(Groups[Cluster.GroupIndex].Children.Contains(ClusterIndex));
+
+		for (const int32 Vertex : GetVertices(Cluster))
+		{
+			check(Positions.IsValidIndex(Vertex));
+			check(Cluster.Bounds.Contains(Positions[Vertex]));
+		}
+
+		if (Cluster.IsLeaf())
+		{
+			check(Cluster.LODError == 0.f);
+			check(Groups[Cluster.GroupIndex].Level == 0);
+			continue;
+		}
+
+		const FLODGroup& GeneratingGroup = Groups[Cluster.GeneratingGroupIndex];
+		check(Groups[Cluster.GroupIndex].Level == GeneratingGroup.Level + 1);
+		check(Cluster.LODError == GeneratingGroup.MaxParentLODError);
+		check(GeneratingGroup.Bounds.Contains(Cluster.Bounds));
+
+		for (const int32 ChildIndex : GeneratingGroup.Children)
+		{
+			const FLODCluster& Child = Clusters[ChildIndex];
+			check(Cluster.LODError >= Child.LODError);
+			check(ContainsSphere(Cluster.LODBounds, Child.LODBounds));
+		}
+	}
+
+	int32 NumChildren = 0;
+	for (const FLODGroup& Group : Groups)
+	{
+		check(Group.Children.Num() > 0);
+		NumChildren += Group.Children.Num();
+
+		for (const int32 ChildIndex : Group.Children)
+		{
+			const FLODCluster& Child = Clusters[ChildIndex];
+			check(Group.MinLODError <= Child.LODError);
+			check(Group.MaxParentLODError >= Child.LODError);
+			check(Group.Bounds.Contains(Child.Bounds));
+			check(ContainsSphere(Group.LODBounds, Child.LODBounds));
+		}
+	}
+	check(NumChildren == Clusters.Num());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+uint32 FClusterDAG::GetMortonCode(const FVoxelBox& Bounds, const FVector& Position)
+{
+	const FVector Scale = FVector(1023.) / FVoxelUtilities::ComponentMax(Bounds.Size(), FVector(KINDA_SMALL_NUMBER));
+
+	const FIntVector Cell = FVoxelUtilities::Clamp(
+		FVoxelUtilities::FloorToInt((Position - Bounds.Min) * Scale),
+		FIntVector(0),
+		FIntVector(1023));
+
+	return
+		(FMath::MortonCode3(Cell.X) << 0) |
+		(FMath::MortonCode3(Cell.Y) << 1) |
+		(FMath::MortonCode3(Cell.Z) << 2);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FClusterDAG::ComputeBounds(FLODCluster& Cluster) const
+{
+	const TConstVoxelArrayView<int32> ClusterVertices = GetVertices(Cluster);
+
+	Cluster.Bounds = FVoxelBox::InvertedInfinite;
+	for (const int32 Vertex : ClusterVertices)
+	{
+		Cluster.Bounds += Positions[Vertex];
+	}
+
+	const FVector3f Center = FVector3f(Cluster.Bounds.GetCenter());
+
+	float RadiusSquared = 0.f;
+	for (const int32 Vertex : ClusterVertices)
+	{
+		RadiusSquared = FMath::Max(RadiusSquared, FVector3f::DistSquared(Center, Positions[Vertex]));
+	}
+
+	Cluster.LODBounds = FSphere3f(Center, FMath::Sqrt(RadiusSquared));
+}
+
+int32 FClusterDAG::AddCluster(const TConstVoxelArrayView<int32> ClusterVertices)
+{
+	const int32 ClusterIndex = Clusters.Num();
+
+	FLODCluster& Cluster = Clusters.Emplace_GetRef();
+	Cluster.VertexOffset = Vertices.Num();
+	Cluster.NumVertices = ClusterVertices.Num();
+
+	Vertices.Append(ClusterVertices.GetData(), ClusterVertices.Num());
+
+	ComputeBounds(Cluster);
+
+	return ClusterIndex;
+}
+
+int32 FClusterDAG::AddGroup(
+	const int32 Level,
+	TVoxelArray<int32> Children,
+	const float SimplificationError)
+{
+	const int32 GroupIndex = Groups.Num();
+
+	FLODGroup& Group = Groups.Emplace_GetRef();
+	Group.Level = Level;
+	Group.Bounds = FVoxelBox::InvertedInfinite;
+	Group.MinLODError = MAX_flt;
+
+	float MaxLODError = 0.f;
+	FVoxelBox SpheresBounds = FVoxelBox::InvertedInfinite;
+
+	for (const int32 ClusterIndex : Children)
+	{
+		FLODCluster& Cluster = Clusters[ClusterIndex];
+		check(Cluster.GroupIndex == -1);
+		Cluster.GroupIndex = GroupIndex;
+
+		Group.Bounds += Cluster.Bounds;
+		Group.MinLODError = FMath::Min(Group.MinLODError, Cluster.LODError);
+		MaxLODError = FMath::Max(MaxLODError, Cluster.LODError);
+
+		SpheresBounds += FVoxelBox(
+			FVector3d(Cluster.LODBounds.Center) - Cluster.LODBounds.W,
+			FVector3d(Cluster.LODBounds.Center) + Cluster.LODBounds.W);
+	}
+
+	// Not the smallest enclosing sphere, but it does contain all the children spheres
+	const FVector3f Center = FVector3f(SpheresBounds.GetCenter());
+
+	double Radius = 0.;
+	for (const int32 ClusterIndex : Children)
+	{
+		const FSphere3f& LODBounds = Clusters[ClusterIndex].LODBounds;
+		Radius = FMath::Max(Radius, FVector3d::Distance(FVector3d(Center), FVector3d(LODBounds.Center)) + LODBounds.W);
+	}
+
+	Group.LODBounds = FSphere3f(Center, float(Radius));
+
+	// Errors must increase monotonically from children to parents, otherwise a parent could be drawn along with its children
+	Group.MaxParentLODError = FMath::Max(SimplificationError, MaxLODError);
+	Group.Children = MoveTemp(Children);
+
+	return GroupIndex;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+TVoxelArray<TVoxelArray<int32>> FClusterDAG::MakeGroups(const TConstVoxelArrayView<int32> LevelClusters) const
+{
+	VOXEL_FUNCTION_COUNTER_NUM(LevelClusters.Num(), 16);
+
+	FVoxelBox Bounds = FVoxelBox::InvertedInfinite;
+	for (const int32 ClusterIndex : LevelClusters)
+	{
+		Bounds += Clusters[ClusterIndex].Bounds;
+	}
+
+	// Morton code in the high bits, index in the low bits to keep the sort deterministic
+	TVoxelArray<uint64> Keys;
+	FVoxelUtilities::SetNumFast(Keys, LevelClusters.Num());
+
+	for (int32 Index = 0; Index < LevelClusters.Num(); Index++)
+	{
+		const uint32 Code = GetMortonCode(Bounds, Clusters[LevelClusters[Index]].Bounds.GetCenter());
+		Keys[Index] = (uint64(Code) << 32) | uint64(Index);
+	}
+
+	Keys.Sort();
+
+	TVoxelArray<TVoxelArray<int32>> Result;
+	Result.Reserve(FVoxelUtilities::DivideCeil_Positive(Keys.Num(), GroupSize));
+
+	int32 Index = 0;
+	while (Index < Keys.Num())
+	{
+		int32 Num = FMath::Min(GroupSize, Keys.Num() - Index);
+
+		// Don't leave a single cluster alone in the last group, it could never be simplified
+		if (Keys.Num() - (Index + Num) == 1)
+		{
+			Num++;
+		}
+
+		TVoxelArray<int32>& Group = Result.Emplace_GetRef();
+		Group.Reserve(Num);
+
+		for (int32 KeyIndex = Index; KeyIndex < Index + Num; KeyIndex++)
+		{
+			Group.Add(LevelClusters[int32(Keys[KeyIndex] & MAX_uint32)]);
+		}
+
+		Index += Num;
+	}
+
+	return Result;
+}
+
+bool FClusterDAG::SimplifyGroup(
+	const TConstVoxelArrayView<int32> Children,
+	TVoxelArray<int32>& OutVertices,
+	float& OutError) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	// Clusters don't share vertices: weld them by position to get the topology of the group
+	TVoxelArray<FVector3f> WeldedPositions;
+	// Welded vertex to source vertex, the first one found with this position
+	TVoxelArray<int32> WeldedToVertex;
+	TVoxelArray<int32> Indices;
+	{
+		int32 NumVertices = 0;
+		for (const int32 ClusterIndex : Children)
+		{
+			NumVertices += Clusters[ClusterIndex].NumVertices;
+		}
+
+		TVoxelMap<FVector3f, int32> PositionToWelded;
+		PositionToWelded.Reserve(NumVertices / 2);
+		Indices.Reserve(NumVertices);
+
+		for (const int32 ClusterIndex : Children)
+		{
+			const TConstVoxelArrayView<int32> ClusterVertices = GetVertices(Clusters[ClusterIndex]);
+
+			for (int32 TriangleIndex = 0; TriangleIndex < ClusterVertices.Num() / 3; TriangleIndex++)
+			{
+				int32 Triangle[3];
+				for (int32 Corner = 0; Corner < 3; Corner++)
+				{
+					const int32 Vertex = ClusterVertices[3 * TriangleIndex + Corner];
+					const FVector3f& Position = Positions[Vertex];
+					const uint32 Hash = PositionToWelded.HashValue(Position);
+
+					if (const int32* Welded = PositionToWelded.FindHashed(Hash, Position))
+					{
+						Triangle[Corner] = *Welded;
+						continue;
+					}
+
+					Triangle[Corner] = WeldedPositions.Add(Position);
+					WeldedToVertex.Add(Vertex);
+					PositionToWelded.AddHashed_CheckNew(Hash, Position, Triangle[Corner]);
+				}
+
+				// Degenerate triangles aren't visible, skip them
+				if (Triangle[0] == Triangle[1] ||
+					Triangle[1] == Triangle[2] ||
+					Triangle[0] == Triangle[2])
+				{
+					continue;
+				}
+
+				Indices.Add(Triangle[0]);
+				Indices.Add(Triangle[1]);
+				Indices.Add(Triangle[2]);
+			}
+		}
+	}
+
+	const int32 NumTriangles = Indices.Num() / 3;
+	if (NumTriangles == 0)
+	{
+		return false;
+	}
+
+	// Lock all the vertices of edges that aren't shared by exactly two triangles:
+	// this is the group boundary, shared with the neighboring groups, and non-manifold edges
+	FVoxelBitArray LockedVertices;
+	LockedVertices.SetNum(WeldedPositions.Num(), false);
+	{
+		TVoxelMap<uint64, int32> EdgeToCount;
+		EdgeToCount.Reserve(Indices.Num());
+
+		for (int32 TriangleIndex = 0; TriangleIndex < NumTriangles; TriangleIndex++)
+		{
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				const int32 IndexA = Indices[3 * TriangleIndex + Corner];
+				const int32 IndexB = Indices[3 * TriangleIndex + (Corner + 1) % 3];
+
+				const uint64 Edge = (uint64(FMath::Min(IndexA, IndexB)) << 32) | uint64(FMath::Max(IndexA, IndexB));
+				EdgeToCount.FindOrAdd(Edge)++;
+			}
+		}
+
+		for (const auto& It : EdgeToCount)
+		{
+			if (It.Value == 2)
+			{
+				continue;
+			}
+
+			LockedVertices[int32(It.Key >> 32)] = true;
+			LockedVertices[int32(It.Key & MAX_uint32)] = true;
+		}
+	}
+
+	OutError = SimplifyMesh(WeldedPositions, LockedVertices, Indices, NumTriangles / 2);
+
+	const int32 NewNumTriangles = Indices.Num() / 3;
+	if (NewNumTriangles == 0 ||
+		FVoxelUtilities::DivideCeil_Positive(NewNumTriangles, MaxTrianglesPerCluster) >= Children.Num())
+	{
+		return false;
+	}
+
+	// Sort triangles along a Morton curve so that the parent clusters are compact
+	const FVoxelBox Bounds = FVoxelBox::FromPositions(WeldedPositions);
+
+	TVoxelArray<uint64> Keys;
+	FVoxelUtilities::SetNumFast(Keys, NewNumTriangles);
+
+	for (int32 TriangleIndex = 0; TriangleIndex < NewNumTriangles; TriangleIndex++)
+	{
+		const FVector3f Centroid =
+			(WeldedPositions[Indices[3 * TriangleIndex + 0]] +
+			WeldedPositions[Indices[3 * TriangleIndex + 1]] +
+			WeldedPositions[Indices[3 * TriangleIndex + 2]]) / 3.f;
+
+		Keys[TriangleIndex] = (uint64(GetMortonCode(Bounds, FVector(Centroid))) << 32) | uint64(TriangleIndex);
+	}
+
+	Keys.Sort();
+
+	FVoxelUtilities::SetNumFast(OutVertices, 3 * NewNumTriangles);
+
+	for (int32 Index = 0; Index < NewNumTriangles; Index++)
+	{
+		const int32 TriangleIndex = int32(Keys[Index] & MAX_uint32);
+
+		OutVertices[3 * Index + 0] = WeldedToVertex[Indices[3 * TriangleIndex + 0]];
+		OutVertices[3 * Index + 1] = WeldedToVertex[Indices[3 * TriangleIndex + 1]];
+		OutVertices[3 * Index + 2] = WeldedToVertex[Indices[3 * TriangleIndex + 2]];
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+float FClusterDAG::SimplifyMesh(
+	const TConstVoxelArrayView<FVector3f> MeshPositions,
+	const FVoxelBitArray& LockedVertices,
+	TVoxelArray<int32>& Indices,
+	const int32 TargetNumTriangles)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Indices.Num() / 3, 128);
+	check(Indices.Num() % 3 == 0);
+	check(LockedVertices.Num() == MeshPositions.Num());
+
+	const int32 NumVertices = MeshPositions.Num();
+	int32 NumTriangles = Indices.Num() / 3;
+
+	// Relative to the center to keep the quadrics precise
+	TVoxelArray<FVector3d> LocalPositions;
+	{
+		const FVector3d Center = FVoxelBox::FromPositions(MeshPositions).GetCenter();
+
+		FVoxelUtilities::SetNumFast(LocalPositions, NumVertices);
+		for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+		{
+			LocalPositions[Vertex] = FVector3d(MeshPositions[Vertex]) - Center;
+		}
+	}
+
+	TVoxelArray<FQuadric> Quadrics;
+	TVoxelArray<TVoxelInlineArray<int32, 8>> VertexToTriangles;
+	Quadrics.SetNum(NumVertices);
+	VertexToTriangles.SetNum(NumVertices);
+
+	for (int32 TriangleIndex = 0; TriangleIndex < NumTriangles; TriangleIndex++)
+	{
+		const int32 IndexA = Indices[3 * TriangleIndex + 0];
+		const int32 IndexB = Indices[3 * TriangleIndex + 1];
+		const int32 IndexC = Indices[3 * TriangleIndex + 2];
+
+		VertexToTriangles[IndexA].Add(TriangleIndex);
+		VertexToTriangles[IndexB].Add(TriangleIndex);
+		VertexToTriangles[IndexC].Add(TriangleIndex);
+
+		const FVector3d Cross = FVector3d::CrossProduct(
+			LocalPositions[IndexB] - LocalPositions[IndexA],
+			LocalPositions[IndexC] - LocalPositions[IndexA]);
+
+		const double DoubleArea = Cross.Size();
+		if (DoubleArea == 0.)
+		{
+			continue;
+		}
+
+		const FVector3d Normal = Cross / DoubleArea;
+		const FQuadric Quadric(Normal, -Normal.Dot(LocalPositions[IndexA]), DoubleArea / 2.);
+
+		Quadrics[IndexA] += Quadric;
+		Quadrics[IndexB] += Quadric;
+		Quadrics[IndexC] += Quadric;
+	}
+
+	FVoxelBitArray IsTriangleRemoved;
+	IsTriangleRemoved.SetNum(NumTriangles, false);
+
+	// Bumped every time the quadric of a vertex changes, to detect outdated candidates
+	TVoxelArray<int32> Versions;
+	Versions.SetNumZeroed(NumVertices);
+
+	struct FCandidate
+	{
+		double Cost = 0;
+		int32 From = 0;
+		int32 To = 0;
+		int32 FromVersion = 0;
+		int32 ToVersion = 0;
+	};
+	const auto HeapPredicate = [](const FCandidate& A, const FCandidate& B)
+	{
+		return A.Cost < B.Cost;
+	};
+	TVoxelArray<FCandidate> Heap;
+
+	using FNeighbors = TVoxelInlineArray<int32, 32>;
+
+	const auto GetNeighbors = [&](const int32 Vertex, FNeighbors& OutNeighbors)
+	{
+		OutNeighbors.Reset();
+
+		for (const int32 TriangleIndex : VertexToTriangles[Vertex])
+		{
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				const int32 Other = Indices[3 * TriangleIndex + Corner];
+				if (Other != Vertex)
+				{
+					OutNeighbors.AddUnique(Other);
+				}
+			}
+		}
+	};
+
+	const auto AddCandidate = [&](const int32 From, const int32 To)
+	{
+		FQuadric Quadric = Quadrics[From];
+		Quadric += Quadrics[To];
+
+		FCandidate Candidate;
+		// Normalized by area so that the cost is a squared distance
+		Candidate.Cost = FMath::Max(0., Quadric.Evaluate(LocalPositions[To])) / FMath::Max(Quadric.Area, UE_DOUBLE_SMALL_NUMBER);
+		Candidate.From = From;
+		Candidate.To = To;
+		Candidate.FromVersion = Versions[From];
+		Candidate.ToVersion = Versions[To];
+
+		Heap.HeapPush(Candidate, HeapPredicate);
+	};
+
+	FNeighbors Neighbors;
+	for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+	{
+		if (LockedVertices[Vertex])
+		{
+			continue;
+		}
+
+		GetNeighbors(Vertex, Neighbors);
+
+		for (const int32 Neighbor : Neighbors)
+		{
+			AddCandidate(Vertex, Neighbor);
+		}
+	}
+
+	const auto CanCollapse = [&](const int32 From, const int32 To)
+	{
+		// Link condition: the vertices adjacent to both must be the ones of the triangles removed by the collapse,
+		// otherwise the collapse would create a non-manifold edge or duplicated triangles
+		{
+			FNeighbors FromNeighbors;
+			FNeighbors ToNeighbors;
+			GetNeighbors(From, FromNeighbors);
+			GetNeighbors(To, ToNeighbors);
+
+			int32 NumSharedNeighbors = 0;
+			for (const int32 Neighbor : FromNeighbors)
+			{
+				if (ToNeighbors.Contains(Neighbor))
+				{
+					NumSharedNeighbors++;
+				}
+			}
+
+			int32 NumSharedTriangles = 0;
+			for (const int32 TriangleIndex : VertexToTriangles[From])
+			{
+				if (VertexToTriangles[To].Contains(TriangleIndex))
+				{
+					NumSharedTriangles++;
+				}
+			}
+
+			if (NumSharedNeighbors != NumSharedTriangles)
+			{
+				return false;
+			}
+		}
+
+		// Reject collapses that flip or badly rotate a triangle
+		for (const int32 TriangleIndex : VertexToTriangles[From])
+		{
+			FVector3d Corners[3];
+			FVector3d NewCorners[3];
+			bool bHasTo = false;
+
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				const int32 Vertex = Indices[3 * TriangleIndex + Corner];
+				bHasTo |= Vertex == To;
+
+				Corners[Corner] = LocalPositions[Vertex];
+				NewCorners[Corner] = LocalPositions[Vertex == From ? To : Vertex];
+			}
+
+			if (bHasTo)
+			{
+				// Removed by the collapse
+				continue;
+			}
+
+			const FVector3d Normal = FVector3d::CrossProduct(Corners[1] - Corners[0], Corners[2] - Corners[0]);
+			const FVector3d NewNormal = FVector3d::CrossProduct(NewCorners[1] - NewCorners[0], NewCorners[2] - NewCorners[0]);
+
+			if (Normal.SizeSquared() == 0.)
+			{
+				continue;
+			}
+
+			if (Normal.Dot(NewNormal) <= 0.2 * Normal.Size() * NewNormal.Size())
+			{
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	double MaxCost = 0.;
+	while (
+		NumTriangles > TargetNumTriangles &&
+		Heap.Num() > 0)
+	{
+		FCandidate Candidate;
+		Heap.HeapPop(Candidate, HeapPredicate, EAllowShrinking::No);
+
+		const int32 From = Candidate.From;
+		const int32 To = Candidate.To;
+
+		if (Candidate.FromVersion != Versions[From] ||
+			Candidate.ToVersion != Versions[To])
+		{
+			continue;
+		}
+		checkVoxelSlow(!LockedVertices[From]);
+
+		if (!CanCollapse(From, To))
+		{
+			continue;
+		}
+
+		MaxCost = FMath::Max(MaxCost, Candidate.Cost);
+
+		for (const int32 TriangleIndex : VertexToTriangles[From])
+		{
+			int32* Corners = &Indices[3 * TriangleIndex];
+
+			if (Corners[0] == To ||
+				Corners[1] == To ||
+				Corners[2] == To)
+			{
+				IsTriangleRemoved[TriangleIndex] = true;
+				NumTriangles--;
+
+				for (int32 Corner = 0; Corner < 3; Corner++)
+				{
+					if (Corners[Corner] != From)
+					{
+						VertexToTriangles[Corners[Corner]].RemoveSingleSwap(TriangleIndex);
+					}
+				}
+				continue;
+			}
+
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				if (Corners[Corner] == From)
+				{
+					Corners[Corner] = To;
+				}
+			}
+			VertexToTriangles[To].Add(TriangleIndex);
+		}
+
+		VertexToTriangles[From].Reset();
+		Quadrics[To] += Quadrics[From];
+
+		Versions[From]++;
+		Versions[To]++;
+
+		// Costs of the edges of To changed, and collapses rejected before might now be valid
+		GetNeighbors(To, Neighbors);
+
+		for (const int32 Neighbor : Neighbors)
+		{
+			if (!LockedVertices[To])
+			{
+				AddCandidate(To, Neighbor);
+			}
+			if (!LockedVertices[Neighbor])
+			{
+				AddCandidate(Neighbor, To);
+			}
+		}
+	}
+
+	TVoxelArray<int32> NewIndices;
+	NewIndices.Reserve(3 * NumTriangles);
+
+	for (int32 TriangleIndex = 0; TriangleIndex < IsTriangleRemoved.Num(); TriangleIndex++)
+	{
+		if (IsTriangleRemoved[TriangleIndex])
+		{
+			continue;
+		}
+
+		NewIndices.Add(Indices[3 * TriangleIndex + 0]);
+		NewIndices.Add(Indices[3 * TriangleIndex + 1]);
+		NewIndices.Add(Indices[3 * TriangleIndex + 2]);
+	}
+	check(NewIndices.Num() == 3 * NumTriangles);
+
+	Indices = MoveTemp(NewIndices);
+
+	return FMath::Sqrt(MaxCost);
+}
+}
@@ -0,0 +1,118 @@
+﻿// Copyright Voxel Plugin SAS. All Rights Reserved.
+
+#pragma once
+
+#include "VoxelMinimal.h"
+
+namespace Voxel::Nanite
+{
+struct FLODCluster
+{
+	// Range in FClusterDAG::Vertices, 3 per triangle
+	int32 VertexOffset = 0;
+	int32 NumVertices = 0;
+
+	FVoxelBox Bounds;
+	// Contains the LODBounds of all the clusters this one was simplified from
+	FSphere3f LODBounds = FSphere3f(ForceInit);
+	// 0 for clusters of the source mesh
+	float LODError = 0.f;
+
+	// Group this cluster was simplified from, -1 for clusters of the source mesh
+	int32 GeneratingGroupIndex = -1;
+	// Group this cluster is a child of
+	int32 GroupIndex = -1;
+
+	FORCEINLINE bool IsLeaf() const
+	{
+		return GeneratingGroupIndex == -1;
+	}
+};
+
+struct FLODGroup
+{
+	// Level of the children, 0 for clusters of the source mesh
+	int32 Level = 0;
+	TVoxelArray<int32> Children;
+
+	FVoxelBox Bounds;
+	FSphere3f LODBounds = FSphere3f(ForceInit);
+	float MinLODError = 0.f;
+	// LODError of the clusters simplified from this group, MAX_flt if it wasn't simplified
+	float MaxParentLODError = 0.f;
+};
+
+// Clusters of a triangle list and the coarser clusters simplified from them
+// Clusters are grouped with their neighbors, each group is merged, simplified to half its triangles and split into parent clusters
+// The boundary of a group is locked so that parents seamlessly connect to the neighboring groups of the same level
+//
+// Simplification only collapses vertices onto their neighbors, so parent clusters only reference vertices of the source mesh
+// Invariants, see CheckInvariants:
+// - a parent LODError is >= the LODError of its children
+// - a parent LODBounds contains the LODBounds of its children
+// - each cluster is the child of exactly one group
+class FClusterDAG
+{
+public:
+	static constexpr int32 GroupSize = 4;
+
+	const TConstVoxelArrayView<FVector3f> Positions;
+	const int32 MaxTrianglesPerCluster;
+	const EParallelForFlags ParallelForFlags;
+
+	// Indices into Positions, referenced by the clusters
+	TVoxelArray<int32> Vertices;
+	TVoxelArray<FLODCluster> Clusters;
+	TVoxelArray<FLODGroup> Groups;
+
+	// Split the triangles in clusters of MaxTrianglesPerCluster, following TriangleOrder if set
+	FClusterDAG(
+		TConstVoxelArrayView<FVector3f> Positions,
+		TConstVoxelArrayView<int32> TriangleOrder,
+		int32 MaxTrianglesPerCluster,
+		EParallelForFlags ParallelForFlags);
+
+	// Put each cluster in its own group, without any simplification
+	void BuildFlat();
+	// Simplify clusters until there's a single one left or they can't be simplified further
+	void BuildLODs();
+
+	// Cluster indices sorted by group, so that the children of a group are contiguous
+	TVoxelArray<int32> GetClustersSortedByGroup() const;
+
+	void CheckInvariants() const;
+
+public:
+	FORCEINLINE TConstVoxelArrayView<int32> GetVertices(const FLODCluster& Cluster) const
+	{
+		return MakeVoxelArrayView(Vertices).Slice(Cluster.VertexOffset, Cluster.NumVertices);
+	}
+
+	// 30-bit Morton code of Position quantized in Bounds
+	static uint32 GetMortonCode(const FVoxelBox& Bounds, const FVector& Position);
+
+private:
+	struct FQuadric;
+
+	void ComputeBounds(FLODCluster& Cluster) const;
+	int32 AddCluster(TConstVoxelArrayView<int32> ClusterVertices);
+	int32 AddGroup(int32 Level, TVoxelArray<int32> Children, float SimplificationError);
+
+	TVoxelArray<TVoxelArray<int32>> MakeGroups(TConstVoxelArrayView<int32> LevelClusters) const;
+
+	// Returns the new vertices, 3 per triangle, split in clusters of MaxTrianglesPerCluster
+	// Returns false if the group can't be simplified into fewer clusters
+	bool SimplifyGroup(
+		TConstVoxelArrayView<int32> Children,
+		TVoxelArray<int32>& OutVertices,
+		float& OutError) const;
+
+	// Half-edge collapses ordered by quadric error, returns the max error as a distance
+	// Locked vertices are never collapsed, but other vertices can be collapsed onto them
+	static float SimplifyMesh(
+		TConstVoxelArrayView<FVector3f> MeshPositions,
+		const FVoxelBitArray& LockedVertices,
+		TVoxelArray<int32>& Indices,
+		int32 TargetNumTriangles);
+};
+}
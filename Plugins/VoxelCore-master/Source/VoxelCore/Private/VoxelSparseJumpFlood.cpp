@@ -0,0 +1,458 @@
+// Copyright Voxel Plugin SAS. All Rights Reserved.
+
+#include "VoxelSparseJumpFlood.h"
+
+namespace Voxel::SparseJumpFlood
+{
+	constexpr int32 BrickSize = FVoxelSparseJumpFlood::BrickSize;
+	constexpr int32 BrickCount = FVoxelSparseJumpFlood::BrickCount;
+	constexpr int32 BricksPerTask = 64;
+
+	FORCEINLINE int32 GetIndex(const int32 X, const int32 Y, const int32 Z)
+	{
+		checkVoxelSlow(0 <= X && X < BrickSize);
+		checkVoxelSlow(0 <= Y && Y < BrickSize);
+		checkVoxelSlow(0 <= Z && Z < BrickSize);
+		return X + Y * BrickSize + Z * BrickSize * BrickSize;
+	}
+
+	// Index in a 3x3x3 neighborhood of the brick containing Local, which can be outside of the current brick by at most one brick
+	// Also returns the index of Local in that brick
+	// Works for steps that are multiple of BrickSize too, as then Local & (BrickSize - 1) is unchanged
+	FORCEINLINE int32 GetNeighborBrick(const FIntVector& Local, int32& OutIndex)
+	{
+		OutIndex = GetIndex(
+			Local.X & (BrickSize - 1),
+			Local.Y & (BrickSize - 1),
+			Local.Z & (BrickSize - 1));
+
+		const auto GetOffset = [](const int32 Value)
+		{
+			return Value < 0 ? 0 : Value < BrickSize ? 1 : 2;
+		};
+
+		return
+			GetOffset(Local.X) +
+			GetOffset(Local.Y) * 3 +
+			GetOffset(Local.Z) * 9;
+	}
+
+	// Center first to try to keep consistent closest points
+	const TVoxelStaticArray<FIntVector, 27> Directions = INLINE_LAMBDA
+	{
+		TVoxelStaticArray<FIntVector, 27> Result{ NoInit };
+
+		int32 Index = 0;
+		Result[Index++] = FIntVector(0);
+
+		for (int32 Z = -1; Z <= 1; Z++)
+		{
+			for (int32 Y = -1; Y <= 1; Y++)
+			{
+				for (int32 X = -1; X <= 1; X++)
+				{
+					if (X == 0 && Y == 0 && Z == 0)
+					{
+						continue;
+					}
+
+					Result[Index++] = FIntVector(X, Y, Z);
+				}
+			}
+		}
+		check(Index == 27);
+
+		return Result;
+	};
+
+	struct FClosestView
+	{
+		float* X = nullptr;
+		float* Y = nullptr;
+		float* Z = nullptr;
+		// Axis going from the inside to the outside of the surface at the closest point: +-1 for X, +-2 for Y, +-3 for Z
+		int8* Outside = nullptr;
+	};
+}
+
+void FVoxelSparseJumpFlood::JumpFlood(
+	FBrickMap& Bricks,
+	const float NarrowBand)
+{
+	using namespace Voxel::SparseJumpFlood;
+
+	VOXEL_FUNCTION_COUNTER();
+	VOXEL_SCOPE_COUNTER_FORMAT("SparseJumpFlood NumBricks=%d NarrowBand=%f", Bricks.Num(), NarrowBand);
+
+	if (!ensureVoxelSlow(NarrowBand > 0.f))
+	{
+		return;
+	}
+
+	const float MaxDistanceSquared = FMath::Square(NarrowBand);
+
+	TVoxelArray<FIntVector> Positions;
+	TVoxelArray<FBrick*> BrickPtrs;
+	TVoxelMap<FIntVector, int32> PositionToIndex;
+
+	Positions.Reserve(Bricks.Num());
+	BrickPtrs.Reserve(Bricks.Num());
+	PositionToIndex.Reserve(Bricks.Num());
+
+	for (const auto& It : Bricks)
+	{
+		if (!ensureVoxelSlow(It.Value))
+		{
+			continue;
+		}
+
+		PositionToIndex.Add_CheckNew(It.Key, Positions.Num());
+		Positions.Add(It.Key);
+		BrickPtrs.Add(It.Value.Get());
+	}
+
+	const auto ForeachBrick = [&](const int32 NumBricks, const TFunctionRef<void(int32)> Lambda)
+	{
+		FVoxelParallelTaskScope Scope;
+
+		for (int32 StartIndex = 0; StartIndex < NumBricks; StartIndex += BricksPerTask)
+		{
+			Scope.AddTask([&, StartIndex]
+			{
+				const int32 EndIndex = FMath::Min(StartIndex + BricksPerTask, NumBricks);
+				for (int32 BrickIndex = StartIndex; BrickIndex < EndIndex; BrickIndex++)
+				{
+					Lambda(BrickIndex);
+				}
+			});
+		}
+	};
+
+	const auto GetNeighbors = [&](const FIntVector& Position, const int32 Step, int32 OutNeighbors[27])
+	{
+		const int32 BrickOffset = Step >= BrickSize ? Step / BrickSize : 1;
+		checkVoxelSlow(Step < BrickSize || Step % BrickSize == 0);
+
+		for (int32 Z = 0; Z < 3; Z++)
+		{
+			for (int32 Y = 0; Y < 3; Y++)
+			{
+				for (int32 X = 0; X < 3; X++)
+				{
+					const int32* IndexPtr = PositionToIndex.Find(Position + BrickOffset * FIntVector(X - 1, Y - 1, Z - 1));
+					OutNeighbors[X + Y * 3 + Z * 9] = IndexPtr ? *IndexPtr : -1;
+				}
+			}
+		}
+	};
+
+	const int32 NumInputBricks = Positions.Num();
+
+	// Which input bricks have seeds
+	TVoxelArray<bool> Occupancy;
+	FVoxelUtilities::SetNumFast(Occupancy, NumInputBricks);
+
+	// [0] is the seeds, [1] is temporary: both buffers are ping-ponged during the passes
+	TVoxelArray<int8> Outside[2];
+	FVoxelUtilities::SetNumFast(Outside[0], NumInputBricks * BrickCount);
+
+	{
+		VOXEL_SCOPE_COUNTER("Seeds");
+
+		ForeachBrick(NumInputBricks, [&](const int32 BrickIndex)
+		{
+			FBrick& Brick = *BrickPtrs[BrickIndex];
+
+			int32 Neighbors[27];
+			GetNeighbors(Positions[BrickIndex], 1, Neighbors);
+
+			bool bHasSeeds = false;
+
+			for (int32 Z = 0; Z < BrickSize; Z++)
+			{
+				for (int32 Y = 0; Y < BrickSize; Y++)
+				{
+					for (int32 X = 0; X < BrickSize; X++)
+					{
+						const int32 Index = GetIndex(X, Y, Z);
+						const float Distance = Brick.Distances[Index];
+						const bool bIsDistanceNegative = Distance < 0.f;
+
+						float BestNeighborDistance = 0.f;
+						int32 BestNeighborDirection = -1;
+
+						// Same as VoxelDistanceFieldUtilities_JumpFlood_Initialize
+						const FIntVector NeighborDirections[] =
+						{
+							FIntVector(-1, 0, 0),
+							FIntVector(+1, 0, 0),
+							FIntVector(0, -1, 0),
+							FIntVector(0, +1, 0),
+							FIntVector(0, 0, -1),
+							FIntVector(0, 0, +1)
+						};
+
+						for (int32 Direction = 0; Direction < 6; Direction++)
+						{
+							int32 NeighborIndex;
+							const int32 NeighborBrick = Neighbors[GetNeighborBrick(FIntVector(X, Y, Z) + NeighborDirections[Direction], NeighborIndex)];
+							if (NeighborBrick == -1)
+							{
+								continue;
+							}
+
+							const float NeighborDistance = BrickPtrs[NeighborBrick]->Distances[NeighborIndex];
+
+							// Note: 0 is defined as positive
+							if (!FMath::IsNaN(NeighborDistance) &&
+								bIsDistanceNegative != (NeighborDistance < BestNeighborDistance))
+							{
+								BestNeighborDistance = NeighborDistance;
+								BestNeighborDirection = Direction;
+							}
+						}
+
+						if (FMath::IsNaN(Distance) ||
+							BestNeighborDirection == -1)
+						{
+							Brick.ClosestX[Index] = FVoxelUtilities::NaNf();
+							Brick.ClosestY[Index] = FVoxelUtilities::NaNf();
+							Brick.ClosestZ[Index] = FVoxelUtilities::NaNf();
+							Outside[0][BrickIndex * BrickCount + Index] = 0;
+							continue;
+						}
+
+						bHasSeeds = true;
+
+						const float Alpha = Distance / (Distance - BestNeighborDistance);
+						const FVector3f Closest = FVector3f(Positions[BrickIndex] * BrickSize + FIntVector(X, Y, Z)) + Alpha * FVector3f(NeighborDirections[BestNeighborDirection]);
+
+						Brick.ClosestX[Index] = Closest.X;
+						Brick.ClosestY[Index] = Closest.Y;
+						Brick.ClosestZ[Index] = Closest.Z;
+
+						// Towards the neighbor if we're inside
+						const int32 Axis = 1 + BestNeighborDirection / 2;
+						const bool bTowardsPositive = BestNeighborDirection % 2 == 1;
+						Outside[0][BrickIndex * BrickCount + Index] = bTowardsPositive == bIsDistanceNegative ? Axis : -Axis;
+					}
+				}
+			}
+
+			Occupancy[BrickIndex] = bHasSeeds;
+		});
+	}
+
+	{
+		VOXEL_SCOPE_COUNTER("Add band bricks");
+
+		const int32 BandInBricks = FVoxelUtilities::DivideCeil_Positive(FMath::CeilToInt(NarrowBand), BrickSize);
+
+		for (int32 BrickIndex = 0; BrickIndex < NumInputBricks; BrickIndex++)
+		{
+			if (!Occupancy[BrickIndex])
+			{
+				continue;
+			}
+
+			for (int32 Z = -BandInBricks; Z <= BandInBricks; Z++)
+			{
+				for (int32 Y = -BandInBricks; Y <= BandInBricks; Y++)
+				{
+					for (int32 X = -BandInBricks; X <= BandInBricks; X++)
+					{
+						const FIntVector Position = Positions[BrickIndex] + FIntVector(X, Y, Z);
+						if (PositionToIndex.Contains(Position))
+						{
+							continue;
+						}
+
+						const TSharedRef<FBrick> Brick = MakeShared<FBrick>();
+
+						PositionToIndex.Add_CheckNew(Position, Positions.Num());
+						Positions.Add(Position);
+						BrickPtrs.Add(&Brick.Get());
+						Bricks.Add_CheckNew(Position, Brick);
+					}
+				}
+			}
+		}
+	}
+
+	const int32 NumBricks = Positions.Num();
+
+	FVoxelUtilities::SetNumFast(Outside[1], NumBricks * BrickCount);
+	Outside[0].SetNumUninitialized(NumBricks * BrickCount);
+
+	TVoxelArray<float> TempClosest;
+	FVoxelUtilities::SetNumFast(TempClosest, NumBricks * BrickCount * 3);
+
+	const auto GetClosest = [&](const int32 Buffer, const int32 BrickIndex)
+	{
+		FClosestView View;
+		View.Outside = &Outside[Buffer][BrickIndex * BrickCount];
+
+		if (Buffer == 0)
+		{
+			View.X = BrickPtrs[BrickIndex]->ClosestX.GetData();
+			View.Y = BrickPtrs[BrickIndex]->ClosestY.GetData();
+			View.Z = BrickPtrs[BrickIndex]->ClosestZ.GetData();
+		}
+		else
+		{
+			View.X = &TempClosest[(BrickIndex * 3 + 0) * BrickCount];
+			View.Y = &TempClosest[(BrickIndex * 3 + 1) * BrickCount];
+			View.Z = &TempClosest[(BrickIndex * 3 + 2) * BrickCount];
+		}
+		return View;
+	};
+
+	{
+		VOXEL_SCOPE_COUNTER("Initialize band bricks");
+
+		ForeachBrick(NumBricks - NumInputBricks, [&](const int32 Index)
+		{
+			const int32 BrickIndex = NumInputBricks + Index;
+			FBrick& Brick = *BrickPtrs[BrickIndex];
+
+			FVoxelUtilities::SetAll(Brick.Distances, FVoxelUtilities::NaNf());
+			FVoxelUtilities::SetAll(Brick.ClosestX, FVoxelUtilities::NaNf());
+			FVoxelUtilities::SetAll(Brick.ClosestY, FVoxelUtilities::NaNf());
+			FVoxelUtilities::SetAll(Brick.ClosestZ, FVoxelUtilities::NaNf());
+			FVoxelUtilities::Memzero(MakeVoxelArrayView(Outside[0]).Slice(BrickIndex * BrickCount, BrickCount));
+		});
+	}
+
+	// Enough passes for the sum of the steps to cover the band
+	// Steps above BrickSize are multiples of it, so that GetNeighborBrick works
+	const int32 NumPasses = FMath::CeilLogTwo(FMath::CeilToInt(NarrowBand) + 1);
+
+	int32 SourceBuffer = 0;
+	for (int32 Pass = 0; Pass < NumPasses; Pass++)
+	{
+		// -1: we want to start with half the size
+		const int32 Step = 1 << (NumPasses - 1 - Pass);
+
+		VOXEL_SCOPE_COUNTER_FORMAT("SparseJumpFlood Step=%d", Step);
+
+		ForeachBrick(NumBricks, [&](const int32 BrickIndex)
+		{
+			int32 NeighborIndices[27];
+			GetNeighbors(Positions[BrickIndex], Step, NeighborIndices);
+
+			FClosestView Neighbors[27];
+			for (int32 Index = 0; Index < 27; Index++)
+			{
+				if (NeighborIndices[Index] != -1)
+				{
+					Neighbors[Index] = GetClosest(SourceBuffer, NeighborIndices[Index]);
+				}
+			}
+
+			const FClosestView Output = GetClosest(1 - SourceBuffer, BrickIndex);
+
+			for (int32 Z = 0; Z < BrickSize; Z++)
+			{
+				for (int32 Y = 0; Y < BrickSize; Y++)
+				{
+					for (int32 X = 0; X < BrickSize; X++)
+					{
+						const FIntVector Local(X, Y, Z);
+						const FVector3f Position = FVector3f(Positions[BrickIndex] * BrickSize + Local);
+
+						float BestDistance = MaxDistanceSquared;
+						FVector3f BestClosest = FVector3f(FVoxelUtilities::NaNf());
+						int8 BestOutside = 0;
+
+						for (const FIntVector& Direction : Directions)
+						{
+							int32 NeighborIndex;
+							const FClosestView& Neighbor = Neighbors[GetNeighborBrick(Local + Step * Direction, NeighborIndex)];
+							if (!Neighbor.X)
+							{
+								continue;
+							}
+
+							const float NeighborClosestX = Neighbor.X[NeighborIndex];
+							if (FMath::IsNaN(NeighborClosestX))
+							{
+								continue;
+							}
+
+							const FVector3f NeighborClosest(NeighborClosestX, Neighbor.Y[NeighborIndex], Neighbor.Z[NeighborIndex]);
+							const float Distance = FVector3f::DistSquared(Position, NeighborClosest);
+							if (Distance >= BestDistance)
+							{
+								continue;
+							}
+
+							BestDistance = Distance;
+							BestClosest = NeighborClosest;
+							BestOutside = Neighbor.Outside[NeighborIndex];
+						}
+
+						const int32 Index = GetIndex(X, Y, Z);
+						Output.X[Index] = BestClosest.X;
+						Output.Y[Index] = BestClosest.Y;
+						Output.Z[Index] = BestClosest.Z;
+						Output.Outside[Index] = BestOutside;
+					}
+				}
+			}
+		});
+
+		SourceBuffer = 1 - SourceBuffer;
+	}
+
+	{
+		VOXEL_SCOPE_COUNTER("ComputeDistances");
+
+		ForeachBrick(NumBricks, [&](const int32 BrickIndex)
+		{
+			FBrick& Brick = *BrickPtrs[BrickIndex];
+			const FClosestView Closest = GetClosest(SourceBuffer, BrickIndex);
+
+			if (SourceBuffer != 0)
+			{
+				FVoxelUtilities::Memcpy(MakeVoxelArrayView(Brick.ClosestX), TConstVoxelArrayView<float>(Closest.X, BrickCount));
+				FVoxelUtilities::Memcpy(MakeVoxelArrayView(Brick.ClosestY), TConstVoxelArrayView<float>(Closest.Y, BrickCount));
+				FVoxelUtilities::Memcpy(MakeVoxelArrayView(Brick.ClosestZ), TConstVoxelArrayView<float>(Closest.Z, BrickCount));
+			}
+
+			for (int32 Z = 0; Z < BrickSize; Z++)
+			{
+				for (int32 Y = 0; Y < BrickSize; Y++)
+				{
+					for (int32 X = 0; X < BrickSize; X++)
+					{
+						const int32 Index = GetIndex(X, Y, Z);
+						const float ClosestX = Brick.ClosestX[Index];
+
+						if (FMath::IsNaN(ClosestX))
+						{
+							Brick.Distances[Index] = FVoxelUtilities::NaNf();
+							continue;
+						}
+
+						const FVector3f Position = FVector3f(Positions[BrickIndex] * BrickSize + FIntVector(X, Y, Z));
+						const FVector3f Delta = Position - FVector3f(ClosestX, Brick.ClosestY[Index], Brick.ClosestZ[Index]);
+
+						bool bIsNegative;
+						if (!FMath::IsNaN(Brick.Distances[Index]))
+						{
+							bIsNegative = Brick.Distances[Index] < 0.f;
+						}
+						else
+						{
+							const int8 OutsideAxis = Closest.Outside[Index];
+							checkVoxelSlow(OutsideAxis != 0);
+							bIsNegative = Delta[FMath::Abs(OutsideAxis) - 1] * OutsideAxis < 0.f;
+						}
+
+						Brick.Distances[Index] = Delta.Size() * (bIsNegative ? -1.f : 1.f);
+					}
+				}
+			}
+		});
+	}
+}
\ No newline at end of file
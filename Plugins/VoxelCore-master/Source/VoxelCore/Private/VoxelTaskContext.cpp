@@ -8,6 +8,24 @@ VOXEL_CONSOLE_VARIABLE(
 	"voxel.OneThread",
 	"If true, will run all voxel tasks on the game thread. Useful when debugging.");
 
+VOXEL_CONSOLE_VARIABLE(
+	VOXELCORE_API, bool, GVoxelWorkStealing, false,
+	"voxel.WorkStealing",
+	"If true, async tasks dispatched from voxel worker threads are pushed to per-thread work-stealing deques instead of the per-context locked queue");
+
+VOXEL_CONSOLE_VARIABLE(
+	VOXELCORE_API, float, GVoxelTaskPriorityRefreshInterval, 0.01f,
+	"voxel.TaskPriorityRefreshInterval",
+	"Interval in seconds at which the priority lambdas of queued async tasks are re-evaluated");
+
+DEFINE_VOXEL_COUNTER(STAT_VoxelQueuedAsyncTasks_Low);
+DEFINE_VOXEL_COUNTER(STAT_VoxelQueuedAsyncTasks_Normal);
+DEFINE_VOXEL_COUNTER(STAT_VoxelQueuedAsyncTasks_High);
+
+DEFINE_VOXEL_COUNTER(STAT_VoxelAsyncTasksWaitTime_Low);
+DEFINE_VOXEL_COUNTER(STAT_VoxelAsyncTasksWaitTime_Normal);
+DEFINE_VOXEL_COUNTER(STAT_VoxelAsyncTasksWaitTime_High);
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -77,6 +95,329 @@ FVoxelTaskContextTicker* GVoxelTaskContextTicker = new FVoxelTaskContextTicker()
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+// Chase-Lev deque with a fixed capacity
+// The owning thread pushes & pops at the bottom, any other thread can steal from the top
+template<typename T, int32 Capacity>
+class TVoxelWorkStealingDeque
+{
+public:
+	checkStatic(FMath::IsPowerOfTwo(Capacity));
+
+	// Owning thread only. Returns false if full
+	bool Push(T* Element)
+	{
+		const int64 LocalBottom = Bottom.Get(std::memory_order_relaxed);
+		const int64 LocalTop = Top.Get(std::memory_order_acquire);
+
+		if (LocalBottom - LocalTop >= Capacity)
+		{
+			return false;
+		}
+
+		Buffer[LocalBottom & (Capacity - 1)].Set(Element, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		Bottom.Set(LocalBottom + 1, std::memory_order_relaxed);
+		return true;
+	}
+	// Owning thread only
+	T* Pop()
+	{
+		const int64 LocalBottom = Bottom.Get(std::memory_order_relaxed) - 1;
+		Bottom.Set(LocalBottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64 LocalTop = Top.Get(std::memory_order_relaxed);
+
+		if (LocalTop > LocalBottom)
+		{
+			// Empty
+			Bottom.Set(LocalBottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		T* Element = Buffer[LocalBottom & (Capacity - 1)].Get(std::memory_order_relaxed);
+		if (LocalTop != LocalBottom)
+		{
+			return Element;
+		}
+
+		// Last element, race against thieves
+		if (!Top.CompareExchangeStrong(LocalTop, LocalTop + 1))
+		{
+			Element = nullptr;
+		}
+		Bottom.Set(LocalBottom + 1, std::memory_order_relaxed);
+		return Element;
+	}
+	// Any thread. Can spuriously fail if another thread is stealing at the same time
+	T* Steal()
+	{
+		int64 LocalTop = Top.Get(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64 LocalBottom = Bottom.Get(std::memory_order_acquire);
+
+		if (LocalTop >= LocalBottom)
+		{
+			return nullptr;
+		}
+
+		T* Element = Buffer[LocalTop & (Capacity - 1)].Get(std::memory_order_relaxed);
+		if (!Top.CompareExchangeStrong(LocalTop, LocalTop + 1))
+		{
+			return nullptr;
+		}
+		return Element;
+	}
+
+private:
+	TVoxelAtomic_WithPadding<int64> Top = 0;
+	TVoxelAtomic_WithPadding<int64> Bottom = 0;
+	TVoxelAtomic<T*> Buffer[Capacity];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Tasks dispatched from within a loop go to the thread's own deque without taking any lock
+// Tasks dispatched from any other thread go through a global queue
+// Loops are launched as UE tasks, at most one per background worker thread plus one per blocked loop,
+// and run until their own deque, the global queue and all the other deques are empty
+// Tasks count towards the MaxLaunchedTasks of their context
+class FVoxelTaskWorkStealing
+{
+public:
+	void Dispatch(
+		FVoxelTaskContext& Context,
+		TVoxelUniqueFunction<void()> Lambda)
+	{
+		Context.NumLaunchedTasks.Increment();
+
+		FTask* Task = new FTask{ Context, MoveTemp(Lambda) };
+
+		FWorker* Worker = static_cast<FWorker*>(FPlatformTLS::GetTlsValue(WorkerTLS));
+		if (Worker &&
+			Worker->LoopDepth > 0 &&
+			Worker->Deque.Push(Task))
+		{
+			// We'll pop it ourselves once the current task is done,
+			// but wake up another loop so that it can be stolen
+			TryLaunchLoop();
+			return;
+		}
+
+		{
+			VOXEL_SCOPE_LOCK(CriticalSection);
+			GlobalTasks_RequiresLock.Add(Task);
+			NumGlobalTasks.Increment();
+		}
+
+		TryLaunchLoop();
+	}
+
+	// Returns true if the current thread is running a loop
+	bool BeginBlocking()
+	{
+		FWorker* Worker = static_cast<FWorker*>(FPlatformTLS::GetTlsValue(WorkerTLS));
+		if (!Worker ||
+			Worker->LoopDepth == 0)
+		{
+			return false;
+		}
+
+		// The tasks in our deque might be the ones we're waiting on: make sure any loop can pick them up,
+		// and let another loop run in our place in case all the others are busy
+		{
+			VOXEL_SCOPE_LOCK(CriticalSection);
+
+			while (FTask* Task = Worker->Deque.Pop())
+			{
+				GlobalTasks_RequiresLock.Add(Task);
+				NumGlobalTasks.Increment();
+			}
+		}
+
+		NumBlockedLoops.Increment();
+		TryLaunchLoop();
+		return true;
+	}
+	void EndBlocking()
+	{
+		NumBlockedLoops.Decrement();
+	}
+
+private:
+	struct FTask
+	{
+		FVoxelTaskContext& Context;
+		TVoxelUniqueFunction<void()> Lambda;
+	};
+	struct FWorker
+	{
+		int32 WorkerIndex = -1;
+		// Only accessed by the owning thread
+		int32 LoopDepth = 0;
+		TVoxelWorkStealingDeque<FTask, 1024> Deque;
+	};
+
+	static constexpr int32 MaxWorkers = 1024;
+	// Number of global tasks moved to the local deque at once, so that they can be stolen without locking
+	static constexpr int32 GlobalBatchSize = 32;
+
+	const uint32 WorkerTLS = FPlatformTLS::AllocTlsSlot();
+
+	FVoxelCounter32 NumLoops;
+	FVoxelCounter32 NumBlockedLoops;
+	FVoxelCounter32 NumWorkers;
+	TVoxelAtomic<FWorker*> Workers[MaxWorkers];
+
+	FVoxelCounter32_WithPadding NumGlobalTasks;
+	FVoxelCriticalSection CriticalSection;
+	TVoxelArray<FTask*> GlobalTasks_RequiresLock;
+
+	FWorker& GetWorker()
+	{
+		if (FWorker* Worker = static_cast<FWorker*>(FPlatformTLS::GetTlsValue(WorkerTLS)))
+		{
+			return *Worker;
+		}
+
+		// Never freed, worker threads are never destroyed
+		FWorker* Worker = new FWorker();
+		Worker->WorkerIndex = NumWorkers.Increment_ReturnOld();
+
+		// If we have too many threads, the worker won't be visible to thieves but will still drain its own deque
+		if (ensureVoxelSlow(Worker->WorkerIndex < MaxWorkers))
+		{
+			Workers[Worker->WorkerIndex].Set(Worker);
+		}
+
+		FPlatformTLS::SetTlsValue(WorkerTLS, Worker);
+		return *Worker;
+	}
+
+	void TryLaunchLoop()
+	{
+		const int32 MaxLoops = FMath::Max(1, FVoxelUtilities::GetNumBackgroundWorkerThreads()) + NumBlockedLoops.Get();
+
+		int32 OldNumLoops = NumLoops.Get();
+		do
+		{
+			if (OldNumLoops >= MaxLoops)
+			{
+				return;
+			}
+		}
+		while (!NumLoops.CompareExchangeWeak(OldNumLoops, OldNumLoops + 1));
+
+		UE::Tasks::Launch(
+			TEXT("Voxel Work Stealing Loop"),
+			[this]
+			{
+				RunLoop();
+			},
+			LowLevelTasks::ETaskPriority::BackgroundLow);
+	}
+
+	void RunLoop()
+	{
+		VOXEL_FUNCTION_COUNTER();
+
+		// Loops can nest if a task waits on the UE scheduler and it runs another loop inline
+		FWorker& Worker = GetWorker();
+		Worker.LoopDepth++;
+
+		while (FTask* Task = GetNextTask(Worker))
+		{
+			Execute(Task);
+		}
+
+		Worker.LoopDepth--;
+		NumLoops.Decrement();
+
+		// A global task might have been added after our last check while NumLoops was still at its max
+		if (NumGlobalTasks.Get() > 0)
+		{
+			TryLaunchLoop();
+		}
+	}
+
+	FTask* GetNextTask(FWorker& Worker)
+	{
+		if (FTask* Task = Worker.Deque.Pop())
+		{
+			return Task;
+		}
+
+		if (NumGlobalTasks.Get() > 0)
+		{
+			VOXEL_SCOPE_LOCK(CriticalSection);
+
+			if (GlobalTasks_RequiresLock.Num() > 0)
+			{
+				FTask* Task = GlobalTasks_RequiresLock.Pop();
+				NumGlobalTasks.Decrement();
+
+				// Our deque is empty, this cannot fail
+				const int32 NumToMove = FMath::Min(GlobalTasks_RequiresLock.Num(), GlobalBatchSize);
+				for (int32 Index = 0; Index < NumToMove; Index++)
+				{
+					verify(Worker.Deque.Push(GlobalTasks_RequiresLock.Pop()));
+					NumGlobalTasks.Decrement();
+				}
+
+				return Task;
+			}
+		}
+
+		const int32 NumVictims = FMath::Min(NumWorkers.Get(), MaxWorkers);
+		for (int32 Offset = 1; Offset < NumVictims; Offset++)
+		{
+			FWorker* Victim = Workers[(Worker.WorkerIndex + Offset) % NumVictims].Get();
+			if (!Victim)
+			{
+				// Being registered
+				continue;
+			}
+
+			if (FTask* Task = Victim->Deque.Steal())
+			{
+				return Task;
+			}
+		}
+
+		return nullptr;
+	}
+
+	static void Execute(FTask* Task)
+	{
+		FVoxelTaskContext& Context = Task->Context;
+
+		if (!Context.ShouldCancelTasks.Get())
+		{
+			FVoxelTaskScope Scope(Context);
+			Task->Lambda();
+		}
+
+		delete Task;
+
+		// Tasks over MaxLaunchedTasks were queued by the context
+		// Check NumQueuedAsyncTasks first to not take the context lock after every task
+		if (Context.NumLaunchedTasks.Decrement_ReturnNew() < FVoxelTaskContext::MaxLaunchedTasks &&
+			Context.NumQueuedAsyncTasks.Get() > 0)
+		{
+			Context.LaunchTasks();
+		}
+
+		// Decrement allows the context to be deleted, make sure to do it last
+		Context.NumPendingTasks.Decrement();
+	}
+};
+FVoxelTaskWorkStealing* GVoxelTaskWorkStealing = new FVoxelTaskWorkStealing();
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 TUniquePtr<FVoxelTaskContextStrongRef> FVoxelTaskContextWeakRef::Pin() const
 {
 	if (Index == -1)
@@ -124,6 +465,52 @@ FVoxelTaskContextStrongRef::~FVoxelTaskContextStrongRef()
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+FORCEINLINE void UpdateQueuedAsyncTasksStat(
+	const EVoxelTaskPriority Priority,
+	const int32 Delta)
+{
+	switch (Priority)
+	{
+	default: VOXEL_ASSUME(false);
+	case EVoxelTaskPriority::Low: INC_VOXEL_COUNTER_BY(STAT_VoxelQueuedAsyncTasks_Low, Delta); break;
+	case EVoxelTaskPriority::Normal: INC_VOXEL_COUNTER_BY(STAT_VoxelQueuedAsyncTasks_Normal, Delta); break;
+	case EVoxelTaskPriority::High: INC_VOXEL_COUNTER_BY(STAT_VoxelQueuedAsyncTasks_High, Delta); break;
+	}
+}
+
+FORCEINLINE void UpdateAsyncTasksWaitTimeStat(
+	const EVoxelTaskPriority Priority,
+	const double WaitTime)
+{
+	const int64 WaitTimeUs = FMath::Max<int64>(0, FMath::RoundToInt64(WaitTime * 1000000.));
+
+	switch (Priority)
+	{
+	default: VOXEL_ASSUME(false);
+	case EVoxelTaskPriority::Low: INC_VOXEL_COUNTER_BY(STAT_VoxelAsyncTasksWaitTime_Low, WaitTimeUs); break;
+	case EVoxelTaskPriority::Normal: INC_VOXEL_COUNTER_BY(STAT_VoxelAsyncTasksWaitTime_Normal, WaitTimeUs); break;
+	case EVoxelTaskPriority::High: INC_VOXEL_COUNTER_BY(STAT_VoxelAsyncTasksWaitTime_High, WaitTimeUs); break;
+	}
+}
+
+// Higher values first, then FIFO
+struct FPrioritizedTaskPredicate
+{
+	template<typename T>
+	FORCEINLINE bool operator()(const T& A, const T& B) const
+	{
+		if (A.Value != B.Value)
+		{
+			return A.Value > B.Value;
+		}
+		return A.Serial < B.Serial;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 FVoxelTaskContext::FVoxelTaskContext(
 	const bool bCanCancelTasks,
 	const bool bTrackPromisesCallstacks)
@@ -154,8 +541,18 @@ FVoxelTaskContext::~FVoxelTaskContext()
 		{
 			VOXEL_SCOPE_LOCK(AsyncTasksCriticalSection);
 
-			NumPendingTasks.Subtract(AsyncTasks_RequiresLock.Num());
-			AsyncTasks_RequiresLock.Empty();
+			for (int32 Index = 0; Index < NumPriorities; Index++)
+			{
+				FAsyncTaskQueue& Queue = AsyncTaskQueues_RequiresLock[Index];
+				const int32 NumTasks = Queue.Num();
+
+				NumPendingTasks.Subtract(NumTasks);
+				UpdateQueuedAsyncTasksStat(EVoxelTaskPriority(Index), -NumTasks);
+
+				Queue.Tasks.Empty();
+				Queue.FirstTaskIndex = 0;
+				Queue.PrioritizedTasks.Empty();
+			}
 		}
 	}
 
@@ -196,6 +593,14 @@ FVoxelTaskContext::~FVoxelTaskContext()
 void FVoxelTaskContext::Dispatch(
 	const EVoxelFutureThread Thread,
 	TVoxelUniqueFunction<void()> Lambda)
+{
+	Dispatch(Thread, {}, MoveTemp(Lambda));
+}
+
+void FVoxelTaskContext::Dispatch(
+	const EVoxelFutureThread Thread,
+	FVoxelTaskPriority Priority,
+	TVoxelUniqueFunction<void()> Lambda)
 {
 #if VOXEL_DEBUG
 	Lambda = [this, Lambda = MoveTemp(Lambda)]
@@ -252,15 +657,29 @@ void FVoxelTaskContext::Dispatch(
 	{
 		NumPendingTasks.Increment();
 
+		// Work stealing ignores priorities
+		// Once MaxLaunchedTasks are in flight, tasks are queued like any other
+		if (GVoxelWorkStealing &&
+			!GVoxelOneThread &&
+			Priority.IsDefault() &&
+			NumLaunchedTasks.Get() < MaxLaunchedTasks)
+		{
+			GVoxelTaskWorkStealing->Dispatch(*this, MoveTemp(Lambda));
+			return;
+		}
+
 		if (NumLaunchedTasks.Get() < MaxLaunchedTasks)
 		{
 			LaunchTask(MoveTemp(Lambda));
 			return;
 		}
 
+		// Don't call user code with the lock held
+		const double Value = Priority.GetValue ? Priority.GetValue() : Priority.Value;
+
 		{
 			VOXEL_SCOPE_LOCK(AsyncTasksCriticalSection);
-			AsyncTasks_RequiresLock.Add(MoveTemp(Lambda));
+			QueueAsyncTask_RequiresLock(MoveTemp(Priority), Value, MoveTemp(Lambda));
 		}
 
 		if (NumLaunchedTasks.Get() < MaxLaunchedTasks)
@@ -318,7 +737,22 @@ void FVoxelTaskContext::DumpToLog()
 	VOXEL_SCOPE_LOCK(CriticalSection);
 
 	LOG_VOXEL(Log, "Queued game tasks: %d", GameTasks_RequiresLock.Num());
-	LOG_VOXEL(Log, "Queued async tasks: %d", AsyncTasks_RequiresLock.Num());
+	{
+		VOXEL_SCOPE_LOCK(AsyncTasksCriticalSection);
+
+		const TCHAR* PriorityNames[] = { TEXT("Low"), TEXT("Normal"), TEXT("High") };
+		checkStatic(UE_ARRAY_COUNT(PriorityNames) == NumPriorities);
+
+		for (int32 Index = 0; Index < NumPriorities; Index++)
+		{
+			const FAsyncTaskQueue& Queue = AsyncTaskQueues_RequiresLock[Index];
+
+			LOG_VOXEL(Log, "Queued async tasks (%s priority): %d, average wait time: %fms",
+				PriorityNames[Index],
+				Queue.Num(),
+				Queue.NumLaunched > 0 ? 1000. * Queue.TotalWaitTime / Queue.NumLaunched : 0.);
+		}
+	}
 	LOG_VOXEL(Log, "Launched async tasks: %d", NumLaunchedTasks.Get());
 
 	LOG_VOXEL(Log, "Num promises: %d", GetNumPromises());
@@ -352,20 +786,208 @@ void FVoxelTaskContext::DumpToLog()
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+void FVoxelTaskContext::QueueAsyncTask_RequiresLock(
+	FVoxelTaskPriority Priority,
+	const double Value,
+	TVoxelUniqueFunction<void()> Lambda)
+{
+	checkVoxelSlow(AsyncTasksCriticalSection.IsLocked());
+
+	FAsyncTaskQueue& Queue = AsyncTaskQueues_RequiresLock[int32(Priority.Class)];
+	UpdateQueuedAsyncTasksStat(Priority.Class, 1);
+	NumQueuedAsyncTasks.Increment();
+
+	FQueuedTask Task;
+	Task.QueueTime = FPlatformTime::Seconds();
+	Task.Lambda = MoveTemp(Lambda);
+
+	if (Priority.IsFIFO())
+	{
+		Queue.Tasks.Add(MoveTemp(Task));
+		return;
+	}
+
+	FPrioritizedTask PrioritizedTask;
+	PrioritizedTask.Value = Value;
+	PrioritizedTask.Serial = AsyncTasksSerial_RequiresLock++;
+	if (Priority.GetValue)
+	{
+		PrioritizedTask.GetValue = MakeShared<TVoxelUniqueFunction<double()>>(MoveTemp(Priority.GetValue));
+	}
+	PrioritizedTask.Task = MoveTemp(Task);
+
+	Queue.PrioritizedTasks.HeapPush(MoveTemp(PrioritizedTask), FPrioritizedTaskPredicate());
+}
+
+bool FVoxelTaskContext::PopAsyncTask_RequiresLock(
+	const double Time,
+	TVoxelUniqueFunction<void()>& OutLambda)
+{
+	checkVoxelSlow(AsyncTasksCriticalSection.IsLocked());
+
+	for (int32 Index = NumPriorities - 1; Index >= 0; Index--)
+	{
+		FAsyncTaskQueue& Queue = AsyncTaskQueues_RequiresLock[Index];
+		if (Queue.Num() == 0)
+		{
+			continue;
+		}
+
+		FQueuedTask Task;
+		if (Queue.PrioritizedTasks.Num() > 0 &&
+			(Queue.Tasks.Num() == Queue.FirstTaskIndex || Queue.PrioritizedTasks.HeapTop().Value > 0))
+		{
+			FPrioritizedTask PrioritizedTask;
+			Queue.PrioritizedTasks.HeapPop(PrioritizedTask, FPrioritizedTaskPredicate(), EAllowShrinking::No);
+			Task = MoveTemp(PrioritizedTask.Task);
+		}
+		else
+		{
+			Task = MoveTemp(Queue.Tasks[Queue.FirstTaskIndex]);
+			Queue.FirstTaskIndex++;
+
+			if (Queue.FirstTaskIndex == Queue.Tasks.Num())
+			{
+				Queue.Tasks.Reset();
+				Queue.FirstTaskIndex = 0;
+			}
+			else if (Queue.FirstTaskIndex == TVoxelChunkedArray<FQueuedTask>::NumPerChunk)
+			{
+				// Tasks in the chunk were all moved out already
+				Queue.Tasks.PopFirstChunk();
+				Queue.FirstTaskIndex = 0;
+			}
+		}
+
+		const double WaitTime = Time - Task.QueueTime;
+		Queue.NumLaunched++;
+		Queue.TotalWaitTime += WaitTime;
+
+		UpdateQueuedAsyncTasksStat(EVoxelTaskPriority(Index), -1);
+		NumQueuedAsyncTasks.Decrement();
+		UpdateAsyncTasksWaitTimeStat(EVoxelTaskPriority(Index), WaitTime);
+
+		OutLambda = MoveTemp(Task.Lambda);
+		return true;
+	}
+
+	return false;
+}
+
+void FVoxelTaskContext::RefreshPriorities(const double Time)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	// Several threads might refresh at once, that's fine
+	NextPriorityRefreshTime.Set(Time + GVoxelTaskPriorityRefreshInterval);
+
+	struct FPriorityValue
+	{
+		int64 Serial = 0;
+		double Value = 0;
+		TSharedPtr<TVoxelUniqueFunction<double()>> GetValue;
+	};
+	TVoxelStaticArray<TVoxelArray<FPriorityValue>, NumPriorities> QueueToValues;
+
+	// Priority lambdas are user code: snapshot them under the lock, call them outside of it
+	{
+		VOXEL_SCOPE_LOCK(AsyncTasksCriticalSection);
+
+		for (int32 Index = 0; Index < NumPriorities; Index++)
+		{
+			for (const FPrioritizedTask& Task : AsyncTaskQueues_RequiresLock[Index].PrioritizedTasks)
+			{
+				if (Task.GetValue)
+				{
+					QueueToValues[Index].Add(FPriorityValue
+					{
+						Task.Serial,
+						Task.Value,
+						Task.GetValue
+					});
+				}
+			}
+		}
+	}
+
+	for (TVoxelArray<FPriorityValue>& Values : QueueToValues)
+	{
+		VOXEL_SCOPE_COUNTER_NUM("Evaluate priorities", Values.Num(), 128);
+
+		// Only keep the values that changed
+		for (int32 Index = 0; Index < Values.Num(); Index++)
+		{
+			const double NewValue = (*Values[Index].GetValue)();
+			if (NewValue == Values[Index].Value)
+			{
+				Values.RemoveAtSwap(Index);
+				Index--;
+				continue;
+			}
+
+			Values[Index].Value = NewValue;
+			Values[Index].GetValue.Reset();
+		}
+	}
+
+	VOXEL_SCOPE_LOCK(AsyncTasksCriticalSection);
+
+	for (int32 Index = 0; Index < NumPriorities; Index++)
+	{
+		const TVoxelArray<FPriorityValue>& Values = QueueToValues[Index];
+		if (Values.Num() == 0)
+		{
+			continue;
+		}
+
+		TVoxelMap<int64, double> SerialToValue;
+		SerialToValue.Reserve(Values.Num());
+
+		for (const FPriorityValue& Value : Values)
+		{
+			SerialToValue.Add_CheckNew(Value.Serial, Value.Value);
+		}
+
+		// Tasks might have been launched in the meantime
+		bool bAnyChanged = false;
+		for (FPrioritizedTask& Task : AsyncTaskQueues_RequiresLock[Index].PrioritizedTasks)
+		{
+			if (const double* NewValue = SerialToValue.Find(Task.Serial))
+			{
+				Task.Value = *NewValue;
+				bAnyChanged = true;
+			}
+		}
+
+		if (bAnyChanged)
+		{
+			AsyncTaskQueues_RequiresLock[Index].PrioritizedTasks.Heapify(FPrioritizedTaskPredicate());
+		}
+	}
+}
+
 void FVoxelTaskContext::LaunchTasks()
 {
 	VOXEL_FUNCTION_COUNTER();
+
+	const double Time = FPlatformTime::Seconds();
+
+	if (Time >= NextPriorityRefreshTime.Get())
+	{
+		RefreshPriorities(Time);
+	}
+
 	VOXEL_SCOPE_LOCK(AsyncTasksCriticalSection);
-	checkStatic(2 * FTaskArray::NumPerChunk == MaxLaunchedTasks);
 
-	while (
-		AsyncTasks_RequiresLock.Num() > 0 &&
-		NumLaunchedTasks.Get() < MaxLaunchedTasks)
+	while (NumLaunchedTasks.Get() < MaxLaunchedTasks)
 	{
-		for (TVoxelUniqueFunction<void()>& Task : AsyncTasks_RequiresLock.PopFirstChunk())
+		TVoxelUniqueFunction<void()> Task;
+		if (!PopAsyncTask_RequiresLock(Time, Task))
 		{
-			LaunchTask(MoveTemp(Task));
+			break;
 		}
+
+		LaunchTask(MoveTemp(Task));
 	}
 }
 
@@ -443,3 +1065,20 @@ void FVoxelTaskContext::ProcessGameTasks(bool& bAnyTaskProcessed)
 ///////////////////////////////////////////////////////////////////////////////
 
 const uint32 GVoxelTaskScopeTLS = FPlatformTLS::AllocTlsSlot();
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+FVoxelTaskBlockingScope::FVoxelTaskBlockingScope()
+	: bIsBlockingLoop(GVoxelTaskWorkStealing->BeginBlocking())
+{
+}
+
+FVoxelTaskBlockingScope::~FVoxelTaskBlockingScope()
+{
+	if (bIsBlockingLoop)
+	{
+		GVoxelTaskWorkStealing->EndBlocking();
+	}
+}
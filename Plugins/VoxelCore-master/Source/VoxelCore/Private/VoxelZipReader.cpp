@@ -1,6 +1,8 @@
 // Copyright Voxel Plugin SAS. All Rights Reserved.
 
 #include "VoxelZipReader.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
 
 TSharedPtr<FVoxelZipReader> FVoxelZipReader::Create(
 	const int64 TotalSize,
@@ -79,7 +81,7 @@ TSharedPtr<FVoxelZipReader> FVoxelZipReader::Create(
 
 TSharedPtr<FVoxelZipReader> FVoxelZipReader::Create(const TConstVoxelArrayView64<uint8> BulkData)
 {
-	return Create(BulkData.Num(), [=](const int64 Offset, const TVoxelArrayView64<uint8> OutData)
+	const TSharedPtr<FVoxelZipReader> Result = Create(BulkData.Num(), [=](const int64 Offset, const TVoxelArrayView64<uint8> OutData)
 	{
 		if (!ensure(BulkData.IsValidSlice(Offset, OutData.Num())))
 		{
@@ -91,8 +93,50 @@ TSharedPtr<FVoxelZipReader> FVoxelZipReader::Create(const TConstVoxelArrayView64
 			BulkData.Slice(Offset, OutData.Num()));
 		return true;
 	});
+
+	if (!Result)
+	{
+		return nullptr;
+	}
+
+	Result->MemoryData = BulkData;
+	return Result;
 }
 
+TSharedPtr<FVoxelZipReader> FVoxelZipReader::CreateMapped(const FString& Filename)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	const TSharedPtr<IMappedFileHandle> MappedFileHandle = MakeShareable(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (!MappedFileHandle)
+	{
+		return nullptr;
+	}
+
+	const TSharedPtr<IMappedFileRegion> MappedFileRegion = MakeShareable(MappedFileHandle->MapRegion(0, MappedFileHandle->GetFileSize()));
+	if (!ensure(MappedFileRegion))
+	{
+		return nullptr;
+	}
+
+	const TSharedPtr<FVoxelZipReader> Result = Create(TConstVoxelArrayView64<uint8>(
+		MappedFileRegion->GetMappedPtr(),
+		MappedFileRegion->GetMappedSize()));
+
+	if (!Result)
+	{
+		return nullptr;
+	}
+
+	Result->MappedFileHandle = MappedFileHandle;
+	Result->MappedFileRegion = MappedFileRegion;
+	return Result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 bool FVoxelZipReader::TryLoad(
 	const FString& Path,
 	TVoxelArray64<uint8>& OutData,
@@ -122,6 +166,66 @@ bool FVoxelZipReader::TryLoad(
 		*OutCompressedSize = FileStat.m_comp_size;
 	}
 
+	// Oodle-compressed entries are stored without zip compression:
+	// decompress them straight from the archive instead of extracting then decompressing
+	const int64 StoredDataOffset = GetStoredDataOffset(FileStat);
+	if (StoredDataOffset != -1)
+	{
+		const int64 StoredDataSize = FileStat.m_comp_size;
+
+		TConstVoxelArrayView64<uint8> CompressedData;
+		TVoxelArray64<uint8> CompressedDataStorage;
+
+		if (MemoryData.Num() > 0)
+		{
+			CompressedData = MemoryData.Slice(StoredDataOffset, StoredDataSize);
+		}
+		else
+		{
+			// Only read the header first, the entry might not be compressed
+			TVoxelStaticArray<uint8, 64> HeaderStorage{ NoInit };
+			const TVoxelArrayView64<uint8> Header(HeaderStorage.GetData(), FMath::Min<int64>(HeaderStorage.Num(), StoredDataSize));
+
+			if (!ensure(ReadLambda(StoredDataOffset, Header)))
+			{
+				return false;
+			}
+
+			if (FVoxelUtilities::IsCompressedData(Header))
+			{
+				FVoxelUtilities::SetNumFast(CompressedDataStorage, StoredDataSize);
+
+				if (!ensure(ReadLambda(StoredDataOffset, CompressedDataStorage)))
+				{
+					return false;
+				}
+
+				CompressedData = CompressedDataStorage;
+			}
+		}
+
+		if (FVoxelUtilities::IsCompressedData(CompressedData))
+		{
+			if (!CheckCrc32(CompressedData, FileStat.m_crc32))
+			{
+				return false;
+			}
+
+			const int64 UncompressedSize = FVoxelUtilities::GetDecompressedSize(CompressedData);
+			if (!ensure(UncompressedSize != -1))
+			{
+				return false;
+			}
+
+			FVoxelUtilities::SetNumFast(OutData, UncompressedSize);
+
+			return ensure(FVoxelUtilities::Decompress(
+				CompressedData,
+				MakeVoxelArrayView(OutData),
+				bAllowParallel));
+		}
+	}
+
 	FVoxelUtilities::SetNumFast(OutData, FileStat.m_uncomp_size);
 
 	if (!ensure(mz_zip_reader_extract_to_mem_no_alloc(
@@ -154,4 +258,374 @@ bool FVoxelZipReader::TryLoad(
 
 	OutData = MoveTemp(UncompressedData);
 	return true;
+}
+
+TVoxelArray<TVoxelFuture<TSharedPtr<TVoxelArray64<uint8>>>> FVoxelZipReader::LoadAsync(const TConstVoxelArrayView<FString> Paths) const
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Paths.Num(), 1);
+
+	using FPromise = TVoxelPromise<TSharedPtr<TVoxelArray64<uint8>>>;
+
+	struct FEntry
+	{
+		FPromise Promise;
+		FString Path;
+		int64 LocalHeaderOffset = 0;
+		// Upper bound of the local header size, the real size is only known once it's read
+		int64 MaxLocalHeaderSize = 0;
+		int64 DataSize = 0;
+		uint32 Crc32 = 0;
+
+		explicit FEntry(const FPromise& Promise)
+			: Promise(Promise)
+		{
+		}
+	};
+	struct FBatch
+	{
+		int64 Offset = 0;
+		int64 Size = 0;
+		TVoxelArray<FEntry> Entries;
+	};
+
+	TVoxelArray<TVoxelFuture<TSharedPtr<TVoxelArray64<uint8>>>> Futures;
+	Futures.Reserve(Paths.Num());
+
+	TVoxelArray<FEntry> Entries;
+	Entries.Reserve(Paths.Num());
+
+	// Entries that are not stored, loaded with TryLoad
+	TVoxelArray<FEntry> SlowEntries;
+
+	for (const FString& Path : Paths)
+	{
+		FPromise Promise;
+		Futures.Add(Promise);
+
+		const int32* IndexPtr = PathToIndex.Find(Path);
+		if (!ensure(IndexPtr))
+		{
+			Promise.Set(nullptr);
+			continue;
+		}
+
+		// The central directory is in memory, this doesn't call ReadLambda
+		mz_zip_archive_file_stat FileStat;
+		if (!ensure(mz_zip_reader_file_stat(
+			&Archive,
+			*IndexPtr,
+			&FileStat)))
+		{
+			CheckError();
+			Promise.Set(nullptr);
+			continue;
+		}
+
+		FEntry Entry(Promise);
+		Entry.Path = Path;
+
+		if (!IsStored(FileStat))
+		{
+			SlowEntries.Add(MoveTemp(Entry));
+			continue;
+		}
+
+		// Local headers usually have the same filename & a small zip64 extra field
+		constexpr int64 MaxExtraSize = 64;
+
+		Entry.LocalHeaderOffset = FileStat.m_local_header_ofs;
+		Entry.MaxLocalHeaderSize = LocalHeaderMinSize + FCStringAnsi::Strlen(FileStat.m_filename) + MaxExtraSize;
+		Entry.DataSize = FileStat.m_comp_size;
+		Entry.Crc32 = FileStat.m_crc32;
+		Entries.Add(MoveTemp(Entry));
+	}
+
+	Entries.Sort([](const FEntry& A, const FEntry& B)
+	{
+		return A.LocalHeaderOffset < B.LocalHeaderOffset;
+	});
+
+	const int64 ArchiveSize = Archive.m_archive_size;
+
+	TVoxelArray<FBatch> Batches;
+	for (FEntry& Entry : Entries)
+	{
+		const int64 Start = Entry.LocalHeaderOffset;
+		const int64 End = FMath::Min(Start + Entry.MaxLocalHeaderSize + Entry.DataSize, ArchiveSize);
+
+		if (Batches.Num() > 0)
+		{
+			FBatch& Batch = Batches.Last();
+			const int64 BatchEnd = Batch.Offset + Batch.Size;
+
+			if (Start <= BatchEnd + MaxBatchReadGap &&
+				FMath::Max(End, BatchEnd) - Batch.Offset <= MaxBatchReadSize)
+			{
+				Batch.Size = FMath::Max(End, BatchEnd) - Batch.Offset;
+				Batch.Entries.Add(MoveTemp(Entry));
+				continue;
+			}
+		}
+
+		FBatch& Batch = Batches.Emplace_GetRef();
+		Batch.Offset = Start;
+		Batch.Size = End - Start;
+		Batch.Entries.Add(MoveTemp(Entry));
+	}
+
+	if (Batches.Num() == 0 &&
+		SlowEntries.Num() == 0)
+	{
+		return Futures;
+	}
+
+	// Reads are issued from a single task so that ReadLambda is never called concurrently and the disk reads sequentially
+	Voxel::AsyncTask([This = AsShared(), Batches = MoveTemp(Batches), SlowEntries = MoveTemp(SlowEntries)]
+	{
+		VOXEL_SCOPE_COUNTER_FORMAT("FVoxelZipReader::LoadAsync %d batches", Batches.Num());
+
+		for (const FBatch& Batch : Batches)
+		{
+			// Memory-backed readers don't need to read anything
+			TSharedPtr<TVoxelArray64<uint8>> Buffer;
+			TConstVoxelArrayView64<uint8> BatchData;
+
+			if (This->MemoryData.Num() > 0)
+			{
+				BatchData = This->MemoryData.Slice(Batch.Offset, Batch.Size);
+			}
+			else
+			{
+				VOXEL_SCOPE_COUNTER_FORMAT("Read %lldB", Batch.Size);
+
+				Buffer = MakeShared<TVoxelArray64<uint8>>();
+				FVoxelUtilities::SetNumFast(*Buffer, Batch.Size);
+
+				if (!ensure(This->ReadLambda(Batch.Offset, *Buffer)))
+				{
+					for (const FEntry& Entry : Batch.Entries)
+					{
+						Entry.Promise.Set(nullptr);
+					}
+					continue;
+				}
+
+				BatchData = *Buffer;
+			}
+
+			for (const FEntry& Entry : Batch.Entries)
+			{
+				const TConstVoxelArrayView64<uint8> EntryData = BatchData.RightOf(Entry.LocalHeaderOffset - Batch.Offset);
+
+				const int64 LocalHeaderSize = GetLocalHeaderSize(EntryData);
+				if (!ensure(LocalHeaderSize != -1))
+				{
+					Entry.Promise.Set(nullptr);
+					continue;
+				}
+
+				if (LocalHeaderSize + Entry.DataSize <= EntryData.Num())
+				{
+					// Data points into Buffer or into This->MemoryData: keep both alive
+					Voxel::AsyncTask([This, Buffer, Data = EntryData.Slice(LocalHeaderSize, Entry.DataSize), Entry]
+					{
+						Entry.Promise.Set(LoadStoredData(Data, Entry.Crc32));
+					});
+					continue;
+				}
+
+				// The local header is bigger than expected, read the entry on its own
+				const TSharedRef<TVoxelArray64<uint8>> EntryBuffer = MakeShared<TVoxelArray64<uint8>>();
+				FVoxelUtilities::SetNumFast(*EntryBuffer, Entry.DataSize);
+
+				if (!ensure(Entry.LocalHeaderOffset + LocalHeaderSize + Entry.DataSize <= int64(This->Archive.m_archive_size)) ||
+					!ensure(This->ReadLambda(Entry.LocalHeaderOffset + LocalHeaderSize, *EntryBuffer)))
+				{
+					Entry.Promise.Set(nullptr);
+					continue;
+				}
+
+				Voxel::AsyncTask([EntryBuffer, Entry]
+				{
+					Entry.Promise.Set(LoadStoredData(*EntryBuffer, Entry.Crc32));
+				});
+			}
+		}
+
+		for (const FEntry& Entry : SlowEntries)
+		{
+			const TSharedRef<TVoxelArray64<uint8>> Data = MakeShared<TVoxelArray64<uint8>>();
+			if (!This->TryLoad(Entry.Path, *Data))
+			{
+				Entry.Promise.Set(nullptr);
+				continue;
+			}
+
+			Entry.Promise.Set(Data);
+		}
+	});
+
+	return Futures;
+}
+
+bool FVoxelZipReader::TryGetView(
+	const FString& Path,
+	TConstVoxelArrayView64<uint8>& OutData) const
+{
+	VOXEL_SCOPE_COUNTER_FORMAT("FVoxelZipReader::TryGetView %s", *Path);
+
+	if (MemoryData.Num() == 0)
+	{
+		return false;
+	}
+
+	const int32* IndexPtr = PathToIndex.Find(Path);
+	if (!ensure(IndexPtr))
+	{
+		return false;
+	}
+
+	mz_zip_archive_file_stat FileStat;
+	if (!ensure(mz_zip_reader_file_stat(
+		&Archive,
+		*IndexPtr,
+		&FileStat)))
+	{
+		CheckError();
+		return false;
+	}
+
+	const int64 StoredDataOffset = GetStoredDataOffset(FileStat);
+	if (StoredDataOffset == -1)
+	{
+		return false;
+	}
+
+	const TConstVoxelArrayView64<uint8> Data = MemoryData.Slice(StoredDataOffset, FileStat.m_comp_size);
+	if (FVoxelUtilities::IsCompressedData(Data))
+	{
+		return false;
+	}
+
+	if (!CheckCrc32(Data, FileStat.m_crc32))
+	{
+		return false;
+	}
+
+	OutData = Data;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+int64 FVoxelZipReader::GetStoredDataOffset(const mz_zip_archive_file_stat& FileStat) const
+{
+	if (!IsStored(FileStat))
+	{
+		return -1;
+	}
+
+	TVoxelStaticArray<uint8, LocalHeaderMinSize> LocalHeader{ NoInit };
+	if (!ensure(ReadLambda(FileStat.m_local_header_ofs, TVoxelArrayView64<uint8>(LocalHeader.GetData(), LocalHeader.Num()))))
+	{
+		return -1;
+	}
+
+	const int64 LocalHeaderSize = GetLocalHeaderSize(TConstVoxelArrayView64<uint8>(LocalHeader.GetData(), LocalHeader.Num()));
+	if (!ensure(LocalHeaderSize != -1))
+	{
+		return -1;
+	}
+
+	const int64 DataOffset = FileStat.m_local_header_ofs + LocalHeaderSize;
+
+	if (!ensure(DataOffset + int64(FileStat.m_comp_size) <= int64(Archive.m_archive_size)))
+	{
+		return -1;
+	}
+
+	return DataOffset;
+}
+
+bool FVoxelZipReader::IsStored(const mz_zip_archive_file_stat& FileStat)
+{
+	return
+		FileStat.m_method == 0 &&
+		!FileStat.m_is_encrypted &&
+		FileStat.m_is_supported &&
+		FileStat.m_comp_size == FileStat.m_uncomp_size;
+}
+
+int64 FVoxelZipReader::GetLocalHeaderSize(const TConstVoxelArrayView64<uint8> LocalHeader)
+{
+	if (LocalHeader.Num() < LocalHeaderMinSize)
+	{
+		return -1;
+	}
+
+	const auto ReadLE16 = [&](const int64 Offset)
+	{
+		return uint16(LocalHeader[Offset]) | (uint16(LocalHeader[Offset + 1]) << 8);
+	};
+
+	const uint32 Signature =
+		uint32(ReadLE16(0)) |
+		(uint32(ReadLE16(2)) << 16);
+
+	if (Signature != LocalHeaderSignature)
+	{
+		return -1;
+	}
+
+	return
+		LocalHeaderMinSize +
+		ReadLE16(LocalHeaderFilenameLengthOffset) +
+		ReadLE16(LocalHeaderExtraLengthOffset);
+}
+
+bool FVoxelZipReader::CheckCrc32(
+	const TConstVoxelArrayView64<uint8> Data,
+	const uint32 Crc32)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Data.Num(), 1024);
+
+	return ensure(FCrc::MemCrc32(Data.GetData(), Data.Num()) == Crc32);
+}
+
+TSharedPtr<TVoxelArray64<uint8>> FVoxelZipReader::LoadStoredData(
+	const TConstVoxelArrayView64<uint8> Data,
+	const uint32 Crc32)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Data.Num(), 1024);
+
+	if (!CheckCrc32(Data, Crc32))
+	{
+		return nullptr;
+	}
+
+	const TSharedRef<TVoxelArray64<uint8>> Result = MakeShared<TVoxelArray64<uint8>>();
+
+	if (FVoxelUtilities::IsCompressedData(Data))
+	{
+		const int64 UncompressedSize = FVoxelUtilities::GetDecompressedSize(Data);
+		if (!ensure(UncompressedSize != -1))
+		{
+			return nullptr;
+		}
+
+		FVoxelUtilities::SetNumFast(*Result, UncompressedSize);
+
+		// Entries are already decompressed in parallel
+		if (!ensure(FVoxelUtilities::Decompress(Data, MakeVoxelArrayView(*Result), false)))
+		{
+			return nullptr;
+		}
+
+		return Result;
+	}
+
+	*Result = TVoxelArray64<uint8>(Data);
+	return Result;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 // Copyright Voxel Plugin SAS. All Rights Reserved.
 
 #include "VoxelZipWriter.h"
+#include "VoxelBlockCompressedData.h"
 
 TSharedRef<FVoxelZipWriter> FVoxelZipWriter::Create(const FWriteLambda& WriteLambda)
 {
@@ -99,6 +100,163 @@ void FVoxelZipWriter::WriteCompressed_Oodle(
 	WriteImpl(Path, CompressedData, MZ_NO_COMPRESSION);
 }
 
+void FVoxelZipWriter::WriteCompressed_Blocks(
+	const FString& Path,
+	const TConstVoxelArrayView64<uint8> Data,
+	const int32 BlockSize,
+	const FOodleDataCompression::ECompressor Compressor,
+	const FOodleDataCompression::ECompressionLevel CompressionLevel)
+{
+	VOXEL_SCOPE_COUNTER_FORMAT("FVoxelZipWriter::WriteCompressed_Blocks %s %lldB", *Path, Data.Num());
+
+	const TVoxelArray64<uint8> CompressedData = FVoxelBlockCompressedData::Compress(Data, BlockSize, Compressor, CompressionLevel);
+
+	WriteImpl(Path, CompressedData, MZ_NO_COMPRESSION);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelZipWriter::WriteBatch(
+	const TConstVoxelArrayView<FBatchEntry> Entries,
+	const FOodleDataCompression::ECompressor Compressor,
+	const FOodleDataCompression::ECompressionLevel CompressionLevel)
+{
+	VOXEL_FUNCTION_COUNTER_NUM(Entries.Num(), 1);
+
+	struct FCompressedEntry
+	{
+		TVoxelArray64<uint8> Storage;
+		TConstVoxelArrayView64<uint8> Data;
+		int32 LevelAndFlags = MZ_NO_COMPRESSION;
+		int64 UncompressedSize = 0;
+		uint32 Crc32 = 0;
+		// Failed entries are skipped, the writer is then in an error state
+		bool bFailed = false;
+		TVoxelAtomic<bool> bIsReady;
+	};
+	TVoxelArray<FCompressedEntry> CompressedEntries;
+	CompressedEntries.SetNum(Entries.Num());
+
+	FVoxelCriticalSection AppendCriticalSection;
+	int32 NumAppended = 0;
+
+	// Requires AppendCriticalSection
+	const auto AppendReadyEntries = [&]
+	{
+		while (
+			NumAppended < Entries.Num() &&
+			CompressedEntries[NumAppended].bIsReady.Get())
+		{
+			FCompressedEntry& CompressedEntry = CompressedEntries[NumAppended];
+
+			if (!CompressedEntry.bFailed)
+			{
+				AppendImpl(
+					Entries[NumAppended].Path,
+					CompressedEntry.Data,
+					CompressedEntry.LevelAndFlags,
+					CompressedEntry.UncompressedSize,
+					CompressedEntry.Crc32);
+			}
+
+			// Free the compressed data as soon as possible
+			CompressedEntry.Storage.Empty();
+			CompressedEntry.Data = {};
+
+			NumAppended++;
+		}
+	};
+
+	ParallelFor(Entries.Num(), [&](const int32 Index)
+	{
+		const FBatchEntry& Entry = Entries[Index];
+		FCompressedEntry& CompressedEntry = CompressedEntries[Index];
+		VOXEL_SCOPE_COUNTER_FORMAT("FVoxelZipWriter::WriteBatch %s %lldB", *Entry.Path, Entry.Data.Num());
+
+		switch (Entry.Compression)
+		{
+		default: VOXEL_ASSUME(false);
+		case ECompression::None:
+		{
+			CompressedEntry.Data = Entry.Data;
+		}
+		break;
+		case ECompression::Deflate:
+		{
+			if (Entry.Data.Num() == 0)
+			{
+				break;
+			}
+
+			VOXEL_SCOPE_COUNTER("Deflate");
+
+			// Same parameters as mz_zip_writer_add_mem_ex_v2
+			const mz_uint Flags = tdefl_create_comp_flags_from_zip_params(MZ_DEFAULT_LEVEL, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+
+			const bool bSuccess = tdefl_compress_mem_to_output(
+				Entry.Data.GetData(),
+				Entry.Data.Num(),
+				[](const void* pBuf, const int len, void* pUser) -> mz_bool
+				{
+					static_cast<TVoxelArray64<uint8>*>(pUser)->Append(static_cast<const uint8*>(pBuf), len);
+					return true;
+				},
+				&CompressedEntry.Storage,
+				Flags);
+
+			if (!ensure(bSuccess))
+			{
+				RaiseError();
+				CompressedEntry.Storage.Empty();
+				CompressedEntry.bFailed = true;
+				break;
+			}
+
+			CompressedEntry.Data = CompressedEntry.Storage;
+			CompressedEntry.LevelAndFlags = MZ_DEFAULT_LEVEL | MZ_ZIP_FLAG_COMPRESSED_DATA;
+			CompressedEntry.UncompressedSize = Entry.Data.Num();
+		}
+		break;
+		case ECompression::Oodle:
+		{
+			// Entries are already compressed in parallel
+			CompressedEntry.Storage = FVoxelUtilities::Compress(Entry.Data, false, Compressor, CompressionLevel);
+			CompressedEntry.Data = CompressedEntry.Storage;
+		}
+		break;
+		}
+
+		if (!CompressedEntry.bFailed)
+		{
+			VOXEL_SCOPE_COUNTER("MemCrc32");
+
+			// The zip CRC is always of the data stored in the archive once unzipped
+			CompressedEntry.Crc32 = Entry.Compression == ECompression::Deflate
+				? FCrc::MemCrc32(Entry.Data.GetData(), Entry.Data.Num())
+				: FCrc::MemCrc32(CompressedEntry.Data.GetData(), CompressedEntry.Data.Num());
+		}
+
+		CompressedEntry.bIsReady.Set(true);
+
+		// If another thread is appending, it or the final flush below will append us
+		if (!AppendCriticalSection.TryLock())
+		{
+			return;
+		}
+
+		AppendReadyEntries();
+
+		AppendCriticalSection.Unlock();
+	});
+
+	VOXEL_SCOPE_LOCK(AppendCriticalSection);
+
+	AppendReadyEntries();
+	ensure(NumAppended == Entries.Num());
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -116,6 +274,18 @@ void FVoxelZipWriter::WriteImpl(
 		return FCrc::MemCrc32(Data.GetData(), Data.Num());
 	};
 
+	AppendImpl(Path, Data, Compression, 0, Crc32);
+}
+
+void FVoxelZipWriter::AppendImpl(
+	const FString& Path,
+	const TConstVoxelArrayView64<uint8> Data,
+	const int32 LevelAndFlags,
+	const int64 UncompressedSize,
+	const uint32 Crc32)
+{
+	VOXEL_SCOPE_COUNTER_FORMAT("FVoxelZipWriter::AppendImpl %lldB", Data.Num());
+
 	// Write data outside the critical section
 	struct FPendingWrite
 	{
@@ -149,7 +319,7 @@ void FVoxelZipWriter::WriteImpl(
 				}
 				else
 				{
-					ensure(Compression != MZ_NO_COMPRESSION);
+					ensure((LevelAndFlags & 0xF) != MZ_NO_COMPRESSION);
 
 					// Copying the data would be too expensive
 					WriteLambda(Offset, DataToWrite);
@@ -163,8 +333,8 @@ void FVoxelZipWriter::WriteImpl(
 			Data.Num(),
 			nullptr,
 			0,
-			Compression,
-			0,
+			LevelAndFlags,
+			UncompressedSize,
 			Crc32));
 
 		WriteLambdaOverride_RequiresLock = {};
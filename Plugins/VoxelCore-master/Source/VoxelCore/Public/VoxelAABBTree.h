@@ -52,9 +52,15 @@ public:
 	}
 
 	void Initialize(TVoxelArray<FElement>&& Elements);
+	// Binned surface area heuristic builder
+	// Partitions the elements in place instead of copying them at every level, and builds independent subtrees in parallel
+	// Slower to build than Initialize on small inputs, but queries visit fewer nodes
+	void InitializeSAH(TVoxelArray<FElement>&& Elements);
 	void Shrink();
 
-	static TSharedRef<FVoxelAABBTree> Create(TConstVoxelArrayView<FVoxelBox> Bounds);
+	static TSharedRef<FVoxelAABBTree> Create(
+		TConstVoxelArrayView<FVoxelBox> Bounds,
+		bool bUseSAH = false);
 
 public:
 	FORCEINLINE bool IsEmpty() const
@@ -82,6 +88,14 @@ public:
 		TConstVoxelArrayView<FVector3f> RayDirections,
 		FBulkRaycastLambda Lambda);
 
+	// Converts the tree to a FVoxelFastAABBTree and traces rays in packets, see FVoxelFastAABBTree::RaycastPackets
+	// The conversion is linear in the number of elements: pass as many rays as possible per call
+	using FRaycastPacketsLambda = TFunctionRef<void(TConstVoxelArrayView<int32> RayIndices, TConstVoxelArrayView<int32> Payloads)>;
+	void RaycastPackets(
+		TConstVoxelArrayView<FVector3f> RayPositions,
+		TConstVoxelArrayView<FVector3f> RayDirections,
+		FRaycastPacketsLambda Lambda) const;
+
 	template<typename LambdaType>
 	bool Raycast(const FVector& RayOrigin, const FVector& RayDirection, LambdaType&& Lambda) const
 	{
@@ -0,0 +1,114 @@
+﻿// Copyright Voxel Plugin SAS. All Rights Reserved.
+
+#pragma once
+
+#include "VoxelMinimal.h"
+
+class FVoxelZipReader;
+
+// Seekable compressed data: the data is split into fixed-size blocks compressed independently with FVoxelUtilities::Compress,
+// plus a block index. Reading a range only decompresses the blocks it overlaps, and blocks are decompressed in parallel
+// Recently used blocks are kept in a small LRU cache so that nearby reads don't decompress the same block again
+//
+// The compressed data is a single blob, store it as a zip entry with FVoxelZipWriter::WriteCompressed_Blocks
+// or in a FVoxelWriter with Save, and load it back with the matching Load
+class VOXELCORE_API FVoxelBlockCompressedData
+{
+public:
+	static constexpr int32 DefaultBlockSize = 256 * 1024;
+	static constexpr int32 DefaultMaxCachedBlocks = 16;
+
+	static TVoxelArray64<uint8> Compress(
+		TConstVoxelArrayView64<uint8> Data,
+		int32 BlockSize = DefaultBlockSize,
+		FOodleDataCompression::ECompressor Compressor = FOodleDataCompression::ECompressor::Leviathan,
+		FOodleDataCompression::ECompressionLevel CompressionLevel = FOodleDataCompression::ECompressionLevel::Optimal3);
+
+	static bool IsBlockCompressedData(TConstVoxelArrayView64<uint8> CompressedData);
+
+	// Writes CompressedData prefixed by its size
+	static void Save(
+		FVoxelWriter& Writer,
+		TConstVoxelArrayView64<uint8> CompressedData);
+
+public:
+	// CompressedData must outlive the result
+	static TSharedPtr<FVoxelBlockCompressedData> Load(
+		TConstVoxelArrayView64<uint8> CompressedData,
+		int32 MaxCachedBlocks = DefaultMaxCachedBlocks);
+
+	// Reads data written by Save without copying it: the bytes of Reader must outlive the result
+	static TSharedPtr<FVoxelBlockCompressedData> Load(
+		FVoxelReader& Reader,
+		int32 MaxCachedBlocks = DefaultMaxCachedBlocks);
+
+	// Keeps ZipReader alive. If it is memory-backed the entry is used in place, otherwise it's loaded in memory, still compressed
+	static TSharedPtr<FVoxelBlockCompressedData> Load(
+		const FVoxelZipReader& ZipReader,
+		const FString& Path,
+		int32 MaxCachedBlocks = DefaultMaxCachedBlocks);
+
+public:
+	FORCEINLINE int64 GetUncompressedSize() const
+	{
+		return UncompressedSize;
+	}
+	FORCEINLINE int64 GetCompressedSize() const
+	{
+		return CompressedData.Num();
+	}
+	FORCEINLINE int32 GetBlockSize() const
+	{
+		return BlockSize;
+	}
+	FORCEINLINE int32 NumBlocks() const
+	{
+		return BlockOffsets.Num() - 1;
+	}
+
+	// Thread-safe
+	// Blocks entirely covered by OutData are decompressed straight into it, the others go through the cache
+	bool Read(
+		int64 Offset,
+		TVoxelArrayView64<uint8> OutData) const;
+
+	bool Decompress(TVoxelArray64<uint8>& OutData) const;
+
+	void EmptyCache() const;
+
+private:
+	const int32 MaxCachedBlocks;
+
+	TConstVoxelArrayView64<uint8> CompressedData;
+	TVoxelArray64<uint8> CompressedDataStorage;
+	TSharedPtr<const FVoxelZipReader> ZipReader;
+
+	int64 UncompressedSize = 0;
+	int32 BlockSize = 0;
+	// NumBlocks + 1 offsets into CompressedData
+	TVoxelArray<int64> BlockOffsets;
+
+	struct FCachedBlock
+	{
+		TSharedPtr<const TVoxelArray64<uint8>> Data;
+		uint64 LastUsed = 0;
+	};
+	mutable FVoxelCriticalSection CriticalSection;
+	mutable uint64 CacheSerial_RequiresLock = 0;
+	mutable TVoxelMap<int32, FCachedBlock> CachedBlocks_RequiresLock;
+
+	explicit FVoxelBlockCompressedData(const int32 MaxCachedBlocks)
+		: MaxCachedBlocks(MaxCachedBlocks)
+	{
+	}
+
+	bool Initialize(TConstVoxelArrayView64<uint8> NewCompressedData);
+
+	bool DecompressBlock(
+		int32 BlockIndex,
+		TVoxelArrayView64<uint8> OutData) const;
+
+	void AddToCache(
+		int32 BlockIndex,
+		const TSharedRef<const TVoxelArray64<uint8>>& Data) const;
+};
\ No newline at end of file
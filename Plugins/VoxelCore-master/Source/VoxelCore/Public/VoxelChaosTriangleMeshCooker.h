@@ -12,4 +12,60 @@ struct VOXELCORE_API FVoxelChaosTriangleMeshCooker
 		TConstVoxelArrayView<uint16> FaceMaterials);
 
 	static int64 GetAllocatedSize(const Chaos::FTriangleMeshImplicitObject& TriangleMesh);
+
+public:
+	// BVH & triangle mapping of a cooked mesh, used to update it without cooking from scratch
+	struct FUpdateData;
+
+	struct FUpdatableMesh
+	{
+		TRefCountPtr<Chaos::FTriangleMeshImplicitObject> TriangleMesh;
+		// Null if the mesh can't be updated, eg if voxel.collision.FastCooking is false
+		TSharedPtr<const FUpdateData> UpdateData;
+
+		int64 GetAllocatedSize() const;
+	};
+
+	// Same as Create, but keeps the BVH & what Update needs
+	static FUpdatableMesh CreateUpdatable(
+		TConstVoxelArrayView<int32> Indices,
+		TConstVoxelArrayView<FVector3f> Vertices,
+		TConstVoxelArrayView<uint16> FaceMaterials);
+
+	// Cook a new version of Previous where only the triangles in [ChangedTrianglesStart, ChangedTrianglesStart + NumChangedTriangles)
+	// of the new Indices changed. The number of triangles can change, triangles after the range are then shifted
+	// Triangles outside the range must keep the same positions, but their indices can change
+	//
+	// Instead of building a new BVH, the changed triangles are removed from their leaves & inserted in the leaves
+	// that grow the least, and only the bounds of the ancestors of these leaves are refitted. This degrades the tree
+	// a bit on every update: falls back to a full cook if too much changed or if a leaf grew too large
+	// New triangles reuse the slots of removed ones, so the order of the cooked triangles doesn't follow Indices
+	//
+	// This overload copies the update data of Previous, prefer the one below if Previous isn't needed anymore
+	static FUpdatableMesh Update(
+		const FUpdatableMesh& Previous,
+		TConstVoxelArrayView<int32> Indices,
+		TConstVoxelArrayView<FVector3f> Vertices,
+		TConstVoxelArrayView<uint16> FaceMaterials,
+		int32 ChangedTrianglesStart,
+		int32 NumChangedTriangles);
+
+	// Updates the data of Previous in place if nothing else references it
+	static FUpdatableMesh Update(
+		FUpdatableMesh&& Previous,
+		TConstVoxelArrayView<int32> Indices,
+		TConstVoxelArrayView<FVector3f> Vertices,
+		TConstVoxelArrayView<uint16> FaceMaterials,
+		int32 ChangedTrianglesStart,
+		int32 NumChangedTriangles);
+
+private:
+	static FUpdatableMesh UpdateImpl(
+		const TSharedPtr<const FUpdateData>& PreviousUpdateData,
+		bool bCanReuseUpdateData,
+		TConstVoxelArrayView<int32> Indices,
+		TConstVoxelArrayView<FVector3f> Vertices,
+		TConstVoxelArrayView<uint16> FaceMaterials,
+		int32 ChangedTrianglesStart,
+		int32 NumChangedTriangles);
 };
\ No newline at end of file
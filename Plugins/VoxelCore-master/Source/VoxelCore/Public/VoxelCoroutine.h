@@ -0,0 +1,313 @@
+// Copyright Voxel Plugin SAS. All Rights Reserved.
+
+#pragma once
+
+#include "VoxelMinimal.h"
+#include "VoxelTaskContext.h"
+#include <coroutine>
+
+// Allows any function returning FVoxelFuture or TVoxelFuture<T> to be a coroutine:
+//
+//	TVoxelFuture<FMesh> BuildMesh()
+//	{
+//		const TSharedRef<FData> Data = co_await LoadData();
+//
+//		co_await EVoxelFutureThread::AsyncThread;
+//		FMesh Mesh = Process(*Data);
+//
+//		co_return Mesh;
+//	}
+//
+// The coroutine starts running inline on the calling thread, in the current task context
+// co_await on a complete future continues inline, otherwise the coroutine is resumed on the thread completing it
+// co_await on a thread hops to it, unless already there
+// If the task context is destroyed or cancels its tasks while the coroutine is suspended, the coroutine is destroyed without being resumed
+// and its future is set to a default value (TVoxelFuture<T> requires T to be default constructible for that, otherwise it is never set)
+
+// Owns a suspended coroutine until it's resumed
+class FVoxelCoroutineResumer
+{
+public:
+	FORCEINLINE FVoxelCoroutineResumer(
+		const std::coroutine_handle<> Handle,
+		const FVoxelTaskContextWeakRef& ContextWeakRef)
+		: Handle(Handle)
+		, ContextWeakRef(ContextWeakRef)
+	{
+	}
+	FORCEINLINE FVoxelCoroutineResumer(FVoxelCoroutineResumer&& Other)
+		: Handle(Other.Handle)
+		, ContextWeakRef(Other.ContextWeakRef)
+	{
+		Other.Handle = nullptr;
+	}
+	FORCEINLINE ~FVoxelCoroutineResumer()
+	{
+		if (Handle)
+		{
+			// Never resumed, the continuation was dropped
+			Handle.destroy();
+		}
+	}
+	UE_NONCOPYABLE(FVoxelCoroutineResumer);
+
+	void Resume()
+	{
+		checkVoxelSlow(Handle);
+
+		const std::coroutine_handle<> LocalHandle = Handle;
+		Handle = nullptr;
+
+		const TUniquePtr<FVoxelTaskContextStrongRef> ContextStrongRef = ContextWeakRef.Pin();
+		if (!ContextStrongRef)
+		{
+			LocalHandle.destroy();
+			return;
+		}
+
+		FVoxelTaskScope Scope(ContextStrongRef->Context);
+		LocalHandle.resume();
+	}
+
+private:
+	std::coroutine_handle<> Handle;
+	FVoxelTaskContextWeakRef ContextWeakRef;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+class FVoxelFutureAwaiter
+{
+public:
+	FORCEINLINE FVoxelFutureAwaiter(
+		const FVoxelFuture& Future,
+		const FVoxelTaskContextWeakRef& ContextWeakRef)
+		: Future(Future)
+		, ContextWeakRef(ContextWeakRef)
+	{
+	}
+
+	FORCEINLINE bool await_ready() const
+	{
+		return Future.IsComplete();
+	}
+	void await_suspend(const std::coroutine_handle<> Handle) const
+	{
+		// The coroutine might be resumed & destroyed before AddContinuation returns, don't rely on this awaiter staying alive
+		const FVoxelPromiseStatePtr PromiseState = Future.PromiseState;
+
+		PromiseState->AddContinuation(EVoxelFutureThread::AnyThread, [Resumer = FVoxelCoroutineResumer(Handle, ContextWeakRef)]() mutable
+		{
+			Resumer.Resume();
+		});
+	}
+	FORCEINLINE void await_resume() const
+	{
+	}
+
+protected:
+	const FVoxelFuture Future;
+	const FVoxelTaskContextWeakRef ContextWeakRef;
+};
+
+template<typename T>
+class TVoxelFutureAwaiter : public FVoxelFutureAwaiter
+{
+public:
+	using FVoxelFutureAwaiter::FVoxelFutureAwaiter;
+
+	FORCEINLINE TSharedRef<T> await_resume() const
+	{
+		return ReinterpretCastRef<TVoxelFuture<T>>(Future).GetSharedValueChecked();
+	}
+};
+
+class FVoxelThreadAwaiter
+{
+public:
+	FORCEINLINE FVoxelThreadAwaiter(
+		const EVoxelFutureThread Thread,
+		const FVoxelTaskContextWeakRef& ContextWeakRef)
+		: Thread(Thread)
+		, ContextWeakRef(ContextWeakRef)
+	{
+	}
+
+	FORCEINLINE bool await_ready() const
+	{
+		return
+			Thread == EVoxelFutureThread::AnyThread ||
+			(Thread == EVoxelFutureThread::GameThread && IsInGameThread());
+	}
+	void await_suspend(const std::coroutine_handle<> Handle) const
+	{
+		const TUniquePtr<FVoxelTaskContextStrongRef> ContextStrongRef = ContextWeakRef.Pin();
+		if (!ContextStrongRef)
+		{
+			// Will set the future to a default value, see ~FVoxelCoroutinePromise
+			Handle.destroy();
+			return;
+		}
+
+		ContextStrongRef->Context.Dispatch(Thread, [Resumer = FVoxelCoroutineResumer(Handle, ContextWeakRef)]() mutable
+		{
+			Resumer.Resume();
+		});
+	}
+	FORCEINLINE void await_resume() const
+	{
+	}
+
+private:
+	const EVoxelFutureThread Thread;
+	const FVoxelTaskContextWeakRef ContextWeakRef;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+class FVoxelCoroutinePromiseBase
+{
+public:
+	// Context the coroutine was started in, all resumes happen in it
+	const FVoxelTaskContextWeakRef ContextWeakRef = FVoxelTaskScope::GetContext();
+
+	FORCEINLINE std::suspend_never initial_suspend() const noexcept
+	{
+		return {};
+	}
+	FORCEINLINE std::suspend_never final_suspend() const noexcept
+	{
+		return {};
+	}
+	void unhandled_exception() const
+	{
+		// Exceptions are disabled in UE: this is never called. If it is, the coroutine frame
+		// is destroyed right after and its future is set to a default value
+		ensureMsgf(false, TEXT("Unhandled exception in voxel coroutine"));
+	}
+
+public:
+	FORCEINLINE FVoxelFutureAwaiter await_transform(const FVoxelFuture& Future) const
+	{
+		return FVoxelFutureAwaiter(Future, ContextWeakRef);
+	}
+	template<typename T>
+	FORCEINLINE TVoxelFutureAwaiter<T> await_transform(const TVoxelFuture<T>& Future) const
+	{
+		return TVoxelFutureAwaiter<T>(Future, ContextWeakRef);
+	}
+	FORCEINLINE FVoxelThreadAwaiter await_transform(const EVoxelFutureThread Thread) const
+	{
+		return FVoxelThreadAwaiter(Thread, ContextWeakRef);
+	}
+};
+
+class FVoxelCoroutinePromise : public FVoxelCoroutinePromiseBase
+{
+public:
+	FVoxelCoroutinePromise() = default;
+	// Called when the frame is destroyed: if the coroutine didn't return, don't leave waiters hanging
+	~FVoxelCoroutinePromise()
+	{
+		if (!bIsSet)
+		{
+			Promise.Set();
+		}
+	}
+	UE_NONCOPYABLE(FVoxelCoroutinePromise);
+
+	FORCEINLINE FVoxelFuture get_return_object() const
+	{
+		return Promise;
+	}
+	FORCEINLINE void return_void()
+	{
+		checkVoxelSlow(!bIsSet);
+		bIsSet = true;
+		Promise.Set();
+	}
+
+private:
+	const FVoxelPromise Promise;
+	bool bIsSet = false;
+};
+
+template<typename T>
+class TVoxelCoroutinePromise : public FVoxelCoroutinePromiseBase
+{
+public:
+	TVoxelCoroutinePromise() = default;
+	// Called when the frame is destroyed: if the coroutine didn't return, don't leave waiters hanging
+	~TVoxelCoroutinePromise()
+	{
+		if (bIsSet)
+		{
+			return;
+		}
+
+		if constexpr (std::is_default_constructible_v<T>)
+		{
+			Promise.Set(MakeShared<T>());
+		}
+	}
+	UE_NONCOPYABLE(TVoxelCoroutinePromise);
+
+	FORCEINLINE TVoxelFuture<T> get_return_object() const
+	{
+		return Promise;
+	}
+
+	FORCEINLINE void return_value(const T& Value)
+	{
+		MarkSet();
+		Promise.Set(Value);
+	}
+	FORCEINLINE void return_value(T&& Value)
+	{
+		MarkSet();
+		Promise.Set(MoveTemp(Value));
+	}
+	FORCEINLINE void return_value(const TSharedRef<T>& Value)
+	{
+		MarkSet();
+		Promise.Set(Value);
+	}
+	FORCEINLINE void return_value(const TVoxelFuture<T>& Future)
+	{
+		MarkSet();
+		Promise.Set(Future);
+	}
+
+private:
+	const TVoxelPromise<T> Promise;
+	bool bIsSet = false;
+
+	FORCEINLINE void MarkSet()
+	{
+		checkVoxelSlow(!bIsSet);
+		bIsSet = true;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+namespace std
+{
+	template<typename... ArgTypes>
+	struct coroutine_traits<FVoxelFuture, ArgTypes...>
+	{
+		using promise_type = FVoxelCoroutinePromise;
+	};
+
+	template<typename T, typename... ArgTypes>
+	struct coroutine_traits<TVoxelFuture<T>, ArgTypes...>
+	{
+		using promise_type = TVoxelCoroutinePromise<T>;
+	};
+}
@@ -6,11 +6,15 @@
 
 DECLARE_UNIQUE_VOXEL_ID(FVoxelDependencyId);
 
+class FVoxelDependencyTrackerIndex;
+
 class VOXELCORE_API FVoxelDependencyBase : public TSharedFromThis<FVoxelDependencyBase>
 {
 public:
 	const FString Name;
 	const FVoxelDependencyId DependencyId;
+	// Trackers depending on this, used to avoid iterating all trackers when invalidating
+	const TSharedRef<FVoxelDependencyTrackerIndex> Trackers;
 
 	VOXEL_COUNT_INSTANCES();
 
@@ -7,6 +7,7 @@
 class FVoxelDependency;
 class FVoxelDependency3D;
 class FVoxelDependency2D;
+class FVoxelDependencyTrackerIndex;
 
 DECLARE_UNIQUE_VOXEL_ID(FVoxelDependencyId);
 
@@ -58,9 +59,25 @@ private:
 	TVoxelAtomic<bool> bIsInvalidated;
 	TVoxelUniqueFunction<void()> OnInvalidated_RequiresLock;
 
-	TVoxelSet<FVoxelDependencyId> Dependencies_RequiresLock;
-	TVoxelMap<FVoxelDependencyId, FVoxelBox2D> Dependency2DToBounds_RequiresLock;
-	TVoxelMap<FVoxelDependencyId, FVoxelBox> Dependency3DToBounds_RequiresLock;
+	struct FBounds2D
+	{
+		FVoxelBox2D Bounds;
+		int32 ElementId = -1;
+		TWeakPtr<FVoxelDependencyTrackerIndex> WeakTrackers;
+	};
+	struct FBounds3D
+	{
+		FVoxelBox Bounds;
+		int32 ElementId = -1;
+		TWeakPtr<FVoxelDependencyTrackerIndex> WeakTrackers;
+	};
+
+	TVoxelMap<FVoxelDependencyId, TWeakPtr<FVoxelDependencyTrackerIndex>> Dependencies_RequiresLock;
+	TVoxelMap<FVoxelDependencyId, FBounds2D> Dependency2DToBounds_RequiresLock;
+	TVoxelMap<FVoxelDependencyId, FBounds3D> Dependency3DToBounds_RequiresLock;
+
+	// Clear all dependencies & remove this tracker from the dependencies indices
+	void ClearDependencies_RequiresLock();
 
 	friend FVoxelDependency;
 	friend FVoxelDependency2D;
@@ -15,12 +15,22 @@ public:
 	public:
 		void Initialize(const FVoxelDistanceFieldWrapper& Wrapper);
 
+		// Bricks are allocated in a chunked pool and never move: returned pointers stay valid until SetSize
+		// Thread-safe as long as each cell is only accessed by one thread at a time
 		FBrick* FindBrick(const FIntVector& Position);
 		FBrick& FindOrAddBrick(const FIntVector& Position);
 
 		void AddBrick(
 			const FIntVector& Position,
-			const TSharedRef<FBrick>& Brick);
+			const FBrick& Brick);
+
+		UE_DEPRECATED(5.5, "Use AddBrick with a const FBrick& instead, bricks are now stored in a pool")
+		void AddBrick(
+			const FIntVector& Position,
+			const TSharedRef<FBrick>& Brick)
+		{
+			AddBrick(Position, *Brick);
+		}
 
 		FORCEINLINE uint8 QuantizeDistance(const float Distance) const
 		{
@@ -37,7 +47,11 @@ public:
 		float LocalToVolumeScale = 0.f;
 		FVector2D DistanceFieldToVolumeScaleBias = FVector2D::ZeroVector;
 		FIntVector IndirectionSize = FIntVector::ZeroValue;
-		TVoxelArray<TSharedPtr<FBrick>> Bricks;
+		// Index into BrickPool for each indirection cell, -1 if the cell has no brick
+		TVoxelArray<int32> BrickIndices;
+		TVoxelChunkedArray<FBrick> BrickPool;
+		// Adding to BrickPool can reallocate its chunk table, lock all accesses to it
+		FVoxelCriticalSection BrickPoolCriticalSection;
 
 		friend class FVoxelDistanceFieldWrapper;
 	};
@@ -0,0 +1,420 @@
+// Copyright Voxel Plugin SAS. All Rights Reserved.
+
+#pragma once
+
+#include "VoxelMinimal.h"
+
+// Incremental AABB tree supporting insertion & removal of single elements
+// Unlike FVoxelAABBTree, does not need to be rebuilt from scratch when elements change
+// Balanced using tree rotations, see Box2D b2DynamicTree
+// BoxType is either FVoxelBox or FVoxelBox2D
+template<typename BoxType>
+class TVoxelDynamicAABBTree
+{
+public:
+	static constexpr bool bIs2D = std::is_same_v<BoxType, FVoxelBox2D>;
+	checkStatic(bIs2D || std::is_same_v<BoxType, FVoxelBox>);
+
+	struct FNode
+	{
+		BoxType Bounds;
+		int32 Parent = -1;
+		int32 ChildIndex0 = -1;
+		int32 ChildIndex1 = -1;
+		// 0 for leaves
+		int32 Height = 0;
+		int32 Payload = -1;
+
+		FORCEINLINE bool IsLeaf() const
+		{
+			return ChildIndex0 == -1;
+		}
+	};
+
+	TVoxelDynamicAABBTree() = default;
+
+public:
+	FORCEINLINE bool IsEmpty() const
+	{
+		return RootIndex == -1;
+	}
+	FORCEINLINE int32 NumElements() const
+	{
+		return NumLeaves;
+	}
+	FORCEINLINE int64 GetAllocatedSize() const
+	{
+		return Nodes.GetAllocatedSize();
+	}
+	FORCEINLINE const BoxType& GetBounds(const int32 ElementId) const
+	{
+		checkVoxelSlow(Nodes[ElementId].IsLeaf());
+		return Nodes[ElementId].Bounds;
+	}
+	FORCEINLINE int32 GetPayload(const int32 ElementId) const
+	{
+		checkVoxelSlow(Nodes[ElementId].IsLeaf());
+		return Nodes[ElementId].Payload;
+	}
+
+	void Empty()
+	{
+		Nodes.Empty();
+		RootIndex = -1;
+		NumLeaves = 0;
+	}
+
+public:
+	// Returns an id that can be used to update or remove the element
+	int32 Insert(const BoxType& Bounds, const int32 Payload)
+	{
+		checkVoxelSlow(Bounds.IsValid());
+
+		const int32 LeafIndex = Nodes.Emplace();
+		{
+			FNode& Leaf = Nodes[LeafIndex];
+			Leaf.Bounds = Bounds;
+			Leaf.Payload = Payload;
+		}
+
+		NumLeaves++;
+		InsertLeaf(LeafIndex);
+
+		return LeafIndex;
+	}
+	void Remove(const int32 ElementId)
+	{
+		checkVoxelSlow(Nodes.IsValidIndex(ElementId));
+		checkVoxelSlow(Nodes[ElementId].IsLeaf());
+
+		RemoveLeaf(ElementId);
+		Nodes.RemoveAt(ElementId);
+		NumLeaves--;
+	}
+	void Update(const int32 ElementId, const BoxType& NewBounds)
+	{
+		checkVoxelSlow(Nodes.IsValidIndex(ElementId));
+		checkVoxelSlow(Nodes[ElementId].IsLeaf());
+
+		if (Nodes[ElementId].Bounds == NewBounds)
+		{
+			return;
+		}
+
+		RemoveLeaf(ElementId);
+		Nodes[ElementId].Bounds = NewBounds;
+		InsertLeaf(ElementId);
+	}
+
+public:
+	template<typename ShouldVisitType, typename VisitType>
+	void Traverse(ShouldVisitType&& ShouldVisit, VisitType&& Visit) const
+	{
+		if (RootIndex == -1)
+		{
+			return;
+		}
+
+		TVoxelInlineArray<int32, 64> QueuedNodes;
+		QueuedNodes.Add(RootIndex);
+
+		while (QueuedNodes.Num() > 0)
+		{
+			const FNode& Node = Nodes[QueuedNodes.Pop()];
+			if (!ShouldVisit(Node.Bounds))
+			{
+				continue;
+			}
+
+			if (Node.IsLeaf())
+			{
+				Visit(Node.Payload);
+				continue;
+			}
+
+			QueuedNodes.Add(Node.ChildIndex0);
+			QueuedNodes.Add(Node.ChildIndex1);
+		}
+	}
+	template<typename VisitType>
+	void TraverseBounds(const BoxType& Bounds, VisitType&& Visit) const
+	{
+		this->Traverse(
+			[&](const BoxType& OtherBounds)
+			{
+				return OtherBounds.Intersects(Bounds);
+			},
+			MoveTemp(Visit));
+	}
+	template<typename VisitType>
+	void TraverseAll(VisitType&& Visit) const
+	{
+		this->Traverse(
+			[](const BoxType&)
+			{
+				return true;
+			},
+			MoveTemp(Visit));
+	}
+
+private:
+	TVoxelSparseArray<FNode> Nodes;
+	int32 RootIndex = -1;
+	int32 NumLeaves = 0;
+
+	// Surface area heuristic. Sizes are clamped as dependencies can have infinite bounds
+	FORCEINLINE static double GetCost(const BoxType& Bounds)
+	{
+		constexpr double MaxSize = 1.e30;
+
+		if constexpr (bIs2D)
+		{
+			const FVector2D Size = Bounds.Size();
+			return
+				FMath::Min(Size.X, MaxSize) +
+				FMath::Min(Size.Y, MaxSize);
+		}
+		else
+		{
+			const FVector3d Size = Bounds.Size();
+			const double X = FMath::Min(Size.X, MaxSize);
+			const double Y = FMath::Min(Size.Y, MaxSize);
+			const double Z = FMath::Min(Size.Z, MaxSize);
+			return X * Y + Y * Z + Z * X;
+		}
+	}
+
+	void InsertLeaf(const int32 LeafIndex)
+	{
+		if (RootIndex == -1)
+		{
+			RootIndex = LeafIndex;
+			Nodes[RootIndex].Parent = -1;
+			return;
+		}
+
+		const BoxType LeafBounds = Nodes[LeafIndex].Bounds;
+
+		// Find the best sibling
+		int32 SiblingIndex = RootIndex;
+		while (!Nodes[SiblingIndex].IsLeaf())
+		{
+			const FNode& Node = Nodes[SiblingIndex];
+
+			const double Cost = GetCost(Node.Bounds);
+			const double CombinedCost = GetCost(Node.Bounds.UnionWith(LeafBounds));
+
+			// Cost of creating a new parent for this node and the new leaf
+			const double NewParentCost = 2 * CombinedCost;
+			// Minimum cost of pushing the leaf further down the tree
+			const double InheritanceCost = 2 * (CombinedCost - Cost);
+
+			const auto GetChildCost = [&](const int32 ChildIndex)
+			{
+				const FNode& Child = Nodes[ChildIndex];
+				const double ChildCost = GetCost(Child.Bounds.UnionWith(LeafBounds));
+
+				if (Child.IsLeaf())
+				{
+					return ChildCost + InheritanceCost;
+				}
+
+				return ChildCost - GetCost(Child.Bounds) + InheritanceCost;
+			};
+
+			const double Cost0 = GetChildCost(Node.ChildIndex0);
+			const double Cost1 = GetChildCost(Node.ChildIndex1);
+
+			if (NewParentCost < Cost0 &&
+				NewParentCost < Cost1)
+			{
+				break;
+			}
+
+			SiblingIndex = Cost0 < Cost1 ? Node.ChildIndex0 : Node.ChildIndex1;
+		}
+
+		const int32 OldParentIndex = Nodes[SiblingIndex].Parent;
+
+		const int32 NewParentIndex = Nodes.Emplace();
+		{
+			FNode& NewParent = Nodes[NewParentIndex];
+			NewParent.Parent = OldParentIndex;
+			NewParent.Bounds = Nodes[SiblingIndex].Bounds.UnionWith(LeafBounds);
+			NewParent.Height = Nodes[SiblingIndex].Height + 1;
+			NewParent.ChildIndex0 = SiblingIndex;
+			NewParent.ChildIndex1 = LeafIndex;
+		}
+
+		if (OldParentIndex == -1)
+		{
+			RootIndex = NewParentIndex;
+		}
+		else
+		{
+			FNode& OldParent = Nodes[OldParentIndex];
+			if (OldParent.ChildIndex0 == SiblingIndex)
+			{
+				OldParent.ChildIndex0 = NewParentIndex;
+			}
+			else
+			{
+				checkVoxelSlow(OldParent.ChildIndex1 == SiblingIndex);
+				OldParent.ChildIndex1 = NewParentIndex;
+			}
+		}
+
+		Nodes[SiblingIndex].Parent = NewParentIndex;
+		Nodes[LeafIndex].Parent = NewParentIndex;
+
+		RefitAncestors(NewParentIndex);
+	}
+	void RemoveLeaf(const int32 LeafIndex)
+	{
+		if (LeafIndex == RootIndex)
+		{
+			RootIndex = -1;
+			return;
+		}
+
+		const int32 ParentIndex = Nodes[LeafIndex].Parent;
+		const int32 GrandParentIndex = Nodes[ParentIndex].Parent;
+		const int32 SiblingIndex =
+			Nodes[ParentIndex].ChildIndex0 == LeafIndex
+			? Nodes[ParentIndex].ChildIndex1
+			: Nodes[ParentIndex].ChildIndex0;
+
+		Nodes.RemoveAt(ParentIndex);
+		Nodes[SiblingIndex].Parent = GrandParentIndex;
+		Nodes[LeafIndex].Parent = -1;
+
+		if (GrandParentIndex == -1)
+		{
+			RootIndex = SiblingIndex;
+			return;
+		}
+
+		FNode& GrandParent = Nodes[GrandParentIndex];
+		if (GrandParent.ChildIndex0 == ParentIndex)
+		{
+			GrandParent.ChildIndex0 = SiblingIndex;
+		}
+		else
+		{
+			checkVoxelSlow(GrandParent.ChildIndex1 == ParentIndex);
+			GrandParent.ChildIndex1 = SiblingIndex;
+		}
+
+		RefitAncestors(GrandParentIndex);
+	}
+	void RefitAncestors(int32 Index)
+	{
+		while (Index != -1)
+		{
+			Index = Balance(Index);
+
+			FNode& Node = Nodes[Index];
+			const FNode& Child0 = Nodes[Node.ChildIndex0];
+			const FNode& Child1 = Nodes[Node.ChildIndex1];
+
+			Node.Bounds = Child0.Bounds.UnionWith(Child1.Bounds);
+			Node.Height = 1 + FMath::Max(Child0.Height, Child1.Height);
+
+			Index = Node.Parent;
+		}
+	}
+
+	// Rotate the tree if the node is imbalanced, returns the new root of the subtree
+	int32 Balance(const int32 IndexA)
+	{
+		FNode& A = Nodes[IndexA];
+		if (A.IsLeaf() ||
+			A.Height < 2)
+		{
+			return IndexA;
+		}
+
+		const int32 IndexB = A.ChildIndex0;
+		const int32 IndexC = A.ChildIndex1;
+
+		const int32 Balance = Nodes[IndexC].Height - Nodes[IndexB].Height;
+
+		if (Balance > 1)
+		{
+			return Rotate(IndexA, IndexC, IndexB);
+		}
+		if (Balance < -1)
+		{
+			return Rotate(IndexA, IndexB, IndexC);
+		}
+
+		return IndexA;
+	}
+	// Promote the taller child of A, OtherIndex being A's other child
+	int32 Rotate(const int32 IndexA, const int32 TallIndex, const int32 OtherIndex)
+	{
+		FNode& A = Nodes[IndexA];
+		FNode& Tall = Nodes[TallIndex];
+
+		const int32 IndexF = Tall.ChildIndex0;
+		const int32 IndexG = Tall.ChildIndex1;
+		FNode& F = Nodes[IndexF];
+		FNode& G = Nodes[IndexG];
+
+		// Swap A and Tall
+		Tall.ChildIndex0 = IndexA;
+		Tall.Parent = A.Parent;
+		A.Parent = TallIndex;
+
+		if (Tall.Parent == -1)
+		{
+			RootIndex = TallIndex;
+		}
+		else
+		{
+			FNode& Parent = Nodes[Tall.Parent];
+			if (Parent.ChildIndex0 == IndexA)
+			{
+				Parent.ChildIndex0 = TallIndex;
+			}
+			else
+			{
+				checkVoxelSlow(Parent.ChildIndex1 == IndexA);
+				Parent.ChildIndex1 = TallIndex;
+			}
+		}
+
+		const bool bAIsChild0 = A.ChildIndex0 == TallIndex;
+		const FNode& Other = Nodes[OtherIndex];
+
+		// Keep the tallest of F & G under Tall, move the other one to A
+		const bool bKeepF = F.Height > G.Height;
+		const int32 KeptIndex = bKeepF ? IndexF : IndexG;
+		const int32 MovedIndex = bKeepF ? IndexG : IndexF;
+		FNode& Kept = bKeepF ? F : G;
+		FNode& Moved = bKeepF ? G : F;
+
+		Tall.ChildIndex1 = KeptIndex;
+
+		if (bAIsChild0)
+		{
+			A.ChildIndex0 = MovedIndex;
+		}
+		else
+		{
+			A.ChildIndex1 = MovedIndex;
+		}
+		Moved.Parent = IndexA;
+
+		A.Bounds = Other.Bounds.UnionWith(Moved.Bounds);
+		A.Height = 1 + FMath::Max(Other.Height, Moved.Height);
+
+		Tall.Bounds = A.Bounds.UnionWith(Kept.Bounds);
+		Tall.Height = 1 + FMath::Max(A.Height, Kept.Height);
+
+		return TallIndex;
+	}
+};
+
+using FVoxelDynamicAABBTree = TVoxelDynamicAABBTree<FVoxelBox>;
+using FVoxelDynamicAABBTree2D = TVoxelDynamicAABBTree<FVoxelBox2D>;
@@ -4,6 +4,8 @@
 
 #include "VoxelMinimal.h"
 
+class FVoxelAABBTree;
+
 class VOXELCORE_API FVoxelFastAABBTree
 {
 public:
@@ -72,6 +74,19 @@ public:
 			::Swap(MaxZ[IndexA], MaxZ[IndexB]);
 		}
 
+		FElementArrayView Slice(const int32 Index, const int32 Number) const
+		{
+			FElementArrayView Result;
+			Result.Payload = Payload.Slice(Index, Number);
+			Result.MinX = MinX.Slice(Index, Number);
+			Result.MinY = MinY.Slice(Index, Number);
+			Result.MinZ = MinZ.Slice(Index, Number);
+			Result.MaxX = MaxX.Slice(Index, Number);
+			Result.MaxY = MaxY.Slice(Index, Number);
+			Result.MaxZ = MaxZ.Slice(Index, Number);
+			return Result;
+		}
+
 		FElementArray Array() const
 		{
 			FElementArray Result;
@@ -128,8 +143,39 @@ public:
 	}
 
 	void Initialize(FElementArray&& Elements);
+	// Copies the hierarchy of Tree, rounding bounds outwards so that they still contain the original double bounds
+	void Initialize(const FVoxelAABBTree& Tree);
 	void Shrink();
 
+public:
+	// Receives the tree as it is built, to emit it directly into another layout without going through Nodes/Leaves
+	// Node indices are allocated in creation order, root is 0
+	// A node is set once all its elements are partitioned, which can be after its children indices are allocated
+	class IBuildWriter
+	{
+	public:
+		virtual ~IBuildWriter() = default;
+
+		virtual void Reserve(int32 ExpectedNumNodes, int32 ExpectedNumLeaves) = 0;
+		// Elements is a view into the array passed to Build
+		virtual void SetLeaf(int32 NodeIndex, const FElementArrayView& Elements) = 0;
+		virtual void SetInnerNode(
+			int32 NodeIndex,
+			int32 ChildIndex0,
+			const FVector3f& ChildBounds0_Min,
+			const FVector3f& ChildBounds0_Max,
+			int32 ChildIndex1,
+			const FVector3f& ChildBounds1_Min,
+			const FVector3f& ChildBounds1_Max) = 0;
+	};
+
+	// Elements are partitioned in place
+	static void Build(
+		const FElementArrayView& AllElements,
+		int32 MaxChildrenInLeaf,
+		int32 MaxTreeDepth,
+		IBuildWriter& Writer);
+
 public:
 	FORCEINLINE TConstVoxelArrayView<FNode> GetNodes() const
 	{
@@ -292,6 +338,18 @@ public:
 			MoveTemp(Visit));
 	}
 
+public:
+	using FRaycastPacketsLambda = TFunctionRef<void(TConstVoxelArrayView<int32> RayIndices, TConstVoxelArrayView<int32> Payloads)>;
+
+	// Traces rays in packets of 4 or 8 (the ISPC target width), with one traversal stack per packet
+	// Uses the same line/box test as FVoxelBox::RayBoxIntersection
+	// Packets only pay off if consecutive rays are coherent (close origins, similar directions), eg the AO rays of a texel
+	// Lambda is called with batches of hits: ray RayIndices[Index] intersects the bounds of the element with payload Payloads[Index]
+	void RaycastPackets(
+		TConstVoxelArrayView<FVector3f> RayPositions,
+		TConstVoxelArrayView<FVector3f> RayDirections,
+		FRaycastPacketsLambda Lambda) const;
+
 private:
 	TVoxelArray<FNode> Nodes;
 	TVoxelArray<FLeaf> Leaves;
@@ -7,10 +7,16 @@
 struct VOXELCORE_API FVoxelJumpFlood
 {
 public:
+	// Runs the passes through ISPC, with rows in parallel
 	static void JumpFlood2D(
 		const FIntPoint& Size,
 		TVoxelArrayView<FIntPoint> InOutClosestPosition);
 
+	// Scalar single-threaded version, bit-identical to JumpFlood2D
+	static void JumpFlood2D_Reference(
+		const FIntPoint& Size,
+		TVoxelArrayView<FIntPoint> InOutClosestPosition);
+
 private:
 	static void JumpFlood2DImpl(
 		const FIntPoint& Size,
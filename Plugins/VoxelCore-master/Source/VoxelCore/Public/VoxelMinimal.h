@@ -84,6 +84,10 @@
 #include "VoxelMinimal/Containers/VoxelBitArray.h"
 #include "VoxelMinimal/Containers/VoxelChunkedArray.h"
 #include "VoxelMinimal/Containers/VoxelChunkedSparseArray.h"
+#include "VoxelMinimal/Containers/VoxelConcurrentMap.h"
+#include "VoxelMinimal/Containers/VoxelFlatHashTable.h"
+#include "VoxelMinimal/Containers/VoxelFlatMap.h"
+#include "VoxelMinimal/Containers/VoxelFlatSet.h"
 #include "VoxelMinimal/Containers/VoxelMap.h"
 #include "VoxelMinimal/Containers/VoxelSet.h"
 #include "VoxelMinimal/Containers/VoxelSparseArray.h"
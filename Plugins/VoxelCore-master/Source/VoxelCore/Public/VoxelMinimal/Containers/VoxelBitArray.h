@@ -289,6 +289,11 @@ public:
 		checkVoxelSlow(Num() == Size.X * Size.Y * Size.Z);
 		return FVoxelBitArrayHelpers::GreedyMeshing3D(GetWordView(), Size);
 	}
+	FORCEINLINE TVoxelArray<FVoxelIntBox> GreedyMeshing3D_Parallel(const FIntVector& Size) const
+	{
+		checkVoxelSlow(Num() == Size.X * Size.Y * Size.Z);
+		return FVoxelBitArrayHelpers::GreedyMeshing3D_Parallel(GetWordView(), Size);
+	}
 
 public:
 	FORCEINLINE int64 GetAllocatedSize() const
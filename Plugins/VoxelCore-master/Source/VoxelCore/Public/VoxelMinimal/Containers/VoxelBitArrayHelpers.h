@@ -562,7 +562,15 @@ public:
 	static int64 CountSetBits_UpperBound(const uint32* RESTRICT Data, int32 NumBits);
 
 public:
+	// Will clear Data
 	static TVoxelArray<FVoxelIntBox> GreedyMeshing3D(
 		TVoxelArrayView<uint32> Data,
 		const FIntVector& Size);
+
+	// Same as GreedyMeshing3D but Data is left untouched
+	// Runs are scanned a uint64 word at a time, and slabs along Z are meshed in parallel
+	// Boxes are merged across slab seams only if they have the same XY extent, so the result can differ slightly from GreedyMeshing3D
+	static TVoxelArray<FVoxelIntBox> GreedyMeshing3D_Parallel(
+		TConstVoxelArrayView<uint32> Data,
+		const FIntVector& Size);
 };
\ No newline at end of file
@@ -0,0 +1,367 @@
+// Copyright Voxel Plugin SAS. All Rights Reserved.
+
+#pragma once
+
+#include "VoxelCoreMinimal.h"
+#include "VoxelMinimal/VoxelAtomic.h"
+#include "VoxelMinimal/VoxelCriticalSection.h"
+#include "VoxelMinimal/Containers/VoxelStaticArray.h"
+#include "VoxelMinimal/Utilities/VoxelHashUtilities.h"
+
+// Insert-only concurrent hash map, meant for caches shared across threads
+// - Find is wait-free: no lock, no CAS loop, just a bounded linear probe
+// - FindOrAdd only locks the shard the key belongs to, and only if the key isn't already in the map
+//
+// Elements are allocated individually and never move, so returned pointers are valid until Empty
+// Each shard is a linear-probing table of atomic element pointers. When a shard grows, the new table
+// is published with a release store and the previous one is kept alive until Empty,
+// so that readers still probing it never read freed memory
+//
+// Values are not synchronized: either make them immutable once constructed or protect them yourself
+template<typename KeyType, typename ValueType, int32 NumShardsLog2 = 6>
+class TVoxelConcurrentMap
+{
+public:
+	static constexpr int32 NumShards = 1 << NumShardsLog2;
+	checkStatic(0 < NumShardsLog2 && NumShardsLog2 < 16);
+
+	struct FElement
+	{
+		const KeyType Key;
+		ValueType Value;
+
+		template<typename LambdaType>
+		FORCEINLINE FElement(const KeyType& Key, LambdaType&& Construct)
+			: Key(Key)
+			, Value(Construct())
+		{
+		}
+	};
+
+	TVoxelConcurrentMap() = default;
+	UE_NONCOPYABLE(TVoxelConcurrentMap);
+
+public:
+	// Approximate if called while elements are being added
+	int32 Num() const
+	{
+		int32 Result = 0;
+		for (const FShard& Shard : Shards)
+		{
+			Result += Shard.Num.Get(std::memory_order_relaxed);
+		}
+		return Result;
+	}
+	int64 GetAllocatedSize() const
+	{
+		int64 AllocatedSize = 0;
+		for (const FShard& Shard : Shards)
+		{
+			AllocatedSize += Shard.AllocatedSize.Get(std::memory_order_relaxed);
+		}
+		return AllocatedSize;
+	}
+
+	// Not thread-safe: no other thread can access the map while this is called
+	void Empty()
+	{
+		VOXEL_FUNCTION_COUNTER_NUM(Num(), 1024);
+
+		for (FShard& Shard : Shards)
+		{
+			Shard.Empty();
+		}
+	}
+
+public:
+	// Wait-free. Might miss an element that is being added concurrently
+	FORCEINLINE ValueType* Find(const KeyType& Key)
+	{
+		return this->FindHashed(this->HashValue(Key), Key);
+	}
+	FORCEINLINE const ValueType* Find(const KeyType& Key) const
+	{
+		return ConstCast(this)->Find(Key);
+	}
+	FORCEINLINE ValueType* FindHashed(const uint64 Hash, const KeyType& Key)
+	{
+		checkVoxelSlow(this->HashValue(Key) == Hash);
+
+		FElement* Element = Shards[GetShardIndex(Hash)].Find(Hash, Key);
+		if (!Element)
+		{
+			return nullptr;
+		}
+		return &Element->Value;
+	}
+
+	FORCEINLINE bool Contains(const KeyType& Key) const
+	{
+		return this->Find(Key) != nullptr;
+	}
+
+	// Construct is called at most once per key, with the shard locked, and should return a ValueType
+	// Avoid doing expensive work in Construct as it blocks other writers of the same shard
+	template<typename LambdaType>
+	requires std::is_constructible_v<ValueType, decltype(DeclVal<LambdaType>()())>
+	FORCEINLINE ValueType& FindOrAdd(const KeyType& Key, LambdaType&& Construct)
+	{
+		const uint64 Hash = this->HashValue(Key);
+
+		FShard& Shard = Shards[GetShardIndex(Hash)];
+		if (FElement* Element = Shard.Find(Hash, Key))
+		{
+			return Element->Value;
+		}
+
+		return Shard.FindOrAdd(Hash, Key, Construct).Value;
+	}
+	FORCEINLINE ValueType& FindOrAdd(const KeyType& Key)
+	requires std::is_default_constructible_v<ValueType>
+	{
+		return this->FindOrAdd(Key, []
+		{
+			return ValueType();
+		});
+	}
+
+	// Elements added concurrently might not be visited
+	template<typename LambdaType>
+	void ForEach(LambdaType&& Lambda)
+	{
+		for (const FShard& Shard : Shards)
+		{
+			const FTable* Table = Shard.Table.Get(std::memory_order_acquire);
+			if (!Table)
+			{
+				continue;
+			}
+
+			for (int32 Index = 0; Index < Table->NumSlots; Index++)
+			{
+				if (FElement* Element = Table->GetSlots()[Index].Get(std::memory_order_acquire))
+				{
+					Lambda(Element->Key, Element->Value);
+				}
+			}
+		}
+	}
+
+public:
+	FORCEINLINE static uint64 HashValue(const KeyType& Key)
+	{
+		if constexpr (std::has_unique_object_representations_v<KeyType>)
+		{
+			return FVoxelUtilities::MurmurHash(Key);
+		}
+		else
+		{
+			return FVoxelUtilities::MurmurHash64(FVoxelUtilities::HashValue(Key));
+		}
+	}
+
+private:
+	using FSlot = TVoxelAtomic<FElement*>;
+
+	// Slots are allocated right after the table header to save an indirection when probing
+	struct FTable
+	{
+		int32 NumSlots = 0;
+		// Kept alive for readers that loaded it before we grew
+		FTable* PreviousTable = nullptr;
+
+		FORCEINLINE FSlot* GetSlots()
+		{
+			return reinterpret_cast<FSlot*>(this + 1);
+		}
+		FORCEINLINE const FSlot* GetSlots() const
+		{
+			return reinterpret_cast<const FSlot*>(this + 1);
+		}
+
+		FORCEINLINE static int64 GetAllocatedSize(const int32 NumSlots)
+		{
+			return sizeof(FTable) + NumSlots * sizeof(FSlot);
+		}
+
+		static FTable* New(const int32 NumSlots)
+		{
+			checkVoxelSlow(FMath::IsPowerOfTwo(NumSlots));
+
+			void* Memory = FMemory::Malloc(GetAllocatedSize(NumSlots), FMath::Max(alignof(FTable), alignof(FSlot)));
+
+			FTable* Table = new (Memory) FTable();
+			Table->NumSlots = NumSlots;
+
+			for (int32 Index = 0; Index < NumSlots; Index++)
+			{
+				new (&Table->GetSlots()[Index]) FSlot(nullptr);
+			}
+			return Table;
+		}
+	};
+	checkStatic(sizeof(FTable) % alignof(FSlot) == 0);
+
+	class FShard
+	{
+	public:
+		FVoxelCriticalSection CriticalSection;
+		TVoxelAtomic<FTable*> Table;
+		FVoxelCounter32 Num;
+		FVoxelCounter64 AllocatedSize;
+
+		FShard() = default;
+		UE_NONCOPYABLE(FShard);
+
+		~FShard()
+		{
+			Empty();
+		}
+
+		void Empty()
+		{
+			FTable* CurrentTable = Table.Get();
+			if (!CurrentTable)
+			{
+				return;
+			}
+
+			for (int32 Index = 0; Index < CurrentTable->NumSlots; Index++)
+			{
+				if (FElement* Element = CurrentTable->GetSlots()[Index].Get(std::memory_order_relaxed))
+				{
+					delete Element;
+				}
+			}
+
+			while (CurrentTable)
+			{
+				FTable* PreviousTable = CurrentTable->PreviousTable;
+				FMemory::Free(CurrentTable);
+				CurrentTable = PreviousTable;
+			}
+
+			Table.Set(nullptr);
+			Num.Set(0);
+			AllocatedSize.Set(0);
+		}
+
+		FORCEINLINE FElement* Find(const uint64 Hash, const KeyType& Key) const
+		{
+			// Acquire: pairs with the release when publishing a table, so its slots are visible
+			const FTable* CurrentTable = Table.Get(std::memory_order_acquire);
+			if (!CurrentTable)
+			{
+				return nullptr;
+			}
+
+			const FSlot* Slots = CurrentTable->GetSlots();
+			const int32 SlotMask = CurrentTable->NumSlots - 1;
+
+			// Load factor is at most 1/2, so there is always an empty slot to stop at
+			for (int32 SlotIndex = GetSlotIndex(Hash) & SlotMask; ; SlotIndex = (SlotIndex + 1) & SlotMask)
+			{
+				// Acquire: pairs with the release when adding the element, so its key & value are visible
+				FElement* Element = Slots[SlotIndex].Get(std::memory_order_acquire);
+				if (!Element)
+				{
+					return nullptr;
+				}
+				if (Element->Key == Key)
+				{
+					return Element;
+				}
+			}
+		}
+
+		template<typename LambdaType>
+		FORCENOINLINE FElement& FindOrAdd(const uint64 Hash, const KeyType& Key, LambdaType& Construct)
+		{
+			VOXEL_SCOPE_LOCK(CriticalSection);
+
+			// Check again now that we have the lock
+			if (FElement* Element = Find(Hash, Key))
+			{
+				return *Element;
+			}
+
+			FTable* CurrentTable = Table.Get(std::memory_order_relaxed);
+			const int32 NewNum = Num.Get(std::memory_order_relaxed) + 1;
+
+			if (!CurrentTable ||
+				2 * NewNum > CurrentTable->NumSlots)
+			{
+				CurrentTable = Grow(CurrentTable);
+			}
+
+			FElement* Element = new FElement(Key, Construct);
+
+			FSlot* Slots = CurrentTable->GetSlots();
+			const int32 SlotMask = CurrentTable->NumSlots - 1;
+
+			int32 SlotIndex = GetSlotIndex(Hash) & SlotMask;
+			while (Slots[SlotIndex].Get(std::memory_order_relaxed))
+			{
+				SlotIndex = (SlotIndex + 1) & SlotMask;
+			}
+
+			Slots[SlotIndex].Set(Element, std::memory_order_release);
+
+			Num.Set(NewNum, std::memory_order_relaxed);
+			AllocatedSize.Add(sizeof(FElement), std::memory_order_relaxed);
+
+			return *Element;
+		}
+
+	private:
+		FTable* Grow(FTable* OldTable)
+		{
+			VOXEL_FUNCTION_COUNTER();
+
+			const int32 NewNumSlots = OldTable ? 2 * OldTable->NumSlots : 16;
+
+			FTable* NewTable = FTable::New(NewNumSlots);
+			NewTable->PreviousTable = OldTable;
+
+			if (OldTable)
+			{
+				FSlot* NewSlots = NewTable->GetSlots();
+				const int32 NewSlotMask = NewNumSlots - 1;
+
+				for (int32 Index = 0; Index < OldTable->NumSlots; Index++)
+				{
+					FElement* Element = OldTable->GetSlots()[Index].Get(std::memory_order_relaxed);
+					if (!Element)
+					{
+						continue;
+					}
+
+					int32 SlotIndex = GetSlotIndex(HashValue(Element->Key)) & NewSlotMask;
+					while (NewSlots[SlotIndex].Get(std::memory_order_relaxed))
+					{
+						SlotIndex = (SlotIndex + 1) & NewSlotMask;
+					}
+					NewSlots[SlotIndex].Set(Element, std::memory_order_relaxed);
+				}
+			}
+
+			// Release: readers acquiring the new table see all the slots we just wrote
+			Table.Set(NewTable, std::memory_order_release);
+			AllocatedSize.Add(FTable::GetAllocatedSize(NewNumSlots), std::memory_order_relaxed);
+
+			return NewTable;
+		}
+	};
+
+	TVoxelStaticArray<FShard, NumShards> Shards;
+
+	// Shard uses the high bits, slot the low bits, so that they're independent
+	FORCEINLINE static int32 GetShardIndex(const uint64 Hash)
+	{
+		return int32(Hash >> (64 - NumShardsLog2));
+	}
+	FORCEINLINE static int32 GetSlotIndex(const uint64 Hash)
+	{
+		return int32(Hash & MAX_int32);
+	}
+};
@@ -0,0 +1,377 @@
+// Copyright Voxel Plugin SAS. All Rights Reserved.
+
+#pragma once
+
+#include "VoxelCoreMinimal.h"
+#include "VoxelMinimal/Containers/VoxelArray.h"
+#include "VoxelMinimal/Utilities/VoxelHashUtilities.h"
+#include "VoxelMinimal/Utilities/VoxelArrayUtilities.h"
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#define VOXEL_FLAT_HASH_NEON 1
+#define VOXEL_FLAT_HASH_SSE2 0
+#elif PLATFORM_ENABLE_VECTORINTRINSICS && PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#define VOXEL_FLAT_HASH_NEON 0
+#define VOXEL_FLAT_HASH_SSE2 1
+#else
+#define VOXEL_FLAT_HASH_NEON 0
+#define VOXEL_FLAT_HASH_SSE2 0
+#endif
+
+// 16 control bytes probed at once
+// A control byte is either Empty, Deleted or the 7 low bits of the hash of the element in that slot
+class FVoxelFlatHashGroup
+{
+public:
+	static constexpr int32 Size = 16;
+
+	static constexpr uint8 Empty = 0x80;
+	static constexpr uint8 Deleted = 0xFE;
+
+	struct FMask
+	{
+#if VOXEL_FLAT_HASH_NEON
+		// 4 bits per lane, only the highest one is kept
+		static constexpr int32 Shift = 2;
+#else
+		static constexpr int32 Shift = 0;
+#endif
+
+		uint64 Bits = 0;
+
+		FORCEINLINE explicit operator bool() const
+		{
+			return Bits != 0;
+		}
+		FORCEINLINE int32 GetLowestIndex() const
+		{
+			checkVoxelSlow(Bits != 0);
+			return int32(FPlatformMath::CountTrailingZeros64(Bits) >> Shift);
+		}
+		FORCEINLINE void ClearLowest()
+		{
+			Bits &= Bits - 1;
+		}
+	};
+
+public:
+	FORCEINLINE explicit FVoxelFlatHashGroup(const uint8* Controls)
+#if VOXEL_FLAT_HASH_NEON
+		: Controls(vld1q_u8(Controls))
+#elif VOXEL_FLAT_HASH_SSE2
+		: Controls(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Controls)))
+#else
+		: Controls(Controls)
+#endif
+	{
+	}
+
+	FORCEINLINE FMask Match(const uint8 Hash) const
+	{
+		checkVoxelSlow(Hash < 0x80);
+
+#if VOXEL_FLAT_HASH_NEON
+		return MakeMask(vceqq_u8(Controls, vdupq_n_u8(Hash)));
+#elif VOXEL_FLAT_HASH_SSE2
+		return FMask{ uint64(_mm_movemask_epi8(_mm_cmpeq_epi8(Controls, _mm_set1_epi8(char(Hash))))) };
+#else
+		FMask Mask;
+		for (int32 Index = 0; Index < Size; Index++)
+		{
+			Mask.Bits |= uint64(Controls[Index] == Hash) << Index;
+		}
+		return Mask;
+#endif
+	}
+	FORCEINLINE FMask MatchEmpty() const
+	{
+#if VOXEL_FLAT_HASH_NEON
+		return MakeMask(vceqq_u8(Controls, vdupq_n_u8(Empty)));
+#elif VOXEL_FLAT_HASH_SSE2
+		return FMask{ uint64(_mm_movemask_epi8(_mm_cmpeq_epi8(Controls, _mm_set1_epi8(char(Empty))))) };
+#else
+		FMask Mask;
+		for (int32 Index = 0; Index < Size; Index++)
+		{
+			Mask.Bits |= uint64(Controls[Index] == Empty) << Index;
+		}
+		return Mask;
+#endif
+	}
+	// Empty and Deleted are the only controls with the high bit set
+	FORCEINLINE FMask MatchEmptyOrDeleted() const
+	{
+#if VOXEL_FLAT_HASH_NEON
+		return MakeMask(vcltq_s8(vreinterpretq_s8_u8(Controls), vdupq_n_s8(0)));
+#elif VOXEL_FLAT_HASH_SSE2
+		return FMask{ uint64(_mm_movemask_epi8(Controls)) };
+#else
+		FMask Mask;
+		for (int32 Index = 0; Index < Size; Index++)
+		{
+			Mask.Bits |= uint64(Controls[Index] >> 7) << Index;
+		}
+		return Mask;
+#endif
+	}
+
+private:
+#if VOXEL_FLAT_HASH_NEON
+	uint8x16_t Controls;
+
+	// No movemask on NEON: narrow each 16-bit lane to 8 bits, giving 4 bits per byte
+	FORCEINLINE static FMask MakeMask(const uint8x16_t Compare)
+	{
+		const uint8x8_t Narrowed = vshrn_n_u16(vreinterpretq_u16_u8(Compare), 4);
+		return FMask{ vget_lane_u64(vreinterpret_u64_u8(Narrowed), 0) & 0x8888888888888888ull };
+	}
+#elif VOXEL_FLAT_HASH_SSE2
+	__m128i Controls;
+#else
+	const uint8* Controls;
+#endif
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Open-addressing index from hashes to element indices, shared by TVoxelFlatMap and TVoxelFlatSet
+// Slots are grouped by FVoxelFlatHashGroup::Size and probed group by group using triangular probing,
+// so a miss usually only touches a single cache line of control bytes
+class FVoxelFlatHashIndex
+{
+public:
+	using FGroup = FVoxelFlatHashGroup;
+
+	FORCEINLINE int32 NumSlots() const
+	{
+		return Slots.Num();
+	}
+	FORCEINLINE int64 GetAllocatedSize() const
+	{
+		return Controls.GetAllocatedSize() + Slots.GetAllocatedSize();
+	}
+
+	void Reset()
+	{
+		Controls.Reset();
+		Slots.Reset();
+		NumTombstones = 0;
+	}
+	void Empty()
+	{
+		Controls.Empty();
+		Slots.Empty();
+		NumTombstones = 0;
+	}
+	void Shrink()
+	{
+		Controls.Shrink();
+		Slots.Shrink();
+	}
+
+public:
+	// Max load factor is 7/8: this ensures we always have at least one empty slot to stop probing
+	FORCEINLINE static int32 GetNumSlots(const int32 NumElements)
+	{
+		if (NumElements == 0)
+		{
+			return 0;
+		}
+
+		const int64 MinNumSlots = FMath::DivideAndRoundUp<int64>(int64(NumElements) * 8, 7) + 1;
+		return FMath::Max<int32>(FGroup::Size, int32(FMath::RoundUpToPowerOfTwo64(MinNumSlots)));
+	}
+	FORCEINLINE static int32 GetMaxNumElements(const int32 NumSlots)
+	{
+		return NumSlots - NumSlots / 8;
+	}
+
+	FORCEINLINE bool CanAdd(const int32 NumElements) const
+	{
+		return NumElements + NumTombstones <= GetMaxNumElements(Slots.Num());
+	}
+
+public:
+	// Returns the slot index of the first element matching IsElement, or -1
+	template<typename LambdaType>
+	FORCEINLINE int32 FindSlot(const uint32 Hash, LambdaType&& IsElement) const
+	{
+		if (Slots.Num() == 0)
+		{
+			return -1;
+		}
+
+		const uint32 MixedHash = MixHash(Hash);
+		const uint8 Control = GetControl(MixedHash);
+		const int32 GroupMask = Slots.Num() / FGroup::Size - 1;
+
+		int32 GroupIndex = GetFirstGroup(MixedHash) & GroupMask;
+		for (int32 Step = 1; ; Step++)
+		{
+			const int32 FirstSlot = GroupIndex * FGroup::Size;
+			const FGroup Group(&Controls[FirstSlot]);
+
+			for (FGroup::FMask Mask = Group.Match(Control); Mask; Mask.ClearLowest())
+			{
+				const int32 SlotIndex = FirstSlot + Mask.GetLowestIndex();
+				if (IsElement(Slots[SlotIndex]))
+				{
+					return SlotIndex;
+				}
+			}
+
+			if (Group.MatchEmpty())
+			{
+				return -1;
+			}
+
+			checkVoxelSlow(Step <= GroupMask + 1);
+			GroupIndex = (GroupIndex + Step) & GroupMask;
+		}
+	}
+	// Returns the index of the first element matching IsElement, or -1
+	template<typename LambdaType>
+	FORCEINLINE int32 Find(const uint32 Hash, LambdaType&& IsElement) const
+	{
+		const int32 SlotIndex = this->FindSlot(Hash, IsElement);
+		if (SlotIndex == -1)
+		{
+			return -1;
+		}
+		return Slots[SlotIndex];
+	}
+	FORCEINLINE int32 FindSlotChecked(const uint32 Hash, const int32 ElementIndex) const
+	{
+		const int32 SlotIndex = this->FindSlot(Hash, [&](const int32 OtherElementIndex)
+		{
+			return OtherElementIndex == ElementIndex;
+		});
+		checkVoxelSlow(SlotIndex != -1);
+		return SlotIndex;
+	}
+
+	FORCEINLINE int32 GetElementIndex(const int32 SlotIndex) const
+	{
+		return Slots[SlotIndex];
+	}
+	FORCEINLINE void SetElementIndex(const int32 SlotIndex, const int32 ElementIndex)
+	{
+		checkVoxelSlow(!(Controls[SlotIndex] & 0x80));
+		Slots[SlotIndex] = ElementIndex;
+	}
+
+public:
+	FORCEINLINE void Add_CheckNoRehash(const uint32 Hash, const int32 ElementIndex)
+	{
+		checkVoxelSlow(Slots.Num() > 0);
+		checkVoxelSlow(CanAdd(ElementIndex + 1));
+
+		const uint32 MixedHash = MixHash(Hash);
+		const int32 GroupMask = Slots.Num() / FGroup::Size - 1;
+
+		int32 GroupIndex = GetFirstGroup(MixedHash) & GroupMask;
+		for (int32 Step = 1; ; Step++)
+		{
+			const int32 FirstSlot = GroupIndex * FGroup::Size;
+			const FGroup::FMask Mask = FGroup(&Controls[FirstSlot]).MatchEmptyOrDeleted();
+
+			if (Mask)
+			{
+				const int32 SlotIndex = FirstSlot + Mask.GetLowestIndex();
+				if (Controls[SlotIndex] == FGroup::Deleted)
+				{
+					NumTombstones--;
+				}
+
+				Controls[SlotIndex] = GetControl(MixedHash);
+				Slots[SlotIndex] = ElementIndex;
+				return;
+			}
+
+			checkVoxelSlow(Step <= GroupMask + 1);
+			GroupIndex = (GroupIndex + Step) & GroupMask;
+		}
+	}
+	FORCEINLINE void RemoveSlot(const int32 SlotIndex)
+	{
+		checkVoxelSlow(!(Controls[SlotIndex] & 0x80));
+
+		// If the group still has an empty slot no probe ever went past it,
+		// so we can free the slot instead of leaving a tombstone
+		const int32 FirstSlot = SlotIndex & ~(FGroup::Size - 1);
+		if (FGroup(&Controls[FirstSlot]).MatchEmpty())
+		{
+			Controls[SlotIndex] = FGroup::Empty;
+		}
+		else
+		{
+			Controls[SlotIndex] = FGroup::Deleted;
+			NumTombstones++;
+		}
+	}
+
+public:
+	// GetHash(ElementIndex) should return the hash of the element at ElementIndex
+	template<typename LambdaType>
+	FORCENOINLINE void Rehash(const int32 NewNumSlots, const int32 NumElements, LambdaType&& GetHash)
+	{
+		VOXEL_FUNCTION_COUNTER_NUM(NumElements, 1024);
+		checkVoxelSlow(NewNumSlots == 0 || FMath::IsPowerOfTwo(NewNumSlots));
+		checkVoxelSlow(NewNumSlots % FGroup::Size == 0);
+		checkVoxelSlow(NumElements <= GetMaxNumElements(NewNumSlots));
+
+		Controls.Reset();
+		Slots.Reset();
+		NumTombstones = 0;
+
+		FVoxelUtilities::SetNumFast(Controls, NewNumSlots);
+		FVoxelUtilities::SetNumFast(Slots, NewNumSlots);
+		FVoxelUtilities::Memset(Controls, FGroup::Empty);
+
+		for (int32 Index = 0; Index < NumElements; Index++)
+		{
+			this->Add_CheckNoRehash(GetHash(Index), Index);
+		}
+	}
+	// Called when an add fails CanAdd
+	// If we're mostly tombstones, rehash in place instead of growing
+	template<typename LambdaType>
+	FORCENOINLINE void Grow(const int32 NumElements, LambdaType&& GetHash)
+	{
+		int32 NewNumSlots = GetNumSlots(NumElements);
+		if (NumElements > GetMaxNumElements(Slots.Num()) / 2)
+		{
+			NewNumSlots = FMath::Max(NewNumSlots, 2 * Slots.Num());
+		}
+		else
+		{
+			NewNumSlots = FMath::Max(NewNumSlots, Slots.Num());
+		}
+
+		this->Rehash(NewNumSlots, NumElements, GetHash);
+	}
+
+private:
+	TVoxelArray<uint8> Controls;
+	TVoxelArray<int32> Slots;
+	int32 NumTombstones = 0;
+
+	// FVoxelUtilities::HashValue is the identity for integers: mix it so that both
+	// the group index (high bits) and the control (low 7 bits) are well distributed
+	FORCEINLINE static uint32 MixHash(const uint32 Hash)
+	{
+		return FVoxelUtilities::MurmurHash32(Hash);
+	}
+	FORCEINLINE static uint8 GetControl(const uint32 MixedHash)
+	{
+		return MixedHash & 0x7F;
+	}
+	FORCEINLINE static int32 GetFirstGroup(const uint32 MixedHash)
+	{
+		return int32(MixedHash >> 7);
+	}
+};
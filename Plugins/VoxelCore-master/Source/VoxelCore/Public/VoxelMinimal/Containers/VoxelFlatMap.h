@@ -0,0 +1,658 @@
+// Copyright Voxel Plugin SAS. All Rights Reserved.
+
+#pragma once
+
+#include "VoxelCoreMinimal.h"
+#include "VoxelMinimal/Containers/VoxelSet.h"
+#include "VoxelMinimal/Containers/VoxelArray.h"
+#include "VoxelMinimal/Containers/VoxelFlatHashTable.h"
+#include "VoxelMinimal/Utilities/VoxelTypeUtilities.h"
+#include "VoxelMinimal/Utilities/VoxelHashUtilities.h"
+
+template<typename KeyType, typename ValueType>
+struct TVoxelFlatMapElement
+{
+public:
+	const KeyType Key;
+	ValueType Value;
+
+	TVoxelFlatMapElement() = default;
+
+	template<typename InValueType>
+	FORCEINLINE TVoxelFlatMapElement(
+		const KeyType& Key,
+		InValueType&& Value)
+		: Key(Key)
+		, Value(Forward<InValueType>(Value))
+	{
+	}
+
+private:
+	FORCEINLINE void MoveFrom(TVoxelFlatMapElement&& Other)
+	{
+		const_cast<KeyType&>(Key) = MoveTemp(const_cast<KeyType&>(Other.Key));
+		Value = MoveTemp(Other.Value);
+	}
+
+	FORCEINLINE friend FArchive& operator<<(FArchive& Ar, TVoxelFlatMapElement& Element)
+	{
+		Ar << const_cast<KeyType&>(Element.Key);
+		Ar << Element.Value;
+		return Ar;
+	}
+
+	template<typename, typename>
+	friend class TVoxelFlatMap;
+};
+
+// Same API as TVoxelMap, but the hash table is a Swiss-table-style open-addressing index
+// probed 16 slots at a time with SSE2/NEON (see FVoxelFlatHashIndex)
+// Elements are still stored densely, so iteration, sorting and removal behave exactly like TVoxelMap
+//
+// Prefer this over TVoxelMap for miss-heavy lookups: TVoxelMap has to walk the NextElementIndex chain
+// through the elements array, while a miss here is usually resolved by a single group of control bytes
+template<typename KeyType, typename ValueType>
+class TVoxelFlatMap
+{
+public:
+	using FElement = TVoxelFlatMapElement<KeyType, ValueType>;
+
+	TVoxelFlatMap() = default;
+	TVoxelFlatMap(const TVoxelFlatMap&) = default;
+	TVoxelFlatMap& operator=(const TVoxelFlatMap&) = default;
+
+	TVoxelFlatMap(TVoxelFlatMap&& Other)
+		: HashIndex(MoveTemp(Other.HashIndex))
+		, Elements(MoveTemp(Other.Elements))
+	{
+		Other.Reset();
+	}
+	TVoxelFlatMap& operator=(TVoxelFlatMap&& Other)
+	{
+		HashIndex = MoveTemp(Other.HashIndex);
+		Elements = MoveTemp(Other.Elements);
+		Other.Reset();
+		return *this;
+	}
+
+	TVoxelFlatMap(std::initializer_list<TPairInitializer<const KeyType&, const ValueType&>> Initializer)
+	{
+		this->Reserve(Initializer.size());
+
+		for (const TPairInitializer<const KeyType&, const ValueType&>& Element : Initializer)
+		{
+			this->FindOrAdd(Element.Key) = Element.Value;
+		}
+	}
+
+public:
+	FORCEINLINE int32 Num() const
+	{
+		return Elements.Num();
+	}
+	FORCEINLINE int64 GetAllocatedSize() const
+	{
+		return HashIndex.GetAllocatedSize() + Elements.GetAllocatedSize();
+	}
+	FORCEINLINE TVoxelArrayView<FElement> GetElements()
+	{
+		return Elements;
+	}
+	FORCEINLINE TConstVoxelArrayView<FElement> GetElements() const
+	{
+		return Elements;
+	}
+
+	void Reset()
+	{
+		Elements.Reset();
+		HashIndex.Reset();
+	}
+	void Reset_KeepHashSize()
+	{
+		Elements.Reset();
+		Rehash();
+	}
+	void Empty()
+	{
+		Elements.Empty();
+		HashIndex.Empty();
+	}
+	void Shrink()
+	{
+		VOXEL_FUNCTION_COUNTER();
+
+		if (HashIndex.NumSlots() != FVoxelFlatHashIndex::GetNumSlots(Num()))
+		{
+			checkVoxelSlow(HashIndex.NumSlots() > FVoxelFlatHashIndex::GetNumSlots(Num()));
+
+			HashIndex.Reset();
+			Rehash();
+		}
+
+		HashIndex.Shrink();
+		Elements.Shrink();
+	}
+	void Reserve(const int32 Number)
+	{
+		if (Number <= Elements.Num())
+		{
+			return;
+		}
+
+		VOXEL_FUNCTION_COUNTER_NUM(Number, 1024);
+
+		Elements.Reserve(Number);
+
+		if (HashIndex.NumSlots() < FVoxelFlatHashIndex::GetNumSlots(Number))
+		{
+			HashIndex.Rehash(FVoxelFlatHashIndex::GetNumSlots(Number), Elements.Num(), GetHashLambda());
+		}
+	}
+	void ReserveGrow(const int32 Number)
+	{
+		Reserve(Num() + Number);
+	}
+
+	void Append(const TVoxelFlatMap& Other)
+	{
+		VOXEL_FUNCTION_COUNTER_NUM(Other.Num(), 1024);
+
+		this->ReserveGrow(Other.Num());
+
+		for (const FElement& Element : Other.Elements)
+		{
+			const uint32 Hash = this->HashValue(Element.Key);
+
+			if (ValueType* Value = this->FindHashed(Hash, Element.Key))
+			{
+				*Value = Element.Value;
+			}
+			else
+			{
+				this->AddHashed_CheckNew_CheckNoRehash(Hash, Element.Key, Element.Value);
+			}
+		}
+	}
+	TVoxelArray<KeyType> KeyArray() const
+	{
+		VOXEL_FUNCTION_COUNTER_NUM(Num(), 1024);
+
+		TVoxelArray<KeyType> Result;
+		Result.Reserve(Elements.Num());
+		for (const FElement& Element : Elements)
+		{
+			Result.Add_CheckNoGrow(Element.Key);
+		}
+		return Result;
+	}
+	TVoxelArray<ValueType> ValueArray() const
+	{
+		VOXEL_FUNCTION_COUNTER_NUM(Num(), 1024);
+
+		TVoxelArray<ValueType> Result;
+		Result.Reserve(Elements.Num());
+		for (const FElement& Element : Elements)
+		{
+			Result.Add_CheckNoGrow(Element.Value);
+		}
+		return Result;
+	}
+	TVoxelSet<KeyType> KeySet() const
+	{
+		VOXEL_FUNCTION_COUNTER_NUM(Num(), 1024);
+
+		TVoxelSet<KeyType> Result;
+		Result.Reserve(Elements.Num());
+		for (const FElement& Element : Elements)
+		{
+			Result.Add_CheckNew(Element.Key);
+		}
+		return Result;
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, TVoxelFlatMap& Map)
+	{
+		Ar << Map.Elements;
+
+		if (Ar.IsLoading())
+		{
+			Map.HashIndex.Reset();
+			Map.Rehash();
+		}
+
+		Map.CheckInvariants();
+		return Ar;
+	}
+
+public:
+	FORCEINLINE ValueType* Find(const KeyType& Key)
+	{
+		return this->FindHashed(this->HashValue(Key), Key);
+	}
+	FORCEINLINE ValueType* FindHashed(const uint32 Hash, const KeyType& Key)
+	{
+		checkVoxelSlow(this->HashValue(Key) == Hash);
+		CheckInvariants();
+
+		const int32 ElementIndex = HashIndex.Find(Hash, [&](const int32 OtherElementIndex)
+		{
+			return Elements[OtherElementIndex].Key == Key;
+		});
+
+		if (ElementIndex == -1)
+		{
+			return nullptr;
+		}
+
+		return &Elements[ElementIndex].Value;
+	}
+	FORCEINLINE const ValueType* Find(const KeyType& Key) const
+	{
+		return ConstCast(this)->Find(Key);
+	}
+	FORCEINLINE const ValueType* FindHashed(const uint32 Hash, const KeyType& Key) const
+	{
+		return ConstCast(this)->FindHashed(Hash, Key);
+	}
+
+	FORCEINLINE ValueType FindRef(const KeyType& Key) const
+	{
+		checkStatic(
+			std::is_trivially_destructible_v<ValueType> ||
+			TIsTWeakPtr_V<ValueType> ||
+			TIsTSharedPtr_V<ValueType> ||
+			// Hack to detect TSharedPtr wrappers like FVoxelFuture
+			sizeof(ValueType) == sizeof(FSharedVoidPtr));
+
+		if (const ValueType* Value = this->Find(Key))
+		{
+			return *Value;
+		}
+		return ValueType();
+	}
+
+	FORCEINLINE ValueType& FindChecked(const KeyType& Key)
+	{
+		ValueType* Value = this->Find(Key);
+		checkVoxelSlow(Value);
+		return *Value;
+	}
+	FORCEINLINE const ValueType& FindChecked(const KeyType& Key) const
+	{
+		return ConstCast(this)->FindChecked(Key);
+	}
+
+	FORCEINLINE bool Contains(const KeyType& Key) const
+	{
+		return this->Find(Key) != nullptr;
+	}
+
+	FORCEINLINE ValueType& operator[](const KeyType& Key)
+	{
+		return this->FindChecked(Key);
+	}
+	FORCEINLINE const ValueType& operator[](const KeyType& Key) const
+	{
+		return this->FindChecked(Key);
+	}
+
+public:
+	template<typename InKeyType>
+	requires
+	(
+		std::is_convertible_v<const InKeyType&, KeyType> &&
+		FVoxelUtilities::CanMakeSafe<ValueType>
+	)
+	FORCEINLINE ValueType& FindOrAdd(const InKeyType& Key)
+	{
+		const uint32 Hash = this->HashValue(Key);
+
+		if (ValueType* Value = this->FindHashed(Hash, Key))
+		{
+			return *Value;
+		}
+
+		return this->AddHashed_CheckNew(Hash, Key, FVoxelUtilities::MakeSafe<ValueType>());
+	}
+
+public:
+	// Will crash if Key is already in the map
+	template<typename InKeyType>
+	requires
+	(
+		std::is_convertible_v<const InKeyType&, KeyType> &&
+		FVoxelUtilities::CanMakeSafe<ValueType>
+	)
+	FORCEINLINE ValueType& Add_CheckNew(const InKeyType& Key)
+	{
+		return this->Add_CheckNew(Key, FVoxelUtilities::MakeSafe<ValueType>());
+	}
+	template<typename InValueType>
+	requires std::is_constructible_v<ValueType, InValueType&&>
+	FORCEINLINE ValueType& Add_CheckNew(const KeyType& Key, InValueType&& Value)
+	{
+		return this->AddHashed_CheckNew(this->HashValue(Key), Key, Forward<InValueType>(Value));
+	}
+
+public:
+	template<typename InKeyType>
+	requires
+	(
+		std::is_convertible_v<const InKeyType&, KeyType> &&
+		FVoxelUtilities::CanMakeSafe<ValueType>
+	)
+	FORCEINLINE ValueType& Add_EnsureNew(const InKeyType& Key)
+	{
+		return this->Add_EnsureNew(Key, FVoxelUtilities::MakeSafe<ValueType>());
+	}
+	template<typename InValueType>
+	requires std::is_constructible_v<ValueType, InValueType&&>
+	FORCEINLINE ValueType& Add_EnsureNew(const KeyType& Key, InValueType&& Value)
+	{
+		const uint32 Hash = this->HashValue(Key);
+
+		if (ValueType* ExistingValue = this->FindHashed(Hash, Key))
+		{
+			ensure(false);
+			return *ExistingValue;
+		}
+
+		return this->AddHashed_CheckNew(Hash, Key, Forward<InValueType>(Value));
+	}
+
+public:
+	template<typename InKeyType>
+	requires
+	(
+		std::is_convertible_v<const InKeyType&, KeyType> &&
+		FVoxelUtilities::CanMakeSafe<ValueType>
+	)
+	FORCEINLINE ValueType& Add_CheckNew_CheckNoRehash(const KeyType& Key)
+	{
+		return this->Add_CheckNew_CheckNoRehash(Key, FVoxelUtilities::MakeSafe<ValueType>());
+	}
+	template<typename InValueType>
+	requires std::is_constructible_v<ValueType, InValueType&&>
+	FORCEINLINE ValueType& Add_CheckNew_CheckNoRehash(const KeyType& Key, InValueType&& Value)
+	{
+		return this->AddHashed_CheckNew_CheckNoRehash(this->HashValue(Key), Key, Forward<InValueType>(Value));
+	}
+
+public:
+	template<typename InValueType>
+	requires std::is_constructible_v<ValueType, InValueType&&>
+	FORCEINLINE ValueType& AddHashed_CheckNew(const uint32 Hash, const KeyType& Key, InValueType&& Value)
+	{
+		checkVoxelSlow(!this->Contains(Key));
+		checkVoxelSlow(this->HashValue(Key) == Hash);
+		CheckInvariants();
+
+		const int32 NewElementIndex = Elements.Emplace(Key, Forward<InValueType>(Value));
+
+		if (HashIndex.CanAdd(Elements.Num()))
+		{
+			HashIndex.Add_CheckNoRehash(Hash, NewElementIndex);
+		}
+		else
+		{
+			HashIndex.Grow(Elements.Num(), GetHashLambda());
+		}
+
+		return Elements[NewElementIndex].Value;
+	}
+	template<typename InValueType>
+	requires std::is_constructible_v<ValueType, InValueType&&>
+	FORCEINLINE ValueType& AddHashed_CheckNew_CheckNoRehash(const uint32 Hash, const KeyType& Key, InValueType&& Value)
+	{
+		checkVoxelSlow(!this->Contains(Key));
+		checkVoxelSlow(this->HashValue(Key) == Hash);
+		CheckInvariants();
+
+		const int32 NewElementIndex = Elements.Emplace_CheckNoGrow(Key, Forward<InValueType>(Value));
+
+		checkVoxelSlow(HashIndex.CanAdd(Elements.Num()));
+		HashIndex.Add_CheckNoRehash(Hash, NewElementIndex);
+
+		return Elements[NewElementIndex].Value;
+	}
+
+public:
+	template<typename PredicateType>
+	FORCENOINLINE void Sort(const PredicateType& Predicate)
+	{
+		VOXEL_FUNCTION_COUNTER_NUM(Num(), 1024);
+
+		Elements.Sort([&](const FElement& A, const FElement& B)
+		{
+			return Predicate(A, B);
+		});
+
+		Rehash();
+	}
+	template<typename PredicateType>
+	FORCENOINLINE void KeySort(const PredicateType& Predicate)
+	{
+		VOXEL_FUNCTION_COUNTER_NUM(Num(), 1024);
+
+		Elements.Sort([&](const FElement& A, const FElement& B)
+		{
+			return Predicate(A.Key, B.Key);
+		});
+
+		Rehash();
+	}
+	template<typename PredicateType>
+	FORCENOINLINE void ValueSort(const PredicateType& Predicate)
+	{
+		VOXEL_FUNCTION_COUNTER_NUM(Num(), 1024);
+
+		Elements.Sort([&](const FElement& A, const FElement& B)
+		{
+			return Predicate(A.Value, B.Value);
+		});
+
+		Rehash();
+	}
+
+	void KeySort()
+	{
+		this->KeySort(TLess<KeyType>());
+	}
+	void ValueSort()
+	{
+		this->ValueSort(TLess<ValueType>());
+	}
+
+public:
+	// Not order-preserving
+	FORCEINLINE bool RemoveAndCopyValue(const KeyType& Key, ValueType& OutRemovedValue)
+	{
+		const uint32 Hash = this->HashValue(Key);
+
+		ValueType* Value = this->FindHashed(Hash, Key);
+		if (!Value)
+		{
+			return false;
+		}
+		OutRemovedValue = MoveTemp(*Value);
+
+		this->RemoveHashedChecked(Hash, Key);
+		return true;
+	}
+
+	// Not order-preserving
+	FORCEINLINE bool Remove(const KeyType& Key)
+	{
+		const uint32 Hash = this->HashValue(Key);
+		if (!this->FindHashed(Hash, Key))
+		{
+			return false;
+		}
+
+		this->RemoveHashedChecked(Hash, Key);
+		return true;
+	}
+	FORCEINLINE void RemoveChecked(const KeyType& Key)
+	{
+		this->RemoveHashedChecked(this->HashValue(Key), Key);
+	}
+	FORCEINLINE void RemoveHashedChecked(const uint32 Hash, const KeyType& Key)
+	{
+		checkVoxelSlow(this->Contains(Key));
+		checkVoxelSlow(this->HashValue(Key) == Hash);
+		CheckInvariants();
+
+		const int32 SlotIndex = HashIndex.FindSlot(Hash, [&](const int32 OtherElementIndex)
+		{
+			return Elements[OtherElementIndex].Key == Key;
+		});
+		checkVoxelSlow(SlotIndex != -1);
+
+		const int32 ElementIndex = HashIndex.GetElementIndex(SlotIndex);
+		HashIndex.RemoveSlot(SlotIndex);
+
+		// If we're the last element just pop
+		if (ElementIndex == Elements.Num() - 1)
+		{
+			Elements.Pop();
+			return;
+		}
+
+		// Otherwise move the last element to our index
+		const int32 LastSlotIndex = HashIndex.FindSlotChecked(this->HashValue(Elements.Last().Key), Elements.Num() - 1);
+		HashIndex.SetElementIndex(LastSlotIndex, ElementIndex);
+		Elements[ElementIndex].MoveFrom(Elements.Pop());
+	}
+
+public:
+	template<bool bConst>
+	struct TIterator
+	{
+		template<typename T>
+		using TType = std::conditional_t<bConst, const T, T>;
+
+		TType<TVoxelFlatMap>* MapPtr = nullptr;
+		TType<FElement>* ElementPtr = nullptr;
+		int32 Index = 0;
+
+		TIterator() = default;
+		FORCEINLINE explicit TIterator(TType<TVoxelFlatMap>& Map)
+			: MapPtr(&Map)
+		{
+			if (Map.Elements.Num() > 0)
+			{
+				ElementPtr = &Map.Elements[0];
+			}
+		}
+
+		FORCEINLINE TIterator& operator++()
+		{
+			Index++;
+			if (Index < MapPtr->Elements.Num())
+			{
+				ElementPtr = &MapPtr->Elements[Index];
+			}
+			else
+			{
+				ElementPtr = nullptr;
+			}
+			return *this;
+		}
+		FORCEINLINE explicit operator bool() const
+		{
+			return ElementPtr != nullptr;
+		}
+		FORCEINLINE TType<FElement>& operator*() const
+		{
+			checkVoxelSlow(ElementPtr);
+			return *ElementPtr;
+		}
+		FORCEINLINE TType<FElement>* operator->() const
+		{
+			checkVoxelSlow(ElementPtr);
+			return ElementPtr;
+		}
+		FORCEINLINE bool operator!=(const TIterator&) const
+		{
+			return ElementPtr != nullptr;
+		}
+
+		FORCEINLINE const KeyType& Key() const
+		{
+			checkVoxelSlow(ElementPtr);
+			return ElementPtr->Key;
+		}
+		FORCEINLINE TType<ValueType>& Value() const
+		{
+			checkVoxelSlow(ElementPtr);
+			return ElementPtr->Value;
+		}
+
+		FORCEINLINE void RemoveCurrent()
+		{
+			MapPtr->RemoveChecked(MakeCopy(Key()));
+			// Check for invalid access
+			ElementPtr = nullptr;
+			Index--;
+		}
+	};
+	using FIterator = TIterator<false>;
+	using FConstIterator = TIterator<true>;
+
+	FORCEINLINE FIterator CreateIterator()
+	{
+		return FIterator(*this);
+	}
+	FORCEINLINE FConstIterator CreateIterator() const
+	{
+		return FConstIterator(*this);
+	}
+
+	FORCEINLINE FIterator begin()
+	{
+		return CreateIterator();
+	}
+	FORCEINLINE FIterator end()
+	{
+		return {};
+	}
+
+	FORCEINLINE FConstIterator begin() const
+	{
+		return CreateIterator();
+	}
+	FORCEINLINE FConstIterator end() const
+	{
+		return {};
+	}
+
+public:
+	FORCEINLINE static uint32 HashValue(const KeyType& Key)
+	{
+		return FVoxelUtilities::HashValue(Key);
+	}
+
+private:
+	FVoxelFlatHashIndex HashIndex;
+	TVoxelArray<FElement> Elements;
+
+	FORCEINLINE void CheckInvariants() const
+	{
+		checkVoxelSlow(Elements.Num() <= FVoxelFlatHashIndex::GetMaxNumElements(HashIndex.NumSlots()));
+	}
+
+	FORCEINLINE auto GetHashLambda() const
+	{
+		return [this](const int32 ElementIndex)
+		{
+			return this->HashValue(Elements[ElementIndex].Key);
+		};
+	}
+
+	FORCENOINLINE void Rehash()
+	{
+		const int32 NewNumSlots = FMath::Max(HashIndex.NumSlots(), FVoxelFlatHashIndex::GetNumSlots(Elements.Num()));
+		HashIndex.Rehash(NewNumSlots, Elements.Num(), GetHashLambda());
+	}
+};
@@ -0,0 +1,367 @@
+// Copyright Voxel Plugin SAS. All Rights Reserved.
+
+#pragma once
+
+#include "VoxelCoreMinimal.h"
+#include "VoxelMinimal/Containers/VoxelSet.h"
+#include "VoxelMinimal/Containers/VoxelArray.h"
+#include "VoxelMinimal/Containers/VoxelArrayView.h"
+#include "VoxelMinimal/Containers/VoxelFlatHashTable.h"
+#include "VoxelMinimal/Utilities/VoxelHashUtilities.h"
+
+// Same API as TVoxelSet, but the hash table is a Swiss-table-style open-addressing index
+// probed 16 slots at a time with SSE2/NEON (see FVoxelFlatHashIndex)
+// Values are stored densely, so indices are stable until a Remove like with TVoxelSet
+template<typename Type>
+class TVoxelFlatSet
+{
+public:
+	TVoxelFlatSet() = default;
+	TVoxelFlatSet(const TVoxelFlatSet&) = default;
+	TVoxelFlatSet& operator=(const TVoxelFlatSet&) = default;
+
+	TVoxelFlatSet(TVoxelFlatSet&& Other)
+		: HashIndex(MoveTemp(Other.HashIndex))
+		, Elements(MoveTemp(Other.Elements))
+	{
+		Other.Reset();
+	}
+	TVoxelFlatSet& operator=(TVoxelFlatSet&& Other)
+	{
+		HashIndex = MoveTemp(Other.HashIndex);
+		Elements = MoveTemp(Other.Elements);
+		Other.Reset();
+		return *this;
+	}
+
+	TVoxelFlatSet(const std::initializer_list<Type> Initializer)
+	{
+		this->Append(MakeVoxelArrayView(Initializer));
+	}
+	explicit TVoxelFlatSet(const TConstVoxelArrayView<Type> Array)
+	{
+		this->Append(Array);
+	}
+
+public:
+	FORCEINLINE int32 Num() const
+	{
+		return Elements.Num();
+	}
+	FORCEINLINE int64 GetAllocatedSize() const
+	{
+		return HashIndex.GetAllocatedSize() + Elements.GetAllocatedSize();
+	}
+	FORCEINLINE TConstVoxelArrayView<Type> GetElements() const
+	{
+		return Elements;
+	}
+
+	void Reset()
+	{
+		Elements.Reset();
+		HashIndex.Reset();
+	}
+	void Empty()
+	{
+		Elements.Empty();
+		HashIndex.Empty();
+	}
+	void Shrink()
+	{
+		VOXEL_FUNCTION_COUNTER();
+
+		if (HashIndex.NumSlots() != FVoxelFlatHashIndex::GetNumSlots(Num()))
+		{
+			checkVoxelSlow(HashIndex.NumSlots() > FVoxelFlatHashIndex::GetNumSlots(Num()));
+
+			HashIndex.Reset();
+			Rehash();
+		}
+
+		HashIndex.Shrink();
+		Elements.Shrink();
+	}
+	void Reserve(const int32 Number)
+	{
+		if (Number <= Elements.Num())
+		{
+			return;
+		}
+
+		VOXEL_FUNCTION_COUNTER_NUM(Number, 1024);
+
+		Elements.Reserve(Number);
+
+		if (HashIndex.NumSlots() < FVoxelFlatHashIndex::GetNumSlots(Number))
+		{
+			HashIndex.Rehash(FVoxelFlatHashIndex::GetNumSlots(Number), Elements.Num(), GetHashLambda());
+		}
+	}
+	void ReserveGrow(const int32 Number)
+	{
+		Reserve(Num() + Number);
+	}
+
+	template<typename PredicateType>
+	void Sort(const PredicateType& Predicate)
+	{
+		VOXEL_FUNCTION_COUNTER_NUM(Num(), 1024);
+
+		Elements.Sort(Predicate);
+
+		Rehash();
+	}
+	void Sort()
+	{
+		this->Sort(TLess<Type>());
+	}
+	// For parity with TVoxelFlatMap::KeySort
+	void KeySort()
+	{
+		this->Sort();
+	}
+
+	void Append(const TConstVoxelArrayView<Type> Array)
+	{
+		VOXEL_FUNCTION_COUNTER_NUM(Array.Num(), 1024);
+
+		this->ReserveGrow(Array.Num());
+
+		for (const Type& Value : Array)
+		{
+			this->Add(Value);
+		}
+	}
+	void Append(const TVoxelFlatSet& Set)
+	{
+		this->Append(Set.GetElements());
+	}
+	TVoxelArray<Type> Array() const
+	{
+		return Elements;
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, TVoxelFlatSet& Set)
+	{
+		Ar << Set.Elements;
+
+		if (Ar.IsLoading())
+		{
+			Set.HashIndex.Reset();
+			Set.Rehash();
+		}
+
+		Set.CheckInvariants();
+		return Ar;
+	}
+
+public:
+	FORCEINLINE const Type& GetValue(const FVoxelSetIndex& Index) const
+	{
+		return Elements[Index];
+	}
+	FORCEINLINE const Type& GetFirstValue() const
+	{
+		return Elements[0];
+	}
+	FORCEINLINE const Type& GetUniqueValue() const
+	{
+		checkVoxelSlow(Elements.Num() == 1);
+		return Elements[0];
+	}
+
+	FORCEINLINE FVoxelSetIndex Find(const Type& Value) const
+	{
+		return this->FindHashed(this->HashValue(Value), Value);
+	}
+	FORCEINLINE FVoxelSetIndex FindHashed(const uint32 Hash, const Type& Value) const
+	{
+		checkVoxelSlow(Hash == this->HashValue(Value));
+		CheckInvariants();
+
+		return HashIndex.Find(Hash, [&](const int32 ElementIndex)
+		{
+			return Elements[ElementIndex] == Value;
+		});
+	}
+
+	FORCEINLINE bool Contains(const Type& Value) const
+	{
+		return this->FindHashed(this->HashValue(Value), Value).IsValid();
+	}
+	FORCEINLINE bool ContainsHashed(const uint32 Hash, const Type& Value) const
+	{
+		return this->FindHashed(Hash, Value).IsValid();
+	}
+	template<typename LambdaType>
+	FORCEINLINE bool Contains(const uint32 Hash, LambdaType Matches) const
+	{
+		CheckInvariants();
+
+		return HashIndex.FindSlot(Hash, [&](const int32 ElementIndex)
+		{
+			return Matches(Elements[ElementIndex]);
+		}) != -1;
+	}
+
+public:
+	FORCEINLINE FVoxelSetIndex Add_CheckNew(const Type& Value)
+	{
+		return this->AddHashed_CheckNew(this->HashValue(Value), Value);
+	}
+	FORCEINLINE FVoxelSetIndex Add_EnsureNew(const Type& Value)
+	{
+		const uint32 Hash = this->HashValue(Value);
+
+		const FVoxelSetIndex Index = this->FindHashed(Hash, Value);
+		if (Index.IsValid())
+		{
+			ensure(false);
+			return Index;
+		}
+
+		return this->AddHashed_CheckNew(Hash, Value);
+	}
+	FORCEINLINE FVoxelSetIndex Add_CheckNew_CheckNoRehash(const Type& Value)
+	{
+		return this->AddHashed_CheckNew_CheckNoRehash(this->HashValue(Value), Value);
+	}
+
+	FORCEINLINE FVoxelSetIndex AddHashed_CheckNew(const uint32 Hash, const Type& Value)
+	{
+		checkVoxelSlow(Hash == this->HashValue(Value));
+		checkVoxelSlow(!this->Contains(Value));
+		CheckInvariants();
+
+		const int32 NewElementIndex = Elements.Add(Value);
+
+		if (HashIndex.CanAdd(Elements.Num()))
+		{
+			HashIndex.Add_CheckNoRehash(Hash, NewElementIndex);
+		}
+		else
+		{
+			HashIndex.Grow(Elements.Num(), GetHashLambda());
+		}
+
+		return NewElementIndex;
+	}
+	FORCEINLINE FVoxelSetIndex AddHashed_CheckNew_CheckNoRehash(const uint32 Hash, const Type& Value)
+	{
+		checkVoxelSlow(Hash == this->HashValue(Value));
+		checkVoxelSlow(!this->Contains(Value));
+		CheckInvariants();
+
+		const int32 NewElementIndex = Elements.Add_CheckNoGrow(Value);
+
+		checkVoxelSlow(HashIndex.CanAdd(Elements.Num()));
+		HashIndex.Add_CheckNoRehash(Hash, NewElementIndex);
+
+		return NewElementIndex;
+	}
+
+	FORCEINLINE FVoxelSetIndex Add(const Type& Value)
+	{
+		bool bIsInSet = false;
+		return this->FindOrAdd(Value, bIsInSet);
+	}
+	FORCEINLINE FVoxelSetIndex FindOrAdd(const Type& Value, bool& bIsInSet)
+	{
+		const uint32 Hash = this->HashValue(Value);
+
+		const FVoxelSetIndex Index = this->FindHashed(Hash, Value);
+		if (Index.IsValid())
+		{
+			bIsInSet = true;
+			return Index;
+		}
+
+		bIsInSet = false;
+		return this->AddHashed_CheckNew(Hash, Value);
+	}
+
+public:
+	// Not order-preserving
+	FORCEINLINE bool Remove(const Type& Value)
+	{
+		const uint32 Hash = this->HashValue(Value);
+		if (!this->ContainsHashed(Hash, Value))
+		{
+			return false;
+		}
+
+		this->RemoveHashedChecked(Hash, Value);
+		return true;
+	}
+	FORCEINLINE void RemoveChecked(const Type& Value)
+	{
+		this->RemoveHashedChecked(this->HashValue(Value), Value);
+	}
+	FORCEINLINE void RemoveHashedChecked(const uint32 Hash, const Type& Value)
+	{
+		checkVoxelSlow(this->Contains(Value));
+		checkVoxelSlow(this->HashValue(Value) == Hash);
+		CheckInvariants();
+
+		const int32 SlotIndex = HashIndex.FindSlot(Hash, [&](const int32 ElementIndex)
+		{
+			return Elements[ElementIndex] == Value;
+		});
+		checkVoxelSlow(SlotIndex != -1);
+
+		const int32 ElementIndex = HashIndex.GetElementIndex(SlotIndex);
+		HashIndex.RemoveSlot(SlotIndex);
+
+		// If we're the last element just pop
+		if (ElementIndex == Elements.Num() - 1)
+		{
+			Elements.Pop();
+			return;
+		}
+
+		// Otherwise move the last element to our index
+		const int32 LastSlotIndex = HashIndex.FindSlotChecked(this->HashValue(Elements.Last()), Elements.Num() - 1);
+		HashIndex.SetElementIndex(LastSlotIndex, ElementIndex);
+		Elements[ElementIndex] = Elements.Pop();
+	}
+
+public:
+	FORCEINLINE auto begin() const
+	{
+		return Elements.begin();
+	}
+	FORCEINLINE auto end() const
+	{
+		return Elements.end();
+	}
+
+public:
+	FORCEINLINE static uint32 HashValue(const Type& Value)
+	{
+		return FVoxelUtilities::HashValue(Value);
+	}
+
+private:
+	FVoxelFlatHashIndex HashIndex;
+	TVoxelArray<Type> Elements;
+
+	FORCEINLINE void CheckInvariants() const
+	{
+		checkVoxelSlow(Elements.Num() <= FVoxelFlatHashIndex::GetMaxNumElements(HashIndex.NumSlots()));
+	}
+
+	FORCEINLINE auto GetHashLambda() const
+	{
+		return [this](const int32 ElementIndex)
+		{
+			return this->HashValue(Elements[ElementIndex]);
+		};
+	}
+
+	FORCENOINLINE void Rehash()
+	{
+		const int32 NewNumSlots = FMath::Max(HashIndex.NumSlots(), FVoxelFlatHashIndex::GetNumSlots(Elements.Num()));
+		HashIndex.Rehash(NewNumSlots, Elements.Num(), GetHashLambda());
+	}
+};
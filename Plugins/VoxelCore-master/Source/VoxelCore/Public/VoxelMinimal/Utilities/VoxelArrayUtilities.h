@@ -571,4 +571,13 @@ namespace FVoxelUtilities
 		TConstVoxelArrayView64<uint8> CompressedData,
 		TVoxelArray64<uint8>& OutData,
 		bool bAllowParallel = true);
+
+	// Returns -1 if CompressedData is not valid compressed data
+	VOXELCORE_API int64 GetDecompressedSize(TConstVoxelArrayView64<uint8> CompressedData);
+
+	// OutData.Num() must be GetDecompressedSize(CompressedData)
+	VOXELCORE_API bool Decompress(
+		TConstVoxelArrayView64<uint8> CompressedData,
+		TVoxelArrayView64<uint8> OutData,
+		bool bAllowParallel = true);
 }
\ No newline at end of file
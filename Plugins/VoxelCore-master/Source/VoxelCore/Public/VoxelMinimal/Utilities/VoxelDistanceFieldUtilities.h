@@ -6,6 +6,8 @@
 #include "VoxelMinimal/Containers/VoxelArray.h"
 #include "VoxelMinimal/Containers/VoxelArrayView.h"
 
+struct FVoxelIntBox;
+
 namespace FVoxelUtilities
 {
 	FORCEINLINE FLinearColor GetDistanceFieldColor(const float Value)
@@ -106,4 +108,36 @@ namespace FVoxelUtilities
 	VOXELCORE_API void JumpFlood(
 		const FIntVector& Size,
 		TVoxelArrayView<float> Distances);
+
+	// Same inputs & outputs as JumpFlood, computed with a separable Euclidean distance transform
+	// (Felzenszwalb & Huttenlocher): one lower envelope of parabolas per row, column and slice
+	// Exact for voxel-aligned seeds, and only uses a single set of closest point buffers instead of two
+	VOXELCORE_API void EuclideanDistanceTransform(
+		const FIntVector& Size,
+		TVoxelArrayView<float> Distances,
+		TVoxelArray<float>& OutClosestX,
+		TVoxelArray<float>& OutClosestY,
+		TVoxelArray<float>& OutClosestZ);
+
+	VOXELCORE_API void EuclideanDistanceTransform(
+		const FIntVector& Size,
+		TVoxelArrayView<float> Distances);
+
+	// Updates the output of EuclideanDistanceTransform after the input distances changed inside DirtyBox
+	// Only voxels within MaxDistance of the edit are recomputed, so the cost depends on the edit size & not on the volume size
+	// InputDistances are the new input distances, as they would be given to a full EuclideanDistanceTransform
+	// Distances and Closest are the previous outputs, and are updated in place
+	// MaxDistance must be an upper bound of the absolute previous distances, eg GetAbsMaxSafe(Distances) after the full transform,
+	// or MAX_flt if the previous output had no seeds. It is kept an upper bound of the new distances
+	// Voxels are solved in a box with two voxels of slack so that seeds outside it don't change the separable passes' winners
+	// As the passes are only approximate for sub-voxel seeds, equality with a full transform is expected but not guaranteed
+	VOXELCORE_API void UpdateEuclideanDistanceTransform(
+		const FIntVector& Size,
+		TConstVoxelArrayView<float> InputDistances,
+		const FVoxelIntBox& DirtyBox,
+		TVoxelArrayView<float> Distances,
+		TVoxelArrayView<float> ClosestX,
+		TVoxelArrayView<float> ClosestY,
+		TVoxelArrayView<float> ClosestZ,
+		float& MaxDistance);
 }
\ No newline at end of file
@@ -112,6 +112,10 @@ public:
 		return *this;
 	}
 
+	// Returns the next Num bytes without copying them and skips them
+	// The view points into the bytes passed to the constructor
+	TConstVoxelArrayView64<uint8> ReadView(int64 Num);
+
 private:
 	class VOXELCORE_API FArchiveImpl final : public FMemoryArchive
 	{
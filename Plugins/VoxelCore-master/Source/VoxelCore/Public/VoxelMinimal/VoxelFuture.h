@@ -10,6 +10,7 @@
 class FVoxelFuture;
 class FVoxelPromise;
 class FVoxelPromiseState;
+class FVoxelPromiseStatePtr;
 class FVoxelTaskContext;
 
 template<typename>
@@ -17,6 +18,11 @@ class TVoxelFuture;
 template<typename>
 class TVoxelPromise;
 
+// voxel.PoolPromises
+extern VOXELCORE_API bool GVoxelPoolPromises;
+// Number of promise states & continuations allocated from the heap rather than from a free list
+extern VOXELCORE_API FVoxelCounter64 GVoxelNumPromiseHeapAllocations;
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -81,6 +87,61 @@ enum class EVoxelFutureThread : uint8
 	AsyncThread,
 };
 
+// Only used by AsyncThread tasks: higher priorities are launched first once the task context has too many tasks in flight
+enum class EVoxelTaskPriority : uint8
+{
+	Low,
+	Normal,
+	High,
+};
+
+class FVoxelTaskPriority
+{
+public:
+	EVoxelTaskPriority Class = EVoxelTaskPriority::Normal;
+
+	// Within a class, tasks with a higher value are launched first
+	// Tasks with a value of 0 and no GetValue are launched in FIFO order
+	double Value = 0;
+
+	// If set, overrides Value and is re-evaluated while the task is queued, eg to use the current distance to the viewer
+	// Called without any task context lock held, from any thread: must be thread safe
+	TVoxelUniqueFunction<double()> GetValue;
+
+	FVoxelTaskPriority() = default;
+	FVoxelTaskPriority(const EVoxelTaskPriority Class)
+		: Class(Class)
+	{
+	}
+	FVoxelTaskPriority(
+		const EVoxelTaskPriority Class,
+		const double Value)
+		: Class(Class)
+		, Value(Value)
+	{
+	}
+	FVoxelTaskPriority(
+		const EVoxelTaskPriority Class,
+		TVoxelUniqueFunction<double()> GetValue)
+		: Class(Class)
+		, GetValue(MoveTemp(GetValue))
+	{
+	}
+
+	FORCEINLINE bool IsFIFO() const
+	{
+		return
+			Value == 0 &&
+			!GetValue;
+	}
+	FORCEINLINE bool IsDefault() const
+	{
+		return
+			Class == EVoxelTaskPriority::Normal &&
+			IsFIFO();
+	}
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -88,14 +149,27 @@ enum class EVoxelFutureThread : uint8
 class VOXELCORE_API IVoxelPromiseState
 {
 public:
-	static TSharedRef<IVoxelPromiseState> New(
+	static FVoxelPromiseStatePtr New(
 		FVoxelTaskContext* ContextOverride,
 		bool bWithValue);
 
-	static TSharedRef<IVoxelPromiseState> New(const FSharedVoidRef& Value);
+	static FVoxelPromiseStatePtr New(const FSharedVoidRef& Value);
 
 	UE_NONCOPYABLE(IVoxelPromiseState);
 
+public:
+	FORCEINLINE void AddRef()
+	{
+		NumRefs.Increment(std::memory_order_relaxed);
+	}
+	FORCEINLINE void Release()
+	{
+		if (NumRefs.Decrement_ReturnNew(std::memory_order_acq_rel) == 0)
+		{
+			Destroy();
+		}
+	}
+
 public:
 	FORCEINLINE bool IsComplete() const
 	{
@@ -130,6 +204,8 @@ protected:
 	TVoxelAtomic<bool> bIsComplete;
 	TVoxelAtomic<bool> bIsLocked;
 	int32 KeepAliveIndex = -1;
+	// Intrusive refcount, see FVoxelPromiseStatePtr
+	FVoxelCounter32 NumRefs = 1;
 	FSharedVoidPtr Value;
 
 	FORCEINLINE explicit IVoxelPromiseState(const bool bHasValue)
@@ -137,9 +213,103 @@ protected:
 	{
 	}
 
+	void Destroy();
+
 	friend FVoxelPromiseState;
 };
-checkStatic(sizeof(IVoxelPromiseState) == 24);
+checkStatic(sizeof(IVoxelPromiseState) == 32);
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Promise states are pooled and refcounted intrusively, avoiding a TSharedPtr control block per promise
+class FVoxelPromiseStatePtr
+{
+public:
+	FVoxelPromiseStatePtr() = default;
+
+	FORCEINLINE FVoxelPromiseStatePtr(const FVoxelPromiseStatePtr& Other)
+		: State(Other.State)
+	{
+		if (State)
+		{
+			State->AddRef();
+		}
+	}
+	FORCEINLINE FVoxelPromiseStatePtr(FVoxelPromiseStatePtr&& Other)
+		: State(Other.State)
+	{
+		Other.State = nullptr;
+	}
+	FORCEINLINE ~FVoxelPromiseStatePtr()
+	{
+		if (State)
+		{
+			State->Release();
+		}
+	}
+
+	FORCEINLINE FVoxelPromiseStatePtr& operator=(const FVoxelPromiseStatePtr& Other)
+	{
+		FVoxelPromiseStatePtr Copy(Other);
+		Swap(State, Copy.State);
+		return *this;
+	}
+	FORCEINLINE FVoxelPromiseStatePtr& operator=(FVoxelPromiseStatePtr&& Other)
+	{
+		FVoxelPromiseStatePtr Copy(MoveTemp(Other));
+		Swap(State, Copy.State);
+		return *this;
+	}
+
+public:
+	// Takes ownership of the initial reference of a new state
+	FORCEINLINE static FVoxelPromiseStatePtr Adopt(IVoxelPromiseState& State)
+	{
+		FVoxelPromiseStatePtr Result;
+		Result.State = &State;
+		return Result;
+	}
+	FORCEINLINE static FVoxelPromiseStatePtr AddRef(IVoxelPromiseState& State)
+	{
+		State.AddRef();
+		return Adopt(State);
+	}
+
+public:
+	FORCEINLINE bool IsValid() const
+	{
+		return State != nullptr;
+	}
+	FORCEINLINE explicit operator bool() const
+	{
+		return IsValid();
+	}
+	FORCEINLINE bool operator!() const
+	{
+		return !IsValid();
+	}
+
+	FORCEINLINE IVoxelPromiseState* Get() const
+	{
+		return State;
+	}
+	FORCEINLINE IVoxelPromiseState* operator->() const
+	{
+		checkVoxelSlow(State);
+		return State;
+	}
+	FORCEINLINE IVoxelPromiseState& operator*() const
+	{
+		checkVoxelSlow(State);
+		return *State;
+	}
+
+private:
+	IVoxelPromiseState* State = nullptr;
+};
+checkStatic(sizeof(FVoxelPromiseStatePtr) == sizeof(void*));
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -212,12 +382,39 @@ public:
 		});
 		return Promise;
 	}
+	template<typename LambdaType, typename ReturnType = LambdaReturnType_T<LambdaType>>
+	requires LambdaHasSignature_V<LambdaType, ReturnType()>
+	static FORCEINLINE TVoxelFutureType<ReturnType> Execute(
+		const EVoxelFutureThread Thread,
+		FVoxelTaskPriority Priority,
+		LambdaType Lambda)
+	{
+		TVoxelPromiseType<ReturnType> Promise;
+		FVoxelFuture::ExecuteImpl(Thread, MoveTemp(Priority), [Lambda = MoveTemp(Lambda), Promise]
+		{
+			if constexpr (std::is_void_v<ReturnType>)
+			{
+				Lambda();
+				Promise.Set();
+			}
+			else
+			{
+				Promise.Set(Lambda());
+			}
+		});
+		return Promise;
+	}
 
-private:
+protected:
 	static void ExecuteImpl(
 		EVoxelFutureThread Thread,
 		TVoxelUniqueFunction<void()> Lambda);
 
+	static void ExecuteImpl(
+		EVoxelFutureThread Thread,
+		FVoxelTaskPriority Priority,
+		TVoxelUniqueFunction<void()> Lambda);
+
 public:
 	FORCEINLINE bool IsComplete() const
 	{
@@ -253,6 +450,37 @@ public:
 		});
 		return Promise;
 	}
+	template<typename LambdaType, typename ReturnType = LambdaReturnType_T<LambdaType>>
+	requires LambdaHasSignature_V<LambdaType, ReturnType()>
+	FORCEINLINE TVoxelFutureType<ReturnType> Then(
+		const EVoxelFutureThread Thread,
+		FVoxelTaskPriority Priority,
+		LambdaType Continuation) const
+	{
+		if (IsComplete())
+		{
+			return Execute(Thread, MoveTemp(Priority), MoveTemp(Continuation));
+		}
+
+		// Continuations don't store a priority: go through AnyThread and dispatch from there
+		TVoxelPromiseType<ReturnType> Promise;
+		PromiseState->AddContinuation(EVoxelFutureThread::AnyThread, [Thread, Priority = MoveTemp(Priority), Promise, Continuation = MoveTemp(Continuation)]() mutable
+		{
+			FVoxelFuture::ExecuteImpl(Thread, MoveTemp(Priority), [Promise, Continuation = MoveTemp(Continuation)]
+			{
+				if constexpr (std::is_void_v<ReturnType>)
+				{
+					Continuation();
+					Promise.Set();
+				}
+				else
+				{
+					Promise.Set(Continuation());
+				}
+			});
+		});
+		return Promise;
+	}
 
 #define Define(Thread, Suffix) \
 	template<typename LambdaType, typename ReturnType = LambdaReturnType_T<LambdaType>> \
@@ -291,11 +519,12 @@ public:
 	}
 
 protected:
-	TSharedPtr<IVoxelPromiseState> PromiseState;
+	FVoxelPromiseStatePtr PromiseState;
 
-	FORCEINLINE explicit FVoxelFuture(const TSharedRef<IVoxelPromiseState>& PromiseState)
-		: PromiseState(PromiseState)
+	FORCEINLINE explicit FVoxelFuture(FVoxelPromiseStatePtr PromiseState)
+		: PromiseState(MoveTemp(PromiseState))
 	{
+		checkVoxelSlow(this->PromiseState);
 	}
 
 	template<typename>
@@ -304,6 +533,7 @@ protected:
 	friend FVoxelPromise;
 	friend FVoxelPromiseState;
 	friend IVoxelPromiseState;
+	friend class FVoxelFutureAwaiter;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -416,6 +646,58 @@ public:
 		});
 		return Promise;
 	}
+	template<typename LambdaType, typename ReturnType = LambdaReturnType_T<LambdaType>>
+	requires
+	(
+		LambdaHasSignature_V<LambdaType, ReturnType(TSharedRef<T>)> ||
+		LambdaHasSignature_V<LambdaType, ReturnType(const TSharedRef<T>&)> ||
+		LambdaHasSignature_V<LambdaType, ReturnType(const T&)> ||
+		LambdaHasSignature_V<LambdaType, ReturnType(T&)> ||
+		LambdaHasSignature_V<LambdaType, ReturnType(T)>
+	)
+	FORCEINLINE TVoxelFutureType<ReturnType> Then(
+		const EVoxelFutureThread Thread,
+		FVoxelTaskPriority Priority,
+		LambdaType Continuation) const
+	{
+		// Continuations don't store a priority: go through AnyThread and dispatch from there
+		TVoxelPromiseType<ReturnType> Promise;
+		PromiseState->AddContinuation(EVoxelFutureThread::AnyThread, [Thread, Priority = MoveTemp(Priority), Promise, Continuation = MoveTemp(Continuation)](const FSharedVoidRef& Value) mutable
+		{
+			FVoxelFuture::ExecuteImpl(Thread, MoveTemp(Priority), [Promise, Continuation = MoveTemp(Continuation), Value]
+			{
+				const TSharedRef<T>& TypedValue = ReinterpretCastRef<TSharedRef<T>>(Value);
+
+				if constexpr (
+					LambdaHasSignature_V<LambdaType, ReturnType(TSharedRef<T>)> ||
+					LambdaHasSignature_V<LambdaType, ReturnType(const TSharedRef<T>&)>)
+				{
+					if constexpr (std::is_void_v<ReturnType>)
+					{
+						Continuation(TypedValue);
+						Promise.Set();
+					}
+					else
+					{
+						Promise.Set(Continuation(TypedValue));
+					}
+				}
+				else
+				{
+					if constexpr (std::is_void_v<ReturnType>)
+					{
+						Continuation(*TypedValue);
+						Promise.Set();
+					}
+					else
+					{
+						Promise.Set(Continuation(*TypedValue));
+					}
+				}
+			});
+		});
+		return Promise;
+	}
 
 #define Define(Thread, Suffix) \
 	template<typename LambdaType, typename ReturnType = LambdaReturnType_T<LambdaType>> \
@@ -490,8 +772,8 @@ public:
 	}
 
 protected:
-	FORCEINLINE explicit TVoxelFuture(const TSharedRef<IVoxelPromiseState>& PromiseState)
-		: FVoxelFuture(PromiseState)
+	FORCEINLINE explicit TVoxelFuture(FVoxelPromiseStatePtr PromiseState)
+		: FVoxelFuture(MoveTemp(PromiseState))
 	{
 	}
 };
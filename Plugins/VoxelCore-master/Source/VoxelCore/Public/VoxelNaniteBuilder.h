@@ -24,13 +24,53 @@ public:
 	int32 PositionPrecision = 4;
 	static constexpr int32 NormalBits = 8;
 
+	// If true, triangles are grouped into clusters by spatial locality instead of input order:
+	// identical positions are welded to find triangle adjacency, then clusters are grown over connected
+	// triangles, seeded along a Morton curve. Clusters are more compact, so they cull better and need fewer position bits
+	// Vertices of the render data are then no longer in input order, see OutSourceVertexIndices
+	bool bSpatialClustering = false;
+
+	// If true, clusters are grouped & simplified into coarser parent clusters until a single one is left,
+	// and the runtime picks the LOD of each part of the mesh based on its screen size
+	// Works best with bSpatialClustering, as groups are made of neighboring clusters
+	// Parent clusters reuse the source vertices, so OutSourceVertexIndices has more entries than Mesh has vertices
+	bool bBuildLODs = false;
+
 	TUniquePtr<FStaticMeshRenderData> CreateRenderData(TVoxelArray<int32>& OutVertexOffsets);
+	// OutSourceVertexIndices[Index] is the index in Mesh of the Index-th vertex of the render data
+	TUniquePtr<FStaticMeshRenderData> CreateRenderData(
+		TVoxelArray<int32>& OutVertexOffsets,
+		TVoxelArray<int32>& OutSourceVertexIndices);
 	UStaticMesh* CreateStaticMesh();
 
+	// Build the render data of many meshes in parallel, using the settings of this builder
+	// Each worker reuses its clusters & page buffers across all the meshes it builds
+	// The Mesh member is ignored, Result[Index] is nullptr if Meshes[Index] is empty
+	TVoxelArray<TUniquePtr<FStaticMeshRenderData>> CreateRenderDataBatch(
+		TConstVoxelArrayView<FMesh> Meshes,
+		TVoxelArray<TVoxelArray<int32>>& OutVertexOffsets) const;
+	TVoxelArray<TUniquePtr<FStaticMeshRenderData>> CreateRenderDataBatch(
+		TConstVoxelArrayView<FMesh> Meshes,
+		TVoxelArray<TVoxelArray<int32>>& OutVertexOffsets,
+		TVoxelArray<TVoxelArray<int32>>& OutSourceVertexIndices) const;
+
 public:
 	static void ApplyRenderData(
 		UStaticMesh& StaticMesh,
 		TUniquePtr<FStaticMeshRenderData> RenderData);
 
 	static UStaticMesh* CreateStaticMesh(TUniquePtr<FStaticMeshRenderData> RenderData);
+
+private:
+	struct FScratch;
+
+	// Meshes are passed explicitly so that batches don't need to copy the builder
+	TUniquePtr<FStaticMeshRenderData> CreateRenderData(
+		const FMesh& InMesh,
+		FScratch& Scratch,
+		bool bParallel,
+		TVoxelArray<int32>& OutVertexOffsets,
+		TVoxelArray<int32>& OutSourceVertexIndices) const;
+
+	static TVoxelArray<int32> ComputeSpatialTriangleOrder(const FMesh& InMesh);
 };
\ No newline at end of file
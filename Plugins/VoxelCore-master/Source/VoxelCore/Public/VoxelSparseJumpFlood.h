@@ -0,0 +1,36 @@
+// Copyright Voxel Plugin SAS. All Rights Reserved.
+
+#pragma once
+
+#include "VoxelMinimal.h"
+
+// Jump flood over a sparse set of 8x8x8 bricks, for volumes too large to be stored densely
+// Only voxels closer than NarrowBand to the surface are flooded, so time & memory scale with the surface area
+class VOXELCORE_API FVoxelSparseJumpFlood
+{
+public:
+	static constexpr int32 BrickSizeLog2 = 3;
+	static constexpr int32 BrickSize = 1 << BrickSizeLog2;
+	static constexpr int32 BrickCount = BrickSize * BrickSize * BrickSize;
+
+	struct FBrick
+	{
+		// Signed distances, NaN if unknown
+		// On output, NaN if not closer than NarrowBand to the surface
+		TVoxelStaticArray<float, BrickCount> Distances{ NoInit };
+
+		// Output only: closest surface point in voxel space, NaN if none closer than NarrowBand
+		TVoxelStaticArray<float, BrickCount> ClosestX{ NoInit };
+		TVoxelStaticArray<float, BrickCount> ClosestY{ NoInit };
+		TVoxelStaticArray<float, BrickCount> ClosestZ{ NoInit };
+	};
+	// Key is the voxel position divided by BrickSize
+	using FBrickMap = TVoxelMap<FIntVector, TSharedPtr<FBrick>>;
+
+	// Seeds are found like FVoxelUtilities::JumpFlood, looking across brick borders
+	// Bricks closer than NarrowBand to a seed are added to Bricks if missing
+	// Voxels with an unknown distance get their sign from the side of the surface they are on
+	static void JumpFlood(
+		FBrickMap& Bricks,
+		float NarrowBand);
+};
\ No newline at end of file
@@ -5,6 +5,16 @@
 #include "VoxelMinimal.h"
 
 extern VOXELCORE_API FVoxelTaskContext* GVoxelGlobalTaskContext;
+extern VOXELCORE_API bool GVoxelWorkStealing;
+
+DECLARE_VOXEL_COUNTER(VOXELCORE_API, STAT_VoxelQueuedAsyncTasks_Low, "Queued Async Tasks (Low Priority)");
+DECLARE_VOXEL_COUNTER(VOXELCORE_API, STAT_VoxelQueuedAsyncTasks_Normal, "Queued Async Tasks (Normal Priority)");
+DECLARE_VOXEL_COUNTER(VOXELCORE_API, STAT_VoxelQueuedAsyncTasks_High, "Queued Async Tasks (High Priority)");
+
+// In microseconds, accumulated over all the tasks launched from the queue
+DECLARE_VOXEL_COUNTER(VOXELCORE_API, STAT_VoxelAsyncTasksWaitTime_Low, "Async Tasks Wait Time (Low Priority, us)");
+DECLARE_VOXEL_COUNTER(VOXELCORE_API, STAT_VoxelAsyncTasksWaitTime_Normal, "Async Tasks Wait Time (Normal Priority, us)");
+DECLARE_VOXEL_COUNTER(VOXELCORE_API, STAT_VoxelAsyncTasksWaitTime_High, "Async Tasks Wait Time (High Priority, us)");
 
 class VOXELCORE_API FVoxelTaskContextStrongRef
 {
@@ -47,6 +57,12 @@ public:
 		EVoxelFutureThread Thread,
 		TVoxelUniqueFunction<void()> Lambda);
 
+	// Priority is only used by AsyncThread tasks, once MaxLaunchedTasks are in flight
+	void Dispatch(
+		EVoxelFutureThread Thread,
+		FVoxelTaskPriority Priority,
+		TVoxelUniqueFunction<void()> Lambda);
+
 	void FlushTasks();
 	void DumpToLog();
 
@@ -104,13 +120,52 @@ private:
 
 private:
 	static constexpr int32 MaxLaunchedTasks = 256;
-	using FTaskArray = TVoxelChunkedArray<TVoxelUniqueFunction<void()>, MaxLaunchedTasks * sizeof(TVoxelUniqueFunction<void()>) / 2>;
+	static constexpr int32 NumPriorities = 3;
+
+	struct FQueuedTask
+	{
+		double QueueTime = 0;
+		TVoxelUniqueFunction<void()> Lambda;
+	};
+	struct FPrioritizedTask
+	{
+		double Value = 0;
+		int64 Serial = 0;
+		// Shared so that it can be called outside of AsyncTasksCriticalSection, see RefreshPriorities
+		TSharedPtr<TVoxelUniqueFunction<double()>> GetValue;
+		FQueuedTask Task;
+	};
+	struct FAsyncTaskQueue
+	{
+		// Tasks with a FIFO priority, in order
+		TVoxelChunkedArray<FQueuedTask> Tasks;
+		int32 FirstTaskIndex = 0;
+
+		// Heap of all the other tasks
+		TVoxelArray<FPrioritizedTask> PrioritizedTasks;
+
+		int64 NumLaunched = 0;
+		double TotalWaitTime = 0;
+
+		FORCEINLINE int32 Num() const
+		{
+			return Tasks.Num() - FirstTaskIndex + PrioritizedTasks.Num();
+		}
+	};
 
 	FVoxelCriticalSection GameTasksCriticalSection;
 	TVoxelChunkedArray<TVoxelUniqueFunction<void()>> GameTasks_RequiresLock;
 
 	FVoxelCriticalSection AsyncTasksCriticalSection;
-	FTaskArray AsyncTasks_RequiresLock;
+	int64 AsyncTasksSerial_RequiresLock = 0;
+	TVoxelStaticArray<FAsyncTaskQueue, NumPriorities> AsyncTaskQueues_RequiresLock;
+	TVoxelAtomic<double> NextPriorityRefreshTime = 0.;
+	// Number of tasks in AsyncTaskQueues_RequiresLock, readable without the lock
+	FVoxelCounter32_WithPadding NumQueuedAsyncTasks;
+
+	void QueueAsyncTask_RequiresLock(FVoxelTaskPriority Priority, double Value, TVoxelUniqueFunction<void()> Lambda);
+	bool PopAsyncTask_RequiresLock(double Time, TVoxelUniqueFunction<void()>& OutLambda);
+	void RefreshPriorities(double Time);
 
 	void LaunchTasks();
 	void LaunchTask(TVoxelUniqueFunction<void()> Task);
@@ -120,12 +175,13 @@ private:
 private:
 	FVoxelCriticalSection CriticalSection;
 	TVoxelSparseArray<FVoxelStackFrames> StackFrames_RequiresLock;
-	TVoxelChunkedSparseArray<TSharedPtr<FVoxelPromiseState>> PromisesToKeepAlive_RequiresLock;
+	TVoxelChunkedSparseArray<FVoxelPromiseStatePtr> PromisesToKeepAlive_RequiresLock;
 
 	friend FVoxelPromiseState;
 	friend FVoxelTaskContextWeakRef;
 	friend FVoxelTaskContextStrongRef;
 	friend class FVoxelTaskContextTicker;
+	friend class FVoxelTaskWorkStealing;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -176,4 +232,19 @@ public:
 private:
 	FVoxelTaskContext& Context;
 	void* const PreviousTLS;
+};
+
+// Use around a blocking wait in an async task, eg on an event set by another voxel task
+// With voxel.WorkStealing, the tasks this thread dispatched are made available to all loops
+// and another loop is allowed to run while this one is blocked, so that the wait can't deadlock the scheduler
+// Used by FVoxelParallelTaskScope::FlushTasks, cheap if the current thread isn't running a loop
+class VOXELCORE_API FVoxelTaskBlockingScope
+{
+public:
+	FVoxelTaskBlockingScope();
+	~FVoxelTaskBlockingScope();
+	UE_NONCOPYABLE(FVoxelTaskBlockingScope);
+
+private:
+	const bool bIsBlockingLoop;
 };
\ No newline at end of file
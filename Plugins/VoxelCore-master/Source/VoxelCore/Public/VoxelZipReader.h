@@ -5,7 +5,12 @@
 #include "VoxelMinimal.h"
 #include "VoxelZipBase.h"
 
-class VOXELCORE_API FVoxelZipReader : public FVoxelZipBase
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+class VOXELCORE_API FVoxelZipReader
+	: public FVoxelZipBase
+	, public TSharedFromThis<FVoxelZipReader>
 {
 public:
 	using FReadLambda = TFunction<bool(int64 Offset, TVoxelArrayView64<uint8> OutData)>;
@@ -14,7 +19,10 @@ public:
 		int64 TotalSize,
 		const FReadLambda& ReadLambda);
 
+	// BulkData must outlive the reader
 	static TSharedPtr<FVoxelZipReader> Create(TConstVoxelArrayView64<uint8> BulkData);
+	// Memory-maps the file: entries are decompressed straight from the mapping, and stored entries can be viewed without any copy
+	static TSharedPtr<FVoxelZipReader> CreateMapped(const FString& Filename);
 
 public:
 	FORCEINLINE int32 NumFiles() const
@@ -36,13 +44,57 @@ public:
 		bool bAllowParallel = true,
 		int64* OutCompressedSize = nullptr) const;
 
+	// Only possible if the reader is backed by memory and the entry is stored without any compression
+	// The view is valid as long as the reader is alive
+	// The whole entry is read once to check its CRC
+	bool TryGetView(
+		const FString& Path,
+		TConstVoxelArrayView64<uint8>& OutData) const;
+
+	// Max size of a single ReadLambda call issued by LoadAsync
+	static constexpr int64 MaxBatchReadSize = 16 * 1024 * 1024;
+	// Entries further apart than this are not read in the same call
+	static constexpr int64 MaxBatchReadGap = 64 * 1024;
+
+	// Loads all the files in the background, returning one future per path
+	// Entries close to each other in the archive are coalesced into large sequential reads,
+	// issued one after the other from a single task, and are then decompressed in parallel
+	// Futures are set to nullptr if a file fails to load
+	TVoxelArray<TVoxelFuture<TSharedPtr<TVoxelArray64<uint8>>>> LoadAsync(TConstVoxelArrayView<FString> Paths) const;
+
 private:
 	const FReadLambda ReadLambda;
 	TVoxelArray<FString> IndexToPath;
 	TVoxelMap<FString, int32> PathToIndex;
 
+	// Set if the whole archive is in memory
+	TConstVoxelArrayView64<uint8> MemoryData;
+	TSharedPtr<IMappedFileHandle> MappedFileHandle;
+	TSharedPtr<IMappedFileRegion> MappedFileRegion;
+
 	explicit FVoxelZipReader(const FReadLambda& ReadLambda)
 		: ReadLambda(ReadLambda)
 	{
 	}
+
+	// Offset of the data of an entry stored without zip compression, -1 otherwise
+	int64 GetStoredDataOffset(const mz_zip_archive_file_stat& FileStat) const;
+
+	// See MZ_ZIP_LOCAL_DIR_HEADER_SIZE & co in miniz.cpp
+	static constexpr int64 LocalHeaderMinSize = 30;
+	static constexpr uint32 LocalHeaderSignature = 0x04034b50;
+	static constexpr int64 LocalHeaderFilenameLengthOffset = 26;
+	static constexpr int64 LocalHeaderExtraLengthOffset = 28;
+
+	static bool IsStored(const mz_zip_archive_file_stat& FileStat);
+	// Size of the local header starting at LocalHeader, -1 if invalid or if LocalHeader is too small
+	static int64 GetLocalHeaderSize(TConstVoxelArrayView64<uint8> LocalHeader);
+	// Crc32 is the CRC of the stored bytes, ie of the Oodle-compressed data if the entry was Oodle-compressed
+	static bool CheckCrc32(
+		TConstVoxelArrayView64<uint8> Data,
+		uint32 Crc32);
+	// Data is an entry stored without zip compression, possibly Oodle-compressed
+	static TSharedPtr<TVoxelArray64<uint8>> LoadStoredData(
+		TConstVoxelArrayView64<uint8> Data,
+		uint32 Crc32);
 };
\ No newline at end of file
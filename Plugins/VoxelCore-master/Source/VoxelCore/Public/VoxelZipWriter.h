@@ -36,6 +36,36 @@ public:
 		FOodleDataCompression::ECompressor Compressor = FOodleDataCompression::ECompressor::Leviathan,
 		FOodleDataCompression::ECompressionLevel CompressionLevel = FOodleDataCompression::ECompressionLevel::Optimal3);
 
+	// Seekable: read it back with FVoxelBlockCompressedData::Load
+	void WriteCompressed_Blocks(
+		const FString& Path,
+		TConstVoxelArrayView64<uint8> Data,
+		int32 BlockSize = 256 * 1024,
+		FOodleDataCompression::ECompressor Compressor = FOodleDataCompression::ECompressor::Leviathan,
+		FOodleDataCompression::ECompressionLevel CompressionLevel = FOodleDataCompression::ECompressionLevel::Optimal3);
+
+public:
+	enum class ECompression : uint8
+	{
+		None,
+		Deflate,
+		Oodle
+	};
+	struct FBatchEntry
+	{
+		FString Path;
+		TConstVoxelArrayView64<uint8> Data;
+		ECompression Compression = ECompression::Oodle;
+	};
+
+	// Compresses all the entries in parallel, and appends them to the archive in order as soon as they're ready
+	// The archive layout is the same as if the entries were written one by one
+	// Entries that fail to compress are not written, and the writer raises an error
+	void WriteBatch(
+		TConstVoxelArrayView<FBatchEntry> Entries,
+		FOodleDataCompression::ECompressor Compressor = FOodleDataCompression::ECompressor::Leviathan,
+		FOodleDataCompression::ECompressionLevel CompressionLevel = FOodleDataCompression::ECompressionLevel::Optimal3);
+
 private:
 	const FWriteLambda WriteLambda;
 
@@ -52,6 +82,14 @@ private:
 		TConstVoxelArrayView64<uint8> Data,
 		int32 Compression);
 
+	// If LevelAndFlags has MZ_ZIP_FLAG_COMPRESSED_DATA, Data is raw deflate data
+	void AppendImpl(
+		const FString& Path,
+		TConstVoxelArrayView64<uint8> Data,
+		int32 LevelAndFlags,
+		int64 UncompressedSize,
+		uint32 Crc32);
+
 	void WriteToDisk(
 		int64 Offset,
 		TConstVoxelArrayView64<uint8> Data) const;